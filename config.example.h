@@ -16,4 +16,11 @@ const unsigned long THINGSPEAK_CHANNEL_ID = 0;
 const char* OTA_HOSTNAME = "SEN55-AirQuality";
 const char* OTA_PASSWORD = "YOUR_OTA_PASSWORD";
 
+// MQTT (optional): publish records to this broker instead of ThingSpeak
+// #define MQTT_BROKER "broker.local"
+// #define MQTT_PORT 1883
+
+// Field trace (optional): record reads, WiFi, uploads and records for native replay
+// #define TRACE_SINK TRACE_SERIAL   // or TRACE_FLASH (/trace on LittleFS, first ~5 h)
+
 #endif
\ No newline at end of file
@@ -0,0 +1,168 @@
+/**
+ * @file AveragingBench.cpp
+ * @brief Microbenchmark and sanity check for DataAveraging
+ *
+ * Compares the per-second addReading() and per-upload statistics cost of
+ * the Welford sliding window against the original sum-and-count
+ * accumulator (reproduced below as LegacyAveraging), shows how far the
+ * legacy float sums drift once the count grows into the thousands, and
+ * checks that after an arbitrary number of readings without reset() the
+ * statistics match a two-pass computation over the last
+ * AVERAGING_SAMPLES readings.
+ */
+
+#include "Bench.h"
+
+#include "DataAveraging.h"
+
+#include <math.h>
+#include <stdio.h>
+
+namespace {
+    const int ITERATIONS = 2000000;
+    const int CHECK_READINGS = 3607; // Deliberately not a multiple of the window
+    const int DRIFT_READINGS = 86400; // One day of failed uploads at 1 Hz
+
+    /** The pre-ring-buffer DataAveraging: float sums and a count. */
+    class LegacyAveraging {
+    public:
+        void addReading(const SensorData& r) {
+            sum.pm1 += r.pm1; sum.pm25 += r.pm25; sum.pm4 += r.pm4; sum.pm10 += r.pm10;
+            sum.humidity += r.humidity; sum.temperature += r.temperature;
+            sum.voc += r.voc; sum.nox += r.nox;
+            count++;
+        }
+        void getAveraged(float& pm1, float& pm25, float& pm4, float& pm10,
+                         float& humidity, float& temperature, float& voc, float& nox) const {
+            if (count == 0) return;
+            pm1 = sum.pm1 / count; pm25 = sum.pm25 / count; pm4 = sum.pm4 / count;
+            pm10 = sum.pm10 / count; humidity = sum.humidity / count;
+            temperature = sum.temperature / count; voc = sum.voc / count; nox = sum.nox / count;
+        }
+
+    private:
+        SensorData sum = {0, 0, 0, 0, 0, 0, 0, 0};
+        int count = 0;
+    };
+
+    float syntheticValue(int i, int field) {
+        return 10.0f + 5.0f * sinf(i * 0.01f + field) + (float)((i * 7919 + field * 104729) % 1000) * 0.001f;
+    }
+
+    template <typename Averager>
+    void addSynthetic(Averager& averaging, int i) {
+        SensorData reading;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) reading.*SENSOR_FIELDS[f] = syntheticValue(i, f);
+        averaging.addReading(reading);
+    }
+
+    bool close(double actual, double expected, double relative) {
+        return fabs(actual - expected) <= relative * fabs(expected) + 1e-5;
+    }
+
+    bool checkWindow() {
+        DataAveraging averaging;
+        for (int i = 0; i < CHECK_READINGS; i++) addSynthetic(averaging, i);
+        SensorStats stats = averaging.getStats();
+
+        bool ok = stats.count == AVERAGING_SAMPLES;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            float SensorData::* field = SENSOR_FIELDS[f];
+            double sum = 0;
+            float lo = INFINITY, hi = -INFINITY;
+            for (int i = CHECK_READINGS - AVERAGING_SAMPLES; i < CHECK_READINGS; i++) {
+                float v = syntheticValue(i, f);
+                sum += v;
+                if (v < lo) lo = v;
+                if (v > hi) hi = v;
+            }
+            double mean = sum / AVERAGING_SAMPLES;
+            double squares = 0;
+            for (int i = CHECK_READINGS - AVERAGING_SAMPLES; i < CHECK_READINGS; i++) {
+                double d = syntheticValue(i, f) - mean;
+                squares += d * d;
+            }
+            double variance = squares / (AVERAGING_SAMPLES - 1);
+
+            if (!close(stats.mean.*field, mean, 1e-5) || !close(stats.variance.*field, variance, 1e-3)
+                || stats.min.*field != lo || stats.max.*field != hi) {
+                printf("  FAIL: field %d mean %.6f/%.6f var %.6f/%.6f min %.4f/%.4f max %.4f/%.4f\n",
+                       f, stats.mean.*field, mean, stats.variance.*field, variance,
+                       stats.min.*field, lo, stats.max.*field, hi);
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    /** Worst relative mean error of the legacy float sums after a day without reset. */
+    double legacyDrift() {
+        LegacyAveraging legacy;
+        double exact[8] = {0};
+        for (int i = 0; i < DRIFT_READINGS; i++) {
+            // VOC-index-like magnitudes (~100) push the float sums past 2^23
+            SensorData reading;
+            for (int f = 0; f < 8; f++) {
+                reading.*SENSOR_FIELDS[f] = 100.0f + syntheticValue(i, f) * 3.3f;
+                exact[f] += reading.*SENSOR_FIELDS[f];
+            }
+            legacy.addReading(reading);
+        }
+        float v[8] = {0};
+        legacy.getAveraged(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+        double worst = 0;
+        for (int f = 0; f < 8; f++) {
+            double mean = exact[f] / DRIFT_READINGS;
+            double error = fabs(v[f] - mean) / mean;
+            if (error > worst) worst = error;
+        }
+        return worst;
+    }
+
+    const int TABLE_SIZE = 4096;
+    SensorData table[TABLE_SIZE];
+
+    template <typename Averager>
+    double addCost() {
+        Averager averaging;
+        uint64_t start = hostNanos();
+        for (int i = 0; i < ITERATIONS; i++) {
+            averaging.addReading(table[i & (TABLE_SIZE - 1)]);
+            doNotOptimize(averaging);
+        }
+        return (double)(hostNanos() - start) / ITERATIONS;
+    }
+}
+
+int runAveragingBench(const BenchOptions& options) {
+    (void)options;
+    printf("  window: %d readings, %zu bytes (legacy accumulator: %zu bytes)\n",
+           AVERAGING_SAMPLES, sizeof(DataAveraging), sizeof(LegacyAveraging));
+
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) table[i].*SENSOR_FIELDS[f] = syntheticValue(i, f);
+    }
+    double legacyAdd = addCost<LegacyAveraging>();
+    double welfordAdd = addCost<DataAveraging>();
+
+    DataAveraging averaging;
+    for (int i = 0; i < AVERAGING_SAMPLES * 3; i++) addSynthetic(averaging, i);
+    float sink = 0;
+    uint64_t start = hostNanos();
+    for (int i = 0; i < ITERATIONS; i++) {
+        SensorStats stats = averaging.getStats();
+        sink += stats.variance.pm25;
+        doNotOptimize(sink);
+    }
+    double statsNanos = (double)(hostNanos() - start) / ITERATIONS;
+
+    printf("  addReading, legacy sum/count: %8.2f ns\n", legacyAdd);
+    printf("  addReading, Welford window:   %8.2f ns (+%.2f ns per reading)\n",
+           welfordAdd, welfordAdd - legacyAdd);
+    printf("  getStats:                     %8.2f ns\n", statsNanos);
+    printf("  legacy mean error after %d readings without reset: %.4f%%\n", DRIFT_READINGS, legacyDrift() * 100.0);
+
+    bool ok = checkWindow();
+    printf("  sliding window stats after %d readings: %s\n", CHECK_READINGS, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
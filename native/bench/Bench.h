@@ -0,0 +1,144 @@
+/**
+ * @file Bench.h
+ * @brief Shared declarations for the native benchmark suites
+ *
+ * Each suite is a free function registered in main.cpp. Suites print a
+ * plain-text report to stdout and return 0 on success, non-zero when a
+ * built-in sanity check fails.
+ */
+
+#ifndef NATIVE_BENCH_H
+#define NATIVE_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
+
+class Print;
+
+struct BenchOptions {
+    double hours = 6.0;          // Simulated duration for end-to-end suites
+    uint32_t seed = 1;           // Sensor model seed
+    bool echoSerial = false;     // Mirror firmware Serial output to stdout
+    float netFailure = 0.0f;     // Probability a TCP connect is refused
+    float spikeProbability = 0.0f; // Probability of a PM spike per sample
+    unsigned outageEveryMin = 0; // Schedule a WiFi outage every N minutes (0 = none)
+    unsigned outageSeconds = 120; // Length of each scheduled outage
+    unsigned serverIdleSeconds = 15; // Server closes idle keep-alive sockets after this
+    bool fixedIntervalReads = false; // Sensor task reads on a 1 s timer instead of data-ready
+    int sensorClockPpm = 2500;   // SEN55 oscillator error (+ = slower than 1 Hz)
+    int logLevel = -1;           // Firmware log level after setup() (-1 = firmware default)
+    bool performancePower = false; // Run in POWER_PERFORMANCE instead of the firmware's POWER_MODE
+    bool mqtt = false;           // Upload to the MQTT broker stand-in instead of ThingSpeak
+    const char* recordTracePath = nullptr; // Write the firmware's field trace here (loop suite)
+    const char* replayPath = nullptr;      // Play this field trace back through the firmware (loop suite)
+};
+
+/**
+ * @brief Log-linear histogram for latency-like values
+ *
+ * 16 sub-buckets per power of two gives ~6% resolution with fixed memory,
+ * so millions of samples can be recorded without allocation.
+ */
+class LatencyHistogram {
+public:
+    void record(uint64_t value);
+    uint64_t count() const { return total; }
+    uint64_t max() const { return maxValue; }
+    double mean() const { return total ? (double)sum / (double)total : 0.0; }
+    /** Approximate value at quantile q (0..1). */
+    uint64_t percentile(double q) const;
+
+private:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int BUCKET_COUNT = 64 << SUB_BUCKET_BITS;
+    static int bucketFor(uint64_t value);
+    static uint64_t lowerBound(int bucket);
+
+    uint64_t buckets[BUCKET_COUNT] = {};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t maxValue = 0;
+};
+
+/** Monotonic host clock in nanoseconds. */
+inline uint64_t hostNanos() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** Keep the optimiser from discarding a computed value. */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Suites
+int runLoopBench(const BenchOptions& options);
+int runAveragingBench(const BenchOptions& options);
+int runHistoryBench(const BenchOptions& options);
+int runQueueBench(const BenchOptions& options);
+int runBulkBench(const BenchOptions& options);
+int runSessionBench(const BenchOptions& options);
+int runSpscBench(const BenchOptions& options);
+int runLogBench(const BenchOptions& options);
+int runSchedulerBench(const BenchOptions& options);
+int runWebBench(const BenchOptions& options);
+int runPushBench(const BenchOptions& options);
+int runStoreBench(const BenchOptions& options);
+int runMetricsBench(const BenchOptions& options);
+int runCodecBench(const BenchOptions& options);
+int runMqttBench(const BenchOptions& options);
+int runTraceBench(const BenchOptions& options);
+int runFilterBench(const BenchOptions& options);
+
+/**
+ * @brief Check a Prometheus text exposition (as /metrics serves it)
+ *
+ * HELP then TYPE before each family's samples, valid names, counters
+ * ending in _total, finite values (non-negative but for gauges), and
+ * histogram buckets with increasing bounds, cumulative counts and +Inf
+ * equal to _count.
+ * Prints the first offending line; defined in MetricsBench.cpp.
+ */
+bool checkPrometheusText(const char* text, size_t length);
+
+/**
+ * @brief What prepareReplay() set the simulation up with
+ */
+struct ReplayPlan {
+    size_t samples = 0;          // Sensor reads to play back
+    size_t outages = 0;          // WiFi outages derived from link drops
+    size_t uploads = 0;          // Recorded uploads (ThingSpeak ones are scripted)
+    size_t records = 0;          // Records the trace holds, to compare against
+    uint32_t damagedBlocks = 0;  // Trace blocks skipped as damaged
+    uint64_t endMillis = 0;      // millis() to run until
+    bool mqtt = false;           // The device uploaded over MQTT
+};
+
+// Field traces (TraceBench.cpp)
+/** A Print that keeps what the firmware's TRACE_SERIAL sink writes */
+Print& traceCapture();
+const std::string& capturedTrace();
+/** The blocks of the "#T:" lines in a serial log; other lines are skipped */
+std::string traceBlocksFromText(const std::string& text);
+/** Read a trace file: flash segments laid end to end, or a serial log */
+bool readTraceFile(const char* path, std::string& blocks);
+bool writeTraceFile(const char* path, const std::string& text);
+/**
+ * @brief Set the simulated sensor, WiFi, clock and ThingSpeak up to play a
+ *        trace back; call before setup()
+ * @return false if the trace holds no sensor reads
+ */
+bool prepareReplay(const std::string& blocks, const char* thingSpeakHost, ReplayPlan& plan);
+/** Requests the replayed firmware made beyond the recorded ones */
+uint64_t replayUnscriptedRequests();
+/**
+ * @brief Compare the records of a replay with the trace's; prints a summary
+ * @return true if every record came out the same (timestamps within a second)
+ */
+bool checkReplay(const std::string& traceBlocks, const std::string& replayBlocks);
+
+#endif // NATIVE_BENCH_H
@@ -0,0 +1,197 @@
+/**
+ * @file BulkBench.cpp
+ * @brief Encoding cost and wire format of the ThingSpeak bulk-update path
+ *
+ * Bodies produced by BulkUploader are posted straight to FakeThingSpeak,
+ * whose parser is strict, so the suite checks that:
+ *   - a created_at batch and a delta_t batch are accepted with every entry;
+ *   - a batch mixing both timestamp kinds is cut where the kind changes;
+ *   - malformed bodies (bad key, bad field, mixed kinds) are rejected and
+ *     accept nothing;
+ *   - a second request inside the rate limit gets 429;
+ *   - the fixed-point field formatter prints the same digits as "%.2f"
+ *     (and "%d" for the index fields, "0.00" for a rounded negative zero)
+ *     and encoding never allocates.
+ * It also reports host time and bytes per encoded record.
+ */
+
+#include "Bench.h"
+
+#include "BulkUploader.h"
+
+#include <Simulation.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+namespace {
+    const char* API_KEY = "BENCHKEY";
+    const uint32_t SPACING = 15;
+    const uint32_t FIRST_EPOCH = 1767225600; // 2026-01-01T00:00:00Z
+
+    QueuedRecord makeRecord(uint32_t timestamp, int index) {
+        QueuedRecord record;
+        record.timestamp = timestamp;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            record.data.*SENSOR_FIELDS[f] = 10.0f + index + f * 1.5f;
+        }
+        return record;
+    }
+
+    void makeBatch(QueuedRecord* records, int count, bool timestamped) {
+        for (int i = 0; i < count; i++) {
+            records[i] = makeRecord(timestamped ? FIRST_EPOCH + i * SPACING : 0, i);
+        }
+    }
+
+    int post(FakeThingSpeak& server, const std::string& body, std::string* responseBody = nullptr) {
+        SimHttpRequest request;
+        request.method = "POST";
+        request.path = "/channels/1/bulk_update.json";
+        request.headers = "Content-Type: application/json\r\n";
+        request.body = body;
+        SimHttpResponse response;
+        server.handle(request, response);
+        if (responseBody) *responseBody = response.body;
+        return response.status;
+    }
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool checkAccepted(BulkUploader& uploader, bool timestamped, const char* name) {
+        FakeThingSpeak server(API_KEY, 0);
+        QueuedRecord records[BulkUploader::MAX_RECORDS];
+        makeBatch(records, BulkUploader::MAX_RECORDS, timestamped);
+
+        int encoded = 0;
+        const char* body = uploader.encode(records, BulkUploader::MAX_RECORDS, encoded);
+        std::string response;
+        int status = body ? post(server, std::string(body, uploader.payloadLength()), &response) : 0;
+        bool ok = encoded == BulkUploader::MAX_RECORDS && status == 202
+               && response.find("\"success\":true") != std::string::npos
+               && server.stats().accepted == (uint64_t)encoded && server.stats().bulkRequests == 1
+               && server.stats().outOfOrder == 0;
+        return report(name, ok);
+    }
+
+    bool checkMixedKinds(BulkUploader& uploader) {
+        FakeThingSpeak server(API_KEY, 0);
+        QueuedRecord records[6];
+        makeBatch(records, 6, true);
+        records[3].timestamp = 0;
+
+        int encoded = 0;
+        const char* body = uploader.encode(records, 6, encoded);
+        int status = body ? post(server, std::string(body, uploader.payloadLength())) : 0;
+        bool ok = encoded == 3 && status == 202 && server.stats().accepted == 3;
+        return report("mixed timestamp kinds split the batch", ok);
+    }
+
+    bool checkFormatting(BulkUploader& uploader) {
+        const float samples[] = {0.0f, 0.004f, 0.005f, 0.015f, 1.005f, 2.675f, 12.345f, 22.35f,
+                                 -0.004f, -3.125f, -17.8f, 499.995f, 999.99f, 65535.0f, 123456.78f};
+        uint32_t state = 12345;
+        bool ok = true;
+        SimHeapStats heapBefore = SimHeap::stats();
+        const int CASES = 4000;
+        for (int i = 0; i < CASES && ok; i++) {
+            QueuedRecord record = makeRecord(FIRST_EPOCH + i * 7919, i);
+            for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+                state = state * 1664525u + 1013904223u;
+                float value = i < 15 ? samples[(i + f) % 15] : (float)((int32_t)state) / 1048576.0f;
+                record.data.*SENSOR_FIELDS[f] = value;
+            }
+            int encoded = 0;
+            const char* body = uploader.encode(&record, 1, encoded);
+
+            char expected[BulkUploader::MAX_ENTRY_JSON];
+            const SensorData& d = record.data;
+            snprintf(expected, sizeof(expected),
+                     "\"field1\":%.2f,\"field2\":%.2f,\"field3\":%.2f,\"field4\":%.2f"
+                     ",\"field5\":%.2f,\"field6\":%d,\"field7\":%d,\"field8\":%.2f}",
+                     d.pm1, d.pm25, d.pm4, d.pm10, d.temperature, (int)d.voc, (int)d.nox, d.humidity);
+            // printf keeps the sign of values that round to zero; the encoder prints 0.00
+            for (char* negativeZero; (negativeZero = strstr(expected, ":-0.00")) != nullptr;) {
+                memmove(negativeZero + 1, negativeZero + 2, strlen(negativeZero + 2) + 1);
+            }
+            ok = body && encoded == 1 && strstr(body, expected) != nullptr
+              && uploader.payloadLength() <= BulkUploader::MAX_PAYLOAD - 1;
+            if (!ok) printf("  mismatch: %s\n  expected: %s\n", body ? body : "(null)", expected);
+        }
+        ok = ok && SimHeap::stats().allocations == heapBefore.allocations;
+        return report("fields match printf, no allocation", ok);
+    }
+
+    bool checkRejected() {
+        FakeThingSpeak server(API_KEY, 0);
+        const char* entry = "{\"created_at\":\"2026-01-01T00:00:00Z\",\"field1\":1.5}";
+        std::string badKey = std::string("{\"write_api_key\":\"WRONG\",\"updates\":[") + entry + "]}";
+        std::string badField = "{\"write_api_key\":\"BENCHKEY\",\"updates\":"
+                               "[{\"created_at\":\"2026-01-01T00:00:00Z\",\"field1\":\"abc\"}]}";
+        std::string mixed = std::string("{\"write_api_key\":\"BENCHKEY\",\"updates\":[") + entry
+                          + ",{\"delta_t\":15,\"field1\":2}]}";
+        std::string truncated = std::string("{\"write_api_key\":\"BENCHKEY\",\"updates\":[") + entry;
+
+        bool ok = post(server, badKey) == 401;
+        ok = post(server, badField) == 400 && ok;
+        ok = post(server, mixed) == 400 && ok;
+        ok = post(server, truncated) == 400 && ok;
+        ok = ok && server.stats().accepted == 0 && server.stats().malformed == 4;
+        return report("malformed bodies are rejected", ok);
+    }
+
+    bool checkRateLimit(BulkUploader& uploader) {
+        FakeThingSpeak server(API_KEY, 15000);
+        QueuedRecord records[BulkUploader::BATCH_SIZE];
+        makeBatch(records, BulkUploader::BATCH_SIZE, true);
+
+        int encoded = 0;
+        const char* body = uploader.encode(records, BulkUploader::BATCH_SIZE, encoded);
+        std::string payload(body ? body : "", uploader.payloadLength());
+        bool ok = post(server, payload) == 202;
+        ok = post(server, payload) == 429 && ok;
+        ok = ok && server.stats().accepted == (uint64_t)BulkUploader::BATCH_SIZE && server.stats().rateLimited == 1;
+        return report("second request inside 15 s gets 429", ok);
+    }
+
+    void measureCost(BulkUploader& uploader) {
+        QueuedRecord records[BulkUploader::MAX_RECORDS];
+        makeBatch(records, BulkUploader::MAX_RECORDS, true);
+        const int ITERATIONS = 20000;
+        const int sizes[] = {1, BulkUploader::BATCH_SIZE, BulkUploader::MAX_RECORDS};
+
+        for (int count : sizes) {
+            int encoded = 0;
+            uint64_t start = hostNanos();
+            for (int i = 0; i < ITERATIONS; i++) {
+                doNotOptimize(uploader.encode(records, count, encoded));
+            }
+            double nanos = (double)(hostNanos() - start) / ITERATIONS;
+            printf("  %2d records: %5zu bytes (%5.1f / record), encode %7.2f us (%5.2f us / record)\n",
+                   count, uploader.payloadLength(), (double)uploader.payloadLength() / count,
+                   nanos / 1e3, nanos / 1e3 / count);
+        }
+    }
+}
+
+int runBulkBench(const BenchOptions& options) {
+    (void)options;
+    static BulkUploader uploader(API_KEY, SPACING); // Payload buffer is ~8 KB
+    printf("  batch: %d records, drain: %d records, payload buffer: %zu bytes\n\n",
+           BulkUploader::BATCH_SIZE, BulkUploader::MAX_RECORDS, BulkUploader::MAX_PAYLOAD);
+
+    bool ok = checkAccepted(uploader, true, "created_at batch accepted in full");
+    ok = checkAccepted(uploader, false, "delta_t batch accepted in full") && ok;
+    ok = checkMixedKinds(uploader) && ok;
+    ok = checkFormatting(uploader) && ok;
+    ok = checkRejected() && ok;
+    ok = checkRateLimit(uploader) && ok;
+    printf("\n");
+    measureCost(uploader);
+    return ok ? 0 : 1;
+}
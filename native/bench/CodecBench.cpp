@@ -0,0 +1,281 @@
+/**
+ * @file CodecBench.cpp
+ * @brief RecordCodec round trips, damaged streams, size and speed
+ *
+ * Encodes a day of per-second readings (with warm-up NaNs, PM spikes and
+ * outages) and a day of 15-second averages, decodes them and checks every
+ * value against RecordEncoder::quantized() bit for bit. Then checks the
+ * edges: values beyond the 32-bit range, timestamps that wrap or step
+ * back, a full buffer, a stream cut at every byte (only whole records
+ * come back), bad headers, and a stream with a field the decoder does
+ * not know and without one it does. Reports bytes per record against the
+ * 36-byte raw form and encode and decode time per record.
+ */
+
+#include "Bench.h"
+
+#include "RecordCodec.h"
+
+#include <Simulation.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+    const uint32_t START_TIME = 1760000000;
+    const uint32_t DAY = 86400;
+    const size_t RAW_BYTES = sizeof(uint32_t) + sizeof(SensorData);
+    const int TIMING_RUNS = 20;
+
+    struct Reading {
+        uint32_t time;
+        SensorData data;
+    };
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool sameValue(float a, float b) {
+        return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(a)) == 0;
+    }
+
+    bool matchesQuantized(const Reading& original, uint32_t time, const SensorData& decoded) {
+        if (time != original.time) {
+            return false;
+        }
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            float expected = RecordEncoder::quantized((SensorField)f, original.data.*SENSOR_FIELDS[f]);
+            if (!sameValue(expected, decoded.*SENSOR_FIELDS[f])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    SensorData syntheticReading(uint32_t i, std::mt19937& random) {
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+        float day = (float)(i % DAY) / DAY * 6.2831853f;
+        SensorData r;
+        r.pm25 = 12.0f + 8.0f * sinf(day) + 0.3f * noise(random) + (random() % 5000 == 0 ? 150.0f : 0.0f);
+        r.pm1 = r.pm25 * 0.8f;
+        r.pm4 = r.pm25 * 1.1f;
+        r.pm10 = r.pm25 * 1.2f;
+        r.humidity = 45.0f + 10.0f * sinf(day + 1.0f) + 0.05f * noise(random);
+        r.temperature = 21.0f + 3.0f * sinf(day - 1.0f) + 0.01f * noise(random);
+        r.voc = roundf(100.0f + 40.0f * sinf(day * 3.0f));
+        r.nox = 1.0f + (float)(random() % 3 == 0);
+        return r;
+    }
+
+    /** A day at one reading per second: NaN VOC/NOx while warming up, outages */
+    std::vector<Reading> perSecond(std::mt19937& random) {
+        std::vector<Reading> readings;
+        uint32_t time = START_TIME;
+        for (uint32_t i = 0; i < DAY; i++) {
+            Reading reading;
+            reading.data = syntheticReading(i, random);
+            if (i < 10) {
+                reading.data.voc = NAN; // The SEN55 reports NaN until its VOC/NOx values settle
+                reading.data.nox = NAN;
+            }
+            time += i % 20000 == 19999 ? 300 : 1;
+            reading.time = time;
+            readings.push_back(reading);
+        }
+        return readings;
+    }
+
+    /** A day of 15-second averages, as queued for upload */
+    std::vector<Reading> averaged(std::mt19937& random) {
+        std::vector<Reading> readings;
+        for (uint32_t i = 0; i < DAY / 15; i++) {
+            Reading reading;
+            reading.data = syntheticReading(i * 15, random);
+            reading.data.voc += 0.1f * (random() % 10); // Means are not whole indices
+            reading.time = START_TIME + i * 15;
+            readings.push_back(reading);
+        }
+        return readings;
+    }
+
+    /** Encode readings into buffer; returns how many fit */
+    size_t encodeAll(const std::vector<Reading>& readings, std::vector<uint8_t>& buffer, size_t& length) {
+        RecordEncoder encoder(buffer.data(), buffer.size());
+        size_t added = 0;
+        while (added < readings.size() && encoder.add(readings[added].time, readings[added].data)) {
+            added++;
+        }
+        length = encoder.length();
+        return added;
+    }
+
+    /** Decode and compare with readings; returns records that matched, -1 on a mismatch */
+    long decodeAll(const uint8_t* stream, size_t length, const std::vector<Reading>& readings) {
+        RecordDecoder decoder(stream, length);
+        uint32_t time;
+        SensorData data;
+        long count = 0;
+        while (decoder.next(time, data)) {
+            if ((size_t)count >= readings.size() || !matchesQuantized(readings[count], time, data)) {
+                return -1;
+            }
+            count++;
+        }
+        return decoder.hasError() ? -1 : count;
+    }
+
+    bool roundTrip(const char* name, const std::vector<Reading>& readings) {
+        std::vector<uint8_t> buffer(readings.size() * RecordEncoder::MAX_RECORD_BYTES + RecordEncoder::HEADER_BYTES);
+        size_t length = 0;
+        SimHeapStats heapBefore = SimHeap::stats();
+        bool ok = encodeAll(readings, buffer, length) == readings.size();
+        ok = ok && decodeAll(buffer.data(), length, readings) == (long)readings.size();
+        ok = ok && SimHeap::stats().allocations == heapBefore.allocations;
+
+        uint64_t encodeNanos = UINT64_MAX;
+        uint64_t decodeNanos = UINT64_MAX;
+        for (int run = 0; run < TIMING_RUNS; run++) {
+            uint64_t start = hostNanos();
+            RecordEncoder encoder(buffer.data(), buffer.size());
+            for (const Reading& reading : readings) {
+                encoder.add(reading.time, reading.data);
+            }
+            encodeNanos = std::min(encodeNanos, hostNanos() - start);
+
+            start = hostNanos();
+            RecordDecoder decoder(buffer.data(), length);
+            uint32_t time;
+            SensorData data;
+            float checksum = 0;
+            while (decoder.next(time, data)) {
+                checksum += data.pm25;
+            }
+            doNotOptimize(checksum);
+            decodeNanos = std::min(decodeNanos, hostNanos() - start);
+        }
+        double perRecord = (double)length / readings.size();
+        printf("  %-22s %8lu %9.2f %7.1fx %11.1f %11.1f %10.0f\n", name, (unsigned long)readings.size(), perRecord,
+               RAW_BYTES / perRecord, (double)encodeNanos / readings.size(), (double)decodeNanos / readings.size(),
+               readings.size() * RAW_BYTES / (decodeNanos / 1e9) / 1e6);
+        return ok;
+    }
+}
+
+int runCodecBench(const BenchOptions& options) {
+    std::mt19937 random(options.seed);
+    std::vector<Reading> seconds = perSecond(random);
+    std::vector<Reading> averages = averaged(random);
+
+    printf("  %-22s %8s %9s %8s %11s %11s %10s\n", "stream", "records", "B/record", "vs raw", "encode ns",
+           "decode ns", "raw MB/s");
+    bool secondsOk = roundTrip("1 s readings, 1 day", seconds);
+    bool averagesOk = roundTrip("15 s averages, 1 day", averages);
+    printf("  (raw: %lu bytes per timestamp and SensorData; header %lu bytes at most)\n\n",
+           (unsigned long)RAW_BYTES, (unsigned long)RecordEncoder::HEADER_BYTES);
+    bool ok = report("per-second day round-trips exactly", secondsOk);
+    ok = report("15-second averages round-trip exactly", averagesOk) && ok;
+
+    // Values beyond the quantized range, infinities, timestamps that wrap and step back
+    std::vector<Reading> edges;
+    const float EXTREMES[] = {0.0f, -0.0f, 1e30f, -1e30f, INFINITY, -INFINITY, NAN, 0.05f, -0.05f, 0.0025f,
+                              214748364.7f, -214748364.8f, 3.0e-39f};
+    const uint32_t TIMES[] = {0, 1, UINT32_MAX, 0, 5, 3, 0x80000000u, 0x7FFFFFFFu, 0x80000000u, 42, 42, 100000,
+                              UINT32_MAX - 1};
+    for (size_t i = 0; i < sizeof(TIMES) / sizeof(TIMES[0]); i++) {
+        Reading reading;
+        reading.time = TIMES[i];
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            reading.data.*SENSOR_FIELDS[f] = EXTREMES[(i + f) % (sizeof(EXTREMES) / sizeof(EXTREMES[0]))];
+        }
+        edges.push_back(reading);
+    }
+    std::vector<uint8_t> buffer(edges.size() * RecordEncoder::MAX_RECORD_BYTES + RecordEncoder::HEADER_BYTES);
+    size_t length = 0;
+    bool edgesOk = encodeAll(edges, buffer, length) == edges.size()
+                   && decodeAll(buffer.data(), length, edges) == (long)edges.size();
+    {
+        RecordEncoder encoder(buffer.data(), buffer.size());
+        for (const Reading& reading : edges) {
+            encoder.add(reading.time, reading.data);
+        }
+        edgesOk = edgesOk && encoder.getStats().clamped > 0
+                  && RecordEncoder::quantized(FIELD_PM25, 1e30f) == 214748364.7f
+                  && isnan(RecordEncoder::quantized(FIELD_PM25, NAN));
+    }
+    ok = report("extremes, NaN and wrapping time survive", edgesOk) && ok;
+
+    // A full buffer refuses the record whole; what was added still decodes
+    std::vector<uint8_t> small(RecordEncoder::HEADER_BYTES + 3 * RecordEncoder::MAX_RECORD_BYTES);
+    size_t fitted = encodeAll(seconds, small, length);
+    long smallDecoded = decodeAll(small.data(), length, seconds);
+    std::vector<uint8_t> tiny(RecordEncoder::HEADER_BYTES - 1);
+    RecordEncoder noRoom(tiny.data(), tiny.size());
+    ok = report("full buffer refuses records whole", fitted >= 3 && smallDecoded == (long)fitted
+                                                         && length <= small.size() && noRoom.length() == 0
+                                                         && !noRoom.add(1, SensorData())) && ok;
+
+    // Cut the first records of the day at every byte: whole records only, and an error inside one
+    std::vector<Reading> first(seconds.begin(), seconds.begin() + 40);
+    encodeAll(first, buffer, length);
+    std::vector<size_t> boundaries;
+    {
+        RecordEncoder encoder(buffer.data(), buffer.size());
+        boundaries.push_back(encoder.length());
+        for (const Reading& reading : first) {
+            encoder.add(reading.time, reading.data);
+            boundaries.push_back(encoder.length());
+        }
+    }
+    bool cutsOk = true;
+    for (size_t cut = 0; cut <= length; cut++) {
+        RecordDecoder decoder(buffer.data(), cut);
+        uint32_t time;
+        SensorData data;
+        size_t count = 0;
+        while (decoder.next(time, data)) {
+            cutsOk = cutsOk && count < first.size() && matchesQuantized(first[count], time, data);
+            count++;
+        }
+        size_t whole = 0;
+        while (whole + 1 < boundaries.size() && boundaries[whole + 1] <= cut) {
+            whole++;
+        }
+        bool atBoundary = cut >= boundaries[0] && boundaries[whole] == cut;
+        cutsOk = cutsOk && count == whole && decoder.hasError() == !atBoundary;
+    }
+    ok = report("cut streams yield only whole records", cutsOk) && ok;
+
+    // Damaged headers and an over-long varint
+    uint8_t badMagic[] = {'A', 'X', RecordEncoder::VERSION, 0};
+    uint8_t badVersion[] = {'A', 'Q', RecordEncoder::VERSION + 1, 0};
+    uint8_t zeroScale[] = {'A', 'Q', RecordEncoder::VERSION, 1, FIELD_PM25, 0};
+    uint8_t longVarint[] = {'A', 'Q', RecordEncoder::VERSION, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F};
+    uint32_t time;
+    SensorData data;
+    RecordDecoder longDecoder(longVarint, sizeof(longVarint));
+    bool headersOk = !RecordDecoder(badMagic, sizeof(badMagic)).isValid()
+                     && !RecordDecoder(badVersion, sizeof(badVersion)).isValid()
+                     && !RecordDecoder(zeroScale, sizeof(zeroScale)).isValid()
+                     && longDecoder.isValid() && !longDecoder.next(time, data) && longDecoder.hasError();
+    ok = report("bad headers and over-long varints refused", headersOk) && ok;
+
+    // A newer writer's stream: PM2.5, then a field this decoder does not know; NOx and the rest absent
+    uint8_t future[] = {'A', 'Q', RecordEncoder::VERSION, 2, FIELD_PM25, 10, 99, 0x80, 0x01,
+                        0x80, 0x90, 0x96, 0xC2, 0x0C, 0xF4, 0x03, 0x07,   // t, pm25 25.0, unknown -4
+                        0x02, 0x01, 0x02};                                 // +1 s, pm25 24.9, unknown -3
+    RecordDecoder futureDecoder(future, sizeof(future));
+    uint32_t t1 = 0, t2 = 0;
+    SensorData d1, d2;
+    bool futureOk = futureDecoder.isValid() && futureDecoder.fieldCount() == 2 && futureDecoder.next(t1, d1)
+                    && futureDecoder.next(t2, d2) && !futureDecoder.next(time, data) && !futureDecoder.hasError()
+                    && t1 == 1680000000u && t2 == t1 + 1 && d1.pm25 == 25.0f && d2.pm25 == 24.9f
+                    && isnan(d1.nox) && isnan(d2.pm1);
+    ok = report("unknown fields skipped, absent ones NaN", futureOk) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+/**
+ * @file FilterBench.cpp
+ * @brief Sample filter checks and per-reading cost by window length
+ *
+ * Checks the running median against a sorted copy of the window after
+ * every push (quantized values, so ties are common), then runs the filter
+ * with the firmware's settings over a day of noisy per-second readings:
+ * once clean, to count values it replaces for nothing, and once with
+ * single-reading PM spikes, every one of which must be replaced. A real
+ * step has to pass once it has lasted half the window, and temperature
+ * jumps have to be caught by the rate limit while a fast but physical
+ * ramp is not. Reports how far the 15-reading records move with and
+ * without the filter, and what apply() costs per reading (all eight
+ * fields) at windows from 5 to 61 next to the same test done by selecting
+ * the median and MAD from copies of each window (std::nth_element).
+ */
+
+#include "Bench.h"
+
+#include "DataAveraging.h"
+#include "SampleFilter.h"
+
+#include <Simulation.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+    const int DAY_READINGS = 86400;
+    const float SPIKE_PROBABILITY = 0.01f;
+    const int TIMING_READINGS = 200000;
+    const int RECORD_READINGS = 15;  // One record per 15 s at 1 Hz, as in the firmware
+    const int WINDOWS[] = {5, 7, 15, 31, 61};
+
+    // The firmware's FILTER_CONFIG (main.cpp)
+    const SampleFilterConfig FIRMWARE_CONFIG = {
+        7, 3.5f,
+        {1.0f, 1.0f, 1.0f, 1.0f, 0.5f, 0.2f, 2.0f, 1.0f},
+        {0.0f, 0.0f, 0.0f, 0.0f, 5.0f, 1.0f, 0.0f, 0.0f}
+    };
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    float quantize(float value, float resolution) {
+        return roundf(value / resolution) * resolution;
+    }
+
+    /** A day of readings at the sensor's resolution, PM drifting through the day */
+    std::vector<SensorData> syntheticDay(uint32_t seed) {
+        std::mt19937 random(seed);
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+        std::vector<SensorData> readings(DAY_READINGS);
+        float drift = 0.0f;
+        for (int i = 0; i < DAY_READINGS; i++) {
+            float day = (float)i / DAY_READINGS * 6.2831853f;
+            drift = 0.999f * drift + 0.05f * noise(random);
+            float pm25 = 12.0f + 8.0f * sinf(day) + 3.0f * drift + 0.6f * noise(random);
+            SensorData& r = readings[i];
+            r.pm25 = quantize(pm25 < 0.0f ? 0.0f : pm25, 0.1f);
+            r.pm1 = quantize(r.pm25 * 0.82f + 0.1f * noise(random), 0.1f);
+            r.pm4 = quantize(r.pm25 * 1.10f + 0.1f * noise(random), 0.1f);
+            r.pm10 = quantize(r.pm25 * 1.22f + 0.2f * noise(random), 0.1f);
+            r.humidity = quantize(45.0f + 6.0f * sinf(day) + 0.1f * noise(random), 0.01f);
+            r.temperature = quantize(22.0f - 2.5f * sinf(day) + 0.03f * noise(random), 0.005f);
+            r.voc = roundf(100.0f + 25.0f * sinf(day) + 1.5f * noise(random));
+            r.nox = roundf(1.5f + 0.5f * sinf(day));
+        }
+        return readings;
+    }
+
+    /** Mean absolute difference of pm2.5 between the records of two streams */
+    float recordError(const std::vector<SensorData>& readings, const std::vector<SensorData>& truth) {
+        DataAveraging a;
+        DataAveraging b;
+        double error = 0.0;
+        int records = 0;
+        for (size_t i = 0; i < readings.size(); i++) {
+            a.addReading(readings[i]);
+            b.addReading(truth[i]);
+            if (a.getCount() == RECORD_READINGS) {
+                error += fabsf(a.getAveraged().pm25 - b.getAveraged().pm25);
+                records++;
+                a.reset();
+                b.reset();
+            }
+        }
+        return records ? (float)(error / records) : 0.0f;
+    }
+
+    std::vector<SensorData> filterAll(SampleFilter& filter, const std::vector<SensorData>& readings) {
+        std::vector<SensorData> output(readings.size());
+        for (size_t i = 0; i < readings.size(); i++) {
+            output[i] = filter.apply(readings[i], (unsigned long)(i * 1000));
+        }
+        return output;
+    }
+
+    bool medianMatchesSort() {
+        std::mt19937 random(3);
+        const int LENGTHS[] = {1, 2, 3, 5, 8, 15, 31, 60, 61};
+        for (int length : LENGTHS) {
+            MedianWindow window;
+            window.reset(length);
+            std::vector<float> recent;
+            for (int i = 0; i < 20000; i++) {
+                // Few distinct values (ties), runs and jumps
+                float value = (i / 500) % 2 ? (float)(random() % 7) : (float)(random() % 1000) * 0.5f;
+                window.push(value);
+                recent.push_back(value);
+                if ((int)recent.size() > length) {
+                    recent.erase(recent.begin());
+                }
+                std::vector<float> sorted = recent;
+                std::sort(sorted.begin(), sorted.end());
+                size_t n = sorted.size();
+                float expected = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) * 0.5f;
+                if (window.median() != expected || window.size() != (int)n) {
+                    printf("  window %d, push %d: median %g, expected %g\n", length, i, window.median(), expected);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /** Per reading, ns: apply(), and the same Hampel test by selecting in copies of each window */
+    void timeWindow(int length, const std::vector<SensorData>& readings, double& filterNanos, double& selectNanos) {
+        SampleFilterConfig config = FIRMWARE_CONFIG;
+        config.window = length;
+        static SampleFilter filter(config);
+        filter.configure(config);
+        uint64_t start = hostNanos();
+        for (int i = 0; i < TIMING_READINGS; i++) {
+            SensorData out = filter.apply(readings[i % readings.size()], (unsigned long)i * 1000UL);
+            doNotOptimize(out);
+        }
+        filterNanos = (double)(hostNanos() - start) / TIMING_READINGS;
+
+        // The textbook way: keep each field's ring, select the median from a
+        // copy, then the MAD from the deviations
+        float rings[SENSOR_FIELD_COUNT][SampleFilter::MAX_WINDOW] = {};
+        float scratch[SampleFilter::MAX_WINDOW];
+        int middle = length / 2;
+        start = hostNanos();
+        for (int i = 0; i < TIMING_READINGS; i++) {
+            const SensorData& reading = readings[i % readings.size()];
+            int outliers = 0;
+            for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+                float value = reading.*SENSOR_FIELDS[f];
+                std::copy(rings[f], rings[f] + length, scratch);
+                std::nth_element(scratch, scratch + middle, scratch + length);
+                float median = scratch[middle];
+                for (int k = 0; k < length; k++) {
+                    scratch[k] = fabsf(rings[f][k] - median);
+                }
+                std::nth_element(scratch, scratch + middle, scratch + length);
+                float scale = std::max(1.4826f * scratch[middle], FIRMWARE_CONFIG.minScale[f]);
+                outliers += fabsf(value - median) > FIRMWARE_CONFIG.threshold * scale;
+                rings[f][i % length] = value;
+            }
+            doNotOptimize(outliers);
+        }
+        selectNanos = (double)(hostNanos() - start) / TIMING_READINGS;
+    }
+}
+
+int runFilterBench(const BenchOptions& options) {
+    (void)options;
+    bool ok = true;
+
+    ok = report("running median matches a sorted window", medianMatchesSort()) && ok;
+
+    // Clean day: what the filter replaces is noise it should have let through
+    std::vector<SensorData> clean = syntheticDay(11);
+    static SampleFilter filter(FIRMWARE_CONFIG);
+    filter.configure(FIRMWARE_CONFIG);
+    uint32_t replacedBefore = filter.totalOutliers() + filter.totalRateLimited();
+    std::vector<SensorData> cleanOut = filterAll(filter, clean);
+    uint32_t falseReplacements = filter.totalOutliers() + filter.totalRateLimited() - replacedBefore;
+    SimHeapStats heapBefore = SimHeap::stats();
+    for (int i = 0; i < 1000; i++) {
+        SensorData out = filter.apply(clean[i], (unsigned long)i * 1000UL);
+        doNotOptimize(out);
+    }
+    ok = report("apply() never allocates", SimHeap::stats().allocations == heapBefore.allocations) && ok;
+
+    // The same day with single-reading spikes on all PM channels
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<SensorData> spiked = clean;
+    std::vector<int> spikeAt;
+    for (int i = 1; i < DAY_READINGS; i++) {
+        if (unit(random) < SPIKE_PROBABILITY && (spikeAt.empty() || spikeAt.back() != i - 1)) {
+            float size = 20.0f + 280.0f * unit(random);
+            spiked[i].pm1 = quantize(spiked[i].pm1 + size * 0.6f, 0.1f);
+            spiked[i].pm25 = quantize(spiked[i].pm25 + size, 0.1f);
+            spiked[i].pm4 = quantize(spiked[i].pm4 + size * 1.2f, 0.1f);
+            spiked[i].pm10 = quantize(spiked[i].pm10 + size * 1.4f, 0.1f);
+            spikeAt.push_back(i);
+        }
+    }
+    filter.configure(FIRMWARE_CONFIG);
+    std::vector<SensorData> spikedOut = filterAll(filter, spiked);
+    size_t missed = 0;
+    for (int i : spikeAt) {
+        bool warm = i >= FIRMWARE_CONFIG.window;
+        if (warm && (spikedOut[i].pm25 == spiked[i].pm25 || spikedOut[i].pm10 == spiked[i].pm10)) {
+            missed++;
+        }
+    }
+    ok = report("single-reading PM spikes are all replaced", missed == 0) && ok;
+    float unfilteredError = recordError(spiked, clean);
+    float filteredError = recordError(spikedOut, clean);
+    float cleanError = recordError(cleanOut, clean);
+
+    // A lasting step is the air changing: it must come through after half the window
+    std::vector<SensorData> step(clean.begin(), clean.begin() + 600);
+    for (int i = 300; i < 600; i++) {
+        step[i].pm25 += 60.0f;
+    }
+    filter.configure(FIRMWARE_CONFIG);
+    std::vector<SensorData> stepOut = filterAll(filter, step);
+    int passesAfter = FIRMWARE_CONFIG.window / 2 + 1; // Then the window's median is on the new level
+    bool stepOk = true;
+    for (int i = 300 + passesAfter; i < 600; i++) {
+        stepOk = stepOk && stepOut[i].pm25 == step[i].pm25;
+    }
+    ok = report("a lasting step passes past half the window", stepOk) && ok;
+
+    // Temperature: a 3 °C jump for one reading is caught by the rate limit;
+    // a 0.5 °C/s rise (a heater, sunlight) gets through, late by a few readings
+    std::vector<SensorData> climate(clean.begin(), clean.begin() + 600);
+    climate[200].temperature += 3.0f;
+    for (int i = 400; i < 600; i++) {
+        climate[i].temperature += 0.5f * (i - 400 < 10 ? i - 400 : 10);
+    }
+    filter.configure(FIRMWARE_CONFIG);
+    uint32_t rateBefore = filter.getStats().rateLimited[FIELD_TEMPERATURE];
+    std::vector<SensorData> jumpOut = filterAll(filter, std::vector<SensorData>(climate.begin(), climate.begin() + 400));
+    bool jumpCaught = jumpOut[200].temperature != climate[200].temperature
+                      && filter.getStats().rateLimited[FIELD_TEMPERATURE] == rateBefore + 1;
+    filter.configure(FIRMWARE_CONFIG);
+    std::vector<SensorData> climateOut = filterAll(filter, climate);
+    bool riseKept = true;
+    for (int i = 420; i < 600; i++) {
+        riseKept = riseKept && climateOut[i].temperature == climate[i].temperature;
+    }
+    ok = report("rate limit catches a jump, not a fast rise", jumpCaught && riseKept) && ok;
+
+    printf("\n  day at 1 Hz, window %d, threshold %.1f: %zu spikes, %lu values of %lu replaced"
+           " in the clean stream (%.3f%%)\n", FIRMWARE_CONFIG.window, FIRMWARE_CONFIG.threshold, spikeAt.size(),
+           (unsigned long)falseReplacements, (unsigned long)(DAY_READINGS * SENSOR_FIELD_COUNT),
+           100.0 * falseReplacements / (DAY_READINGS * SENSOR_FIELD_COUNT));
+    printf("  pm2.5 record error against the clean day: %.3f unfiltered, %.3f filtered"
+           " (%.3f from filtering the clean day)\n", unfilteredError, filteredError, cleanError);
+    printf("  memory: %zu bytes per filter (%d-reading windows, two per field)\n", sizeof(SampleFilter),
+           SampleFilter::MAX_WINDOW);
+
+    printf("\n  per reading, all fields\n  %-10s %16s %16s\n", "window", "apply() ns", "select ns");
+    for (int length : WINDOWS) {
+        double filterNanos = 0.0;
+        double selectNanos = 0.0;
+        timeWindow(length, spiked, filterNanos, selectNanos);
+        printf("  %-10d %16.1f %16.1f\n", length, filterNanos, selectNanos);
+    }
+    return ok ? 0 : 1;
+}
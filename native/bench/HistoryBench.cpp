@@ -0,0 +1,123 @@
+/**
+ * @file HistoryBench.cpp
+ * @brief Struct-of-arrays SensorHistory vs the per-field scalar path
+ *
+ * Both sides compute mean, sample variance and min/max of every field
+ * over the newest N readings. The scalar side walks an array
+ * of SensorData records one field at a time through SENSOR_FIELDS, the
+ * way DataAveraging did before; the SoA side is SensorHistory::reduce().
+ * Windows of 20 (the upload window), 600 and 3600
+ * readings are timed and the two results are checked against each other.
+ */
+
+#include "Bench.h"
+
+#include "SensorHistory.h"
+
+#include <math.h>
+#include <stdio.h>
+
+namespace {
+    const int HISTORY_CAPACITY = 3600;
+    const int WINDOWS[] = {20, 600, 3600};
+    const int WRAP_OFFSET = 1234; // Fill past capacity so windows straddle the ring end
+    const uint64_t TARGET_READINGS = 50000000; // Readings reduced per timing run
+
+    SensorData syntheticReading(int i) {
+        SensorData r;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            r.*SENSOR_FIELDS[f] = 10.0f * (f + 1) + (float)((i * 2654435761u + f * 40503u) % 1000) * 0.01f;
+        }
+        return r;
+    }
+
+    /** Per-field scalar reduction over the newest window records of a ring. */
+    SensorStats scalarReduce(const SensorData* ring, int head, int window) {
+        SensorStats result;
+        result.count = window;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            float SensorData::* member = SENSOR_FIELDS[f];
+            float sum = 0, lo = INFINITY, hi = -INFINITY;
+            for (int i = 0, slot = head - window; i < window; i++, slot++) {
+                float v = ring[slot < 0 ? slot + HISTORY_CAPACITY : slot].*member;
+                sum += v;
+                if (v < lo) lo = v;
+                if (v > hi) hi = v;
+            }
+            float mean = sum / window;
+            float squares = 0;
+            for (int i = 0, slot = head - window; i < window; i++, slot++) {
+                float d = ring[slot < 0 ? slot + HISTORY_CAPACITY : slot].*member - mean;
+                squares += d * d;
+            }
+            result.mean.*member = mean;
+            result.variance.*member = window > 1 ? squares / (window - 1) : 0.0f;
+            result.min.*member = lo;
+            result.max.*member = hi;
+        }
+        return result;
+    }
+
+    bool close(float actual, float expected) {
+        return fabsf(actual - expected) <= 1e-4f * fabsf(expected) + 1e-4f;
+    }
+
+    bool matches(const SensorStats& soa, const SensorStats& scalar) {
+        if (soa.count != scalar.count) return false;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            float SensorData::* m = SENSOR_FIELDS[f];
+            if (!close(soa.mean.*m, scalar.mean.*m) || !close(soa.variance.*m, scalar.variance.*m)
+                || soa.min.*m != scalar.min.*m || soa.max.*m != scalar.max.*m) {
+                printf("  FAIL: field %d mean %.5f/%.5f var %.5f/%.5f min %.3f/%.3f max %.3f/%.3f\n",
+                       f, soa.mean.*m, scalar.mean.*m, soa.variance.*m, scalar.variance.*m,
+                       soa.min.*m, scalar.min.*m, soa.max.*m, scalar.max.*m);
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int runHistoryBench(const BenchOptions& options) {
+    (void)options;
+    static SensorHistory<HISTORY_CAPACITY> history;
+    static SensorData ring[HISTORY_CAPACITY];
+    history.clear();
+
+    int total = HISTORY_CAPACITY + WRAP_OFFSET;
+    for (int i = 0; i < total; i++) {
+        SensorData r = syntheticReading(i);
+        history.push(r);
+        ring[i % HISTORY_CAPACITY] = r;
+    }
+    int head = total % HISTORY_CAPACITY;
+
+    printf("  storage: %zu bytes SoA, %zu bytes AoS (%d readings)\n\n",
+           sizeof(history), sizeof(ring), HISTORY_CAPACITY);
+    printf("  %-8s %14s %14s %9s\n", "window", "scalar (ns)", "SoA (ns)", "speedup");
+
+    bool ok = true;
+    for (int window : WINDOWS) {
+        int repeats = (int)(TARGET_READINGS / (uint64_t)window);
+
+        uint64_t start = hostNanos();
+        for (int r = 0; r < repeats; r++) {
+            SensorStats scalar = scalarReduce(ring, head, window);
+            doNotOptimize(scalar);
+        }
+        double scalarNanos = (double)(hostNanos() - start) / repeats;
+
+        start = hostNanos();
+        for (int r = 0; r < repeats; r++) {
+            SensorStats stats = history.reduce(window);
+            doNotOptimize(stats);
+        }
+        double soaNanos = (double)(hostNanos() - start) / repeats;
+
+        printf("  %-8d %14.1f %14.1f %8.2fx\n", window, scalarNanos, soaNanos, scalarNanos / soaNanos);
+        ok = ok && matches(history.reduce(window), scalarReduce(ring, head, window));
+    }
+
+    printf("\n  SoA results match scalar path: %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
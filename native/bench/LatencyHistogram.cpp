@@ -0,0 +1,42 @@
+/**
+ * @file LatencyHistogram.cpp
+ * @brief Fixed-size log-linear histogram used by the benchmark reports
+ */
+
+#include "Bench.h"
+
+int LatencyHistogram::bucketFor(uint64_t value) {
+    if (value < (1u << SUB_BUCKET_BITS)) return (int)value;
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - SUB_BUCKET_BITS;
+    int sub = (int)((value >> shift) & ((1u << SUB_BUCKET_BITS) - 1));
+    return ((shift + 1) << SUB_BUCKET_BITS) + sub;
+}
+
+uint64_t LatencyHistogram::lowerBound(int bucket) {
+    if (bucket < (1 << SUB_BUCKET_BITS)) return (uint64_t)bucket;
+    int shift = (bucket >> SUB_BUCKET_BITS) - 1;
+    uint64_t sub = (uint64_t)(bucket & ((1 << SUB_BUCKET_BITS) - 1));
+    return ((1ULL << SUB_BUCKET_BITS) | sub) << shift;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    buckets[bucketFor(value)]++;
+    total++;
+    sum += value;
+    if (value > maxValue) maxValue = value;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (double)(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint64_t bound = lowerBound(i);
+            return bound < maxValue ? bound : maxValue;
+        }
+    }
+    return maxValue;
+}
@@ -0,0 +1,279 @@
+/**
+ * @file LogBench.cpp
+ * @brief Deferred logger: formatting check, ring stress and hot-path cost
+ *
+ * Checks that:
+ *   - Logger::format() renders records exactly as snprintf() renders the
+ *     same format with the same arguments (the status line, floats,
+ *     negative codes, static strings, hex and %%), converts arguments
+ *     whose type does not match the conversion, marks missing arguments
+ *     and truncates at the buffer size;
+ *   - the lock-free MpscQueue under three producer threads and a consumer
+ *     delivers every item exactly once, in per-producer order, untorn,
+ *     and counts every rejected push as dropped;
+ *   - every message a started logger accepted is printed by its task.
+ * It also compares what the per-sample status line costs the caller when
+ * filtered out, when queued, and when printed inline with Serial.print as
+ * loop() used to (host CPU only; the UART wait comes on top on the device).
+ */
+
+#include "Bench.h"
+
+#include <Arduino.h>
+#include <Simulation.h>
+
+#include "Logger.h"
+#include "MpscQueue.h"
+#include "SensorData.h"
+
+#include <stdio.h>
+
+#include <thread>
+
+namespace {
+    const int PRODUCERS = 3;
+    const uint32_t ITEMS_PER_PRODUCER = 1000000;
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    template <typename... Args>
+    LogRecord makeRecord(LogEvent event, Args... args) {
+        const LogArg values[] = {LogArg(args)...};
+        LogRecord record;
+        memset(&record, 0, sizeof(record));
+        record.level = LOG_LEVEL_INFO;
+        record.event = (uint8_t)event;
+        record.argCount = (uint8_t)sizeof...(Args);
+        for (size_t i = 0; i < sizeof...(Args); i++) {
+            record.args[i] = values[i].value;
+            record.types |= (uint32_t)values[i].type << (2 * i);
+        }
+        return record;
+    }
+
+    // Matches snprintf() with the event's own format and the same arguments
+    template <typename... Args>
+    bool formatsLike(LogEvent event, Args... args) {
+        char expected[Logger::LINE_BYTES];
+        char actual[Logger::LINE_BYTES];
+        snprintf(expected, sizeof(expected), Logger::formatOf(event), args...);
+        Logger::format(makeRecord(event, args...), actual, sizeof(actual));
+        if (strcmp(expected, actual) != 0) {
+            printf("    expected \"%s\"\n    got      \"%s\"\n", expected, actual);
+            return false;
+        }
+        return true;
+    }
+
+    bool formatsAs(const LogRecord& record, size_t size, const char* expected) {
+        char actual[Logger::LINE_BYTES];
+        size_t length = Logger::format(record, actual, size);
+        if (strcmp(expected, actual) != 0 || length != strlen(expected)) {
+            printf("    expected \"%s\"\n    got      \"%s\"\n", expected, actual);
+            return false;
+        }
+        return true;
+    }
+
+    bool checkFormat() {
+        bool ok = formatsLike(LOG_SAMPLE, 9.74f, 11.95f, "🟢", "GOOD", 13.2f, 14.7f, 22.04f, 44.9f, 99, 2,
+                              3u, 15u, 14u, 1u, 8u);
+        ok = formatsLike(LOG_RECORD_AVERAGED, 15u, 11.4f, 12.5f, 0.3125f) && ok;
+        ok = formatsLike(LOG_UPLOAD_HTTP_ERROR, -3, "connection lost") && ok;
+        ok = formatsLike(LOG_WIFI_RETRY, 4u, 201u, 8.6f) && ok;
+        ok = formatsLike(LOG_WIFI_CONNECTED, 1u, "attempt", 192u, 168u, 1u, 100u) && ok;
+        ok = formatsLike(LOG_OTA_PROGRESS, 40u) && ok;
+        ok = formatsLike(LOG_SENSOR_READ_ERROR, 0x10Fu) && ok;
+        report("records format like snprintf()", ok);
+
+        bool edge = formatsAs(makeRecord(LOG_RECORD_COLLECTING, 3.7f, -1), Logger::LINE_BYTES,
+                              "\n⏳ Collecting more samples (3/4294967295) before the next record...");
+        edge = formatsAs(makeRecord(LOG_WIFI_RETRY, 2u, 7u, 3), Logger::LINE_BYTES,
+                         "⟳ WiFi attempt 2 failed (reason 7), retrying in 3.0 s") && edge;
+        edge = formatsAs(makeRecord(LOG_UPLOAD_HTTP_ERROR, 404), Logger::LINE_BYTES,
+                         "✗ HTTP Error Code: 404\nError: ?") && edge;
+        edge = formatsAs(makeRecord(LOG_UPLOAD_TIMING, 12u, 345u), 14, "Connect: 12 m") && edge;
+        return report("mismatched, missing args and truncation", edge) && ok;
+    }
+
+    struct Item {
+        uint32_t producer;
+        uint32_t sequence;
+        uint32_t check;  // Derived from the other two; catches torn items
+    };
+
+    uint32_t checkOf(uint32_t producer, uint32_t sequence) {
+        return (sequence * 2654435761u) ^ (producer << 28);
+    }
+
+    bool checkStress() {
+        static MpscQueue<Item, 64> queue;
+        uint64_t fullSpins[PRODUCERS] = {};
+        uint32_t next[PRODUCERS] = {};
+        uint32_t errors = 0;
+        uint32_t received = 0;
+        const uint32_t total = PRODUCERS * ITEMS_PER_PRODUCER;
+
+        uint64_t start = hostNanos();
+        std::thread producers[PRODUCERS];
+        std::thread consumer;
+        {
+            // Thread start-up state is allocated here and freed on the worker threads
+            SimHeap::Untracked untracked;
+            for (int p = 0; p < PRODUCERS; p++) {
+                producers[p] = std::thread([&fullSpins, p] {
+                    for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; i++) {
+                        Item item = {(uint32_t)p, i, checkOf((uint32_t)p, i)};
+                        while (!queue.push(item)) {
+                            fullSpins[p]++;
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            }
+            consumer = std::thread([&next, &errors, &received, total] {
+                Item item;
+                while (received < total) {
+                    if (!queue.pop(item)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    if (item.producer >= (uint32_t)PRODUCERS || item.sequence != next[item.producer]
+                        || item.check != checkOf(item.producer, item.sequence)) {
+                        errors++;
+                    } else {
+                        next[item.producer]++;
+                    }
+                    received++;
+                }
+            });
+        }
+        for (int p = 0; p < PRODUCERS; p++) producers[p].join();
+        consumer.join();
+        double nanos = (double)(hostNanos() - start) / total;
+
+        uint64_t spins = 0;
+        for (int p = 0; p < PRODUCERS; p++) spins += fullSpins[p];
+        printf("  %d producers: %u items, %.1f ns/item, full %llu times\n", PRODUCERS, (unsigned)received,
+               nanos, (unsigned long long)spins);
+        bool ok = errors == 0 && received == total && queue.isEmpty() && !queue.headReady()
+                  && queue.getDropped() == spins;
+        return report("MPSC ring: ordered per producer, none lost", ok);
+    }
+
+    // Counts what it is given; stands in for the UART so only formatting is timed
+    class NullPrint : public Print {
+    public:
+        using Print::write;
+        size_t write(const uint8_t* buffer, size_t size) override {
+            (void)buffer;
+            bytes += size;
+            return size;
+        }
+        uint64_t bytes = 0;
+    };
+
+    // loop()'s status line as it was printed before the logger
+    void printInline(Print& out, const SensorData& r, int count) {
+        out.print("PM1.0:");
+        out.print(r.pm1, 1);
+        out.print(" | PM2.5:");
+        out.print(r.pm25, 1);
+        out.print(" µg/m³ ");
+        out.print("🟢");
+        out.print(" [");
+        out.print("GOOD");
+        out.print("] | PM4:");
+        out.print(r.pm4, 1);
+        out.print(" | PM10:");
+        out.print(r.pm10, 1);
+        out.print(" | Temp:");
+        out.print(r.temperature, 1);
+        out.print("°C | Hum:");
+        out.print(r.humidity, 1);
+        out.print("% | VOC:");
+        out.print((int)r.voc);
+        out.print(" | NOx:");
+        out.print((int)r.nox);
+        out.print(" | Avg:");
+        out.print(count);
+        out.print("/");
+        out.print(15);
+        out.print(" | Record in ");
+        out.print(7);
+        out.print("s");
+        out.print(" | Batch:");
+        out.print(3);
+        out.print("/");
+        out.print(8);
+        out.println();
+    }
+
+    void logSample(Logger& logger, const SensorData& r, int count) {
+        logger.debug(LOG_SAMPLE, r.pm1, r.pm25, "🟢", "GOOD", r.pm4, r.pm10, r.temperature, r.humidity,
+                     (int)r.voc, (int)r.nox, count, 15, 7u, 3, 8);
+    }
+
+    bool measureCost() {
+        static Logger logger;
+        const int BATCH = 32;  // Half the ring; the log task drains between batches
+        const int BATCHES = 2000;
+        SensorData r = {9.7f, 11.9f, 13.2f, 14.7f, 44.9f, 22.0f, 99.0f, 2.0f};
+
+        logger.setLevel(LOG_LEVEL_INFO);
+        uint64_t start = hostNanos();
+        for (int i = 0; i < BATCHES * BATCH; i++) logSample(logger, r, i & 15);
+        double filtered = (double)(hostNanos() - start) / (BATCHES * BATCH);
+
+        logger.setLevel(LOG_LEVEL_DEBUG);
+        logger.start(0, 1);
+        uint64_t queuedNanos = 0;
+        for (int b = 0; b < BATCHES; b++) {
+            start = hostNanos();
+            for (int i = 0; i < BATCH; i++) logSample(logger, r, i & 15);
+            queuedNanos += hostNanos() - start;
+            logger.flush(1000); // Log task catches up (simulated time, UART-bound if Serial is begun)
+        }
+        double queued = (double)queuedNanos / (BATCHES * BATCH);
+        LoggerStats stats = logger.getStats();
+        double lineBytes = stats.printed ? (double)stats.bytes / stats.printed : 0.0;
+
+        LogRecord record = makeRecord(LOG_SAMPLE, r.pm1, r.pm25, "🟢", "GOOD", r.pm4, r.pm10, r.temperature,
+                                      r.humidity, (int)r.voc, (int)r.nox, 3, 15, 7u, 3, 8);
+        char line[Logger::LINE_BYTES];
+        start = hostNanos();
+        for (int i = 0; i < BATCHES; i++) {
+            record.args[10].i = i & 15;
+            doNotOptimize(Logger::format(record, line, sizeof(line)));
+        }
+        double formatted = (double)(hostNanos() - start) / BATCHES;
+
+        NullPrint uart;
+        start = hostNanos();
+        for (int i = 0; i < BATCHES; i++) printInline(uart, r, i & 15);
+        double inlined = (double)(hostNanos() - start) / BATCHES;
+
+        // What the caller waited for with inline printing on the device: all but a FIFO's worth
+        double uartWaitMs = lineBytes > 128 ? (lineBytes - 128) * 10.0 / 115200.0 * 1e3 : 0.0;
+        printf("\n  status line (%.0f bytes), cost to the caller:\n", lineBytes);
+        printf("    filtered out          %8.1f ns\n", filtered);
+        printf("    queued as a record    %8.1f ns\n", queued);
+        printf("    inline Serial.print   %8.1f ns + %.1f ms UART wait at 115200 baud\n", inlined, uartWaitMs);
+        printf("  log task: format %.1f ns per line, ring max %lu / %lu\n", formatted,
+               (unsigned long)stats.maxDepth, (unsigned long)Logger::CAPACITY);
+
+        return report("every queued message printed", stats.dropped == 0
+                      && stats.printed == (uint32_t)(BATCHES * BATCH));
+    }
+}
+
+int runLogBench(const BenchOptions& options) {
+    (void)options;
+    bool ok = checkFormat();
+    ok = checkStress() && ok;
+    ok = measureCost() && ok;
+    return ok ? 0 : 1;
+}
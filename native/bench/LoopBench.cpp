@@ -0,0 +1,431 @@
+/**
+ * @file LoopBench.cpp
+ * @brief End-to-end benchmark of the firmware's setup()/loop()
+ *
+ * Runs the real main.cpp against the simulated SEN55, WiFi link and
+ * ThingSpeak server for a configurable span of virtual time and reports,
+ * per loop() iteration class:
+ *   - host CPU time (what the code itself costs),
+ *   - simulated blocking time (delays and modelled I/O the device waits on),
+ *   - heap allocations,
+ * plus the sensor sample interval, taken on the acquisition task's clock
+ * (gaps would show up if anything held the sensor task back), how far
+ * loop() let the sample queue fill, duplicate and missed measurements as
+ * the firmware counts them and as the sensor model knows them, the values
+ * the sample filter replaced (--spikes injects PM spikes for it), what the
+ * deferred logger queued and printed, how much of the time the chip
+ * could spend in light sleep and how often tasks and the chip woke up
+ * (--performance compares POWER_PERFORMANCE), how often loop() woke and what
+ * each scheduler job cost (runs, start delay, run time, and overruns:
+ * periods skipped while an upload held loop()), upload throughput,
+ * offline-queue flash traffic and UART volume and wait per simulated hour
+ * (Serial.write blocks once the modelled 128-byte TX FIFO is full;
+ * --log-level 0 turns logging off for comparison). Fails if ThingSpeak
+ * receives malformed or out-of-order entries (--mqtt uploads to the MQTT
+ * broker stand-in instead and reports its session, duplicates and PUBACK
+ * latency), if samples or log messages
+ * are dropped, or if data-ready reads see a duplicate or miss a
+ * measurement (--fixed-interval shows the timer they replaced). The
+ * firmware's own /metrics body is rendered at the end, summarized and
+ * checked against the Prometheus text format.
+ *
+ * --record-trace FILE writes the firmware's field trace (TraceRecorder, as
+ * TRACE_SERIAL lines) of the run to FILE. --replay FILE plays a trace, from
+ * a device or an earlier run, back instead of the sensor model, outages and
+ * server (see TraceBench.cpp) until the trace ends, and fails unless the
+ * firmware averages the same records out of it.
+ *
+ * The firmware keeps its state in globals, so this suite can run once per
+ * process.
+ */
+
+#include "Bench.h"
+
+#include <Arduino.h>
+#include <ArduinoOTA.h>
+#include <Simulation.h>
+#include <WiFi.h>
+
+#include "DashboardServer.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "MqttPublisher.h"
+#include "PowerManager.h"
+#include "RecordUploader.h"
+#include "Scheduler.h"
+#include "SampleFilter.h"
+#include "SensorTask.h"
+#include "TraceRecorder.h"
+#include "UploadQueue.h"
+#include "UploadSession.h"
+
+#include <stdio.h>
+
+void setup();
+void loop();
+extern UploadQueue uploadQueue;
+extern UploadSession thingSpeakSession;
+extern MqttPublisher mqttPublisher;
+extern RecordUploader mqttUploader;
+extern RecordUploader* uploader;
+extern SampleQueue sampleQueue;
+extern SensorTask sensorTask;
+extern Scheduler scheduler;
+extern PowerManager power;
+extern MetricHistogram loopLatency;
+extern MetricHistogram uploadLatency;
+extern SampleFilter sampleFilter;
+extern TraceRecorder trace;
+extern TraceSink traceSink;
+size_t serveMetrics(const char* query, char* body, size_t capacity, void*);
+
+namespace {
+    const char* THINGSPEAK_HOST = "api.thingspeak.com";
+    const char* MQTT_HOST = "mqtt.local";
+    const uint64_t LOOP_OVERHEAD_US = 50; // Floor per iteration when loop() never waits
+    const double UART_BYTES_PER_SECOND = 115200.0 / 10.0; // 8N1 framing
+
+    enum IterationClass { IDLE, SAMPLE, UPLOAD, CLASS_COUNT };
+    const char* CLASS_NAMES[CLASS_COUNT] = {"idle", "sample", "upload"};
+
+    struct ClassProfile {
+        LatencyHistogram hostNanos;
+        LatencyHistogram simMicros;
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+    };
+
+    // Sensor cadence: time between successive reads (1000 ms when nothing holds the sensor task back)
+    LatencyHistogram sampleInterval;
+    uint64_t lastReadUs = 0;
+    uint64_t lateSamples = 0;
+
+    void recordRead() {
+        uint64_t readUs = SimClock::nowMicros();
+        if (lastReadUs) {
+            uint64_t gapUs = readUs - lastReadUs;
+            sampleInterval.record(gapUs);
+            if (gapUs > 1500000) lateSamples++;
+        }
+        lastReadUs = readUs;
+    }
+
+    void printRow(const char* label, const ClassProfile* profiles, double (*value)(const ClassProfile&)) {
+        printf("  %-24s", label);
+        for (int c = 0; c < CLASS_COUNT; c++) printf(" %12.2f", value(profiles[c]));
+        printf("\n");
+    }
+}
+
+int runLoopBench(const BenchOptions& options) {
+    static FakeThingSpeak server(nullptr);
+    // Outlives the firmware's globals: mqttPublisher's socket closes at exit
+    static FakeMqttBroker& broker = *new FakeMqttBroker();
+    static bool started = false;
+    if (started) {
+        printf("  (skipped: firmware globals already initialised in this process)\n");
+        return 0;
+    }
+    started = true;
+
+    Serial.setEcho(options.echoSerial);
+    SimSensor::config().seed = options.seed;
+    SimSensor::config().spikeProbability = options.spikeProbability;
+    SimSensor::config().clockErrorPpm = options.sensorClockPpm;
+    SimNet::config().failureProbability = options.netFailure;
+    SimNet::config().idleTimeoutMillis = options.serverIdleSeconds * 1000U;
+    std::string replayBlocks;
+    ReplayPlan plan;
+    if (options.replayPath) {
+        if (!readTraceFile(options.replayPath, replayBlocks)
+            || !prepareReplay(replayBlocks, THINGSPEAK_HOST, plan)) {
+            printf("  FAIL: no sensor reads in trace %s\n", options.replayPath);
+            return 1;
+        }
+    } else {
+        SimNet::registerHost(THINGSPEAK_HOST, &server);
+    }
+    if (options.recordTracePath || options.replayPath) {
+        trace.setOutput(traceCapture());
+        traceSink = TRACE_SERIAL;
+    }
+    if (options.fixedIntervalReads) sensorTask.setMode(ACQUIRE_INTERVAL);
+    if (options.performancePower) power.setMode(POWER_PERFORMANCE);
+    if (options.mqtt || plan.mqtt) {
+        SimNet::registerStreamHost(MQTT_HOST, &broker);
+        mqttPublisher.setServer(MQTT_HOST, 1883);
+        uploader = &mqttUploader;
+    }
+
+    uint64_t endUs = (uint64_t)(options.hours * 3600.0 * 1e6);
+    if (options.outageEveryMin > 0 && !options.replayPath) {
+        uint64_t periodMs = (uint64_t)options.outageEveryMin * 60000ULL;
+        for (uint64_t t = periodMs; t * 1000ULL < endUs; t += periodMs) {
+            SimWiFi::addOutage(t, (uint64_t)options.outageSeconds * 1000ULL);
+        }
+    }
+
+    uint64_t setupHostStart = hostNanos();
+    setup();
+    if (options.logLevel >= 0) Log.setLevel((LogLevel)options.logLevel);
+    uint64_t setupHostNanos = hostNanos() - setupHostStart;
+    uint64_t setupSimMillis = millis();
+
+    ClassProfile profiles[CLASS_COUNT];
+    SimHeap::resetPeak();
+    SimHeapStats heapStart = SimHeap::stats();
+    SimNetStats netStart = SimNet::stats();
+    UploadSessionStats sessionStart = thingSpeakSession.getStats();
+    FakeThingSpeakStats serverStart = server.stats();
+    SimFlashStats flashStart = SimFlash::stats();
+    uint64_t serialStart = Serial.bytesWritten();
+    uint64_t uartWaitStart = Serial.blockedMicros();
+    LoggerStats logStart = Log.getStats();
+    SimSensorStats sensorStart = SimSensor::stats();
+    uint64_t simStart = SimClock::nowMicros();
+    uint64_t switchesStart = SimTasks::switches();
+    uint64_t wakeupsStart = SimTasks::wakeups();
+    SimPowerStats powerStart = SimPower::stats();
+    PowerStats loopPowerStart = power.getStats();
+    endUs = options.replayPath ? plan.endMillis * 1000ULL : endUs + simStart;
+    SimSensor::setReadHook(recordRead);
+
+    while (SimClock::nowMicros() < endUs) {
+        uint32_t consumed = sampleQueue.popped();
+        // Publishes count too; HTTP bytes only ever go out with a request
+        uint64_t requests = SimNet::stats().requests + SimNet::stats().failedConnects + SimNet::stats().bytesSent;
+        SimHeapStats heapBefore = SimHeap::stats();
+        uint64_t simBefore = SimClock::nowMicros();
+
+        uint64_t hostBefore = hostNanos();
+        loop();
+        uint64_t hostElapsed = hostNanos() - hostBefore;
+
+        if (SimClock::nowMicros() == simBefore) SimClock::advanceMicros(LOOP_OVERHEAD_US);
+        SimHeapStats heapAfter = SimHeap::stats();
+
+        IterationClass cls = IDLE;
+        if (SimNet::stats().requests + SimNet::stats().failedConnects + SimNet::stats().bytesSent != requests) {
+            cls = UPLOAD;
+        } else if (sampleQueue.popped() != consumed) {
+            cls = SAMPLE;
+        }
+
+        ClassProfile& profile = profiles[cls];
+        profile.hostNanos.record(hostElapsed);
+        profile.simMicros.record(SimClock::nowMicros() - simBefore);
+        profile.allocations += heapAfter.allocations - heapBefore.allocations;
+        profile.allocatedBytes += heapAfter.bytesAllocated - heapBefore.bytesAllocated;
+    }
+
+    SimSensor::setReadHook(nullptr);
+    trace.flush();
+    SimSensorStats sensorEnd = SimSensor::stats();
+    double simHours = (double)(SimClock::nowMicros() - simStart) / 3.6e9;
+    SimHeapStats heapEnd = SimHeap::stats();
+    SimNetStats netEnd = SimNet::stats();
+    UploadSessionStats sessionEnd = thingSpeakSession.getStats();
+    FakeThingSpeakStats serverEnd = server.stats();
+    SimFlashStats flashEnd = SimFlash::stats();
+    LoggerStats logEnd = Log.getStats();
+    SimPowerStats powerEnd = SimPower::stats();
+    PowerStats loopPowerEnd = power.getStats();
+
+    printf("  simulated %.2f h after setup (setup: %llu ms simulated, %.2f ms host; first valid sample"
+           " at %lu ms after %lu warm-up reads)\n\n", simHours, (unsigned long long)setupSimMillis,
+           setupHostNanos / 1e6, (unsigned long)sensorTask.getStats().firstValidMs,
+           (unsigned long)sensorTask.getStats().warmupReads);
+
+    printf("  %-24s %12s %12s %12s\n", "per iteration", CLASS_NAMES[IDLE], CLASS_NAMES[SAMPLE], CLASS_NAMES[UPLOAD]);
+    printRow("count", profiles, [](const ClassProfile& p) { return (double)p.hostNanos.count(); });
+    printRow("host p50 (us)", profiles, [](const ClassProfile& p) { return p.hostNanos.percentile(0.50) / 1e3; });
+    printRow("host p99 (us)", profiles, [](const ClassProfile& p) { return p.hostNanos.percentile(0.99) / 1e3; });
+    printRow("host max (us)", profiles, [](const ClassProfile& p) { return p.hostNanos.max() / 1e3; });
+    printRow("blocked p50 (ms)", profiles, [](const ClassProfile& p) { return p.simMicros.percentile(0.50) / 1e3; });
+    printRow("blocked max (ms)", profiles, [](const ClassProfile& p) { return p.simMicros.max() / 1e3; });
+    printRow("allocations / iter", profiles, [](const ClassProfile& p) {
+        return p.hostNanos.count() ? (double)p.allocations / (double)p.hostNanos.count() : 0.0;
+    });
+    printRow("alloc bytes / iter", profiles, [](const ClassProfile& p) {
+        return p.hostNanos.count() ? (double)p.allocatedBytes / (double)p.hostNanos.count() : 0.0;
+    });
+
+    printf("\n  sample interval: p50 %.0f ms, p99 %.0f ms, max %.0f ms, %llu gaps over 1.5 s\n",
+           sampleInterval.percentile(0.50) / 1e3, sampleInterval.percentile(0.99) / 1e3,
+           sampleInterval.max() / 1e3, (unsigned long long)lateSamples);
+    const SensorTaskStats& acquisition = sensorTask.getStats();
+    printf("  sensor task (%s): %lu reads, %lu errors, %.1f data-ready polls / read,"
+           " %lu duplicates, %lu missed\n",
+           options.fixedIntervalReads ? "1 s timer" : "data-ready",
+           (unsigned long)acquisition.reads, (unsigned long)acquisition.readErrors,
+           acquisition.reads ? (double)acquisition.readyPolls / acquisition.reads : 0.0,
+           (unsigned long)acquisition.duplicates, (unsigned long)acquisition.missed);
+    uint64_t duplicateReads = sensorEnd.duplicateReads - sensorStart.duplicateReads;
+    uint64_t missedSamples = sensorEnd.missedSamples - sensorStart.missedSamples;
+    printf("  sensor model (%+d ppm clock): %llu duplicate reads, %llu measurements never read\n",
+           (int)SimSensor::config().clockErrorPpm, (unsigned long long)duplicateReads,
+           (unsigned long long)missedSamples);
+    const SampleFilterStats& filter = sampleFilter.getStats();
+    printf("  sample filter (median of %d): %lu readings, outliers replaced pm2.5 %lu / pm10 %lu / all fields %lu,"
+           " %lu rate-limited\n", sampleFilter.getConfig().window, (unsigned long)filter.readings,
+           (unsigned long)filter.outliers[FIELD_PM25], (unsigned long)filter.outliers[FIELD_PM10],
+           (unsigned long)sampleFilter.totalOutliers(), (unsigned long)sampleFilter.totalRateLimited());
+    printf("  sample queue: max %lu / %lu, %lu dropped, sensor task woke up to %lu ms late"
+           " (%llu task switches)\n",
+           (unsigned long)acquisition.maxDepth, (unsigned long)sampleQueue.capacity(),
+           (unsigned long)sampleQueue.getDropped(), (unsigned long)acquisition.maxLateMs,
+           (unsigned long long)(SimTasks::switches() - switchesStart));
+    printf("  logger (level %d): %lu messages printed, %lu dropped, ring max %lu / %lu\n",
+           (int)Log.getLevel(), (unsigned long)(logEnd.printed - logStart.printed),
+           (unsigned long)(logEnd.dropped - logStart.dropped), (unsigned long)logEnd.maxDepth,
+           (unsigned long)Logger::CAPACITY);
+
+    double perHour = simHours > 0 ? 1.0 / simHours : 0.0;
+    uint64_t passes = 0;
+    for (int c = 0; c < CLASS_COUNT; c++) passes += profiles[c].hostNanos.count();
+    double simSeconds = simHours * 3600.0;
+    printf("  loop(): %.1f passes/s, %.1f wakeups/s (%.1f by samples), idle %.1f%%\n", passes / simSeconds,
+           (loopPowerEnd.wakeups - loopPowerStart.wakeups) / simSeconds,
+           (loopPowerEnd.notified - loopPowerStart.notified) / simSeconds,
+           PowerManager::idlePercent(loopPowerStart, loopPowerEnd));
+    double accounted = (double)(powerEnd.accountedMicros - powerStart.accountedMicros);
+    printf("  power (%s, light sleep %s): tasks idle %.1f%%, light sleep %.1f%% in %.1f sleeps/s"
+           ", %.1f task wakeups/s\n", power.getMode() == POWER_LOW ? "low" : "performance",
+           SimPower::lightSleepEnabled() ? "on" : "off",
+           accounted > 0 ? 100.0 * (powerEnd.idleMicros - powerStart.idleMicros) / accounted : 0.0,
+           accounted > 0 ? 100.0 * (powerEnd.lightSleepMicros - powerStart.lightSleepMicros) / accounted : 0.0,
+           (powerEnd.lightSleeps - powerStart.lightSleeps) / simSeconds,
+           (SimTasks::wakeups() - wakeupsStart) / simSeconds);
+    printf("  %-24s %10s %10s %12s %12s %12s\n", "scheduler job", "runs", "overruns", "max late ms",
+           "avg run us", "max run us");
+    for (int id = 0; id < Scheduler::MAX_JOBS; id++) {
+        if (!scheduler.jobName(id)) continue;
+        const SchedulerJobStats& job = scheduler.jobStats(id);
+        printf("  %-24s %10lu %10lu %12lu %12.1f %12lu\n", scheduler.jobName(id), (unsigned long)job.runs,
+               (unsigned long)job.overruns, (unsigned long)job.maxLateMs,
+               job.runs ? (double)job.totalRunUs / job.runs : 0.0, (unsigned long)job.maxRunUs);
+    }
+
+    printf("\n  per simulated hour\n");
+    printf("  %-24s %12.1f\n", "sensor reads", (sensorEnd.reads - sensorStart.reads) * perHour);
+    printf("  %-24s %12.1f\n", "HTTP requests", (netEnd.requests - netStart.requests) * perHour);
+    printf("  %-24s %12.1f\n", "TCP connects", (netEnd.connects - netStart.connects) * perHour);
+    printf("  %-24s %12.1f\n", "failed connects", (netEnd.failedConnects - netStart.failedConnects) * perHour);
+    printf("  %-24s %12.1f\n", "entries accepted", (serverEnd.accepted - serverStart.accepted) * perHour);
+    uint64_t bulkRequests = serverEnd.bulkRequests - serverStart.bulkRequests;
+    printf("  %-24s %12.1f\n", "bulk requests", bulkRequests * perHour);
+    printf("  %-24s %12.1f\n", "entries / request",
+           bulkRequests ? (double)(serverEnd.accepted - serverStart.accepted) / bulkRequests : 0.0);
+    printf("  %-24s %12.1f\n", "rate-limited", (serverEnd.rateLimited - serverStart.rateLimited) * perHour);
+    printf("  %-24s %12.1f\n", "backfilled entries", (serverEnd.backfilled - serverStart.backfilled) * perHour);
+    printf("  %-24s %12.1f\n", "flash bytes written", (flashEnd.bytesWritten - flashStart.bytesWritten) * perHour);
+    printf("  %-24s %12.1f\n", "flash files removed", (flashEnd.removes - flashStart.removes) * perHour);
+    printf("  %-24s %12.1f\n", "bytes sent", (netEnd.bytesSent - netStart.bytesSent) * perHour);
+    printf("  %-24s %12.1f\n", "bytes received", (netEnd.bytesReceived - netStart.bytesReceived) * perHour);
+    printf("  %-24s %12.1f\n", "serial bytes", (Serial.bytesWritten() - serialStart) * perHour);
+    printf("  %-24s %12.1f\n", "UART busy (s)", (Serial.bytesWritten() - serialStart) * perHour / UART_BYTES_PER_SECOND);
+    printf("  %-24s %12.1f\n", "UART FIFO waits (s)", (Serial.blockedMicros() - uartWaitStart) * perHour / 1e6);
+    printf("  %-24s %12.1f\n", "heap allocations", (heapEnd.allocations - heapStart.allocations) * perHour);
+
+    printf("\n  heap: %llu bytes live, %llu bytes peak, %llu OTA handle() calls\n",
+           (unsigned long long)heapEnd.liveBytes, (unsigned long long)heapEnd.peakLiveBytes,
+           (unsigned long long)ArduinoOTA.handleCount());
+    // Everything below the smallest "largest free block" was either live or a stranded hole
+    uint32_t extent = SimHeap::HEAP_SIZE - heapEnd.minLargestFreeBlock;
+    printf("  heap fragmentation: largest free block %lu now / %lu min, worst extent %lu bytes"
+           " for %llu bytes peak live (%.0f%% overhead)\n",
+           (unsigned long)heapEnd.largestFreeBlock, (unsigned long)heapEnd.minLargestFreeBlock,
+           (unsigned long)extent, (unsigned long long)heapEnd.peakLiveBytes,
+           heapEnd.peakLiveBytes ? 100.0 * ((double)extent / heapEnd.peakLiveBytes - 1.0) : 0.0);
+    uint32_t sessionRequests = sessionEnd.requests - sessionStart.requests;
+    double perRequest = sessionRequests ? 1.0 / sessionRequests / 1e3 : 0.0;
+    printf("  upload session: %lu requests, %lu reused, %lu stale retries"
+           ", connect %.1f ms + transfer %.1f ms per request\n",
+           (unsigned long)sessionRequests, (unsigned long)(sessionEnd.reused - sessionStart.reused),
+           (unsigned long)(sessionEnd.staleRetries - sessionStart.staleRetries),
+           (sessionEnd.connectMicros - sessionStart.connectMicros) * perRequest,
+           (sessionEnd.transferMicros - sessionStart.transferMicros) * perRequest);
+    if (options.mqtt || plan.mqtt) {
+        const MqttStats& mqtt = mqttPublisher.getStats();
+        const FakeMqttBrokerStats& brokerStats = broker.stats();
+        const MetricHistogram& ackLatency = mqttPublisher.getAckLatency();
+        printf("  mqtt: %lu publishes, %lu records, %lu connects (%lu resumed), %lu retransmits, %lu pings"
+               ", PUBACK p50 %lu / p99 %lu ms; broker: %llu records, %llu duplicates\n",
+               (unsigned long)mqtt.published, (unsigned long)mqtt.records, (unsigned long)mqtt.connects,
+               (unsigned long)mqtt.sessionsResumed, (unsigned long)mqtt.retransmits, (unsigned long)mqtt.pings,
+               (unsigned long)(ackLatency.percentile(0.5f) / 1000), (unsigned long)(ackLatency.percentile(0.99f) / 1000),
+               (unsigned long long)brokerStats.records, (unsigned long long)brokerStats.duplicates);
+    }
+    SimWiFiStats wifi = SimWiFi::stats();
+    printf("  wifi: %llu attempts, %llu failed, %llu link drops, %llu events\n",
+           (unsigned long long)wifi.attempts, (unsigned long long)wifi.failedAttempts,
+           (unsigned long long)wifi.disconnects, (unsigned long long)wifi.events);
+    const UploadQueueStats& queue = uploadQueue.getStats();
+    printf("  offline queue: %lu queued, %lu drained, %lu dropped, %lu corrupt, %lu still waiting\n",
+           (unsigned long)queue.appended, (unsigned long)queue.drained, (unsigned long)queue.dropped,
+           (unsigned long)queue.corrupt, (unsigned long)uploadQueue.size());
+    static char metricsBody[DashboardServer::QUERY_RESPONSE_BYTES - DashboardServer::QUERY_HEADER_ROOM];
+    size_t metricsLength = serveMetrics("", metricsBody, sizeof(metricsBody), nullptr);
+    const MetricHistogram& readLatency = sensorTask.getReadLatency();
+    printf("  metrics (simulated time): loop p50 %lu / p99 %lu / max %lu us, sensor read p99 %lu us,"
+           " upload p99 %lu ms; /metrics %lu bytes\n",
+           (unsigned long)loopLatency.percentile(0.5f), (unsigned long)loopLatency.percentile(0.99f),
+           (unsigned long)loopLatency.max(), (unsigned long)readLatency.percentile(0.99f),
+           (unsigned long)(uploadLatency.percentile(0.99f) / 1000), (unsigned long)metricsLength);
+
+    if (options.recordTracePath) {
+        const TraceStats& traceStats = trace.getStats();
+        bool written = writeTraceFile(options.recordTracePath, capturedTrace());
+        printf("  trace: %lu frames in %lu blocks, %lu bytes (%zu as serial lines)%s %s\n",
+               (unsigned long)traceStats.frames, (unsigned long)traceStats.blocks,
+               (unsigned long)traceStats.bytes, capturedTrace().size(), written ? " written to" : ", could not write",
+               options.recordTracePath);
+        if (!written) {
+            return 1;
+        }
+    }
+    if (options.replayPath) {
+        printf("  replay of %s: %zu reads (%llu played late), %zu outages, %zu uploads"
+               " (%llu requests beyond them), %lu damaged blocks\n", options.replayPath, plan.samples,
+               (unsigned long long)(sensorEnd.traceLateReads - sensorStart.traceLateReads), plan.outages,
+               plan.uploads, (unsigned long long)replayUnscriptedRequests(), (unsigned long)plan.damagedBlocks);
+        if (!checkReplay(replayBlocks, traceBlocksFromText(capturedTrace()))) {
+            printf("  FAIL: the replay did not reproduce the trace's records\n");
+            return 1;
+        }
+    }
+    if (!options.fixedIntervalReads && (duplicateReads != 0 || missedSamples != 0)) {
+        printf("  FAIL: data-ready acquisition read %llu duplicates and missed %llu measurements\n",
+               (unsigned long long)duplicateReads, (unsigned long long)missedSamples);
+        return 1;
+    }
+    if (logEnd.dropped != logStart.dropped) {
+        printf("  FAIL: %lu log messages dropped from the log ring\n",
+               (unsigned long)(logEnd.dropped - logStart.dropped));
+        return 1;
+    }
+    if (sampleQueue.getDropped() != 0) {
+        printf("  FAIL: %lu samples dropped from the sample queue\n", (unsigned long)sampleQueue.getDropped());
+        return 1;
+    }
+    if (metricsLength >= sizeof(metricsBody) || !checkPrometheusText(metricsBody, metricsLength)) {
+        printf("  FAIL: /metrics body overflowed or is not valid Prometheus text\n");
+        return 1;
+    }
+    if (serverEnd.malformed != serverStart.malformed) {
+        printf("  FAIL: server saw %llu malformed requests\n",
+               (unsigned long long)(serverEnd.malformed - serverStart.malformed));
+        return 1;
+    }
+    if (broker.stats().malformed != 0 || broker.stats().outOfOrder != 0) {
+        printf("  FAIL: broker saw %llu malformed packets and %llu records out of order\n",
+               (unsigned long long)broker.stats().malformed, (unsigned long long)broker.stats().outOfOrder);
+        return 1;
+    }
+    if (serverEnd.outOfOrder != serverStart.outOfOrder) {
+        printf("  FAIL: server saw %llu entries out of order\n",
+               (unsigned long long)(serverEnd.outOfOrder - serverStart.outOfOrder));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,301 @@
+/**
+ * @file MetricsBench.cpp
+ * @brief Metrics histogram buckets, recording cost and /metrics format check
+ *
+ * Checks that every duration lands in the smallest power-of-two bucket
+ * that holds it and that quantiles match a sorted reference to within
+ * the bucket's 2x resolution, then times record() (the call on every
+ * loop pass, sensor read and dashboard poll) and checks it never
+ * allocates. A registry shaped like the firmware's, with every value at
+ * its widest, is rendered and run through a Prometheus text-format
+ * validator; the firmware's own /metrics is validated by the loop suite.
+ */
+
+#include "Bench.h"
+
+#include "DashboardServer.h"
+#include "Metrics.h"
+#include "Simulation.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    const int QUANTILE_SAMPLES = 200000;
+    const int TIMING_RECORDS = 10000000;
+    // As many of each as the firmware exports
+    const int FIRMWARE_HISTOGRAMS = 5;
+    const int FIRMWARE_COUNTERS = 11;
+    const int FIRMWARE_GAUGES = 10;
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool fail(int line, const char* reason, const std::string& text) {
+        printf("    line %d: %s: %s\n", line, reason, text.c_str());
+        return false;
+    }
+
+    bool validName(const std::string& name) {
+        if (name.empty() || !(islower((unsigned char)name[0]) || name[0] == '_' || name[0] == ':')) {
+            return false;
+        }
+        for (char c : name) {
+            if (!(islower((unsigned char)c) || isdigit((unsigned char)c) || c == '_' || c == ':')) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool endsWith(const std::string& text, const char* suffix) {
+        size_t length = strlen(suffix);
+        return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+    }
+}
+
+bool checkPrometheusText(const char* text, size_t length) {
+    std::string family;       // Name of the last # TYPE
+    std::string type;
+    std::string helped;       // Name of the last # HELP
+    std::vector<std::string> seen;
+    double lastBound = -1;
+    double lastBucket = -1;
+    double infBucket = -1;
+    bool countSeen = false;
+    int lineNumber = 0;
+    size_t position = 0;
+
+    auto closeFamily = [&](int at) {
+        if (type == "histogram" && (infBucket < 0 || !countSeen)) {
+            return fail(at, "histogram without +Inf bucket or _count", family);
+        }
+        return true;
+    };
+
+    if (length == 0 || text[length - 1] != '\n') {
+        return fail(0, "empty or not newline-terminated", "");
+    }
+    while (position < length) {
+        const char* end = (const char*)memchr(text + position, '\n', length - position);
+        std::string line(text + position, end - (text + position));
+        position = end - text + 1;
+        lineNumber++;
+
+        if (line.compare(0, 7, "# HELP ") == 0) {
+            if (!closeFamily(lineNumber)) return false;
+            helped = line.substr(7, line.find(' ', 7) - 7);
+            if (!validName(helped) || std::find(seen.begin(), seen.end(), helped) != seen.end()) {
+                return fail(lineNumber, "bad or repeated name", line);
+            }
+            family.clear();
+            type.clear();
+            continue;
+        }
+        if (line.compare(0, 7, "# TYPE ") == 0) {
+            size_t space = line.find(' ', 7);
+            family = line.substr(7, space - 7);
+            type = space == std::string::npos ? "" : line.substr(space + 1);
+            if (family != helped || (type != "counter" && type != "gauge" && type != "histogram")) {
+                return fail(lineNumber, "TYPE does not follow its HELP", line);
+            }
+            if (type == "counter" && !endsWith(family, "_total")) {
+                return fail(lineNumber, "counter name without _total", line);
+            }
+            seen.push_back(family);
+            lastBound = -1;
+            lastBucket = -1;
+            infBucket = -1;
+            countSeen = false;
+            continue;
+        }
+        if (line.empty() || line[0] == '#') {
+            return fail(lineNumber, "unexpected line", line);
+        }
+
+        size_t space = line.rfind(' ');
+        if (space == std::string::npos) {
+            return fail(lineNumber, "sample without value", line);
+        }
+        std::string series = line.substr(0, space);
+        char* parsedEnd = nullptr;
+        double value = strtod(line.c_str() + space + 1, &parsedEnd);
+        if (family.empty()) {
+            return fail(lineNumber, "sample before its TYPE", line);
+        }
+        if (*parsedEnd != '\0' || !isfinite(value) || (value < 0 && type != "gauge")) {
+            return fail(lineNumber, "value not a finite number (non-negative but for gauges)", line);
+        }
+        if (type != "histogram") {
+            if (series != family) {
+                return fail(lineNumber, "sample outside its family", line);
+            }
+            family.clear(); // One sample per counter or gauge
+            continue;
+        }
+
+        std::string bucketPrefix = family + "_bucket{le=\"";
+        if (series.compare(0, bucketPrefix.size(), bucketPrefix) == 0 && endsWith(series, "\"}")) {
+            std::string le = series.substr(bucketPrefix.size(), series.size() - bucketPrefix.size() - 2);
+            double bound = le == "+Inf" ? INFINITY : strtod(le.c_str(), &parsedEnd);
+            if (infBucket >= 0 || bound <= lastBound || (le != "+Inf" && *parsedEnd != '\0')) {
+                return fail(lineNumber, "bucket bounds not increasing", line);
+            }
+            if (value < lastBucket) {
+                return fail(lineNumber, "bucket counts not cumulative", line);
+            }
+            lastBound = bound;
+            lastBucket = value;
+            if (le == "+Inf") {
+                infBucket = value;
+            }
+        } else if (series == family + "_sum") {
+            if (infBucket < 0) {
+                return fail(lineNumber, "_sum before the +Inf bucket", line);
+            }
+        } else if (series == family + "_count") {
+            if (value != infBucket) {
+                return fail(lineNumber, "_count differs from the +Inf bucket", line);
+            }
+            countSeen = true;
+        } else {
+            return fail(lineNumber, "sample outside its family", line);
+        }
+    }
+    return closeFamily(lineNumber);
+}
+
+int runMetricsBench(const BenchOptions& options) {
+    // Bucket edges: 2^i lands in bucket i, 2^i + 1 in bucket i + 1
+    bool edgesOk = true;
+    for (int i = 0; i < MetricHistogram::BUCKETS - 1; i++) {
+        MetricHistogram histogram;
+        uint32_t bound = MetricHistogram::bucketBound(i);
+        histogram.record(bound);
+        histogram.record(bound + 1);
+        edgesOk = edgesOk && histogram.bucketCount(i) == 1 && histogram.bucketCount(i + 1) == 1
+                  && (i > 0 || histogram.max() == 2);
+    }
+    {
+        MetricHistogram histogram;
+        histogram.record(0);
+        histogram.record(UINT32_MAX);
+        edgesOk = edgesOk && histogram.bucketCount(0) == 1
+                  && histogram.bucketCount(MetricHistogram::BUCKETS - 1) == 1 && histogram.count() == 2
+                  && histogram.max() == UINT32_MAX && histogram.sum() == UINT32_MAX;
+    }
+    bool ok = report("durations land in the smallest bucket", edgesOk);
+
+    // Quantiles of a long-tailed distribution against the exact ones
+    std::mt19937 random(options.seed);
+    std::lognormal_distribution<double> durations(6.0, 1.5); // Median ~400 us, tail to tens of ms
+    MetricHistogram histogram;
+    std::vector<uint32_t> exact;
+    exact.reserve(QUANTILE_SAMPLES);
+    for (int i = 0; i < QUANTILE_SAMPLES; i++) {
+        uint32_t micros = (uint32_t)std::min(durations(random), 4e9);
+        histogram.record(micros);
+        exact.push_back(micros);
+    }
+    std::sort(exact.begin(), exact.end());
+    printf("\n  %-8s %12s %12s\n", "quantile", "exact (us)", "bucket (us)");
+    bool quantilesOk = histogram.count() == (uint32_t)QUANTILE_SAMPLES && histogram.max() == exact.back();
+    const float QUANTILES[] = {0.5f, 0.9f, 0.99f, 0.999f, 1.0f};
+    for (float q : QUANTILES) {
+        uint32_t reference = exact[(size_t)ceil(q * QUANTILE_SAMPLES) - 1];
+        uint32_t reported = histogram.percentile(q);
+        printf("  %-8g %12lu %12lu\n", q, (unsigned long)reference, (unsigned long)reported);
+        quantilesOk = quantilesOk && reported >= reference && reported <= std::max(2 * reference, 1u);
+    }
+    printf("\n");
+    ok = report("quantiles within one bucket of exact", quantilesOk) && ok;
+
+    // record() cost; durations as the firmware sees them, from a precomputed table
+    std::vector<uint32_t> table(4096);
+    for (uint32_t& micros : table) {
+        micros = (uint32_t)std::min(durations(random), 4e9);
+    }
+    MetricHistogram timed;
+    SimHeapStats heapBefore = SimHeap::stats();
+    uint64_t start = hostNanos();
+    for (int i = 0; i < TIMING_RECORDS; i++) {
+        timed.record(table[i & 4095]);
+    }
+    uint64_t elapsed = hostNanos() - start;
+    doNotOptimize(timed.count());
+    printf("  record(): %.2f ns per duration, %d bytes per histogram\n", (double)elapsed / TIMING_RECORDS,
+           (int)sizeof(MetricHistogram));
+    ok = report("record() never allocates", SimHeap::stats().allocations == heapBefore.allocations) && ok;
+
+    // The firmware's shape at its widest: names, help and values as long as
+    // any it exports. Bucket counts stay small here; WIDE_COUNT_SLACK adds
+    // the bytes each bucket line and _count would take at ten digits.
+    static char names[FIRMWARE_HISTOGRAMS + FIRMWARE_COUNTERS + FIRMWARE_GAUGES][48];
+    static MetricHistogram histograms[FIRMWARE_HISTOGRAMS];
+    static MetricCounter counters[FIRMWARE_COUNTERS];
+    static MetricGauge gauges[FIRMWARE_GAUGES];
+    const char* HELP = "Help text as long as the longest the firmware exports here";
+    MetricsRegistry registry;
+    int named = 0;
+    for (int i = 0; i < FIRMWARE_HISTOGRAMS; i++) {
+        for (int b = 0; b < MetricHistogram::BUCKETS; b++) {
+            histograms[i].record(MetricHistogram::bucketBound(b));
+        }
+        snprintf(names[named], sizeof(names[named]), "aqm_dashboard_poll_latency_%d_seconds", i);
+        registry.addHistogram(names[named++], HELP, histograms[i]);
+    }
+    for (int i = 0; i < FIRMWARE_COUNTERS; i++) {
+        counters[i].set(UINT32_MAX);
+        snprintf(names[named], sizeof(names[named]), "aqm_heap_largest_free_block_%d_total", i);
+        registry.addCounter(names[named++], HELP, counters[i]);
+    }
+    for (int i = 0; i < FIRMWARE_GAUGES; i++) {
+        gauges[i].set(1.23456789e-30f); // %.9g at its longest
+        snprintf(names[named], sizeof(names[named]), "aqm_heap_largest_free_block_%d_bytes", i);
+        registry.addGauge(names[named++], HELP, gauges[i]);
+    }
+
+    static char body[DashboardServer::QUERY_RESPONSE_BYTES - DashboardServer::QUERY_HEADER_ROOM];
+    heapBefore = SimHeap::stats();
+    start = hostNanos();
+    size_t length = registry.formatPrometheus(body, sizeof(body));
+    elapsed = hostNanos() - start;
+    const size_t WIDE_COUNT_SLACK = FIRMWARE_HISTOGRAMS * (MetricHistogram::BUCKETS + 1) * 8;
+    printf("  /metrics body: %lu metrics, %lu bytes (+%lu at full counts) of %lu, %.1f us host\n",
+           (unsigned long)registry.size(), (unsigned long)length, (unsigned long)WIDE_COUNT_SLACK,
+           (unsigned long)sizeof(body), elapsed / 1e3);
+    ok = report("widest /metrics fits the response buffer", length + WIDE_COUNT_SLACK < sizeof(body)) && ok;
+    ok = report("rendering never allocates", SimHeap::stats().allocations == heapBefore.allocations) && ok;
+    ok = report("output passes the text-format check", length < sizeof(body) && checkPrometheusText(body, length))
+         && ok;
+
+    // A body cut short is refused rather than sent half-written
+    char small[256];
+    ok = report("overflow reported as snprintf() does", registry.formatPrometheus(small, sizeof(small))
+                                                           >= sizeof(small)) && ok;
+
+    // And the validator itself rejects what it should
+    const char* BROKEN[] = {
+        "# TYPE x counter\nx 1\n",                                            // No HELP
+        "# HELP x_total h\n# TYPE x_total counter\nx_total -1\n",             // Negative counter
+        "# HELP h h\n# TYPE h histogram\nh_bucket{le=\"1\"} 2\nh_bucket{le=\"+Inf\"} 1\nh_sum 0\nh_count 1\n",
+        "# HELP h h\n# TYPE h histogram\nh_bucket{le=\"+Inf\"} 2\nh_sum 0\nh_count 1\n",
+        "# HELP g h\n# TYPE g gauge\ng 1",                                    // No final newline
+    };
+    bool rejectsOk = true;
+    printf("  validator on broken input:\n");
+    for (const char* broken : BROKEN) {
+        rejectsOk = !checkPrometheusText(broken, strlen(broken)) && rejectsOk;
+    }
+    ok = report("validator rejects malformed exposition", rejectsOk) && ok;
+    return ok ? 0 : 1;
+}
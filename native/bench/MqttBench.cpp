@@ -0,0 +1,299 @@
+/**
+ * @file MqttBench.cpp
+ * @brief MQTT QoS 1 publisher against the in-process broker
+ *
+ * MqttPublisher talks to FakeMqttBroker through the simulated TCP stack,
+ * every byte parsed as a broker would. The suite checks that:
+ *   - every record reaches the broker once and in order, and publish()
+ *     and poll() never touch the heap, reconnects included;
+ *   - no more than the window's messages are ever unacknowledged, and
+ *     publish() refuses records while it is full;
+ *   - PUBACKs the broker never sends lead to a reconnect and a DUP
+ *     retransmission, and de-duplication leaves each record once;
+ *   - takeDelivered() reports records in the order they were published,
+ *     never before the broker holds them, also when PUBACKs come out of
+ *     order;
+ *   - a WiFi outage with messages in flight resumes the same session and
+ *     loses nothing;
+ *   - PINGREQs keep an idle session open past the broker's keepalive
+ *     timeout.
+ * It then reports records per second and PUBACK latency at several
+ * round-trip times and window sizes, and bytes on the wire per record
+ * against the bulk-update JSON body.
+ * Times are simulated (modelled round trips; transfer time not included).
+ */
+
+#include "Bench.h"
+
+#include "BulkUploader.h"
+#include "Logger.h"
+#include "MqttPublisher.h"
+
+#include <Simulation.h>
+#include <WiFi.h>
+
+#include <stdio.h>
+
+#include <vector>
+
+namespace {
+    const char* HOST = "mqtt.bench";
+    const uint32_t FIRST_EPOCH = 1767225600; // 2026-01-01T00:00:00Z
+    const uint32_t SPACING = 15;
+    const int BATCH = BulkUploader::BATCH_SIZE;
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    /** Records numbered from first on, one every SPACING seconds */
+    void makeBatch(QueuedRecord* records, int count, uint32_t first) {
+        for (int i = 0; i < count; i++) {
+            uint32_t n = first + i;
+            records[i].timestamp = FIRST_EPOCH + n * SPACING;
+            for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+                records[i].data.*SENSOR_FIELDS[f] = 10.0f + (n % 7) * 0.3f + f;
+            }
+        }
+    }
+
+    /** The broker holds exactly records 0..count-1, each once, in order */
+    bool deliveredOnce(FakeMqttBroker& broker, const char* clientId, uint32_t count) {
+        const std::vector<uint32_t>& timestamps = broker.timestamps(clientId);
+        if (timestamps.size() != count) return false;
+        for (uint32_t i = 0; i < count; i++) {
+            if (timestamps[i] != FIRST_EPOCH + i * SPACING) return false;
+        }
+        return broker.stats().outOfOrder == 0 && broker.stats().malformed == 0;
+    }
+
+    /**
+     * @brief Publish batches back to back, polling every millisecond
+     *
+     * Stops after `batches` batches were taken or `limitMs` passed, then
+     * polls until everything is acknowledged (or the limit). Returns the
+     * records taken; maxInFlight receives the highest inFlight() seen.
+     */
+    uint32_t pump(MqttPublisher& publisher, int batches, uint32_t limitMs, int& maxInFlight,
+                  uint32_t firstRecord = 0) {
+        QueuedRecord records[BATCH];
+        uint32_t taken = 0;
+        int published = 0;
+        uint64_t end = millis() + limitMs;
+        while (millis() < end && (published < batches || publisher.inFlight() > 0)) {
+            publisher.poll();
+            if (published < batches) {
+                makeBatch(records, BATCH, firstRecord + taken);
+                int count = publisher.publish(records, BATCH);
+                if (count > 0) {
+                    taken += count;
+                    published++;
+                }
+            }
+            if (publisher.inFlight() > maxInFlight) maxInFlight = publisher.inFlight();
+            SimClock::advanceMillis(1);
+        }
+        return taken;
+    }
+
+    bool checkDelivery() {
+        FakeMqttBroker broker;
+        SimNet::registerStreamHost(HOST, &broker);
+        MqttPublisher publisher(HOST, 1883, "exact");
+        int maxInFlight = 0;
+        SimHeapStats before = SimHeap::stats();
+        uint32_t taken = pump(publisher, 200, 600000, maxInFlight);
+        publisher.linkLost(); // A reconnect with an empty window allocates nothing either
+        taken += pump(publisher, 50, 600000, maxInFlight, taken);
+        bool noAllocation = SimHeap::stats().allocations == before.allocations;
+        const MqttStats& stats = publisher.getStats();
+        bool ok = taken == 250u * BATCH && deliveredOnce(broker, "exact", taken) && stats.acked == stats.published
+                  && stats.retransmits == 0 && broker.stats().duplicates == 0 && stats.connects == 2;
+        ok = report("every record delivered once and in order", ok);
+        return report("publish() and poll() never allocate", noAllocation) && ok;
+    }
+
+    bool checkWindow() {
+        FakeMqttBroker broker;
+        broker.config().replyMillis = 2000;
+        SimNet::registerStreamHost(HOST, &broker);
+        bool ok = true;
+        for (int window = 1; window <= MqttPublisher::MAX_INFLIGHT; window *= 2) {
+            MqttPublisher publisher(HOST, 1883, window == 1 ? "window1" : (window == 2 ? "window2" : "window4"),
+                                    window);
+            int maxInFlight = 0;
+            uint32_t taken = pump(publisher, 20, 600000, maxInFlight);
+            const MqttStats& stats = publisher.getStats();
+            ok = ok && taken == 20u * BATCH && maxInFlight == window && stats.windowFull > 0
+                 && stats.acked == stats.published;
+        }
+        return report("in-flight messages never exceed the window", ok);
+    }
+
+    bool checkLostAcks() {
+        FakeMqttBroker broker;
+        broker.config().dropAckProbability = 0.2f;
+        SimNet::registerStreamHost(HOST, &broker);
+        MqttPublisher publisher(HOST, 1883, "lossy");
+        int maxInFlight = 0;
+        uint32_t taken = pump(publisher, 100, 3600000, maxInFlight);
+        const MqttStats& stats = publisher.getStats();
+        bool ok = taken == 100u * BATCH && publisher.inFlight() == 0 && stats.timeouts > 0 && stats.retransmits > 0
+                  && broker.stats().duplicates > 0 && broker.stats().sessionsResumed == stats.connects - 1
+                  && deliveredOnce(broker, "lossy", taken);
+        printf("  lost PUBACKs: %lu, reconnects %lu, DUP retransmits %lu, duplicates dropped %lu\n",
+               (unsigned long)broker.stats().acksDropped, (unsigned long)(stats.connects - 1),
+               (unsigned long)stats.retransmits, (unsigned long)broker.stats().duplicates);
+        return report("lost PUBACKs resent with DUP, no loss", ok);
+    }
+
+    bool checkDeliveredOrder() {
+        FakeMqttBroker broker;
+        broker.config().dropAckProbability = 0.2f; // Later messages are acknowledged first
+        SimNet::registerStreamHost(HOST, &broker);
+        MqttPublisher publisher(HOST, 1883, "confirm");
+        QueuedRecord records[BATCH];
+        uint32_t taken = 0;
+        uint32_t delivered = 0;
+        bool ok = true;
+        uint64_t end = millis() + 3600000;
+        while (millis() < end && (taken < 60u * BATCH || publisher.inFlight() > 0)) {
+            publisher.poll();
+            if (taken < 60u * BATCH) {
+                makeBatch(records, BATCH, taken);
+                taken += publisher.publish(records, BATCH);
+            }
+            // Never ahead of what the broker holds: the caller drops these from flash
+            delivered += publisher.takeDelivered();
+            ok = ok && delivered <= broker.timestamps("confirm").size();
+            SimClock::advanceMillis(1);
+        }
+        ok = ok && delivered == taken && taken == 60u * BATCH && publisher.getStats().retransmits > 0;
+        return report("delivered records follow PUBACKs in order", ok);
+    }
+
+    bool checkOutage() {
+        FakeMqttBroker broker;
+        broker.config().replyMillis = 300;
+        SimNet::registerStreamHost(HOST, &broker);
+        MqttPublisher publisher(HOST, 1883, "outage");
+        int maxInFlight = 0;
+        uint32_t taken = pump(publisher, 10, 60000, maxInFlight);
+
+        // Fill the window, then lose the link before the PUBACKs come back
+        QueuedRecord records[BATCH];
+        SimWiFi::addOutage(millis() + 100, 3000);
+        while (publisher.inFlight() < publisher.getWindow()) {
+            makeBatch(records, BATCH, taken);
+            taken += publisher.publish(records, BATCH);
+            SimClock::advanceMillis(20);
+        }
+        int stranded = publisher.inFlight();
+        while (SimWiFi::linkUp()) SimClock::advanceMillis(10);
+        while (!WiFi.isConnected()) SimClock::advanceMillis(100);
+        publisher.linkLost(); // What the firmware does once NetworkManager saw the drop
+        taken += pump(publisher, 10, 600000, maxInFlight, taken);
+
+        const MqttStats& stats = publisher.getStats();
+        bool ok = stranded == publisher.getWindow() && stats.sessionsResumed == 1
+                  && stats.retransmits >= (uint32_t)stranded && publisher.inFlight() == 0
+                  && deliveredOnce(broker, "outage", taken);
+        return report("WiFi outage resumes the session, no loss", ok);
+    }
+
+    bool checkKeepalive() {
+        FakeMqttBroker broker;
+        SimNet::registerStreamHost(HOST, &broker);
+        MqttPublisher publisher(HOST, 1883, "idle");
+        int maxInFlight = 0;
+        pump(publisher, 1, 10000, maxInFlight);
+        // Ten minutes without records, polled once a second as in POWER_LOW
+        for (int second = 0; second < 600; second++) {
+            publisher.poll();
+            SimClock::advanceMillis(1000);
+        }
+        uint32_t taken = pump(publisher, 1, 10000, maxInFlight, BATCH);
+        const MqttStats& stats = publisher.getStats();
+        bool ok = taken == (uint32_t)BATCH && stats.connects == 1 && stats.timeouts == 0 && stats.pings >= 10
+                  && broker.stats().pings == stats.pings && broker.connectionCount() == 1;
+        printf("  idle 10 min: %lu PINGREQs (keepalive %u s)\n", (unsigned long)stats.pings,
+               (unsigned)MqttPublisher::KEEPALIVE_S);
+        return report("PINGREQ keeps an idle session open", ok);
+    }
+
+    void compareRoundTrips() {
+        const uint32_t rtts[] = {10, 50, 200, 500};
+        const uint32_t RUN_MS = 60000;
+        printf("\n  %-8s %-7s %12s %12s %12s\n", "rtt", "window", "records/s", "ack p50 ms", "ack p99 ms");
+        for (uint32_t rtt : rtts) {
+            for (int window = 1; window <= MqttPublisher::MAX_INFLIGHT; window *= 2) {
+                FakeMqttBroker broker;
+                broker.config().replyMillis = rtt;
+                SimNet::registerStreamHost(HOST, &broker);
+                MqttPublisher publisher(HOST, 1883, "table", window);
+                int maxInFlight = 0;
+                pump(publisher, 1, 10000, maxInFlight); // Connected before the clock starts
+                uint64_t start = millis();
+                uint32_t taken = pump(publisher, 1000000, RUN_MS, maxInFlight, BATCH);
+                double seconds = (millis() - start) / 1e3;
+                const MetricHistogram& latency = publisher.getAckLatency();
+                printf("  %5u ms %7d %12.0f %12.1f %12.1f\n", (unsigned)rtt, window, taken / seconds,
+                       latency.percentile(0.5f) / 1e3, latency.percentile(0.99f) / 1e3);
+            }
+        }
+        printf("  (one message is a batch of %d records)\n", BATCH);
+    }
+
+    void compareSize() {
+        FakeMqttBroker broker;
+        SimNet::registerStreamHost(HOST, &broker);
+        MqttPublisher publisher(HOST, 1883, "size");
+        int maxInFlight = 0;
+        pump(publisher, 1, 10000, maxInFlight);
+        uint64_t sentBefore = SimNet::stats().bytesSent;
+        uint32_t taken = pump(publisher, 100, 600000, maxInFlight, BATCH);
+        double mqttBytes = (double)(SimNet::stats().bytesSent - sentBefore) / taken;
+
+        static BulkUploader uploader("XXXXXXXXXXXXXXXX", SPACING);
+        QueuedRecord records[BATCH];
+        makeBatch(records, BATCH, 0);
+        int encoded = 0;
+        uploader.encode(records, BATCH, encoded);
+        printf("\n  bytes per record, batches of %d: MQTT PUBLISH %.1f, bulk-update JSON body %.1f\n", BATCH,
+               mqttBytes, (double)uploader.payloadLength() / encoded);
+    }
+}
+
+int runMqttBench(const BenchOptions& options) {
+    (void)options;
+    SimNetConfig savedNet = SimNet::config();
+    SimNet::config().failureProbability = 0.0f;
+    LogLevel savedLevel = Log.getLevel();
+    Log.setLevel(LOG_LEVEL_NONE); // Reconnect warnings are expected here
+
+    bool savedAutoReconnect = WiFi.getAutoReconnect();
+    WiFi.setAutoReconnect(true);
+    if (!WiFi.isConnected()) {
+        WiFi.mode(WIFI_STA);
+        WiFi.begin("bench", "bench");
+        while (!WiFi.isConnected()) SimClock::advanceMillis(100);
+    }
+    printf("  window %d messages, %d records per message at most, keepalive %u s, ack timeout %lu s\n\n",
+           MqttPublisher::MAX_INFLIGHT, MqttPublisher::MAX_RECORDS, (unsigned)MqttPublisher::KEEPALIVE_S,
+           MqttPublisher::ACK_TIMEOUT_MS / 1000);
+
+    bool ok = checkDelivery();
+    ok = checkWindow() && ok;
+    ok = checkLostAcks() && ok;
+    ok = checkDeliveredOrder() && ok;
+    ok = checkOutage() && ok;
+    ok = checkKeepalive() && ok;
+    compareRoundTrips();
+    compareSize();
+
+    Log.setLevel(savedLevel);
+    SimNet::config() = savedNet;
+    WiFi.setAutoReconnect(savedAutoReconnect);
+    return ok ? 0 : 1;
+}
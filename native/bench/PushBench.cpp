@@ -0,0 +1,412 @@
+/**
+ * @file PushBench.cpp
+ * @brief WebSocket push: handshake and protocol, and many slow and fast clients
+ *
+ * Drives the DashboardServer's /ws route with simulated LAN browsers and
+ * checks the handshake (the RFC 6455 sample key), frames of both length
+ * forms, ping/pong, close, a plain GET and an unmasked frame.
+ *
+ * Then a fleet of browsers on links of different speeds (fast, 4 KB/s,
+ * 150 B/s and stalled) comes and goes, MAX_CLIENTS at a time, while a
+ * dashboard message is published every second for simulated minutes. Each
+ * browser checks that every frame it gets is whole and newer than the last
+ * one. The suite fails unless fast and medium clients get every frame,
+ * slow clients skip to the newest frame instead of queueing, stalled
+ * clients are dropped after the idle timeout with their frame freed, the
+ * frame pool is never exhausted and nothing is allocated. It reports
+ * frames and latency per link class, and what the slowest client would
+ * have queued with one copy of every message per client (textAll()).
+ */
+
+#include "Bench.h"
+
+#include "DashboardJson.h"
+#include "DashboardServer.h"
+#include "WebSocketBroadcaster.h"
+
+#include <Simulation.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    const uint16_t PORT = 8090;
+    const char PAGE[] = "<!DOCTYPE html><html><body>dashboard</body></html>";
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    struct Frame {
+        int opcode = 0;
+        std::string payload;
+    };
+
+    struct WsBrowser {
+        std::shared_ptr<SimLanSocket> socket;
+        std::string received;  // Taken from the socket, not yet parsed
+
+        bool connect(uint16_t port) {
+            socket = SimLan::connect(port);
+            return socket != nullptr;
+        }
+
+        void upgrade(const char* key = "dGhlIHNhbXBsZSBub25jZQ==", bool withUpgrade = true) {
+            if (!socket) return;
+            SimHeap::Untracked untracked;
+            std::string text = "GET /ws HTTP/1.1\r\nHost: 192.168.1.100\r\n";
+            if (withUpgrade) {
+                text += std::string("Upgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: ") + key
+                        + "\r\nSec-WebSocket-Version: 13\r\n";
+            }
+            socket->send((text + "\r\n").c_str());
+        }
+
+        /** The handshake response's status and Sec-WebSocket-Accept ("" if absent); false if incomplete */
+        bool handshake(int& status, std::string& accept) {
+            if (!socket) return false;
+            SimHeap::Untracked untracked;
+            received += socket->take();
+            size_t end = received.find("\r\n\r\n");
+            if (end == std::string::npos) return false;
+            status = atoi(received.c_str() + 9);
+            size_t at = received.find("Sec-WebSocket-Accept: ");
+            accept = at < end ? received.substr(at + 22, received.find("\r\n", at) - at - 22) : "";
+            size_t length = 0;
+            size_t lengthAt = received.find("Content-Length: ");
+            if (lengthAt < end) length = strtoul(received.c_str() + lengthAt + 16, nullptr, 10);
+            received.erase(0, end + 4 + length);
+            return true;
+        }
+
+        void sendFrame(int opcode, const std::string& payload, bool masked = true) {
+            if (!socket) return;
+            SimHeap::Untracked untracked;
+            const uint8_t mask[4] = {0x37, 0xfa, 0x21, 0x3d};
+            std::string frame;
+            frame += (char)(0x80 | opcode);
+            frame += (char)((masked ? 0x80 : 0) | payload.size()); // Payloads under 126 bytes only
+            if (masked) frame.append((const char*)mask, 4);
+            for (size_t i = 0; i < payload.size(); i++) {
+                frame += (char)(payload[i] ^ (masked ? mask[i % 4] : 0));
+            }
+            socket->send(frame.data(), frame.size());
+        }
+
+        /** Take up to maxTake bytes, then parse one whole frame if there is one */
+        bool next(Frame& frame, size_t maxTake = (size_t)-1) {
+            if (!socket) return false;
+            SimHeap::Untracked untracked;
+            if (maxTake > 0) received += socket->take(maxTake);
+            if (received.size() < 2) return false;
+            const uint8_t* data = (const uint8_t*)received.data();
+            size_t header = 2;
+            size_t length = data[1] & 0x7F;
+            if (length == 126) {
+                if (received.size() < 4) return false;
+                length = (size_t)data[2] << 8 | data[3];
+                header = 4;
+            }
+            if (received.size() < header + length) return false;
+            frame.opcode = data[0] & 0x0F;
+            frame.payload = received.substr(header, length);
+            received.erase(0, header + length);
+            return true;
+        }
+    };
+
+    bool poll(DashboardServer& server, WsBrowser& browser, Frame& frame) {
+        for (int i = 0; i < 16; i++) {
+            server.poll();
+            if (browser.next(frame)) return true;
+        }
+        return false;
+    }
+
+    bool publish(WebSocketBroadcaster& feed, const std::string& message) {
+        char* payload = feed.edit();
+        if (!payload) return false;
+        memcpy(payload, message.data(), message.size());
+        return feed.publish(message.size());
+    }
+
+    bool checkProtocol() {
+        static WebSocketBroadcaster feed;
+        static DashboardServer server(PORT);
+        server.addPage("/", "text/html", (const uint8_t*)PAGE, sizeof(PAGE) - 1);
+        server.addWebSocket("/ws", feed);
+        server.begin();
+        bool ok = true;
+
+        WsBrowser browser;
+        int status = 0;
+        std::string accept;
+        ok = ok && browser.connect(PORT);
+        browser.upgrade();
+        server.poll();
+        ok = ok && browser.handshake(status, accept) && status == 101 && accept == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=";
+
+        Frame frame;
+        server.poll();
+        ok = ok && !browser.next(frame); // Nothing published yet
+        std::string small = "{\"n\":1}";
+        std::string large(300, 'x');
+        ok = ok && publish(feed, small) && poll(server, browser, frame) && frame.opcode == 1 && frame.payload == small;
+        ok = ok && publish(feed, large) && poll(server, browser, frame) && frame.payload == large;
+        server.poll();
+        ok = ok && !browser.next(frame); // Each frame once
+
+        browser.sendFrame(0x9, "hi");
+        ok = ok && poll(server, browser, frame) && frame.opcode == 0xA && frame.payload == "hi";
+        browser.sendFrame(0x1, "ignored");
+        server.poll();
+        ok = ok && !browser.next(frame);
+        SimClock::advanceMillis(DashboardServer::PING_INTERVAL_MS);
+        ok = ok && poll(server, browser, frame) && frame.opcode == 0x9 && server.getStats().pings == 1;
+
+        // The page and the socket share the server
+        WsBrowser plain;
+        ok = ok && plain.connect(PORT);
+        plain.upgrade("", false);
+        server.poll();
+        ok = ok && plain.handshake(status, accept) && status == 400;
+
+        browser.sendFrame(0x8, std::string("\x03\xe8", 2));
+        ok = ok && poll(server, browser, frame) && frame.opcode == 0x8 && frame.payload == std::string("\x03\xe8", 2);
+        server.poll();
+        ok = ok && browser.socket->deviceClosed && feed.heldFrames() == 0;
+
+        WsBrowser unmasked;
+        ok = ok && unmasked.connect(PORT);
+        unmasked.upgrade();
+        server.poll();
+        ok = ok && unmasked.handshake(status, accept) && status == 101;
+        ok = ok && poll(server, unmasked, frame) && frame.payload == large; // The newest frame on connect
+        unmasked.sendFrame(0x1, "hello", false);
+        ok = ok && poll(server, unmasked, frame) && frame.opcode == 0x8 && frame.payload == std::string("\x03\xea", 2);
+        server.poll();
+        ok = ok && unmasked.socket->deviceClosed && server.getStats().upgrades == 2;
+        return report("websocket handshake, frames, ping and close", ok);
+    }
+
+    enum LinkClass { FAST, MEDIUM, SLOW, STALLED, LINK_CLASSES };
+    const char* const LINK_NAMES[LINK_CLASSES] = {"fast", "4 KB/s", "150 B/s", "stalled"};
+    const uint32_t LINK_BYTES_PER_SECOND[LINK_CLASSES] = {0, 4000, 150, 0}; // 0 with FAST: unlimited
+
+    struct Session {
+        WsBrowser browser;
+        LinkClass link;
+        uint64_t startMs;
+        uint64_t lastWriteMs; // Last time the server got bytes onto the socket
+        size_t leftOnSocket;  // Bytes the browser had not taken after its last turn
+        double credit;        // Bytes the link may carry now
+        int lastIndex;        // Newest message received (-1 none)
+        bool upgraded;
+        bool active;
+    };
+
+    struct LinkTotals {
+        int sessions = 0;
+        uint64_t frames = 0;
+        uint64_t gaps = 0;        // Messages skipped between two received frames
+        uint64_t badFrames = 0;   // Torn, unknown or older than the last
+        uint64_t dropped = 0;     // Sessions the server closed
+        uint64_t maxDropMs = 0;   // From the last byte the server could write to the close
+        uint64_t maxQueueBytes = 0; // What a copy-per-client queue would hold at worst
+        LatencyHistogram lagMs;
+    };
+
+    bool checkFleet() {
+        const int SESSIONS = 48;
+        const uint64_t SESSION_MS = 90000;
+        const uint64_t TICK_MS = 50;        // pollWebActive's interval
+        const uint64_t PUBLISH_MS = 1000;   // One sensor sample per second
+        static WebSocketBroadcaster feed;
+        static DashboardServer server(PORT + 1);
+        server.addWebSocket("/ws", feed);
+        server.begin();
+
+        std::vector<std::string> messages;
+        std::vector<uint64_t> publishedAt;
+        std::map<std::string, int> indexOf;
+        std::vector<Session> sessions(SESSIONS);
+        LinkTotals totals[LINK_CLASSES];
+        int started = 0;
+        int open = 0;
+        int maxHeld = 0;
+        bool heldWithinOpen = true;
+        uint64_t bytesPushed = 0;
+
+        SimHeapStats heapBefore = SimHeap::stats();
+        uint64_t startMs = SimClock::nowMicros() / 1000;
+        uint64_t nextPublish = startMs;
+        uint64_t endMs = startMs + 2 * SESSIONS * SESSION_MS; // Sessions that never end fail the checks below
+        for (uint64_t now = startMs; (started < SESSIONS || open > 0) && now < endMs; now += TICK_MS) {
+            SimClock::advanceMillis(TICK_MS);
+
+            // Sessions come and go, MAX_CLIENTS at a time
+            for (Session& session : sessions) {
+                if (!session.active || session.link == STALLED) continue;
+                if (now - session.startMs >= SESSION_MS) {
+                    if (session.browser.socket) {
+                        if ((&session - &sessions[0]) % 2) session.browser.sendFrame(0x8, std::string("\x03\xe9", 2));
+                        session.browser.socket->close();
+                    }
+                    session.active = false;
+                    open--;
+                }
+            }
+            while (open < DashboardServer::MAX_CLIENTS && started < SESSIONS) {
+                Session& session = sessions[started];
+                session.link = (LinkClass)(started % LINK_CLASSES);
+                session.startMs = now;
+                session.lastWriteMs = now;
+                session.leftOnSocket = 0;
+                session.credit = 0;
+                session.lastIndex = -1;
+                session.upgraded = false;
+                session.active = true;
+                if (!session.browser.connect(PORT + 1)) return report("many slow and fast clients", false);
+                session.browser.upgrade();
+                totals[session.link].sessions++;
+                started++;
+                open++;
+            }
+
+            if (now >= nextPublish) {
+                nextPublish += PUBLISH_MS;
+                DashboardStatus status = {(uint32_t)(now / 1000), true, -58, {192, 168, 1, 100}, true, 10233,
+                                          0, 3, 210000, 110000, open};
+                SensorData reading = {8.1f, 12.3f, 13.5f, 15.2f, 45.0f, 22.4f, 100.0f, 2.0f};
+                char* payload = feed.edit();
+                if (payload) {
+                    size_t length = formatUpdateJson(payload, WebSocketBroadcaster::MAX_PAYLOAD, status, &reading,
+                                                     (uint32_t)messages.size());
+                    SimHeap::Untracked untracked;
+                    std::string text(payload, length);
+                    indexOf[text] = (int)messages.size();
+                    messages.push_back(text);
+                    publishedAt.push_back(now);
+                    feed.publish(length);
+                }
+            }
+            server.poll();
+
+            int held = feed.heldFrames();
+            maxHeld = held > maxHeld ? held : maxHeld;
+            heldWithinOpen = heldWithinOpen && held <= server.clientCount();
+
+            for (Session& session : sessions) {
+                if (!session.active) continue;
+                LinkTotals& total = totals[session.link];
+                if (session.browser.socket->deviceClosed) {
+                    total.dropped++;
+                    uint64_t silent = now - session.lastWriteMs;
+                    total.maxDropMs = silent > total.maxDropMs ? silent : total.maxDropMs;
+                    session.active = false;
+                    open--;
+                    continue;
+                }
+                SimLanSocket& socket = *session.browser.socket;
+                if (socket.fromDevice.size() > session.leftOnSocket) session.lastWriteMs = now;
+                size_t allowance = (size_t)-1;
+                if (session.link != FAST) {
+                    // What the link did not carry last tick is lost, not saved up (bar a fraction of a byte)
+                    double perTick = LINK_BYTES_PER_SECOND[session.link] * (double)TICK_MS / 1000.0;
+                    session.credit = (session.credit < 1 ? session.credit : 0) + perTick;
+                    allowance = (size_t)session.credit;
+                }
+                size_t pending = socket.fromDevice.size();
+                if (!session.upgraded) {
+                    int status;
+                    std::string accept;
+                    session.upgraded = session.browser.handshake(status, accept) && status == 101;
+                } else {
+                    Frame frame;
+                    for (size_t take = allowance; session.browser.next(frame, take); take = 0) {
+                        SimHeap::Untracked untracked;
+                        auto found = indexOf.find(frame.payload);
+                        if (frame.opcode != 1 || found == indexOf.end() || found->second <= session.lastIndex) {
+                            total.badFrames++;
+                            continue;
+                        }
+                        if (session.lastIndex >= 0) {
+                            // The first frame is whatever was current on connect: no lag to speak of
+                            total.gaps += found->second - session.lastIndex - 1;
+                            total.lagMs.record(now - publishedAt[found->second]);
+                        }
+                        session.lastIndex = found->second;
+                        total.frames++;
+                    }
+                }
+                session.leftOnSocket = socket.fromDevice.size();
+                if (session.link != FAST) {
+                    session.credit -= (double)(pending - session.leftOnSocket);
+                    session.credit = session.credit > 0 ? session.credit : 0; // The handshake is not metered
+                }
+
+                // textAll(): every message since the session started, less what the link carried
+                uint64_t queued = 0;
+                for (size_t i = messages.size(); i-- > 0 && publishedAt[i] >= session.startMs;) {
+                    if ((int)i <= session.lastIndex) break;
+                    queued += messages[i].size() + 4;
+                }
+                total.maxQueueBytes = queued > total.maxQueueBytes ? queued : total.maxQueueBytes;
+            }
+        }
+        server.poll(); // Sees the last browsers' FINs
+        SimHeapStats heapAfter = SimHeap::stats();
+        uint64_t allocations = heapAfter.allocations - heapBefore.allocations;
+        const WebSocketBroadcasterStats& feedStats = feed.getStats();
+        bytesPushed = server.getStats().bytesSent;
+
+        printf("  %d sessions over %.1f simulated minutes, %d at a time, one %zu-byte message per second\n",
+               SESSIONS, (double)(SimClock::nowMicros() / 1000 - startMs) / 60000.0, DashboardServer::MAX_CLIENTS,
+               messages.empty() ? (size_t)0 : messages.back().size());
+        printf("  %-8s %8s %8s %8s %10s %10s %8s %12s\n", "link", "sessions", "frames", "skipped", "lag p50",
+               "lag max", "dropped", "textAll peak");
+        for (int i = 0; i < LINK_CLASSES; i++) {
+            const LinkTotals& total = totals[i];
+            printf("  %-8s %8d %8llu %8llu %8llu ms %7llu ms %8llu %9.1f KB\n", LINK_NAMES[i], total.sessions,
+                   (unsigned long long)total.frames, (unsigned long long)total.gaps,
+                   (unsigned long long)total.lagMs.percentile(0.5), (unsigned long long)total.lagMs.max(),
+                   (unsigned long long)total.dropped, (double)total.maxQueueBytes / 1024.0);
+        }
+        printf("  broadcaster: %u published, %u skipped, %u frames sent, %u superseded; %d of %d frames held at"
+               " most; %llu bytes pushed\n", (unsigned)feedStats.published, (unsigned)feedStats.skipped,
+               (unsigned)feedStats.sent, (unsigned)feedStats.superseded, maxHeld, WebSocketBroadcaster::MAX_FRAMES,
+               (unsigned long long)bytesPushed);
+        printf("  memory: %zu bytes of frames for any number of clients, server %zu bytes for %d slots; heap: %llu"
+               " allocations\n", sizeof(WebSocketBroadcaster), sizeof(DashboardServer), DashboardServer::MAX_CLIENTS,
+               (unsigned long long)allocations);
+
+        bool ok = true;
+        uint64_t badFrames = 0;
+        for (const LinkTotals& total : totals) badFrames += total.badFrames;
+        ok = report("every frame whole and newer than the last", ok && badFrames == 0) && ok;
+        ok = report("fast clients get every frame", totals[FAST].gaps == 0 && totals[MEDIUM].gaps == 0
+                    && totals[FAST].frames > 0 && totals[MEDIUM].frames > 0
+                    && totals[FAST].lagMs.max() <= TICK_MS) && ok;
+        ok = report("slow clients skip to the newest frame", totals[SLOW].gaps > 0 && totals[SLOW].frames > 0
+                    && totals[SLOW].dropped == 0) && ok;
+        ok = report("stalled clients dropped, their frames freed",
+                    totals[STALLED].dropped == (uint64_t)totals[STALLED].sessions
+                    && totals[STALLED].maxDropMs <= DashboardServer::IDLE_TIMEOUT_MS + 2 * TICK_MS
+                    && feed.heldFrames() == 0 && heldWithinOpen) && ok;
+        ok = report("no heap use, frame pool never exhausted", allocations == 0 && feedStats.skipped == 0) && ok;
+        return ok;
+    }
+}
+
+int runPushBench(const BenchOptions& options) {
+    (void)options;
+    bool ok = checkProtocol();
+    ok = checkFleet() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+/**
+ * @file QueueBench.cpp
+ * @brief Crash-safety, bounds and cost of the LittleFS UploadQueue
+ *
+ * Every scenario runs on a wiped simulated filesystem and "reboots" by
+ * constructing a new UploadQueue over the same files:
+ *   - records survive a reboot and drain in order; a reboot mid-drain
+ *     re-sends fewer than CURSOR_COMMIT_INTERVAL records and loses none;
+ *   - a torn append at the end of the tail segment is discarded;
+ *   - a record with a bad CRC is skipped and counted;
+ *   - overfilling the queue drops the oldest segment and keeps flash use
+ *     under MAX_SEGMENTS segments;
+ *   - peekFrom() continues after records still in flight, across
+ *     segments, and headPosition() counts what left the head, dropped
+ *     records included.
+ * It also reports flash traffic and host time per push/pop.
+ */
+
+#include "Bench.h"
+
+#include "UploadQueue.h"
+
+#include <LittleFS.h>
+#include <Simulation.h>
+
+#include <stdio.h>
+
+namespace {
+    const uint32_t CAPACITY = (uint32_t)UploadQueue::RECORDS_PER_SEGMENT * UploadQueue::MAX_SEGMENTS;
+
+    QueuedRecord makeRecord(uint32_t timestamp) {
+        QueuedRecord record;
+        record.timestamp = timestamp;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            record.data.*SENSOR_FIELDS[f] = (float)timestamp + f * 0.25f;
+        }
+        return record;
+    }
+
+    bool fill(UploadQueue& queue, uint32_t first, uint32_t count) {
+        for (uint32_t t = first; t < first + count; t++) {
+            if (!queue.push(makeRecord(t))) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Drain up to limit records, checking each one is intact and that
+     * timestamps are consecutive. Returns the number drained; first/last
+     * receive the first and last timestamp seen.
+     */
+    uint32_t drain(UploadQueue& queue, uint32_t limit, uint32_t& first, uint32_t& last, bool& ok) {
+        uint32_t drained = 0;
+        QueuedRecord record;
+        while (drained < limit && queue.peek(record)) {
+            QueuedRecord expected = makeRecord(record.timestamp);
+            if (memcmp(&record.data, &expected.data, sizeof(record.data)) != 0) ok = false;
+            if (drained == 0) first = record.timestamp;
+            else if (record.timestamp != last + 1) ok = false;
+            last = record.timestamp;
+            queue.pop();
+            drained++;
+        }
+        return drained;
+    }
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool checkReboot() {
+        SimFlash::wipe();
+        bool ok = true;
+        uint32_t first = 0, last = 0;
+        {
+            UploadQueue queue;
+            ok = queue.begin() && fill(queue, 1, 300);
+        }
+        {
+            UploadQueue queue;
+            ok = ok && queue.begin() && queue.size() == 300;
+            ok = ok && drain(queue, 100, first, last, ok) == 100 && first == 1 && last == 100;
+        }
+        // Rebooted mid-drain: resume at or shortly before record 101
+        UploadQueue queue;
+        ok = ok && queue.begin();
+        uint32_t resent = queue.size() - 200;
+        ok = ok && queue.size() >= 200 && resent < (uint32_t)UploadQueue::CURSOR_COMMIT_INTERVAL;
+        uint32_t drained = drain(queue, CAPACITY, first, last, ok);
+        ok = ok && drained == 200 + resent && first == 101 - resent && last == 300 && queue.isEmpty();
+        ok = ok && !LittleFS.exists("/queue/cursor");
+        return report("reboot keeps order, mid-drain reboot resends < 8", ok);
+    }
+
+    bool checkTornTail() {
+        SimFlash::wipe();
+        bool ok;
+        {
+            UploadQueue queue;
+            ok = queue.begin() && fill(queue, 1, 10);
+        }
+        // Power lost in the middle of an append
+        FILE* tail = fopen(SimFlash::hostPath("/queue/00000000.seg").c_str(), "ab");
+        ok = ok && tail && fwrite("partial-record!!!", 1, 17, tail) == 17;
+        if (tail) fclose(tail);
+
+        UploadQueue queue;
+        ok = ok && queue.begin() && queue.size() == 10 && fill(queue, 11, 5);
+        uint32_t first = 0, last = 0;
+        ok = ok && drain(queue, CAPACITY, first, last, ok) == 15 && first == 1 && last == 15;
+        return report("torn append is discarded", ok);
+    }
+
+    bool checkCorruption() {
+        SimFlash::wipe();
+        bool ok;
+        {
+            UploadQueue queue;
+            ok = queue.begin() && fill(queue, 1, 20);
+        }
+        // Flip one bit inside record #5 (timestamp 6)
+        FILE* segment = fopen(SimFlash::hostPath("/queue/00000000.seg").c_str(), "r+b");
+        ok = ok && segment && fseek(segment, 5 * UploadQueue::RECORD_BYTES + 9, SEEK_SET) == 0;
+        if (segment) {
+            int byte = fgetc(segment);
+            fseek(segment, 5 * UploadQueue::RECORD_BYTES + 9, SEEK_SET);
+            fputc(byte ^ 0x10, segment);
+            fclose(segment);
+        }
+
+        UploadQueue queue;
+        ok = ok && queue.begin();
+        uint32_t first = 0, last = 0;
+        bool consecutive = true;
+        uint32_t drained = drain(queue, CAPACITY, first, last, consecutive);
+        ok = ok && !consecutive && drained == 19 && last == 20 && queue.getStats().corrupt == 1;
+        return report("corrupt record is skipped", ok);
+    }
+
+    bool checkPeekFrom() {
+        SimFlash::wipe();
+        UploadQueue queue;
+        const uint32_t COUNT = UploadQueue::RECORDS_PER_SEGMENT * 3;
+        bool ok = queue.begin() && fill(queue, 1, COUNT);
+        // Batches of 32 handed over back to back, confirmed one batch late
+        QueuedRecord records[32];
+        uint32_t sentEnd = queue.headPosition();
+        uint32_t expected = 1;
+        int lastBatch = 0;
+        while (ok) {
+            int count = queue.peekFrom(sentEnd, records, 32);
+            if (count == 0) break;
+            for (int i = 0; i < count; i++) {
+                ok = ok && records[i].timestamp == expected++;
+            }
+            sentEnd += count;
+            queue.pop(lastBatch);
+            lastBatch = count;
+        }
+        ok = ok && expected == COUNT + 1 && queue.size() == (uint32_t)lastBatch
+             && queue.headPosition() == COUNT - lastBatch;
+        queue.pop(lastBatch);
+        // Dropped records count as removed from the head
+        ok = ok && fill(queue, 1, CAPACITY + UploadQueue::RECORDS_PER_SEGMENT);
+        ok = ok && queue.headPosition() == COUNT + queue.getStats().dropped && queue.peekFrom(0, records, 1) == 1
+             && records[0].timestamp == queue.getStats().dropped + 1;
+        return report("peekFrom() skips in-flight records", ok);
+    }
+
+    bool checkBounds() {
+        SimFlash::wipe();
+        UploadQueue queue;
+        const uint32_t EXTRA = 300;
+        bool ok = queue.begin() && fill(queue, 1, CAPACITY + EXTRA);
+        size_t limitBytes = (size_t)CAPACITY * UploadQueue::RECORD_BYTES + 64;
+        size_t used = LittleFS.usedBytes();
+        ok = ok && queue.size() <= CAPACITY && queue.getStats().dropped >= EXTRA && used <= limitBytes;
+        uint32_t first = 0, last = 0;
+        uint32_t drained = drain(queue, CAPACITY + EXTRA, first, last, ok);
+        ok = ok && last == CAPACITY + EXTRA && drained + queue.getStats().dropped == CAPACITY + EXTRA;
+        printf("  full queue: %lu records on %zu bytes of flash, %lu dropped\n",
+               (unsigned long)drained, used, (unsigned long)queue.getStats().dropped);
+        return report("overflow drops oldest, flash stays bounded", ok);
+    }
+
+    void measureCost() {
+        SimFlash::wipe();
+        UploadQueue queue;
+        queue.begin();
+        const uint32_t RECORDS = 2000;
+
+        SimFlashStats before = SimFlash::stats();
+        uint64_t simBefore = SimClock::nowMicros();
+        uint64_t start = hostNanos();
+        fill(queue, 1, RECORDS);
+        double pushNanos = (double)(hostNanos() - start) / RECORDS;
+        double pushSimMicros = (double)(SimClock::nowMicros() - simBefore) / RECORDS;
+        SimFlashStats afterPush = SimFlash::stats();
+
+        QueuedRecord record;
+        simBefore = SimClock::nowMicros();
+        start = hostNanos();
+        while (queue.peek(record)) queue.pop();
+        double popNanos = (double)(hostNanos() - start) / RECORDS;
+        double popSimMicros = (double)(SimClock::nowMicros() - simBefore) / RECORDS;
+        SimFlashStats afterPop = SimFlash::stats();
+
+        printf("  push: %6.2f us host, %6.0f us flash, %5.1f bytes / %4.2f writes per record\n",
+               pushNanos / 1e3, pushSimMicros,
+               (double)(afterPush.bytesWritten - before.bytesWritten) / RECORDS,
+               (double)(afterPush.writeOps - before.writeOps) / RECORDS);
+        printf("  peek+pop: %6.2f us host, %6.0f us flash, %5.1f bytes / %4.2f writes per record"
+               ", %4.2f files removed per record\n",
+               popNanos / 1e3, popSimMicros,
+               (double)(afterPop.bytesWritten - afterPush.bytesWritten) / RECORDS,
+               (double)(afterPop.writeOps - afterPush.writeOps) / RECORDS,
+               (double)(afterPop.removes - afterPush.removes) / RECORDS);
+    }
+}
+
+int runQueueBench(const BenchOptions& options) {
+    (void)options;
+    printf("  record: %zu bytes, segment: %d records, capacity: %lu records\n\n",
+           UploadQueue::RECORD_BYTES, UploadQueue::RECORDS_PER_SEGMENT, (unsigned long)CAPACITY);
+
+    bool ok = checkReboot();
+    ok = checkTornTail() && ok;
+    ok = checkCorruption() && ok;
+    ok = checkPeekFrom() && ok;
+    ok = checkBounds() && ok;
+    printf("\n");
+    measureCost();
+
+    SimFlash::wipe();
+    return ok ? 0 : 1;
+}
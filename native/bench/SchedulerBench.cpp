@@ -0,0 +1,293 @@
+/**
+ * @file SchedulerBench.cpp
+ * @brief Scheduler ordering, overrun and wrap checks, and dispatch cost
+ *
+ * Checks that:
+ *   - random every()/after()/cancel() sequences, with time jumping in
+ *     uneven steps across the millis() wrap, run exactly the jobs a
+ *     linear-scan reference runs, each pass in deadline order, and agree
+ *     on msUntilNext() and every job's run and overrun counts;
+ *   - a job can cancel itself or another job from its callback, a one-shot
+ *     job can schedule itself again, and a full table refuses new jobs;
+ *   - a periodic job held up for several periods runs once and skips
+ *     the rest, keeping its original phase.
+ * It also reports the cost of runDue() per job run and of msUntilNext().
+ */
+
+#include "Bench.h"
+
+#include "Scheduler.h"
+
+#include <stdio.h>
+
+namespace {
+    const int RANDOM_STEPS = 200000;
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    uint32_t nextRandom(uint32_t& state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    bool before(uint32_t a, uint32_t b) {
+        return (int32_t)(a - b) < 0;
+    }
+
+    // The last pass's runs, in the order the scheduler made them
+    struct RunLog {
+        int ids[64];
+        uint32_t deadlines[64];
+        int count;
+    };
+
+    RunLog runLog;
+
+    // Identifies a job to its callback; the id is only known once the job is added
+    struct Ticket {
+        bool inUse;
+        int id;
+        uint32_t deadline;  // Kept up to date from the reference model
+    };
+
+    Ticket tickets[Scheduler::MAX_JOBS];
+
+    Ticket* takeTicket() {
+        for (Ticket& ticket : tickets) {
+            if (!ticket.inUse) {
+                ticket.inUse = true;
+                return &ticket;
+            }
+        }
+        return nullptr;
+    }
+
+    void logRun(void* context) {
+        Ticket* job = static_cast<Ticket*>(context);
+        if (runLog.count < 64) {
+            runLog.ids[runLog.count] = job->id;
+            runLog.deadlines[runLog.count] = job->deadline;
+            runLog.count++;
+        }
+    }
+
+    // Linear-scan model of the scheduler's documented behaviour
+    struct ReferenceJob {
+        bool active;
+        uint32_t periodMs;
+        uint32_t deadline;
+        uint32_t runs;
+        uint32_t overruns;
+        Ticket* ticket;
+    };
+
+    struct Reference {
+        ReferenceJob jobs[Scheduler::MAX_JOBS];
+
+        void runDue(uint32_t now, uint32_t* runsThisPass) {
+            for (int id = 0; id < Scheduler::MAX_JOBS; id++) {
+                runsThisPass[id] = 0;
+                ReferenceJob& job = jobs[id];
+                if (!job.active || before(now, job.deadline)) continue;
+                job.runs++;
+                runsThisPass[id]++;
+                if (job.periodMs == 0) {
+                    job.active = false;
+                    job.ticket->inUse = false;
+                    continue;
+                }
+                job.deadline += job.periodMs;
+                if (!before(now, job.deadline)) {
+                    uint32_t behind = (now - job.deadline) / job.periodMs + 1;
+                    job.overruns += behind;
+                    job.deadline += behind * job.periodMs;
+                }
+            }
+        }
+
+        uint32_t msUntilNext(uint32_t now) const {
+            uint32_t best = Scheduler::NO_DEADLINE;
+            for (int id = 0; id < Scheduler::MAX_JOBS; id++) {
+                if (!jobs[id].active) continue;
+                uint32_t wait = before(now, jobs[id].deadline) ? jobs[id].deadline - now : 0;
+                if (wait < best) best = wait;
+            }
+            return best;
+        }
+    };
+
+    bool checkRandom() {
+        static Scheduler scheduler;
+        static Reference reference;
+        memset(&reference, 0, sizeof(reference));
+        uint32_t state = 0x2545F491u;
+        uint32_t now = 0xFFFFFFFFu - 600000u;  // The wrap comes about a tenth of the way in
+        uint32_t mismatches = 0;
+        uint32_t runs = 0;
+
+        for (int step = 0; step < RANDOM_STEPS && mismatches < 5; step++) {
+            uint32_t op = nextRandom(state) % 16;
+            if (op < 4 && scheduler.jobCount() < Scheduler::MAX_JOBS) {
+                bool periodic = op < 2;
+                uint32_t period = periodic ? 1 + nextRandom(state) % 500 : 0;
+                uint32_t delay = nextRandom(state) % (periodic ? 1000 : 2000);
+                Ticket* ticket = takeTicket();
+                int id = periodic ? scheduler.every("periodic", period, logRun, ticket, now, delay)
+                                  : scheduler.after("one-shot", delay, logRun, ticket, now);
+                if (id == Scheduler::INVALID_JOB || reference.jobs[id].active) {
+                    mismatches++;
+                    break;
+                }
+                ticket->id = id;
+                ReferenceJob job = {true, period, now + delay, 0, 0, ticket};
+                reference.jobs[id] = job;
+            } else if (op < 5) {
+                int id = (int)(nextRandom(state) % Scheduler::MAX_JOBS);
+                bool cancelled = scheduler.cancel(id);
+                if (cancelled != reference.jobs[id].active) mismatches++;
+                if (reference.jobs[id].active) reference.jobs[id].ticket->inUse = false;
+                reference.jobs[id].active = false;
+            } else {
+                now += nextRandom(state) % 300;
+            }
+
+            for (int id = 0; id < Scheduler::MAX_JOBS; id++) {
+                if (reference.jobs[id].active) reference.jobs[id].ticket->deadline = reference.jobs[id].deadline;
+            }
+            uint32_t expected[Scheduler::MAX_JOBS];
+            reference.runDue(now, expected);
+            runLog.count = 0;
+            int ran = scheduler.runDue(now);
+            runs += (uint32_t)ran;
+
+            uint32_t seen[Scheduler::MAX_JOBS] = {};
+            bool ordered = true;
+            for (int i = 0; i < runLog.count; i++) {
+                seen[runLog.ids[i]]++;
+                if (i > 0 && before(runLog.deadlines[i], runLog.deadlines[i - 1])) ordered = false;
+            }
+            bool same = ordered && ran == runLog.count
+                        && scheduler.msUntilNext(now) == reference.msUntilNext(now);
+            for (int id = 0; id < Scheduler::MAX_JOBS; id++) {
+                same = same && seen[id] == expected[id]
+                       && (scheduler.jobName(id) != nullptr) == reference.jobs[id].active;
+                if (reference.jobs[id].active) {
+                    const SchedulerJobStats& stats = scheduler.jobStats(id);
+                    same = same && stats.runs == reference.jobs[id].runs
+                           && stats.overruns == reference.jobs[id].overruns;
+                }
+            }
+            if (!same) {
+                printf("    step %d at %lu: scheduler and reference disagree\n", step, (unsigned long)now);
+                mismatches++;
+            }
+        }
+        printf("  %d random steps, %lu job runs, clock %lu -> %lu\n", RANDOM_STEPS, (unsigned long)runs,
+               (unsigned long)(0xFFFFFFFFu - 600000u), (unsigned long)now);
+        return report("random jobs run like the reference", mismatches == 0);
+    }
+
+    // Callbacks for the edge cases; each scheduler under test is passed as the context
+    int selfId = Scheduler::INVALID_JOB;
+    int victimId = Scheduler::INVALID_JOB;
+    int victimRuns = 0;
+    int rescheduled = 0;
+    uint32_t edgeNow = 0;
+
+    void cancelSelf(void* context) {
+        static_cast<Scheduler*>(context)->cancel(selfId);
+    }
+
+    void cancelVictim(void* context) {
+        static_cast<Scheduler*>(context)->cancel(victimId);
+        victimId = Scheduler::INVALID_JOB;  // The slot may be reused
+    }
+
+    void countVictim(void* context) {
+        (void)context;
+        victimRuns++;
+    }
+
+    void rescheduleSelf(void* context) {
+        if (++rescheduled < 3) {
+            static_cast<Scheduler*>(context)->after("again", 10, rescheduleSelf, context, edgeNow);
+        }
+    }
+
+    void nothing(void* context) {
+        (void)context;
+    }
+
+    bool checkEdges() {
+        static Scheduler scheduler;
+        bool ok = true;
+
+        selfId = scheduler.every("self", 10, cancelSelf, &scheduler, 0);
+        scheduler.runDue(0);
+        ok = ok && scheduler.jobCount() == 0 && scheduler.runDue(100) == 0;
+
+        // The victim is cancelled before its first deadline
+        scheduler.every("canceller", 10, cancelVictim, &scheduler, 0, 5);
+        victimId = scheduler.every("victim", 10, countVictim, nullptr, 0, 6);
+        scheduler.runDue(5);
+        scheduler.runDue(50);
+        ok = ok && victimRuns == 0 && scheduler.jobCount() == 1;
+
+        edgeNow = 100;
+        scheduler.after("again", 0, rescheduleSelf, &scheduler, edgeNow);
+        for (edgeNow = 100; edgeNow <= 200; edgeNow += 10) scheduler.runDue(edgeNow);
+        ok = ok && rescheduled == 3 && scheduler.jobCount() == 1;
+
+        int added = 0;
+        while (scheduler.every("filler", 1000, nothing, nullptr, 0) != Scheduler::INVALID_JOB) added++;
+        ok = ok && added == Scheduler::MAX_JOBS - 1 && scheduler.jobCount() == Scheduler::MAX_JOBS;
+        ok = ok && scheduler.every("zero", 0, nothing, nullptr, 0) == Scheduler::INVALID_JOB;
+        report("callback cancel/reschedule, full table", ok);
+
+        // Period 100, due at 200 but run at 450: 300 and 400 are skipped, the next run is at 500
+        static Scheduler late;
+        int id = late.every("late", 100, nothing, nullptr, 0, 100);
+        late.runDue(100);
+        late.runDue(450);
+        const SchedulerJobStats& stats = late.jobStats(id);
+        bool skipped = stats.runs == 2 && stats.overruns == 2 && stats.maxLateMs == 250
+                       && late.msUntilNext(450) == 50;
+        return report("late periodic job skips missed runs in phase", skipped) && ok;
+    }
+
+    bool measureCost() {
+        static Scheduler scheduler;
+        const int ROUNDS = 200000;
+        for (int i = 0; i < Scheduler::MAX_JOBS; i++) {
+            scheduler.every("job", 10 + 3 * (uint32_t)i, nothing, nullptr, 0);
+        }
+
+        uint64_t runs = 0;
+        uint64_t start = hostNanos();
+        for (uint32_t now = 0; now < (uint32_t)ROUNDS; now++) runs += scheduler.runDue(now);
+        double perRun = (double)(hostNanos() - start) / runs;
+
+        uint32_t sum = 0;
+        start = hostNanos();
+        for (uint32_t now = 0; now < (uint32_t)ROUNDS; now++) sum += scheduler.msUntilNext(now);
+        doNotOptimize(sum);
+        double perQuery = (double)(hostNanos() - start) / ROUNDS;
+
+        printf("  %d jobs: runDue() %.1f ns per job run (incl. 2 micros()), msUntilNext() %.1f ns\n",
+               Scheduler::MAX_JOBS, perRun, perQuery);
+        return true;
+    }
+}
+
+int runSchedulerBench(const BenchOptions& options) {
+    (void)options;
+    bool ok = checkRandom();
+    ok = checkEdges() && ok;
+    ok = measureCost() && ok;
+    return ok ? 0 : 1;
+}
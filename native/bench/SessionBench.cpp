@@ -0,0 +1,238 @@
+/**
+ * @file SessionBench.cpp
+ * @brief Connect vs. transfer time of the keep-alive UploadSession
+ *
+ * Posts to an in-process echo server through the simulated TCP stack and
+ * compares a fresh connection per request (what a WiFiClient per upload
+ * costs) with one UploadSession, at request spacings below and above the
+ * server's keep-alive idle timeout. Then checks stale-socket handling:
+ *   - a socket the server closed while idle is replaced without a retry;
+ *   - a reused socket the server closes without answering is retried once
+ *     on a fresh connection;
+ *   - a request the server took but never answered, or one written to a
+ *     socket left half-open by a WiFi outage, times out and is not sent
+ *     again (it may have been stored); the next request connects afresh;
+ *   - a socket idle for longer than UploadSession::MAX_IDLE_MS is closed
+ *     before use even if the server would still take it.
+ * It also checks that post() does not touch the heap, on fresh and reused
+ * connections alike.
+ * Times are simulated (modelled DNS, handshake and server latency).
+ */
+
+#include "Bench.h"
+
+#include "UploadSession.h"
+
+#include <Simulation.h>
+#include <WiFi.h>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+    const char* HOST = "session.bench";
+    const char* BODY = "{\"ping\":1}";
+
+    class EchoServer : public SimHttpHandler {
+    public:
+        uint32_t received = 0;
+        bool closeNext = false; // Close the next request's connection without answering
+        bool hangNext = false;  // Never answer the next request
+
+        void handle(const SimHttpRequest& request, SimHttpResponse& response) override {
+            received++;
+            if (closeNext || hangNext) {
+                response.noResponse = true;
+                response.closeConnection = closeNext;
+                closeNext = false;
+                hangNext = false;
+                return;
+            }
+            response.status = 200;
+            response.body = request.body;
+        }
+    };
+
+    EchoServer server;
+
+    struct Run {
+        uint32_t ok = 0;
+        uint32_t requests = 0;
+        uint64_t connectMicros = 0;
+        uint64_t transferMicros = 0;
+    };
+
+    int post(UploadSession& session) {
+        char response[32];
+        return session.post("/echo", "application/json", (const uint8_t*)BODY, strlen(BODY),
+                            response, sizeof(response));
+    }
+
+    bool postOnce(UploadSession& session, Run& run) {
+        char response[32];
+        int code = session.post("/echo", "application/json", (const uint8_t*)BODY, strlen(BODY),
+                                response, sizeof(response));
+        bool ok = code == 200 && strcmp(response, BODY) == 0;
+        run.ok += ok;
+        run.requests++;
+        run.connectMicros += session.lastConnectMicros();
+        run.transferMicros += session.lastTransferMicros();
+        return ok;
+    }
+
+    Run measure(bool keepAlive, uint32_t spacingMs, int requests, UploadSessionStats& stats) {
+        UploadSession session(HOST);
+        Run run;
+        for (int i = 0; i < requests; i++) {
+            postOnce(session, run);
+            if (!keepAlive) session.close();
+            SimClock::advanceMillis(spacingMs);
+        }
+        stats = session.getStats();
+        return run;
+    }
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool compareSpacings() {
+        const int REQUESTS = 50;
+        const uint32_t spacings[] = {1000, 10000, 16000, 120000};
+        bool ok = true;
+        printf("  %-10s %-11s %12s %12s %12s %8s\n", "spacing", "mode", "connect ms", "transfer ms", "total ms", "reused");
+        for (uint32_t spacing : spacings) {
+            for (int keepAlive = 0; keepAlive < 2; keepAlive++) {
+                UploadSessionStats stats;
+                Run run = measure(keepAlive != 0, spacing, REQUESTS, stats);
+                double connectMs = run.connectMicros / 1e3 / REQUESTS;
+                double transferMs = run.transferMicros / 1e3 / REQUESTS;
+                printf("  %8.0f s %-11s %12.1f %12.1f %12.1f %8lu\n", spacing / 1e3,
+                       keepAlive ? "keep-alive" : "fresh", connectMs, transferMs, connectMs + transferMs,
+                       (unsigned long)stats.reused);
+                ok = ok && run.ok == (uint32_t)REQUESTS && stats.staleRetries == 0;
+                // Below the server's idle timeout every request after the first reuses the socket
+                bool reusable = keepAlive && spacing < SimNet::config().idleTimeoutMillis;
+                ok = ok && stats.reused == (reusable ? (uint32_t)REQUESTS - 1 : 0);
+            }
+        }
+        printf("\n");
+        return report("reuse below idle timeout, none above", ok);
+    }
+
+    bool checkNoAllocation() {
+        UploadSession session(HOST);
+        Run run;
+        SimHeapStats before = SimHeap::stats();
+        bool ok = true;
+        for (int i = 0; i < 20; i++) {
+            ok = postOnce(session, run) && ok;
+            if (i % 5 == 4) session.close();
+        }
+        ok = ok && SimHeap::stats().allocations == before.allocations;
+        return report("post() performs no heap allocation", ok);
+    }
+
+    bool checkServerClosed() {
+        UploadSession session(HOST);
+        Run run;
+        bool ok = postOnce(session, run);
+        SimClock::advanceMillis(SimNet::config().idleTimeoutMillis + 1000);
+        ok = postOnce(session, run) && ok;
+        const UploadSessionStats& stats = session.getStats();
+        ok = ok && stats.connects == 2 && stats.reused == 0 && stats.staleRetries == 0;
+        return report("server-closed socket replaced before sending", ok);
+    }
+
+    bool checkClosedUnanswered() {
+        UploadSession session(HOST);
+        Run run;
+        bool ok = postOnce(session, run);
+        uint32_t receivedBefore = server.received;
+        server.closeNext = true;
+        ok = postOnce(session, run) && ok;
+        const UploadSessionStats& stats = session.getStats();
+        ok = ok && stats.staleRetries == 1 && stats.connects == 2 && server.received == receivedBefore + 2;
+        return report("socket closed unanswered retried once", ok);
+    }
+
+    bool checkHangNotResent() {
+        UploadSession session(HOST);
+        Run run;
+        bool ok = postOnce(session, run);
+        uint32_t receivedBefore = server.received;
+        server.hangNext = true;
+        ok = ok && post(session) == HTTPC_ERROR_READ_TIMEOUT;
+        const UploadSessionStats& stats = session.getStats();
+        ok = ok && stats.staleRetries == 0 && server.received == receivedBefore + 1 && !session.isOpen();
+        ok = postOnce(session, run) && ok;
+        ok = ok && stats.connects == 2;
+        return report("unanswered request times out, not resent", ok);
+    }
+
+    bool checkHalfOpen() {
+        UploadSession session(HOST);
+        Run run;
+        bool ok = postOnce(session, run);
+        uint64_t lostBefore = SimNet::stats().lostRequests;
+        // Short outage: the socket stays "connected" but the server forgot it
+        SimWiFi::addOutage(millis() + 1000, 2000);
+        SimClock::advanceMillis(2000 + 1000 + SimWiFi::config().associateMillis + 1000);
+        ok = ok && session.isOpen();
+        ok = ok && post(session) == HTTPC_ERROR_READ_TIMEOUT;
+        printf("  half-open socket cost: %.1f ms (response timeout %u ms)\n",
+               session.lastTransferMicros() / 1e3, (unsigned)UploadSession::TIMEOUT_MS);
+        const UploadSessionStats& stats = session.getStats();
+        ok = ok && stats.staleRetries == 0 && SimNet::stats().lostRequests == lostBefore + 1;
+        ok = postOnce(session, run) && ok;
+        ok = ok && stats.connects == 2 && !session.lastReused();
+        return report("half-open socket times out, then replaced", ok);
+    }
+
+    bool checkMaxIdle() {
+        uint32_t savedIdle = SimNet::config().idleTimeoutMillis;
+        SimNet::config().idleTimeoutMillis = UploadSession::MAX_IDLE_MS * 4;
+        UploadSession session(HOST);
+        Run run;
+        bool ok = postOnce(session, run);
+        SimClock::advanceMillis(UploadSession::MAX_IDLE_MS + 1000);
+        ok = ok && session.isOpen();
+        ok = postOnce(session, run) && ok;
+        const UploadSessionStats& stats = session.getStats();
+        ok = ok && stats.connects == 2 && stats.staleRetries == 0;
+        SimNet::config().idleTimeoutMillis = savedIdle;
+        return report("socket idle past MAX_IDLE_MS is not reused", ok);
+    }
+}
+
+int runSessionBench(const BenchOptions& options) {
+    SimNet::registerHost(HOST, &server);
+    SimNetConfig savedNet = SimNet::config();
+    SimNet::config().failureProbability = 0.0f;
+    SimNet::config().idleTimeoutMillis = options.serverIdleSeconds * 1000U;
+
+    // The station must come back after the outage in checkHalfOpen() on its own
+    bool savedAutoReconnect = WiFi.getAutoReconnect();
+    WiFi.setAutoReconnect(true);
+    if (!WiFi.isConnected()) {
+        WiFi.mode(WIFI_STA);
+        WiFi.begin("bench", "bench");
+        while (!WiFi.isConnected()) SimClock::advanceMillis(100);
+    }
+    printf("  DNS %u ms + handshake %u ms per connect, server %u ms per request, idle timeout %u s\n\n",
+           (unsigned)SimNet::config().dnsMillis, (unsigned)SimNet::config().connectMillis,
+           (unsigned)SimNet::config().requestMillis, options.serverIdleSeconds);
+
+    bool ok = compareSpacings();
+    ok = checkNoAllocation() && ok;
+    ok = checkServerClosed() && ok;
+    ok = checkClosedUnanswered() && ok;
+    ok = checkHangNotResent() && ok;
+    ok = checkHalfOpen() && ok;
+    ok = checkMaxIdle() && ok;
+
+    SimNet::config() = savedNet;
+    WiFi.setAutoReconnect(savedAutoReconnect);
+    return ok ? 0 : 1;
+}
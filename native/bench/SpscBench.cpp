@@ -0,0 +1,160 @@
+/**
+ * @file SpscBench.cpp
+ * @brief Cross-thread stress test of the lock-free SampleQueue
+ *
+ * The firmware's sensor task and loop() run on different cores and share
+ * only the SpscQueue. Here a producer and a consumer std::thread play
+ * those two roles flat out, with no simulated clock in between, so the
+ * host's memory model and scheduler get every chance to expose a race:
+ *   - every sample arrives exactly once, in order, with no torn fields
+ *     (each field is derived from the sequence number and checked);
+ *   - this holds for the firmware's 64-slot queue and for a 2-slot queue
+ *     that is full or empty on almost every operation;
+ *   - a full queue rejects the push, counts it as dropped and keeps the
+ *     queued items intact.
+ * It also reports cross-thread throughput and single-thread push/pop cost.
+ */
+
+#include "Bench.h"
+
+#include "SensorTask.h"
+
+#include <Simulation.h>
+
+#include <stdio.h>
+
+#include <thread>
+
+namespace {
+    const uint32_t STRESS_ITEMS = 4000000;
+
+    void fillSample(SensorSample& sample, uint32_t sequence) {
+        sample.timestamp = sequence;
+        sample.ok = (sequence & 1) != 0;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            sample.data.*SENSOR_FIELDS[f] = (float)(sequence ^ (0x9E37u * (f + 1)));
+        }
+    }
+
+    bool sampleMatches(const SensorSample& sample, uint32_t sequence) {
+        if (sample.timestamp != sequence || sample.ok != ((sequence & 1) != 0)) return false;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            if (sample.data.*SENSOR_FIELDS[f] != (float)(sequence ^ (0x9E37u * (f + 1)))) return false;
+        }
+        return true;
+    }
+
+    struct StressResult {
+        uint32_t received = 0;
+        uint32_t errors = 0;     // Out of order, duplicated or torn samples
+        uint64_t fullSpins = 0;  // Producer found the queue full
+        uint64_t emptySpins = 0; // Consumer found the queue empty
+        double nanosPerItem = 0;
+    };
+
+    template <uint32_t CAPACITY>
+    StressResult stress(uint32_t items) {
+        static SpscQueue<SensorSample, CAPACITY> queue;
+        StressResult result;
+        uint64_t fullSpins = 0;
+
+        uint64_t start = hostNanos();
+        std::thread producer;
+        std::thread consumer;
+        {
+            // Thread start-up state is allocated here and freed on the worker threads
+            SimHeap::Untracked untracked;
+            producer = std::thread([&fullSpins, items] {
+                SensorSample sample;
+                for (uint32_t i = 0; i < items; i++) {
+                    fillSample(sample, i);
+                    while (!queue.push(sample)) {
+                        fullSpins++;
+                        std::this_thread::yield();
+                    }
+                }
+            });
+            consumer = std::thread([&result, items] {
+                SensorSample sample;
+                while (result.received < items) {
+                    if (!queue.pop(sample)) {
+                        result.emptySpins++;
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    if (!sampleMatches(sample, result.received)) result.errors++;
+                    result.received++;
+                }
+            });
+        }
+        producer.join();
+        consumer.join();
+        result.nanosPerItem = (double)(hostNanos() - start) / items;
+        result.fullSpins = fullSpins;
+        // Every rejected push is counted as dropped, the producer's retries included
+        result.errors += queue.getDropped() != fullSpins || !queue.isEmpty();
+        return result;
+    }
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    template <uint32_t CAPACITY>
+    bool checkStress(const char* name) {
+        StressResult result = stress<CAPACITY>(STRESS_ITEMS);
+        printf("  %2u slots: %u items, %6.1f ns/item, producer full %llu times, consumer empty %llu times\n",
+               (unsigned)CAPACITY, (unsigned)result.received, result.nanosPerItem,
+               (unsigned long long)result.fullSpins, (unsigned long long)result.emptySpins);
+        return report(name, result.received == STRESS_ITEMS && result.errors == 0);
+    }
+
+    bool checkFull() {
+        SampleQueue queue;
+        SensorSample sample;
+        bool ok = true;
+        for (uint32_t i = 0; i < queue.capacity(); i++) {
+            fillSample(sample, i);
+            ok = queue.push(sample) && ok;
+        }
+        fillSample(sample, queue.capacity());
+        ok = !queue.push(sample) && ok;
+        ok = ok && queue.getDropped() == 1 && queue.size() == queue.capacity();
+        for (uint32_t i = 0; ok && i < queue.capacity(); i++) {
+            ok = queue.pop(sample) && sampleMatches(sample, i);
+        }
+        ok = ok && !queue.pop(sample) && queue.pushed() == queue.popped();
+        return report("full queue drops the new sample only", ok);
+    }
+
+    void measureCost() {
+        static SampleQueue queue;
+        const int ITERATIONS = 2000000;
+        SensorSample in;
+        fillSample(in, 1);
+        SensorSample out = in;
+        uint64_t start = hostNanos();
+        for (int i = 0; i < ITERATIONS; i++) {
+            in.timestamp = (uint32_t)i;
+            queue.push(in);
+            queue.pop(out);
+            doNotOptimize(out.timestamp);
+        }
+        double nanos = (double)(hostNanos() - start) / ITERATIONS;
+        printf("  single thread: push + pop %.1f ns (%zu-byte sample, %zu-byte queue)\n",
+               nanos, sizeof(SensorSample), sizeof(SampleQueue));
+    }
+}
+
+int runSpscBench(const BenchOptions& options) {
+    (void)options;
+    printf("  %u hardware threads\n\n", std::thread::hardware_concurrency());
+
+    bool ok = checkStress<64>("64-slot queue: in order, none lost or torn");
+    ok = checkStress<2>("2-slot queue: in order, none lost or torn") && ok;
+    ok = checkFull() && ok;
+    printf("\n");
+    measureCost();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+/**
+ * @file StoreBench.cpp
+ * @brief HistoryStore memory per reading, query cost and downsampling check
+ *
+ * Fills a three-day store with per-second readings (with outages, so some
+ * blocks close early, a few seconds skipped or holding two readings, and
+ * past capacity, so the ring wraps) next to a
+ * plain vector of the same quantized readings. Random range queries are
+ * compared bucket by bucket with a brute-force pass over the vector;
+ * then query time and the readings decoded per query are reported for
+ * ranges from an hour to the whole store, against the brute-force pass,
+ * and /api/history bodies are built for the largest query and checked
+ * against the server's buffer and for malformed parameters.
+ */
+
+#include "Bench.h"
+
+#include "DashboardJson.h"
+#include "DashboardServer.h"
+#include "HistoryStore.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+    const uint32_t START_TIME = 1760000000;
+    const uint32_t OUTAGE_EVERY = 7 * 3600 + 123; // Seconds of readings between outages
+    const uint32_t OUTAGE_SECONDS = 600;
+    const uint32_t EXTRA_READINGS = 43200;         // Half a day past capacity
+    const int RANDOM_QUERIES = 400;
+    const int TIMING_RUNS = 200;
+
+    struct Reading {
+        uint32_t time;
+        float values[SENSOR_FIELD_COUNT]; // As stored (quantized)
+    };
+
+    struct Collector {
+        std::vector<HistoryPoint> points;
+    };
+
+    void collect(const HistoryPoint& point, void* context) {
+        ((Collector*)context)->points.push_back(point);
+    }
+
+    SensorData syntheticReading(uint32_t i, std::mt19937& random) {
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+        float day = (float)(i % 86400) / 86400.0f * 6.2831853f;
+        SensorData r;
+        r.pm25 = 12.0f + 8.0f * sinf(day) + 2.0f * noise(random) + (random() % 5000 == 0 ? 150.0f : 0.0f);
+        r.pm1 = r.pm25 * 0.8f;
+        r.pm4 = r.pm25 * 1.1f;
+        r.pm10 = r.pm25 * 1.2f;
+        r.humidity = 45.0f + 10.0f * sinf(day + 1.0f) + noise(random);
+        r.temperature = 21.0f + 3.0f * sinf(day - 1.0f) + 0.2f * noise(random);
+        r.voc = 100.0f + 40.0f * sinf(day * 3.0f) + 5.0f * noise(random);
+        r.nox = 1.0f + (float)(random() % 3);
+        return r;
+    }
+
+    /** Brute force: every reading of [from, to] into its bucket */
+    std::vector<HistoryPoint> reference(const std::vector<Reading>& readings, uint32_t from, uint32_t to,
+                                        SensorField field, int points) {
+        std::vector<HistoryPoint> result;
+        uint64_t step = HistoryStore::bucketSeconds(from, to, points);
+        double sum = 0;
+        for (const Reading& reading : readings) {
+            if (reading.time < from || reading.time > to) {
+                continue;
+            }
+            float value = reading.values[field];
+            uint32_t time = (uint32_t)(from + (reading.time - from) / step * step);
+            if (result.empty() || result.back().time != time) {
+                if (!result.empty()) {
+                    result.back().mean = (float)(sum / result.back().count);
+                }
+                result.push_back(HistoryPoint{time, 0, value, 0, value});
+                sum = 0;
+            }
+            HistoryPoint& point = result.back();
+            point.count++;
+            point.min = fminf(point.min, value);
+            point.max = fmaxf(point.max, value);
+            sum += value;
+        }
+        if (!result.empty()) {
+            result.back().mean = (float)(sum / result.back().count);
+        }
+        return result;
+    }
+
+    bool matches(const std::vector<HistoryPoint>& actual, const std::vector<HistoryPoint>& expected) {
+        if (actual.size() != expected.size()) {
+            printf("  FAIL: %zu buckets, expected %zu\n", actual.size(), expected.size());
+            return false;
+        }
+        for (size_t i = 0; i < actual.size(); i++) {
+            const HistoryPoint& a = actual[i];
+            const HistoryPoint& e = expected[i];
+            if (a.time != e.time || a.count != e.count || a.min != e.min || a.max != e.max
+                || fabsf(a.mean - e.mean) > 1e-3f * fabsf(e.mean) + 1e-3f) {
+                printf("  FAIL: bucket %zu time %u/%u count %u/%u min %.3f/%.3f mean %.4f/%.4f max %.3f/%.3f\n",
+                       i, a.time, e.time, a.count, e.count, a.min, e.min, a.mean, e.mean, a.max, e.max);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+}
+
+int runStoreBench(const BenchOptions& options) {
+    static HistoryStore store;
+    if (!store.begin()) {
+        return report("PSRAM allocation", false) ? 0 : 1;
+    }
+    std::mt19937 random(options.seed);
+    std::vector<Reading> readings;
+    readings.reserve(store.capacity() + EXTRA_READINGS);
+
+    // Fill past capacity; outages leave blocks part-filled
+    uint32_t total = store.capacity() + EXTRA_READINGS;
+    uint32_t time = START_TIME;
+    bool quantizationOk = true;
+    for (uint32_t i = 0; i < total; i++) {
+        SensorData data = syntheticReading(i, random);
+        Reading reading;
+        reading.time = time;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            float value = data.*SENSOR_FIELDS[f];
+            reading.values[f] = HistoryStore::quantized((SensorField)f, value);
+            quantizationOk = quantizationOk
+                             && fabsf(reading.values[f] - value) <= 0.5f / HistoryStore::SCALE[f] + 1e-4f;
+        }
+        readings.push_back(reading);
+        store.add(time, data);
+        uint32_t jitter = random() % 1000;
+        time += (i + 1) % OUTAGE_EVERY == 0 ? OUTAGE_SECONDS : (jitter == 0 ? 2 : (jitter == 1 ? 0 : 1));
+    }
+    // The store keeps whole blocks: drop what it no longer holds from the reference
+    size_t dropped = readings.size() > store.size() ? readings.size() - store.size() : 0;
+    readings.erase(readings.begin(), readings.begin() + dropped);
+
+    const HistoryStoreStats& stats = store.getStats();
+    printf("  %u readings held (capacity %u, %u blocks dropped), oldest %.2f days back\n", store.size(),
+           store.capacity(), stats.blocksDropped, (double)(store.newest() - store.oldest()) / 86400.0);
+    printf("  memory: %zu bytes, %.2f bytes/reading (SensorData and timestamp: %zu)\n", store.memoryBytes(),
+           (double)store.memoryBytes() / store.capacity(), sizeof(SensorData) + sizeof(uint32_t));
+
+    // add() cost: the held readings again, into a second store
+    static HistoryStore copy;
+    copy.begin();
+    uint64_t start = hostNanos();
+    for (const Reading& reading : readings) {
+        SensorData data;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            data.*SENSOR_FIELDS[f] = reading.values[f];
+        }
+        copy.add(reading.time, data);
+    }
+    printf("  add(): %.1f ns/reading\n", (double)(hostNanos() - start) / readings.size());
+    bool ok = report("quantization within half a step", quantizationOk);
+    ok = report("store holds what the reference holds", !readings.empty()
+                && store.oldest() == readings.front().time && store.newest() == readings.back().time
+                && stats.rejected == 0 && stats.sameSecond > 0 && copy.size() == store.size()) && ok;
+    const HistoryStoreStats& copyStats = copy.getStats();
+    uint32_t sameBefore = copyStats.sameSecond;
+    ok = report("same second kept, older timestamp rejected", copy.add(copy.newest(), SensorData())
+                && copyStats.sameSecond == sameBefore + 1 && !copy.add(copy.newest() - 1, SensorData())
+                && copyStats.rejected == 1) && ok;
+
+    // Random ranges, partly outside what is held, against the brute-force pass
+    bool randomOk = true;
+    uint32_t first = store.oldest() - 3600;
+    uint32_t span = store.newest() + 3600 - first;
+    for (int q = 0; q < RANDOM_QUERIES && randomOk; q++) {
+        uint32_t from = first + (uint32_t)(random() % span);
+        uint32_t to = q % 4 == 0 ? from + (uint32_t)(random() % 600) : from + (uint32_t)(random() % (span / 2));
+        int points = q % 10 == 0 ? 1 : 1 + (int)(random() % HISTORY_MAX_POINTS);
+        SensorField field = (SensorField)(random() % SENSOR_FIELD_COUNT);
+        Collector collector;
+        int reported = store.query(from, to, field, points, collect, &collector);
+        randomOk = reported == (int)collector.points.size()
+                   && matches(collector.points, reference(readings, from, to, field, points));
+    }
+    ok = report("random queries match brute force", randomOk) && ok;
+
+    // Query cost by range: bounded by the block headers plus a block per bucket edge
+    printf("\n  %-10s %7s %12s %12s %12s %14s\n", "range", "points", "query (us)", "decoded", "headers",
+           "brute (us)");
+    const uint32_t RANGES[] = {3600, 6 * 3600, 86400, store.newest() - store.oldest() + 1};
+    const char* const RANGE_NAMES[] = {"1 hour", "6 hours", "1 day", "all"};
+    const int POINTS[] = {HISTORY_DEFAULT_POINTS, HISTORY_MAX_POINTS};
+    double worstMicros = 0;
+    uint64_t worstDecoded = 0;
+    for (int r = 0; r < 4; r++) {
+        for (int points : POINTS) {
+            uint32_t to = store.newest();
+            uint32_t from = to - RANGES[r] + 1;
+            HistoryStoreStats before = store.getStats();
+            Collector collector;
+            collector.points.reserve(points);
+            start = hostNanos();
+            for (int run = 0; run < TIMING_RUNS; run++) {
+                collector.points.clear();
+                store.query(from, to, FIELD_PM25, points, collect, &collector);
+            }
+            double micros = (double)(hostNanos() - start) / TIMING_RUNS / 1e3;
+            uint64_t decoded = (store.getStats().samplesScanned - before.samplesScanned) / TIMING_RUNS;
+            uint64_t headers = (store.getStats().blocksSummarized - before.blocksSummarized) / TIMING_RUNS;
+
+            start = hostNanos();
+            std::vector<HistoryPoint> expected = reference(readings, from, to, FIELD_PM25, points);
+            double bruteMicros = (double)(hostNanos() - start) / 1e3;
+            ok = ok && matches(collector.points, expected);
+            printf("  %-10s %7d %12.1f %12llu %12llu %14.1f\n", RANGE_NAMES[r], points, micros,
+                   (unsigned long long)decoded, (unsigned long long)headers, bruteMicros);
+            if (micros > worstMicros) worstMicros = micros;
+            if (decoded > worstDecoded) worstDecoded = decoded;
+        }
+    }
+    uint64_t bound = (uint64_t)(HISTORY_MAX_POINTS + 1) * HistoryStore::BLOCK_SAMPLES;
+    printf("  worst query: %.1f us host, %llu readings decoded (bound %llu)\n", worstMicros,
+           (unsigned long long)worstDecoded, (unsigned long long)bound);
+    ok = report("query cost bounded whatever the range", worstDecoded <= bound) && ok;
+
+    // /api/history bodies: the largest answer fits the server's buffer
+    static char body[DashboardServer::QUERY_RESPONSE_BYTES - DashboardServer::QUERY_HEADER_ROOM];
+    char query[96];
+    snprintf(query, sizeof(query), "from=%u&to=%u&points=%d&field=temperature", store.oldest(), store.newest(),
+             HISTORY_MAX_POINTS);
+    start = hostNanos();
+    size_t length = formatHistoryJson(body, sizeof(body), store, query);
+    double formatMicros = (double)(hostNanos() - start) / 1e3;
+    printf("  /api/history?%s\n    %zu bytes of %zu, %.1f us host\n", query, length, sizeof(body), formatMicros);
+    bool bodyOk = length > 0 && length < sizeof(body) && strncmp(body, "{\"field\":\"temperature\",", 23) == 0
+                  && strcmp(body + length - 3, "]]}") == 0;
+    // Widest answer: the most negative value of every field in each of HISTORY_MAX_POINTS buckets
+    HistoryStore widest;
+    widest.begin(HISTORY_MAX_POINTS);
+    SensorData lowest;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        lowest.*SENSOR_FIELDS[f] = -1e6f;
+    }
+    for (int i = 0; i < HISTORY_MAX_POINTS; i++) {
+        widest.add(4294967295u - HISTORY_MAX_POINTS + i, lowest);
+    }
+    const char* const FIELD_NAMES[] = {"pm1", "pm25", "pm4", "pm10", "humidity", "temperature", "voc", "nox"};
+    size_t widestLength = 0;
+    for (const char* name : FIELD_NAMES) {
+        snprintf(query, sizeof(query), "from=%u&to=%u&points=%d&field=%s", widest.oldest(), widest.newest(),
+                 HISTORY_MAX_POINTS, name);
+        size_t fieldLength = formatHistoryJson(body, sizeof(body), widest, query);
+        bodyOk = bodyOk && fieldLength > 0 && fieldLength < sizeof(body);
+        if (fieldLength > widestLength) widestLength = fieldLength;
+    }
+    printf("    widest possible body (%d points): %zu bytes\n", HISTORY_MAX_POINTS, widestLength);
+    ok = report("history body fits the response buffer", bodyOk) && ok;
+
+    const char* const MALFORMED[] = {"points=0", "points=481", "from=20&to=10", "field=dust", "from=abc",
+                                     "to=99999999999", "from=&to=5", "points=12x"};
+    bool malformedOk = formatHistoryJson(body, sizeof(body), store, "") > 0
+                       && formatHistoryJson(body, sizeof(body), store, "field=voc&_=123&points=10") > 0;
+    for (const char* malformed : MALFORMED) {
+        malformedOk = malformedOk && formatHistoryJson(body, sizeof(body), store, malformed) == 0;
+    }
+    ok = report("malformed queries refused", malformedOk) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,629 @@
+/**
+ * @file TraceBench.cpp
+ * @brief Field trace format checks, and trace files for the loop suite
+ *
+ * The trace suite records a day of sensor reads (failed reads and warm-up
+ * NaNs included), WiFi drops, uploads and records through TraceRecorder
+ * into both sinks and reads every frame back, value for value. It checks
+ * that a damaged block costs only its own frames and a cut file only its
+ * last block, that the flash sink stops at its budget and that the next
+ * boot keeps the previous trace, and reports bytes per sample and the cost
+ * of recording and decoding a frame.
+ *
+ * The rest serves the loop suite's --record-trace and --replay: a Print
+ * that keeps the firmware's "#T:" lines, reading a trace file (the flash
+ * segments laid end to end, or a serial log), and setting the simulation
+ * up to play a trace back:
+ *   - the recorded reads replace the sensor model (SimSensor::setTrace());
+ *   - the time between a link drop and the next connection, less the
+ *     association time, becomes a WiFi outage;
+ *   - the wall clock is set when it was on the device;
+ *   - ThingSpeak answers each request with the recorded status after the
+ *     recorded server time; a transport error is replayed as a request
+ *     that is never answered. MQTT traces are played against the broker
+ *     stand-in, whose acknowledgements are not scripted.
+ * After the run, checkReplay() compares the records the firmware produced
+ * with the ones in the trace.
+ */
+
+#include "Bench.h"
+
+#include "TraceRecorder.h"
+#include "RecordCodec.h"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <Simulation.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    const uint32_t DAY_SECONDS = 86400;
+    const uint32_t START_EPOCH = 1760000000;
+    const uint32_t RECORD_EVERY = 15;  // Reads per record, as the firmware averages
+    const uint32_t UPLOAD_EVERY = 8;   // Records per upload
+
+    class TraceCapture : public Print {
+    public:
+        std::string text;
+
+        using Print::write;
+        size_t write(const uint8_t* buffer, size_t size) override {
+            SimHeap::Untracked untracked;
+            text.append((const char*)buffer, size);
+            return size;
+        }
+    };
+
+    TraceCapture firmwareCapture;
+
+    /**
+     * @brief Plays ThingSpeak's part from a trace: each request gets the
+     *        next recorded outcome (a success once the script has run out)
+     */
+    class ScriptedThingSpeak : public SimHttpHandler {
+    public:
+        std::deque<TraceEvent> script;
+        uint64_t answered = 0;
+        uint64_t unscripted = 0;
+
+        void handle(const SimHttpRequest& request, SimHttpResponse& response) override {
+            (void)request;
+            SimHeap::Untracked untracked;
+            response.contentType = "application/json";
+            if (script.empty()) {
+                unscripted++;
+                response.status = 202;
+                response.body = "{\"success\":true}";
+                return;
+            }
+            TraceEvent upload = script.front();
+            script.pop_front();
+            answered++;
+            if (upload.result <= 0) {
+                response.noResponse = true; // Timed out, refused or reset on the device
+                return;
+            }
+            response.status = upload.result;
+            response.body = upload.result == 200 || upload.result == 202 ? "{\"success\":true}" : "{\"success\":false}";
+            uint32_t modelled = SimNet::config().requestMillis;
+            if (upload.durationMs > modelled) {
+                SimClock::advanceMillis(upload.durationMs - modelled);
+            }
+        }
+    };
+
+    ScriptedThingSpeak scriptedServer;
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool sameValue(float a, float b) {
+        return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(a)) == 0;
+    }
+
+    bool sameData(const SensorData& a, const SensorData& b) {
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            if (!sameValue(a.*SENSOR_FIELDS[f], b.*SENSOR_FIELDS[f])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** What decoding an event written from original must give */
+    bool matches(const TraceEvent& original, const TraceEvent& decoded) {
+        if (decoded.type != original.type || decoded.ms != original.ms) {
+            return false;
+        }
+        SensorData expected = original.data;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            expected.*SENSOR_FIELDS[f] = RecordEncoder::quantized((SensorField)f, original.data.*SENSOR_FIELDS[f]);
+        }
+        switch (original.type) {
+            case TRACE_SAMPLE:
+                return decoded.ok == original.ok && decoded.warmingUp == original.warmingUp
+                       && (!original.ok || sameData(expected, decoded.data));
+            case TRACE_WIFI:
+                return decoded.up == original.up;
+            case TRACE_CLOCK:
+                return decoded.epoch == original.epoch;
+            case TRACE_UPLOAD:
+                return decoded.mqtt == original.mqtt && decoded.result == original.result
+                       && decoded.records == original.records && decoded.durationMs == original.durationMs;
+            case TRACE_RECORD:
+                return decoded.epoch == original.epoch && sameData(expected, decoded.data);
+            default:
+                return false;
+        }
+    }
+
+    SensorData syntheticReading(uint32_t second, std::mt19937& random) {
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+        float day = (float)(second % DAY_SECONDS) / DAY_SECONDS * 6.2831853f;
+        SensorData r;
+        r.pm25 = 12.0f + 8.0f * sinf(day) + 0.8f * noise(random) + (random() % 5000 == 0 ? 150.0f : 0.0f);
+        r.pm1 = r.pm25 * 0.82f;
+        r.pm4 = r.pm25 * 1.1f;
+        r.pm10 = r.pm25 * 1.22f;
+        r.humidity = 45.0f + 6.0f * sinf(day) + 0.2f * noise(random);
+        r.temperature = 22.0f - 2.5f * sinf(day) + 0.05f * noise(random);
+        r.voc = roundf(100.0f + 25.0f * sinf(day) + 3.0f * noise(random));
+        r.nox = roundf(1.0f + 0.6f * (1.0f + sinf(day)));
+        if (second < 10) {
+            r.voc = r.nox = NAN; // Gas indices still settling
+        }
+        return r;
+    }
+
+    /**
+     * @brief A day on a device: reads a second apart (every 5000th fails),
+     *        a record per 15, an upload per 8 records (some rejected, some
+     *        timed out), the clock set early and the link down every 3 h
+     */
+    std::vector<TraceEvent> syntheticDay() {
+        std::mt19937 random(7);
+        std::vector<TraceEvent> events;
+        TraceEvent event;
+        uint32_t records = 0;
+        const int32_t RESULTS[] = {202, 202, 202, 429, 202, -11, 202, 202};
+        for (uint32_t second = 1; second <= DAY_SECONDS; second++) {
+            uint32_t ms = second * 1000 + (uint32_t)(random() % 20);
+            memset(&event, 0, sizeof(event));
+            event.type = TRACE_SAMPLE;
+            event.ms = ms;
+            event.ok = second % 5000 != 0;
+            event.warmingUp = second < 10;
+            event.data = syntheticReading(second, random);
+            events.push_back(event);
+
+            if (second == 5) {
+                memset(&event, 0, sizeof(event));
+                event.type = TRACE_CLOCK;
+                event.ms = ms + 2;
+                event.epoch = START_EPOCH + 5;
+                events.push_back(event);
+            }
+            if (second % (3 * 3600) == 0) {
+                memset(&event, 0, sizeof(event));
+                event.type = TRACE_WIFI;
+                event.ms = ms + 3;
+                events.push_back(event);
+            }
+            if (second % (3 * 3600) == 120) {
+                memset(&event, 0, sizeof(event));
+                event.type = TRACE_WIFI;
+                event.ms = ms + 3;
+                event.up = true;
+                events.push_back(event);
+            }
+            if (second % RECORD_EVERY == 0) {
+                memset(&event, 0, sizeof(event));
+                event.type = TRACE_RECORD;
+                event.ms = ms + 5;
+                event.epoch = START_EPOCH + second;
+                event.data = syntheticReading(second, random);
+                events.push_back(event);
+                if (++records % UPLOAD_EVERY == 0) {
+                    memset(&event, 0, sizeof(event));
+                    event.type = TRACE_UPLOAD;
+                    event.ms = ms - 400; // Samples are handled after the upload that held loop() up
+                    event.result = RESULTS[(records / UPLOAD_EVERY) % 8];
+                    event.records = UPLOAD_EVERY;
+                    event.durationMs = event.result > 0 ? 180 + random() % 400 : 10000;
+                    events.push_back(event);
+                }
+            }
+        }
+        return events;
+    }
+
+    /** Record events through recorder, on the simulated clock */
+    void recordAll(TraceRecorder& recorder, const std::vector<TraceEvent>& events, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            const TraceEvent& event = events[i];
+            uint64_t atUs = (uint64_t)event.ms * 1000ULL;
+            if (SimClock::nowMicros() < atUs) {
+                SimClock::advanceMicros(atUs - SimClock::nowMicros());
+            }
+            switch (event.type) {
+                case TRACE_SAMPLE: {
+                    SensorSample sample;
+                    sample.timestamp = event.ms;
+                    sample.ok = event.ok;
+                    sample.warmingUp = event.warmingUp;
+                    sample.data = event.data;
+                    recorder.sample(sample);
+                    break;
+                }
+                case TRACE_WIFI:
+                    recorder.wifi(event.up);
+                    break;
+                case TRACE_CLOCK:
+                    recorder.clock(event.epoch);
+                    break;
+                case TRACE_UPLOAD:
+                    recorder.upload(event.ms, event.mqtt, event.result, event.records, event.durationMs);
+                    break;
+                case TRACE_RECORD: {
+                    QueuedRecord record;
+                    record.timestamp = event.epoch;
+                    record.data = event.data;
+                    recorder.record(record);
+                    break;
+                }
+            }
+        }
+    }
+
+    /** Events of a day, offset so they start after the simulated clock's present */
+    std::vector<TraceEvent> shifted(const std::vector<TraceEvent>& events) {
+        std::vector<TraceEvent> result = events;
+        uint32_t base = (uint32_t)(SimClock::nowMicros() / 1000) + 1000;
+        for (TraceEvent& event : result) {
+            event.ms += base;
+        }
+        return result;
+    }
+
+    /** How many of expected the blocks give back in order, -1 on the first mismatch */
+    long decodeAll(const std::string& blocks, const std::vector<TraceEvent>& expected, uint32_t* damaged) {
+        TraceReader reader((const uint8_t*)blocks.data(), blocks.size());
+        TraceEvent event;
+        long count = 0;
+        while (reader.next(event)) {
+            if ((size_t)count >= expected.size() || !matches(expected[count], event)) {
+                return -1;
+            }
+            count++;
+        }
+        if (damaged) {
+            *damaged = reader.damagedBlocks();
+        }
+        return count;
+    }
+
+    /** Start offsets of the blocks, and the end */
+    std::vector<size_t> blockBounds(const std::string& blocks) {
+        std::vector<size_t> bounds;
+        size_t position = 0;
+        while (position + TraceRecorder::BLOCK_HEADER_BYTES <= blocks.size()) {
+            bounds.push_back(position);
+            size_t frames = (uint8_t)blocks[position + 3] | (size_t)(uint8_t)blocks[position + 4] << 8;
+            position += TraceRecorder::BLOCK_HEADER_BYTES + frames;
+        }
+        bounds.push_back(position);
+        return bounds;
+    }
+
+    size_t framesIn(const std::string& blocks, size_t from, size_t to) {
+        std::string block = blocks.substr(from, to - from);
+        TraceReader reader((const uint8_t*)block.data(), block.size());
+        TraceEvent event;
+        size_t count = 0;
+        while (reader.next(event)) {
+            count++;
+        }
+        return count;
+    }
+
+    std::string readDirectory(const char* dir) {
+        std::string blocks;
+        for (int segment = 0; segment < TraceRecorder::MAX_SEGMENTS; segment++) {
+            char path[48];
+            snprintf(path, sizeof(path), "%s/%08x.trc", dir, segment);
+            File file = LittleFS.open(path, FILE_READ);
+            if (!file) {
+                break;
+            }
+            std::vector<uint8_t> bytes(file.size());
+            file.read(bytes.data(), bytes.size());
+            file.close();
+            blocks.append((const char*)bytes.data(), bytes.size());
+        }
+        return blocks;
+    }
+
+    int base64Value(char c) {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+') return 62;
+        if (c == '/') return 63;
+        return -1;
+    }
+}
+
+Print& traceCapture() {
+    return firmwareCapture;
+}
+
+const std::string& capturedTrace() {
+    return firmwareCapture.text;
+}
+
+std::string traceBlocksFromText(const std::string& text) {
+    SimHeap::Untracked untracked;
+    std::string blocks;
+    const std::string prefix = TraceRecorder::LINE_PREFIX;
+    size_t position = 0;
+    while ((position = text.find(prefix, position)) != std::string::npos) {
+        position += prefix.size();
+        uint32_t group = 0;
+        int bits = 0;
+        for (; position < text.size(); position++) {
+            int value = base64Value(text[position]);
+            if (value < 0) {
+                break; // '=', the line end or whatever the log put after it
+            }
+            group = group << 6 | (uint32_t)value;
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                blocks += (char)(group >> bits);
+            }
+        }
+    }
+    return blocks;
+}
+
+bool readTraceFile(const char* path, std::string& blocks) {
+    SimHeap::Untracked untracked;
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    std::string bytes;
+    char chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.append(chunk, got);
+    }
+    fclose(file);
+    // Flash segments start with a block; anything else is a serial log
+    blocks = bytes.size() >= 2 && bytes[0] == 'A' && bytes[1] == 'T' ? bytes : traceBlocksFromText(bytes);
+    return !blocks.empty();
+}
+
+bool writeTraceFile(const char* path, const std::string& text) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+    return fclose(file) == 0 && ok;
+}
+
+bool prepareReplay(const std::string& blocks, const char* thingSpeakHost, ReplayPlan& plan) {
+    SimHeap::Untracked untracked;
+    TraceReader reader((const uint8_t*)blocks.data(), blocks.size());
+    TraceEvent event;
+    std::vector<SimSensorTraceSample> samples;
+    bool linkUp = false;
+    uint64_t downSinceMs = 0;
+    uint64_t lastMs = 0;
+    uint32_t lastSampleMs = 0;
+    bool clockSet = false;
+    uint64_t associateMs = SimWiFi::config().associateMillis;
+    auto outage = [&](uint64_t fromMs, uint64_t toMs) {
+        if (toMs > fromMs) {
+            SimWiFi::addOutage(fromMs, toMs - fromMs);
+            plan.outages++;
+        }
+    };
+
+    while (reader.next(event)) {
+        lastMs = event.ms > lastMs ? event.ms : lastMs;
+        switch (event.type) {
+            case TRACE_SAMPLE: {
+                SimSensorTraceSample sample;
+                sample.atMillis = event.ms;
+                sample.ok = event.ok;
+                const SensorData& d = event.data;
+                sample.pm1 = d.pm1; sample.pm25 = d.pm25; sample.pm4 = d.pm4; sample.pm10 = d.pm10;
+                sample.humidity = d.humidity; sample.temperature = d.temperature; sample.voc = d.voc;
+                sample.nox = d.nox;
+                samples.push_back(sample);
+                lastSampleMs = event.ms;
+                break;
+            }
+            case TRACE_WIFI:
+                if (event.up && !linkUp) {
+                    // Down until the association that brought it up started
+                    outage(downSinceMs, event.ms > associateMs ? event.ms - associateMs : 0);
+                } else if (!event.up && linkUp) {
+                    downSinceMs = event.ms;
+                }
+                linkUp = event.up;
+                break;
+            case TRACE_CLOCK:
+                if (!clockSet) {
+                    clockSet = true;
+                    SimClock::setEpochAtBoot(event.epoch - event.ms / 1000);
+                    // Valid from the read it was first seen with: that sample was handled with it
+                    SimClock::setSntpSyncMicros((uint64_t)(lastSampleMs ? lastSampleMs : event.ms) * 1000ULL);
+                }
+                break;
+            case TRACE_UPLOAD:
+                plan.uploads++;
+                if (event.mqtt) {
+                    plan.mqtt = true;
+                } else {
+                    scriptedServer.script.push_back(event);
+                }
+                break;
+            case TRACE_RECORD:
+                plan.records++;
+                break;
+        }
+    }
+    plan.samples = samples.size();
+    plan.damagedBlocks = reader.damagedBlocks();
+    plan.endMillis = lastMs + 2000;
+    if (!linkUp) {
+        outage(downSinceMs, plan.endMillis);
+    }
+    if (!clockSet) {
+        SimClock::setSntpSyncMicros(UINT64_MAX); // The device never had the time
+    }
+    if (samples.empty()) {
+        return false;
+    }
+    SimSensor::setTrace(samples);
+    SimNet::registerHost(thingSpeakHost, &scriptedServer);
+    return true;
+}
+
+uint64_t replayUnscriptedRequests() {
+    return scriptedServer.unscripted;
+}
+
+bool checkReplay(const std::string& traceBlocks, const std::string& replayBlocks) {
+    SimHeap::Untracked untracked;
+    std::vector<TraceEvent> expected;
+    std::vector<TraceEvent> produced;
+    TraceEvent event;
+    TraceReader traceReader((const uint8_t*)traceBlocks.data(), traceBlocks.size());
+    while (traceReader.next(event)) {
+        if (event.type == TRACE_RECORD) expected.push_back(event);
+    }
+    TraceReader replayReader((const uint8_t*)replayBlocks.data(), replayBlocks.size());
+    while (replayReader.next(event)) {
+        if (event.type == TRACE_RECORD) produced.push_back(event);
+    }
+
+    size_t compared = expected.size() < produced.size() ? expected.size() : produced.size();
+    size_t differ = 0;
+    size_t shiftedTimestamps = 0;
+    for (size_t i = 0; i < compared; i++) {
+        int64_t skew = (int64_t)produced[i].epoch - (int64_t)expected[i].epoch;
+        bool bothUnset = produced[i].epoch == 0 && expected[i].epoch == 0;
+        if (!sameData(produced[i].data, expected[i].data) || (!bothUnset && (skew < -1 || skew > 1))
+            || (produced[i].epoch == 0) != (expected[i].epoch == 0)) {
+            if (differ++ == 0) {
+                printf("  first difference at record %zu: PM2.5 %.1f vs %.1f, timestamp %lu vs %lu\n", i,
+                       produced[i].data.pm25, expected[i].data.pm25, (unsigned long)produced[i].epoch,
+                       (unsigned long)expected[i].epoch);
+            }
+        } else if (skew != 0) {
+            shiftedTimestamps++;
+        }
+    }
+    size_t missing = expected.size() - compared;
+    size_t extra = produced.size() - compared;
+    printf("  replay records: %zu of %zu reproduced, %zu differ, %zu timestamps a second off,"
+           " %zu missing, %zu extra\n", compared - differ, expected.size(), differ, shiftedTimestamps, missing,
+           extra);
+    // The run ends with the trace; a window closing right at the end may fall either side
+    return differ == 0 && missing <= 1 && extra <= 1;
+}
+
+int runTraceBench(const BenchOptions& options) {
+    (void)options;
+    bool ok = true;
+
+    // Serial sink: a day through the recorder, every frame back
+    std::vector<TraceEvent> day = shifted(syntheticDay());
+    size_t samples = 0;
+    for (const TraceEvent& event : day) {
+        samples += event.type == TRACE_SAMPLE;
+    }
+    TraceCapture serial;
+    TraceRecorder recorder;
+    recorder.setOutput(serial);
+    recorder.begin(TRACE_SERIAL);
+    uint64_t recordStart = hostNanos();
+    recordAll(recorder, day, day.size());
+    recorder.flush();
+    double recordNanos = (double)(hostNanos() - recordStart) / day.size();
+    std::string blocks = traceBlocksFromText(serial.text);
+    uint32_t damaged = 0;
+    uint64_t decodeStart = hostNanos();
+    long decoded = decodeAll(blocks, day, &damaged);
+    double decodeNanos = (double)(hostNanos() - decodeStart) / day.size();
+    const TraceStats& stats = recorder.getStats();
+    ok = report("serial lines give back every frame", decoded == (long)day.size() && damaged == 0
+                                                           && stats.frames == day.size() && stats.dropped == 0
+                                                           && stats.bytes == blocks.size()) && ok;
+
+    // A flipped byte inside a block costs that block; a broken header is skipped to the next block
+    std::vector<size_t> bounds = blockBounds(blocks);
+    std::string flipped = blocks;
+    flipped[bounds[3] + TraceRecorder::BLOCK_HEADER_BYTES + 40] ^= 0x10;
+    flipped[bounds[7]] = 'X';
+    size_t lost = framesIn(blocks, bounds[3], bounds[4]) + framesIn(blocks, bounds[7], bounds[8]);
+    TraceReader damagedReader((const uint8_t*)flipped.data(), flipped.size());
+    TraceEvent event;
+    size_t kept = 0;
+    size_t index = 0;
+    bool keptMatch = true;
+    while (damagedReader.next(event)) {
+        // Skip the expected events of the two lost blocks
+        while (index < day.size() && !matches(day[index], event)) {
+            index++;
+        }
+        keptMatch = keptMatch && index < day.size();
+        index++;
+        kept++;
+    }
+    ok = report("damaged blocks cost only their own frames",
+                keptMatch && kept == day.size() - lost && damagedReader.damagedBlocks() == 2) && ok;
+
+    // Cut within the first blocks at every byte: the whole blocks before the cut come back
+    bool cutsOk = true;
+    for (size_t cut = 0; cut <= bounds[3]; cut++) {
+        size_t whole = 0;
+        while (whole + 1 < bounds.size() && bounds[whole + 1] <= cut) {
+            whole++;
+        }
+        uint32_t cutDamaged = 0;
+        long count = decodeAll(blocks.substr(0, cut), day, &cutDamaged);
+        cutsOk = cutsOk && count == (long)framesIn(blocks, 0, bounds[whole])
+                 && cutDamaged == (bounds[whole] == cut ? 0u : 1u);
+    }
+    ok = report("cut traces end at the last whole block", cutsOk) && ok;
+
+    // Flash sink: recording stops at the budget, the trace keeps its start
+    SimFlash::wipe();
+    LittleFS.begin(true);
+    std::vector<TraceEvent> flashDay = shifted(syntheticDay());
+    TraceRecorder flashRecorder;
+    bool started = flashRecorder.begin(TRACE_FLASH);
+    recordAll(flashRecorder, flashDay, flashDay.size());
+    flashRecorder.flush();
+    const TraceStats& flashStats = flashRecorder.getStats();
+    std::string flashBlocks = readDirectory("/trace");
+    long flashDecoded = decodeAll(flashBlocks, flashDay, nullptr);
+    ok = report("flash trace stops at its budget, start kept",
+                started && !flashRecorder.isActive() && flashStats.dropped > 0
+                && flashBlocks.size() <= TraceRecorder::SEGMENT_BYTES * TraceRecorder::MAX_SEGMENTS
+                && flashBlocks.size() > TraceRecorder::SEGMENT_BYTES * (TraceRecorder::MAX_SEGMENTS - 1)
+                && flashDecoded > 0 && (uint32_t)flashDecoded == flashStats.frames) && ok;
+
+    // Next boot: the old trace moves to /trace.prev, the new one starts empty
+    TraceRecorder nextBoot;
+    bool restarted = nextBoot.begin(TRACE_FLASH);
+    ok = report("next boot keeps the previous trace",
+                restarted && readDirectory("/trace.prev") == flashBlocks && readDirectory("/trace").empty()) && ok;
+    SimFlash::wipe();
+
+    printf("\n  %zu samples, %zu frames in a day: %.1f bytes per sample, %.0f KB a day"
+           " (%.0f KB as serial lines), %lu blocks\n", samples, day.size(), (double)blocks.size() / samples,
+           blocks.size() / 1024.0, serial.text.size() / 1024.0, (unsigned long)stats.blocks);
+    printf("  flash budget %u KB: %.1f h of readings, %lu frames kept, %lu dropped\n",
+           (unsigned)(TraceRecorder::SEGMENT_BYTES * TraceRecorder::MAX_SEGMENTS / 1024),
+           (double)TraceRecorder::SEGMENT_BYTES * TraceRecorder::MAX_SEGMENTS / blocks.size() * 24.0,
+           (unsigned long)flashStats.frames, (unsigned long)flashStats.dropped);
+    printf("  record %.0f ns per frame (base64 lines included), decode %.0f ns per frame\n", recordNanos,
+           decodeNanos);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,463 @@
+/**
+ * @file WebBench.cpp
+ * @brief Dashboard server: routes, slow clients, and load against snapshot responses
+ *
+ * Drives a DashboardServer with simulated LAN browsers (SimLan) and checks:
+ *   - the API answers 503 until a snapshot is published, then exactly the
+ *     published JSON; the page, 404, 405 and 414 answers; keep-alive,
+ *     pipelined requests and Connection: close;
+ *   - a client too slow to take its response keeps the snapshot it was
+ *     given intact while new readings are published (one update is skipped
+ *     while both buffers are out, none is torn);
+ *   - idle connections are closed and connections beyond MAX_CLIENTS wait
+ *     in the backlog until a slot frees;
+ *   - the dashboard's gzipped assets (DashboardAssets.h) go out with
+ *     Content-Encoding: gzip and their ETag, and a request naming the ETag
+ *     gets a 304 without a body. Bytes on the wire for a first and a repeat
+ *     page load and the host time to the first response byte are reported
+ *     per asset;
+ *   - a query route answers with the body its handler builds from the
+ *     query string (/api/history over a HistoryStore), across several
+ *     polls when it is larger than the send buffer, and answers 400 for a
+ *     query the handler refuses and 414 for one longer than QUERY_BYTES.
+ * Then a load generator keeps MAX_CLIENTS keep-alive browsers busy with
+ * dashboard requests (with browser-sized headers) while new readings are
+ * published, and reports requests per second of host time spent in
+ * poll() and heap allocations per request (fails if there are any). For
+ * comparison it times building each response per request into Strings, as
+ * a handler that serializes on every request would.
+ */
+
+#include "Bench.h"
+
+#include "DashboardAssets.h"
+#include "DashboardJson.h"
+#include "DashboardServer.h"
+#include "HistoryStore.h"
+#include "JsonSnapshot.h"
+
+#include <Simulation.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+
+namespace {
+    const uint16_t PORT = 8080;
+    const char PAGE[] = "<!DOCTYPE html><html><body>dashboard</body></html>";
+    const char BROWSER_HEADERS[] =
+        "Host: 192.168.1.100\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+        "Chrome/120.0.0.0 Safari/537.36\r\n"
+        "Accept: */*\r\nAccept-Encoding: gzip, deflate\r\nAccept-Language: en-US,en;q=0.9\r\n"
+        "Referer: http://192.168.1.100/\r\n";
+
+    bool report(const char* name, bool ok) {
+        printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    struct Response {
+        int status = 0;
+        std::string headers;
+        std::string body;
+    };
+
+    struct Browser {
+        std::shared_ptr<SimLanSocket> socket;
+        std::string received;  // Taken from the socket, not yet parsed
+
+        bool connect(uint16_t port) {
+            socket = SimLan::connect(port);
+            return socket != nullptr;
+        }
+
+        void request(const char* method, const char* path, const char* connection = "keep-alive",
+                     const std::string& extraHeaders = "") {
+            if (!socket) return;
+            SimHeap::Untracked untracked;
+            std::string text = std::string(method) + " " + path + " HTTP/1.1\r\n" + BROWSER_HEADERS + extraHeaders
+                               + "Connection: " + connection + "\r\n\r\n";
+            socket->send(text.data(), text.size());
+        }
+
+        /** Move what the server wrote into received; false while a response is incomplete */
+        bool next(Response& response, size_t maxTake = (size_t)-1) {
+            if (!socket) return false;
+            SimHeap::Untracked untracked;
+            received += socket->take(maxTake);
+            size_t headerEnd = received.find("\r\n\r\n");
+            if (headerEnd == std::string::npos) return false;
+            size_t lengthAt = received.find("Content-Length: ");
+            size_t length = 0; // 304: no body
+            if (lengthAt < headerEnd) length = strtoul(received.c_str() + lengthAt + 16, nullptr, 10);
+            if (received.size() < headerEnd + 4 + length) return false;
+            response.status = atoi(received.c_str() + 9);
+            response.headers = received.substr(0, headerEnd + 2);
+            response.body = received.substr(headerEnd + 4, length);
+            received.erase(0, headerEnd + 4 + length);
+            return true;
+        }
+    };
+
+    /** Poll until the browser has a whole response (or give up) */
+    bool fetch(DashboardServer& server, Browser& browser, Response& response) {
+        for (int i = 0; i < 16; i++) {
+            server.poll();
+            if (browser.next(response)) return true;
+        }
+        return false;
+    }
+
+    bool get(DashboardServer& server, Browser& browser, const char* path, Response& response) {
+        browser.request("GET", path);
+        return fetch(server, browser, response);
+    }
+
+    SensorData sampleReading(uint32_t i) {
+        SensorData reading = {8.0f + (float)(i % 7), 12.0f + (float)(i % 11) * 0.3f, 13.5f, 15.2f,
+                              45.0f, 22.0f + (float)(i % 5) * 0.1f, 100.0f, 2.0f};
+        return reading;
+    }
+
+    std::string publishReading(JsonSnapshot& snapshot, uint32_t i) {
+        char* body = snapshot.edit();
+        if (!body) return "";
+        size_t length = formatCurrentJson(body, JsonSnapshot::MAX_BODY, sampleReading(i), 1767225600u + i);
+        SimHeap::Untracked untracked;
+        std::string text(body, length);
+        snapshot.publish(length);
+        return text;
+    }
+
+    bool checkRoutes() {
+        static JsonSnapshot current;
+        static DashboardServer server(PORT);
+        server.addPage("/", "text/html; charset=utf-8", (const uint8_t*)PAGE, sizeof(PAGE) - 1);
+        server.addSnapshot("/api/current", current);
+        server.begin();
+        bool ok = true;
+
+        Browser browser;
+        Response response;
+        ok = ok && browser.connect(PORT);
+        ok = ok && get(server, browser, "/api/current", response) && response.status == 503;
+        std::string published = publishReading(current, 1);
+        ok = ok && get(server, browser, "/api/current", response) && response.status == 200
+             && response.body == published && response.headers.find("application/json") != std::string::npos;
+        ok = ok && get(server, browser, "/api/current?since=5", response) && response.body == published;
+        ok = ok && get(server, browser, "/", response) && response.status == 200 && response.body == PAGE;
+        ok = ok && get(server, browser, "/missing", response) && response.status == 404;
+        browser.request("POST", "/api/current");
+        ok = ok && fetch(server, browser, response) && response.status == 405;
+        ok = ok && !browser.socket->deviceClosed && server.getStats().connections == 1;
+
+        // Two requests in one segment are answered in order
+        browser.request("GET", "/");
+        browser.request("GET", "/api/current");
+        Response second;
+        ok = ok && fetch(server, browser, response) && fetch(server, browser, second)
+             && response.body == PAGE && second.body == published;
+
+        browser.request("GET", "/api/current", "close");
+        ok = ok && fetch(server, browser, response) && response.status == 200;
+        server.poll();
+        ok = ok && browser.socket->deviceClosed && server.clientCount() == 0;
+
+        Browser longUrl;
+        ok = ok && longUrl.connect(PORT);
+        std::string path(300, 'a');
+        path[0] = '/';
+        longUrl.request("GET", path.c_str());
+        ok = ok && fetch(server, longUrl, response) && response.status == 414;
+        server.poll();
+        ok = ok && longUrl.socket->deviceClosed;
+        return report("routes, errors, keep-alive and pipelining", ok);
+    }
+
+    bool checkSlowClient() {
+        static JsonSnapshot current;
+        static DashboardServer server(PORT + 1);
+        server.addSnapshot("/api/current", current);
+        server.begin();
+        std::string first = publishReading(current, 1);
+
+        Browser slow;
+        Browser fast;
+        SimLan::connect(0); // Nothing listens on port 0: refused
+        bool ok = SimLan::stats().refused > 0;
+        ok = ok && slow.connect(PORT + 1) && fast.connect(PORT + 1);
+        slow.socket->sendBuffer = 64; // A browser on a weak link
+        slow.request("GET", "/api/current");
+        server.poll();
+
+        // The slow response pins buffer 0: the next reading goes to buffer 1,
+        // the one after has nowhere to go and is skipped
+        std::string second = publishReading(current, 2);
+        std::string third = publishReading(current, 3);
+        ok = ok && !second.empty() && third.empty() && current.getStats().skipped == 1;
+
+        Response response;
+        ok = ok && get(server, fast, "/api/current", response) && response.body == second;
+        Response slowResponse;
+        bool done = false;
+        for (int i = 0; i < 64 && !done; i++) {
+            server.poll();
+            done = slow.next(slowResponse, 16);
+        }
+        ok = ok && done && slowResponse.body == first && server.getStats().shortWrites > 0;
+
+        // Released: updates go through again
+        std::string fourth = publishReading(current, 4);
+        ok = ok && !fourth.empty() && get(server, fast, "/api/current", response) && response.body == fourth;
+        return report("slow client's snapshot survives new readings", ok);
+    }
+
+    bool checkLimits() {
+        static DashboardServer server(PORT + 2);
+        server.addPage("/", "text/html", (const uint8_t*)PAGE, sizeof(PAGE) - 1);
+        server.begin();
+        bool ok = true;
+
+        Browser browsers[DashboardServer::MAX_CLIENTS + 1];
+        for (int i = 0; i < DashboardServer::MAX_CLIENTS; i++) ok = ok && browsers[i].connect(PORT + 2);
+        server.poll();
+        Browser& waiting = browsers[DashboardServer::MAX_CLIENTS];
+        ok = ok && waiting.connect(PORT + 2);
+        Response response;
+        waiting.request("GET", "/");
+        server.poll();
+        ok = ok && server.clientCount() == DashboardServer::MAX_CLIENTS && !waiting.next(response);
+
+        browsers[0].socket->close();
+        server.poll();  // Frees the slot
+        ok = ok && fetch(server, waiting, response) && response.status == 200;
+
+        SimClock::advanceMillis(DashboardServer::IDLE_TIMEOUT_MS + 1000);
+        server.poll();
+        ok = ok && server.clientCount() == 0 && browsers[1].socket->deviceClosed
+             && server.getStats().timeouts == DashboardServer::MAX_CLIENTS
+             && server.getStats().maxClients == DashboardServer::MAX_CLIENTS;
+        return report("client limit, backlog and idle timeout", ok);
+    }
+
+    bool checkAssets() {
+        static DashboardServer server(PORT + 4);
+        bool ok = true;
+        for (size_t i = 0; i < DASHBOARD_ASSET_COUNT; i++) {
+            const DashboardAsset& asset = DASHBOARD_ASSETS[i];
+            ok = server.addAsset(asset.path, asset.contentType, asset.body, asset.length, asset.etag,
+                                 asset.immutable) && ok;
+        }
+        server.begin();
+        Browser browser;
+        ok = ok && browser.connect(PORT + 4);
+
+        printf("  %-22s %8s %8s %8s %11s %11s %9s\n", "asset", "source", "minified", "gzip", "first load",
+               "repeat load", "TTFB");
+        size_t sourceTotal = 0;
+        uint64_t firstTotal = 0;
+        uint64_t repeatTotal = 0;
+        for (size_t i = 0; i < DASHBOARD_ASSET_COUNT && ok; i++) {
+            const DashboardAsset& asset = DASHBOARD_ASSETS[i];
+            const DashboardRouteStats* route = server.getRouteStats(asset.path);
+            Response response;
+
+            // First load; time the poll() that answers, up to the first byte on the socket
+            browser.request("GET", asset.path);
+            uint64_t start = hostNanos();
+            server.poll();
+            uint64_t firstByteNanos = hostNanos() - start;
+            ok = ok && !browser.socket->fromDevice.empty() && fetch(server, browser, response)
+                 && response.status == 200 && response.body.size() == asset.length
+                 && memcmp(response.body.data(), asset.body, asset.length) == 0
+                 && (uint8_t)response.body[0] == 0x1f && (uint8_t)response.body[1] == 0x8b
+                 && response.headers.find("Content-Encoding: gzip\r\n") != std::string::npos
+                 && response.headers.find(std::string("ETag: ") + asset.etag + "\r\n") != std::string::npos
+                 && response.headers.find(asset.immutable ? "immutable" : "no-cache") != std::string::npos;
+            uint64_t firstBytes = route ? route->bytesSent : 0;
+
+            // Reload: the browser asks with the ETag it has (immutable ones it would not ask for at all)
+            std::string ifNoneMatch = std::string("If-None-Match: ") + asset.etag + "\r\n";
+            browser.request("GET", asset.path, "keep-alive", ifNoneMatch);
+            ok = ok && fetch(server, browser, response) && response.status == 304 && response.body.empty()
+                 && response.headers.find(asset.etag) != std::string::npos;
+            uint64_t revalidateBytes = route ? route->bytesSent - firstBytes : 0;
+            browser.request("GET", asset.path, "keep-alive", "If-None-Match: \"0123456789abcdef\"\r\n");
+            ok = ok && fetch(server, browser, response) && response.status == 200 && route
+                 && route->notModified == 1;
+
+            uint64_t repeatBytes = asset.immutable ? 0 : revalidateBytes;
+            printf("  %-22s %8zu %8zu %8zu %9llu B %9llu B %6.1f us\n", asset.path, asset.sourceLength,
+                   asset.minifiedLength, asset.length, (unsigned long long)firstBytes,
+                   (unsigned long long)repeatBytes, (double)firstByteNanos / 1e3);
+            sourceTotal += asset.sourceLength;
+            firstTotal += firstBytes;
+            repeatTotal += repeatBytes;
+        }
+        printf("  page load: %llu bytes first (%zu in web/), %llu bytes repeated (one 304)\n",
+               (unsigned long long)firstTotal, sourceTotal, (unsigned long long)repeatTotal);
+        return report("gzipped assets, ETag and 304", ok);
+    }
+
+    size_t serveHistory(const char* query, char* body, size_t capacity, void* context) {
+        return formatHistoryJson(body, capacity, *(HistoryStore*)context, query);
+    }
+
+    bool checkQuery() {
+        static HistoryStore store;
+        static DashboardServer server(PORT + 5);
+        const uint32_t start = 1767225600u;
+        bool ok = store.begin(HISTORY_MAX_POINTS) && server.addQuery("/api/history", serveHistory, &store);
+        for (int i = 0; i < HISTORY_MAX_POINTS; i++) {
+            store.add(start + i, sampleReading(i));
+        }
+        server.begin();
+        Browser browser;
+        Response response;
+        ok = ok && browser.connect(PORT + 5);
+
+        // One bucket per reading: larger than the socket's send buffer
+        char query[128];
+        snprintf(query, sizeof(query), "/api/history?from=%u&to=%u&points=%d&field=temperature", start,
+                 start + HISTORY_MAX_POINTS - 1, HISTORY_MAX_POINTS);
+        static char expected[DashboardServer::QUERY_RESPONSE_BYTES];
+        size_t length = formatHistoryJson(expected, sizeof(expected), store, strchr(query, '?') + 1);
+        uint32_t shortWrites = server.getStats().shortWrites;
+        ok = ok && get(server, browser, query, response) && response.status == 200
+             && response.body == std::string(expected, length)
+             && response.headers.find("application/json") != std::string::npos
+             && length > browser.socket->sendBuffer && server.getStats().shortWrites > shortWrites;
+        ok = ok && get(server, browser, "/api/history", response) && response.status == 200
+             && response.body.find("\"points\":[[") != std::string::npos;
+        const DashboardRouteStats* route = server.getRouteStats("/api/history");
+        ok = ok && route && route->requests == 2 && server.getStats().queries == 2;
+
+        std::string longQuery = "/api/history?from=1&_=" + std::string(DashboardServer::QUERY_BYTES, '0');
+        ok = ok && get(server, browser, longQuery.c_str(), response) && response.status == 414;
+        Browser refused;
+        ok = ok && refused.connect(PORT + 5);
+        ok = ok && get(server, refused, "/api/history?points=0", response) && response.status == 400;
+        return report("query route: handler body, 400 and 414", ok);
+    }
+
+    // What a handler that serializes on every request builds (String JSON plus a header String)
+    String perRequestResponse(const SensorData& reading, uint32_t timestamp) {
+        String json = "{\"pm1\":";
+        json += String(reading.pm1, 1);
+        json += ",\"pm25\":";
+        json += String(reading.pm25, 1);
+        json += ",\"pm4\":";
+        json += String(reading.pm4, 1);
+        json += ",\"pm10\":";
+        json += String(reading.pm10, 1);
+        json += ",\"temperature\":";
+        json += String(reading.temperature, 1);
+        json += ",\"humidity\":";
+        json += String(reading.humidity, 1);
+        json += ",\"voc\":";
+        json += (int)reading.voc;
+        json += ",\"nox\":";
+        json += (int)reading.nox;
+        json += ",\"timestamp\":";
+        json += (unsigned long)timestamp;
+        json += ",\"quality\":\"GOOD\"}";
+        String response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: ";
+        response += json.length();
+        response += "\r\n\r\n";
+        response += json;
+        return response;
+    }
+
+    bool measureLoad() {
+        const int REQUESTS = 40000;
+        const int REQUESTS_PER_READING = 8;
+        static JsonSnapshot current;
+        static JsonSnapshot status;
+        static DashboardServer server(PORT + 3);
+        server.addPage("/", "text/html", (const uint8_t*)PAGE, sizeof(PAGE) - 1);
+        server.addSnapshot("/api/current", current);
+        server.addSnapshot("/api/status", status);
+        server.begin();
+        publishReading(current, 0);
+        char* body = status.edit();
+        status.publish((size_t)snprintf(body, JsonSnapshot::MAX_BODY, "{\"uptime\":1}"));
+
+        Browser browsers[DashboardServer::MAX_CLIENTS];
+        bool connected = true;
+        for (Browser& browser : browsers) connected = browser.connect(PORT + 3) && connected;
+        if (!connected) return report("no heap use while serving", false);
+        const char* paths[] = {"/api/current", "/api/status", "/api/current", "/"};
+
+        SimHeapStats heapBefore = SimHeap::stats();
+        uint64_t pollNanos = 0;
+        uint64_t bytes = 0;
+        int completed = 0;
+        int issued = 0;
+        Response response;
+        for (int round = 0; completed < REQUESTS && round < 2 * REQUESTS; round++) {
+            for (Browser& browser : browsers) {
+                browser.request("GET", paths[issued++ % 4]);
+            }
+            uint64_t start = hostNanos();
+            server.poll();
+            pollNanos += hostNanos() - start;
+            for (Browser& browser : browsers) {
+                while (browser.next(response)) {
+                    bytes += response.body.size();
+                    if (++completed % REQUESTS_PER_READING == 0) publishReading(current, (uint32_t)completed);
+                }
+            }
+        }
+        SimHeapStats heapAfter = SimHeap::stats();
+        uint64_t allocations = heapAfter.allocations - heapBefore.allocations;
+        double perRequest = (double)pollNanos / completed;
+        if (completed < REQUESTS) return report("no heap use while serving", false); // Server stalled
+        printf("  %d requests from %d keep-alive browsers: %.2f us host in poll() per request, simulated"
+               " sockets included (%.0f requests/s), %.0f body bytes/request\n", completed, DashboardServer::MAX_CLIENTS,
+               perRequest / 1e3, 1e9 / perRequest, (double)bytes / completed);
+        printf("  heap: %llu allocations during poll() and publish; static: server %zu bytes,"
+               " %zu per snapshot\n", (unsigned long long)allocations, sizeof(DashboardServer),
+               sizeof(JsonSnapshot));
+
+        // Producing one response: pin the snapshot vs. serialize into Strings
+        const int ROUNDS = 200000;
+        uint64_t sum = 0;
+        uint64_t start = hostNanos();
+        for (int i = 0; i < ROUNDS; i++) {
+            const uint8_t* data;
+            size_t length;
+            int buffer = current.acquire(data, length);
+            sum += length + data[length - 1];
+            current.release(buffer);
+        }
+        double snapshotNanos = (double)(hostNanos() - start) / ROUNDS;
+        SimHeapStats stringBefore = SimHeap::stats();
+        start = hostNanos();
+        for (int i = 0; i < ROUNDS; i++) {
+            String text = perRequestResponse(sampleReading((uint32_t)i), 1767225600u);
+            sum += text.length();
+        }
+        double stringNanos = (double)(hostNanos() - start) / ROUNDS;
+        SimHeapStats stringAfter = SimHeap::stats();
+        doNotOptimize(sum);
+        printf("  per response: snapshot %.1f ns, 0 allocations; per-request String JSON %.0f ns,"
+               " %.1f allocations, %.0f bytes allocated\n", snapshotNanos, stringNanos,
+               (double)(stringAfter.allocations - stringBefore.allocations) / ROUNDS,
+               (double)(stringAfter.bytesAllocated - stringBefore.bytesAllocated) / ROUNDS);
+        return report("no heap use while serving", allocations == 0);
+    }
+}
+
+int runWebBench(const BenchOptions& options) {
+    (void)options;
+    bool ok = checkRoutes();
+    ok = checkSlowClient() && ok;
+    ok = checkLimits() && ok;
+    ok = checkAssets() && ok;
+    ok = checkQuery() && ok;
+    ok = measureLoad() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file main.cpp
+ * @brief Entry point for the native benchmark binary
+ *
+ * Usage: program [suite] [--hours H] [--seed N] [--echo] [--net-fail P]
+ *                [--spikes P] [--outage-every MIN] [--outage-seconds S]
+ *                [--server-idle S] [--fixed-interval] [--sensor-ppm N]
+ *                [--log-level N] [--performance] [--mqtt]
+ *                [--record-trace FILE] [--replay FILE]
+ *
+ * Without a suite name every suite runs in turn.
+ */
+
+#include "Bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+    struct Suite {
+        const char* name;
+        const char* description;
+        int (*run)(const BenchOptions&);
+    };
+
+    const Suite SUITES[] = {
+        {"loop", "Drive setup()/loop() over simulated hours", runLoopBench},
+        {"averaging", "DataAveraging push/mean cost and window check", runAveragingBench},
+        {"history", "SoA SensorHistory vs per-field scalar window reduction", runHistoryBench},
+        {"queue", "LittleFS UploadQueue crash recovery, bounds and flash cost", runQueueBench},
+        {"bulk", "BulkUploader encoding cost and bulk_update.json acceptance", runBulkBench},
+        {"session", "Keep-alive UploadSession connect vs transfer time and stale sockets", runSessionBench},
+        {"spsc", "Sensor-task SampleQueue stressed across two host threads", runSpscBench},
+        {"log", "Deferred logger formatting, MPSC ring stress and hot-path cost", runLogBench},
+        {"scheduler", "Timer-heap scheduler against a reference, wrap and dispatch cost", runSchedulerBench},
+        {"web", "Dashboard server routes, slow clients and snapshot serving under load", runWebBench},
+        {"push", "WebSocket push protocol and many slow and fast clients", runPushBench},
+        {"store", "PSRAM HistoryStore memory, downsampled query cost and check", runStoreBench},
+        {"metrics", "Latency histogram buckets, record() cost and /metrics format check", runMetricsBench},
+        {"codec", "Binary record codec round trips, damaged streams, size and speed", runCodecBench},
+        {"mqtt", "MQTT QoS 1 publisher delivery, window, lost acks, throughput", runMqttBench},
+        {"filter", "Sample filter median check, spike and step handling, cost by window", runFilterBench},
+        {"trace", "Field trace round trips, damaged blocks, flash budget, size and speed", runTraceBench},
+    };
+
+    void printUsage(const char* program) {
+        printf("Usage: %s [suite] [options]\n\nSuites:\n", program);
+        for (const Suite& suite : SUITES) {
+            printf("  %-12s %s\n", suite.name, suite.description);
+        }
+        printf("\nOptions:\n"
+               "  --hours H           Simulated duration (default 6)\n"
+               "  --seed N            Sensor model seed (default 1)\n"
+               "  --echo              Mirror firmware Serial output\n"
+               "  --net-fail P        Probability a TCP connect fails\n"
+               "  --spikes P          Probability of a PM spike per sample\n"
+               "  --outage-every MIN  Drop WiFi every MIN minutes\n"
+               "  --outage-seconds S  Length of each outage (default 120)\n"
+               "  --server-idle S     Server keep-alive idle timeout (default 15)\n"
+               "  --fixed-interval    Read the sensor on a 1 s timer instead of its data-ready flag\n"
+               "  --sensor-ppm N      SEN55 clock error, + = slower (default 2500)\n"
+               "  --log-level N       Firmware log level after setup(): 0 off .. 4 debug\n"
+               "  --performance       Run in POWER_PERFORMANCE (no light sleep, radio always on)\n"
+               "  --mqtt              Upload over MQTT to a broker stand-in instead of ThingSpeak\n"
+               "  --record-trace FILE Write the firmware's field trace (serial lines) to FILE\n"
+               "  --replay FILE       Play a field trace back through the firmware (loop suite)\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    const char* only = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--hours") == 0 && hasValue) options.hours = atof(argv[++i]);
+        else if (strcmp(arg, "--seed") == 0 && hasValue) options.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--echo") == 0) options.echoSerial = true;
+        else if (strcmp(arg, "--net-fail") == 0 && hasValue) options.netFailure = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--spikes") == 0 && hasValue) options.spikeProbability = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--outage-every") == 0 && hasValue) options.outageEveryMin = (unsigned)atoi(argv[++i]);
+        else if (strcmp(arg, "--outage-seconds") == 0 && hasValue) options.outageSeconds = (unsigned)atoi(argv[++i]);
+        else if (strcmp(arg, "--server-idle") == 0 && hasValue) options.serverIdleSeconds = (unsigned)atoi(argv[++i]);
+        else if (strcmp(arg, "--fixed-interval") == 0) options.fixedIntervalReads = true;
+        else if (strcmp(arg, "--sensor-ppm") == 0 && hasValue) options.sensorClockPpm = atoi(argv[++i]);
+        else if (strcmp(arg, "--log-level") == 0 && hasValue) options.logLevel = atoi(argv[++i]);
+        else if (strcmp(arg, "--performance") == 0) options.performancePower = true;
+        else if (strcmp(arg, "--mqtt") == 0) options.mqtt = true;
+        else if (strcmp(arg, "--record-trace") == 0 && hasValue) options.recordTracePath = argv[++i];
+        else if (strcmp(arg, "--replay") == 0 && hasValue) options.replayPath = argv[++i];
+        else if (arg[0] != '-' && !only) only = arg;
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    int failures = 0;
+    bool matched = false;
+    for (const Suite& suite : SUITES) {
+        if (only && strcmp(only, suite.name) != 0) continue;
+        matched = true;
+        printf("== %s ==\n", suite.name);
+        failures += suite.run(options) != 0;
+        printf("\n");
+    }
+
+    if (!matched) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    return failures ? 1 : 0;
+}
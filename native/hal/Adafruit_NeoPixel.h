@@ -0,0 +1,39 @@
+/**
+ * @file Adafruit_NeoPixel.h
+ * @brief Host stand-in for the NeoPixel driver (records the last colour)
+ */
+
+#ifndef NATIVE_HAL_ADAFRUIT_NEOPIXEL_H
+#define NATIVE_HAL_ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+public:
+    Adafruit_NeoPixel(uint16_t numPixels, int16_t pin, uint16_t type)
+        : count(numPixels), pin(pin), type(type) {}
+
+    void begin() {}
+    void show() { shows++; }
+    void clear() { lastColor = 0; }
+    void setBrightness(uint8_t value) { brightness = value; }
+    void setPixelColor(uint16_t index, uint32_t color) { (void)index; lastColor = color; }
+    uint32_t getPixelColor(uint16_t index) const { (void)index; return lastColor; }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+        return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+private:
+    uint16_t count;
+    int16_t pin;
+    uint16_t type;
+    uint8_t brightness = 255;
+    uint32_t lastColor = 0;
+    unsigned long shows = 0;
+};
+
+#endif // NATIVE_HAL_ADAFRUIT_NEOPIXEL_H
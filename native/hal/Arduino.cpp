@@ -0,0 +1,416 @@
+/**
+ * @file Arduino.cpp
+ * @brief Host implementation of the Arduino core stand-in
+ */
+
+#include "Arduino.h"
+#include "Simulation.h"
+
+#include <map>
+#include <new>
+
+// ---------------------------------------------------------------------------
+// Timing (the virtual clock and task scheduler live in FreeRTOS.cpp)
+// ---------------------------------------------------------------------------
+
+unsigned long millis() { return (unsigned long)(SimClock::nowMicros() / 1000ULL); }
+unsigned long micros() { return (unsigned long)SimClock::nowMicros(); }
+// vTaskDelay() on the device: other tasks run while this one waits (every
+// advance of the virtual clock lets tasks that fell behind catch up)
+void delay(unsigned long ms) { SimClock::sleepMicros(ms * 1000ULL); }
+void delayMicroseconds(unsigned int us) { SimClock::advanceMicros(us); }
+void yield() {}
+
+namespace {
+    uint32_t randomState = 0x9E3779B9u;
+}
+
+long random(long howBig) {
+    if (howBig <= 0) return 0;
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return (long)(randomState % (uint32_t)howBig);
+}
+
+long random(long howSmall, long howBig) {
+    return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+// ---------------------------------------------------------------------------
+// Wall clock
+// ---------------------------------------------------------------------------
+
+namespace {
+    const uint64_t SNTP_SYNC_MICROS = 250000; // Request/response to the NTP pool
+    bool sntpStarted = false;
+    uint64_t sntpSyncedAt = 0;
+    bool sntpSyncFixed = false;
+}
+
+void SimClock::setSntpSyncMicros(uint64_t atUs) {
+    sntpSyncFixed = true;
+    sntpSyncedAt = atUs;
+}
+
+void configTime(long gmtOffsetSeconds, int daylightOffsetSeconds, const char* server1,
+                const char* server2, const char* server3) {
+    (void)gmtOffsetSeconds; (void)daylightOffsetSeconds;
+    (void)server1; (void)server2; (void)server3;
+    if (!sntpStarted) {
+        sntpStarted = true;
+        if (!sntpSyncFixed) sntpSyncedAt = SimClock::nowMicros() + SNTP_SYNC_MICROS;
+    }
+}
+
+// Replaces libc's time() for the whole program, the same way newlib's
+// time() on the ESP32 reads the SNTP-adjusted system clock
+time_t time(time_t* out) noexcept {
+    uint64_t nowUs = SimClock::nowMicros();
+    time_t now = (time_t)(nowUs / 1000000ULL);
+    if (sntpStarted && nowUs >= sntpSyncedAt) now += SimClock::epochAtBoot();
+    if (out) *out = now;
+    return now;
+}
+
+bool getLocalTime(struct tm* info, uint32_t timeoutMs) {
+    const time_t VALID_AFTER = 1609459200; // 2021-01-01, as the ESP32 core checks
+    uint64_t deadline = SimClock::nowMicros() + (uint64_t)timeoutMs * 1000ULL;
+    time_t now = time(nullptr);
+    while (now < VALID_AFTER && SimClock::nowMicros() < deadline) {
+        delay(10);
+        now = time(nullptr);
+    }
+    if (now < VALID_AFTER) return false;
+    gmtime_r(&now, info);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Heap accounting
+// ---------------------------------------------------------------------------
+
+namespace {
+    SimHeapStats heapStats = {0, 0, 0, 0, 0, SimHeap::HEAP_SIZE, SimHeap::HEAP_SIZE, SimHeap::HEAP_SIZE};
+    const size_t HEAP_HEADER = 32; // Keeps returned pointers 16-byte aligned
+
+    // First-fit model of the device heap: free blocks by offset
+    const uint32_t ARENA_BLOCK_HEADER = 8;
+    const uint32_t ARENA_MIN_BLOCK = 16;
+    const size_t ARENA_UNPLACED = (size_t)-1;
+
+    std::map<uint32_t, uint32_t>& arenaFreeBlocks() {
+        static std::map<uint32_t, uint32_t>* blocks = nullptr;
+        if (!blocks) {
+            SimTasks::untrackedDepth()++;
+            blocks = new std::map<uint32_t, uint32_t>();
+            (*blocks)[0] = SimHeap::HEAP_SIZE;
+            SimTasks::untrackedDepth()--;
+        }
+        return *blocks;
+    }
+
+    void arenaUpdateLargest() {
+        uint32_t largest = 0;
+        for (const auto& block : arenaFreeBlocks()) {
+            if (block.second > largest) largest = block.second;
+        }
+        largest = largest > ARENA_BLOCK_HEADER ? largest - ARENA_BLOCK_HEADER : 0;
+        heapStats.largestFreeBlock = largest;
+        if (largest < heapStats.minLargestFreeBlock) heapStats.minLargestFreeBlock = largest;
+    }
+
+    size_t arenaPlace(size_t size, size_t& blockSize) {
+        SimTasks::untrackedDepth()++;
+        size_t needed = (size + ARENA_BLOCK_HEADER + 3) & ~(size_t)3;
+        if (needed < ARENA_MIN_BLOCK) needed = ARENA_MIN_BLOCK;
+        std::map<uint32_t, uint32_t>& blocks = arenaFreeBlocks();
+        size_t offset = ARENA_UNPLACED;
+        for (auto it = blocks.begin(); it != blocks.end(); ++it) {
+            if (it->second < needed) continue;
+            offset = it->first;
+            uint32_t remaining = it->second - (uint32_t)needed;
+            blocks.erase(it);
+            if (remaining >= ARENA_MIN_BLOCK) blocks[(uint32_t)(offset + needed)] = remaining;
+            else needed += remaining; // Too small to split off
+            heapStats.freeBytes -= (uint32_t)needed;
+            break;
+        }
+        blockSize = needed;
+        arenaUpdateLargest();
+        SimTasks::untrackedDepth()--;
+        return offset;
+    }
+
+    void arenaRelease(size_t offset, size_t blockSize) {
+        if (offset == ARENA_UNPLACED) return;
+        SimTasks::untrackedDepth()++;
+        std::map<uint32_t, uint32_t>& blocks = arenaFreeBlocks();
+        uint32_t start = (uint32_t)offset;
+        uint32_t length = (uint32_t)blockSize;
+        heapStats.freeBytes += length;
+        auto next = blocks.lower_bound(start);
+        if (next != blocks.end() && start + length == next->first) {
+            length += next->second;
+            next = blocks.erase(next);
+        }
+        if (next != blocks.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == start) {
+                start = prev->first;
+                length += prev->second;
+                blocks.erase(prev);
+            }
+        }
+        blocks[start] = length;
+        arenaUpdateLargest();
+        SimTasks::untrackedDepth()--;
+    }
+
+    // Header layout: [0] requested size, [1] non-zero if counted in heapStats,
+    // [2] offset in the heap model, [3] model block size
+    void* trackedAlloc(size_t size) {
+        unsigned char* block = (unsigned char*)malloc(size + HEAP_HEADER);
+        if (!block) throw std::bad_alloc();
+        size_t* header = (size_t*)block;
+        header[0] = size;
+        header[1] = SimTasks::untrackedDepth() == 0;
+        if (!header[1]) return block + HEAP_HEADER;
+        header[2] = arenaPlace(size, header[3]);
+        heapStats.allocations++;
+        heapStats.bytesAllocated += size;
+        heapStats.liveBytes += size;
+        if (heapStats.liveBytes > heapStats.peakLiveBytes) {
+            heapStats.peakLiveBytes = heapStats.liveBytes;
+        }
+        return block + HEAP_HEADER;
+    }
+
+    void trackedFree(void* ptr) {
+        if (!ptr) return;
+        unsigned char* block = (unsigned char*)ptr - HEAP_HEADER;
+        size_t* header = (size_t*)block;
+        if (header[1]) {
+            heapStats.frees++;
+            heapStats.liveBytes -= header[0];
+            arenaRelease(header[2], header[3]);
+        }
+        free(block);
+    }
+}
+
+SimHeapStats SimHeap::stats() { return heapStats; }
+void SimHeap::resetPeak() {
+    heapStats.peakLiveBytes = heapStats.liveBytes;
+    heapStats.minLargestFreeBlock = heapStats.largestFreeBlock;
+}
+SimHeap::Untracked::Untracked() { SimTasks::untrackedDepth()++; }
+SimHeap::Untracked::~Untracked() { SimTasks::untrackedDepth()--; }
+
+void* operator new(size_t size) { return trackedAlloc(size); }
+void* operator new[](size_t size) { return trackedAlloc(size); }
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { trackedFree(ptr); }
+
+// ---------------------------------------------------------------------------
+// String
+// ---------------------------------------------------------------------------
+
+namespace {
+    std::string formatUnsigned(unsigned long number, unsigned char base) {
+        if (base < 2) base = DEC;
+        char buffer[8 * sizeof(unsigned long) + 1];
+        char* p = buffer + sizeof(buffer) - 1;
+        *p = '\0';
+        do {
+            unsigned digit = number % base;
+            *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+            number /= base;
+        } while (number);
+        return p;
+    }
+
+    std::string formatSigned(long number, unsigned char base) {
+        if (number < 0 && base == DEC) {
+            return "-" + formatUnsigned((unsigned long)(-(number + 1)) + 1, base);
+        }
+        return formatUnsigned((unsigned long)number, base);
+    }
+
+    std::string formatFloat(double number, unsigned int decimals) {
+        if (isnan(number)) return "nan";
+        if (isinf(number)) return number > 0 ? "inf" : "-inf";
+        char buffer[48];
+        snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, number);
+        return buffer;
+    }
+}
+
+String::String(int number, unsigned char base) : value(formatSigned(number, base)) {}
+String::String(unsigned int number, unsigned char base) : value(formatUnsigned(number, base)) {}
+String::String(long number, unsigned char base) : value(formatSigned(number, base)) {}
+String::String(unsigned long number, unsigned char base) : value(formatUnsigned(number, base)) {}
+String::String(float number, unsigned int decimalPlaces) : value(formatFloat(number, decimalPlaces)) {}
+String::String(double number, unsigned int decimalPlaces) : value(formatFloat(number, decimalPlaces)) {}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = value.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const char* str, unsigned int from) const {
+    size_t pos = value.find(str, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from) const {
+    return from >= value.length() ? String() : String(value.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) { unsigned int tmp = from; from = to; to = tmp; }
+    if (from >= value.length()) return String();
+    return String(value.substr(from, to - from));
+}
+
+bool String::startsWith(const char* prefix) const {
+    return value.compare(0, strlen(prefix), prefix) == 0;
+}
+
+void String::trim() {
+    size_t begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) { value.clear(); return; }
+    size_t end = value.find_last_not_of(" \t\r\n");
+    value = value.substr(begin, end - begin + 1);
+}
+
+String operator+(const String& lhs, const String& rhs) { String s(lhs); s += rhs; return s; }
+String operator+(const String& lhs, const char* rhs) { String s(lhs); s += rhs; return s; }
+String operator+(const char* lhs, const String& rhs) { String s(lhs); s += rhs; return s; }
+
+// ---------------------------------------------------------------------------
+// Print / Stream
+// ---------------------------------------------------------------------------
+
+size_t Print::print(long number, int base) {
+    return print(String(number, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long number, int base) {
+    return print(String(number, (unsigned char)base));
+}
+
+size_t Print::print(double number, int digits) {
+    char buffer[48];
+    int n = snprintf(buffer, sizeof(buffer), "%.*f", digits, number);
+    return write(buffer, n < 0 ? 0 : (size_t)n);
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (n < 0) return 0;
+    return write(buffer, (size_t)n < sizeof(buffer) ? (size_t)n : sizeof(buffer) - 1);
+}
+
+int Stream::timedRead() {
+    if (available() > 0) return read();
+    // Nothing buffered: a real stream would block until the timeout expires
+    SimClock::advanceMillis(timeout);
+    return available() > 0 ? read() : -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0) break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0 || c == terminator) break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String result;
+    int c;
+    while ((c = timedRead()) >= 0) result += (char)c;
+    return result;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String result;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator) result += (char)c;
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Serial
+// ---------------------------------------------------------------------------
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    written += size;
+    if (echo) fwrite(buffer, 1, size, stdout);
+    if (baudRate == 0) return size; // begin() not called: no UART timing
+
+    // 8N1: ten bit times per byte; the caller waits until all but a FIFO's worth has gone out
+    uint64_t byteNanos = 10000000000ULL / baudRate;
+    uint64_t now = SimClock::nowMicros() * 1000ULL;
+    if (txIdleNanos < now) txIdleNanos = now;
+    txIdleNanos += size * byteNanos;
+    SimPower::busyUntil((txIdleNanos + 999) / 1000); // Light sleep waits for the FIFO to drain
+    uint64_t fifoNanos = TX_FIFO_BYTES * byteNanos;
+    if (txIdleNanos > now + fifoNanos) {
+        uint64_t waitUs = (txIdleNanos - now - fifoNanos + 999) / 1000;
+        blocked += waitUs;
+        SimClock::advanceMicros(waitUs);
+    }
+    return size;
+}
+
+// ---------------------------------------------------------------------------
+// ESP
+// ---------------------------------------------------------------------------
+
+EspClass ESP;
+
+void EspClass::restart() {
+    fprintf(stderr, "[sim] ESP.restart() called at %lu ms\n", millis());
+    exit(2);
+}
+
+uint32_t EspClass::getHeapSize() { return SimHeap::HEAP_SIZE; }
+
+uint32_t EspClass::getFreeHeap() {
+    uint64_t live = heapStats.liveBytes;
+    return live >= SimHeap::HEAP_SIZE ? 0 : (uint32_t)(SimHeap::HEAP_SIZE - live);
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    uint64_t peak = heapStats.peakLiveBytes;
+    return peak >= SimHeap::HEAP_SIZE ? 0 : (uint32_t)(SimHeap::HEAP_SIZE - peak);
+}
+
+uint32_t EspClass::getMaxAllocHeap() { return heapStats.largestFreeBlock; }
+uint32_t EspClass::getPsramSize() { return 8 * 1024 * 1024; }
+uint32_t EspClass::getFreePsram() { return getPsramSize(); }
+
+bool psramFound() { return true; }
+void* ps_malloc(size_t size) { return size <= ESP.getPsramSize() ? malloc(size) : nullptr; }
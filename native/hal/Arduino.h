@@ -0,0 +1,223 @@
+/**
+ * @file Arduino.h
+ * @brief Host-side stand-in for the Arduino core used by the native environment
+ *
+ * Provides just enough of the ESP32 Arduino API (String, Print, Serial,
+ * millis/delay, ESP) for the firmware sources in src/ to compile and run
+ * on a desktop machine. Time is simulated: delay() advances a virtual
+ * clock instantly, so hours of device behaviour run in seconds.
+ */
+
+#ifndef NATIVE_HAL_ARDUINO_H
+#define NATIVE_HAL_ARDUINO_H
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+
+#define F(str) (str)
+#define PROGMEM
+
+#define HEX 16
+#define DEC 10
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// ---------------------------------------------------------------------------
+// Timing (simulated clock, see SimClock in Simulation.h)
+// ---------------------------------------------------------------------------
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+/** Deterministic stand-ins for the Arduino PRNG (esp_random() on the device). */
+long random(long howBig);
+long random(long howSmall, long howBig);
+
+// Wall clock: time() counts seconds since boot until configTime() has
+// synced over SNTP, then follows SimClock::epochAtBoot() + uptime
+void configTime(long gmtOffsetSeconds, int daylightOffsetSeconds, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+bool getLocalTime(struct tm* info, uint32_t timeoutMs = 5000);
+
+// ---------------------------------------------------------------------------
+// String
+// ---------------------------------------------------------------------------
+
+class String {
+public:
+    String() = default;
+    String(const char* str) : value(str ? str : "") {}
+    String(const std::string& str) : value(str) {}
+    String(char c) : value(1, c) {}
+    String(int number, unsigned char base = DEC);
+    String(unsigned int number, unsigned char base = DEC);
+    String(long number, unsigned char base = DEC);
+    String(unsigned long number, unsigned char base = DEC);
+    String(float number, unsigned int decimalPlaces = 2);
+    String(double number, unsigned int decimalPlaces = 2);
+
+    unsigned int length() const { return value.length(); }
+    bool isEmpty() const { return value.empty(); }
+    const char* c_str() const { return value.c_str(); }
+    bool reserve(unsigned int size) { value.reserve(size); return true; }
+
+    String& operator+=(const String& rhs) { value += rhs.value; return *this; }
+    String& operator+=(const char* rhs) { value += rhs; return *this; }
+    String& operator+=(char rhs) { value += rhs; return *this; }
+    String& operator+=(int rhs) { return *this += String(rhs); }
+    String& operator+=(unsigned int rhs) { return *this += String(rhs); }
+    String& operator+=(long rhs) { return *this += String(rhs); }
+    String& operator+=(unsigned long rhs) { return *this += String(rhs); }
+    bool concat(const String& rhs) { value += rhs.value; return true; }
+
+    bool operator==(const String& rhs) const { return value == rhs.value; }
+    bool operator==(const char* rhs) const { return value == rhs; }
+    bool operator!=(const String& rhs) const { return value != rhs.value; }
+    char operator[](unsigned int index) const { return value[index]; }
+    char charAt(unsigned int index) const { return value[index]; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const char* str, unsigned int from = 0) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    bool startsWith(const char* prefix) const;
+    void trim();
+    long toInt() const { return atol(value.c_str()); }
+    float toFloat() const { return (float)atof(value.c_str()); }
+
+private:
+    std::string value;
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+
+// ---------------------------------------------------------------------------
+// Print / Stream
+// ---------------------------------------------------------------------------
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() = default;
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) { return write(&c, 1); }
+    virtual size_t write(const uint8_t* buffer, size_t size) = 0;
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str) { return write(str.c_str(), str.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int number, int base = DEC) { return print((long)number, base); }
+    size_t print(unsigned int number, int base = DEC) { return print((unsigned long)number, base); }
+    size_t print(long number, int base = DEC);
+    size_t print(unsigned long number, int base = DEC);
+    size_t print(double number, int digits = 2);
+    size_t print(const Printable& printable) { return printable.printTo(*this); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+
+    void setTimeout(unsigned long timeoutMs) { timeout = timeoutMs; }
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    size_t readBytesUntil(char terminator, char* buffer, size_t length);
+    String readString();
+    String readStringUntil(char terminator);
+
+protected:
+    int timedRead();
+    unsigned long timeout = 1000;
+};
+
+// ---------------------------------------------------------------------------
+// Serial
+// ---------------------------------------------------------------------------
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { baudRate = baud; }
+    using Print::write;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() const { return true; }
+
+    /** Echo output to stdout (off by default so benchmarks stay quiet). */
+    void setEcho(bool enabled) { echo = enabled; }
+    /** Total bytes written since start, used to model UART cost. */
+    unsigned long long bytesWritten() const { return written; }
+    /** Simulated time writers spent waiting for room in the TX FIFO. */
+    unsigned long long blockedMicros() const { return blocked; }
+
+private:
+    // Arduino-ESP32 installs the UART driver without a TX ring buffer, so
+    // write() returns only once the rest of the data fits in the FIFO
+    static const uint32_t TX_FIFO_BYTES = 128;
+
+    unsigned long baudRate = 0;
+    bool echo = false;
+    unsigned long long written = 0;
+    unsigned long long blocked = 0;
+    uint64_t txIdleNanos = 0;  // When the FIFO will have drained everything written so far
+};
+
+extern HardwareSerial Serial;
+
+// ---------------------------------------------------------------------------
+// ESP system object
+// ---------------------------------------------------------------------------
+
+class EspClass {
+public:
+    [[noreturn]] void restart();
+    uint32_t getHeapSize();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getPsramSize();
+    uint32_t getFreePsram();
+    uint32_t getCpuFreqMHz() { return 240; }
+};
+
+extern EspClass ESP;
+
+// PSRAM (the N16R8's 8 MB): ps_malloc() is plain host malloc(), outside the
+// modelled internal heap
+bool psramFound();
+void* ps_malloc(size_t size);
+
+#endif // NATIVE_HAL_ARDUINO_H
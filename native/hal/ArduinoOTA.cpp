@@ -0,0 +1,8 @@
+/**
+ * @file ArduinoOTA.cpp
+ * @brief Global instance for the ArduinoOTA stand-in
+ */
+
+#include "ArduinoOTA.h"
+
+ArduinoOTAClass ArduinoOTA;
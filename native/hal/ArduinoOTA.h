@@ -0,0 +1,58 @@
+/**
+ * @file ArduinoOTA.h
+ * @brief Host stand-in for the ESP32 ArduinoOTA service
+ *
+ * Callbacks are stored but never fired; handle() only counts calls so
+ * benchmarks can confirm the loop keeps servicing OTA during outages.
+ */
+
+#ifndef NATIVE_HAL_ARDUINO_OTA_H
+#define NATIVE_HAL_ARDUINO_OTA_H
+
+#include <Arduino.h>
+
+#include <functional>
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+typedef enum {
+    OTA_AUTH_ERROR,
+    OTA_BEGIN_ERROR,
+    OTA_CONNECT_ERROR,
+    OTA_RECEIVE_ERROR,
+    OTA_END_ERROR
+} ota_error_t;
+
+class ArduinoOTAClass {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+    typedef std::function<void(ota_error_t)> THandlerFunction_Error;
+    typedef std::function<void(unsigned int, unsigned int)> THandlerFunction_Progress;
+
+    ArduinoOTAClass& setHostname(const char* name) { (void)name; return *this; }
+    ArduinoOTAClass& setPassword(const char* password) { (void)password; return *this; }
+    ArduinoOTAClass& onStart(THandlerFunction fn) { startCallback = fn; return *this; }
+    ArduinoOTAClass& onEnd(THandlerFunction fn) { endCallback = fn; return *this; }
+    ArduinoOTAClass& onError(THandlerFunction_Error fn) { errorCallback = fn; return *this; }
+    ArduinoOTAClass& onProgress(THandlerFunction_Progress fn) { progressCallback = fn; return *this; }
+
+    void begin() { started = true; }
+    void handle() { handleCalls++; }
+    int getCommand() const { return U_FLASH; }
+
+    /** Number of handle() calls, a proxy for OTA responsiveness. */
+    unsigned long long handleCount() const { return handleCalls; }
+
+private:
+    THandlerFunction startCallback;
+    THandlerFunction endCallback;
+    THandlerFunction_Error errorCallback;
+    THandlerFunction_Progress progressCallback;
+    bool started = false;
+    unsigned long long handleCalls = 0;
+};
+
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif // NATIVE_HAL_ARDUINO_OTA_H
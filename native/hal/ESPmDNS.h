@@ -0,0 +1,25 @@
+/**
+ * @file ESPmDNS.h
+ * @brief Host stand-in for the ESP32 mDNS responder (records the name, answers nothing)
+ */
+
+#ifndef NATIVE_HAL_ESPMDNS_H
+#define NATIVE_HAL_ESPMDNS_H
+
+#include <Arduino.h>
+
+class MDNSResponder {
+public:
+    bool begin(const char* hostName) { (void)hostName; return true; }
+    bool addService(const char* service, const char* proto, uint16_t port) {
+        (void)service;
+        (void)proto;
+        (void)port;
+        return true;
+    }
+    void end() {}
+};
+
+extern MDNSResponder MDNS;
+
+#endif // NATIVE_HAL_ESPMDNS_H
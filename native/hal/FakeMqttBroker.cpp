@@ -0,0 +1,202 @@
+/**
+ * @file FakeMqttBroker.cpp
+ * @brief In-process model of an MQTT 3.1.1 broker taking QoS 1 publishes
+ */
+
+#include "Simulation.h"
+
+#include "RecordCodec.h"
+
+namespace {
+    const uint8_t CONNECT = 1;
+    const uint8_t PUBLISH = 3;
+    const uint8_t PINGREQ = 12;
+    const uint8_t DISCONNECT = 14;
+
+    /** Big-endian 16-bit value at body[pos] */
+    uint16_t read16(const std::string& body, size_t pos) {
+        return (uint16_t)((uint8_t)body[pos] << 8 | (uint8_t)body[pos + 1]);
+    }
+
+    /** Length-prefixed string at body[pos]; false if it runs past the end */
+    bool readString(const std::string& body, size_t& pos, std::string& out) {
+        if (pos + 2 > body.size()) return false;
+        size_t length = read16(body, pos);
+        if (pos + 2 + length > body.size()) return false;
+        out = body.substr(pos + 2, length);
+        pos += 2 + length;
+        return true;
+    }
+}
+
+FakeMqttBroker::FakeMqttBroker() : counters(), randomState(0x2545F491) {}
+
+float FakeMqttBroker::nextUnit() {
+    randomState = randomState * 1664525u + 1013904223u;
+    return (randomState >> 8) / 16777216.0f;
+}
+
+void FakeMqttBroker::onData(SimStreamConnection& connection) {
+    SimHeap::Untracked untracked;
+    std::string& input = connection.input;
+    while (!connection.closing && input.size() >= 2) {
+        // Fixed header: type and flags, then the remaining length in up to 4 varint bytes
+        size_t remaining = 0;
+        size_t pos = 1;
+        int shift = 0;
+        bool complete = false;
+        while (pos < input.size() && pos <= 4) {
+            uint8_t byte = (uint8_t)input[pos++];
+            remaining |= (size_t)(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete) {
+            if (pos > 4) {
+                counters.malformed++;
+                connection.closing = true;
+            }
+            return;
+        }
+        if (input.size() < pos + remaining) {
+            return; // The rest of the packet is still on its way
+        }
+        uint8_t first = (uint8_t)input[0];
+        std::string body = input.substr(pos, remaining);
+        input.erase(0, pos + remaining);
+        counters.bytesReceived += pos + remaining;
+        if (!handlePacket(connection, first, body)) {
+            counters.malformed++;
+            connection.closing = true;
+        }
+    }
+}
+
+void FakeMqttBroker::onClose(SimStreamConnection& connection) {
+    SimHeap::Untracked untracked;
+    clients.erase(connection.id);
+}
+
+const std::vector<uint32_t>& FakeMqttBroker::timestamps(const char* clientId) {
+    SimHeap::Untracked untracked;
+    return sessions[clientId].timestamps;
+}
+
+void FakeMqttBroker::clearSessions() {
+    SimHeap::Untracked untracked;
+    sessions.clear();
+}
+
+bool FakeMqttBroker::handlePacket(SimStreamConnection& connection, uint8_t first, const std::string& body) {
+    uint8_t type = first >> 4;
+    bool connected = clients.count(connection.id) != 0;
+    if (type == CONNECT) {
+        return !connected && handleConnect(connection, body); // A second CONNECT is a protocol violation
+    }
+    if (!connected) {
+        return false;
+    }
+    if (type == PUBLISH) {
+        return handlePublish(connection, first & 0x0F, body);
+    }
+    if (type == PINGREQ && body.empty()) {
+        counters.pings++;
+        connection.reply(std::string("\xD0\x00", 2), settings.replyMillis);
+        return true;
+    }
+    if (type == DISCONNECT && body.empty()) {
+        connection.closing = true;
+        return true;
+    }
+    return false;
+}
+
+bool FakeMqttBroker::handleConnect(SimStreamConnection& connection, const std::string& body) {
+    size_t pos = 0;
+    std::string protocol;
+    std::string clientId;
+    if (!readString(body, pos, protocol) || protocol != "MQTT" || pos + 4 > body.size()) {
+        return false;
+    }
+    uint8_t level = (uint8_t)body[pos];
+    uint8_t flags = (uint8_t)body[pos + 1];
+    uint16_t keepAlive = read16(body, pos + 2);
+    pos += 4;
+    if (level != 4 || (flags & 0x01) || (flags & 0xFC) || !readString(body, pos, clientId) || clientId.empty()
+        || pos != body.size()) {
+        return false; // 3.1.1, no will, user name or password, and a client id
+    }
+
+    bool cleanSession = (flags & 0x02) != 0;
+    bool present = sessions.count(clientId) != 0;
+    if (cleanSession) {
+        sessions.erase(clientId);
+        present = false;
+    }
+    sessions[clientId];
+    // A client id already connected is taken over by the new connection
+    for (auto it = clients.begin(); it != clients.end();) {
+        it = it->second == clientId ? clients.erase(it) : std::next(it);
+    }
+    clients[connection.id] = clientId;
+    connection.idleTimeoutMillis = keepAlive * 1500U;
+    counters.connects++;
+    counters.sessionsResumed += present ? 1 : 0;
+    char connack[4] = {0x20, 0x02, (char)(present ? 1 : 0), 0x00};
+    connection.reply(std::string(connack, sizeof(connack)), settings.replyMillis);
+    return true;
+}
+
+bool FakeMqttBroker::handlePublish(SimStreamConnection& connection, uint8_t flags, const std::string& body) {
+    uint8_t qos = (flags >> 1) & 0x03;
+    size_t pos = 0;
+    std::string topic;
+    if (qos != 1 || !readString(body, pos, topic) || topic.empty() || pos + 2 > body.size()) {
+        return false; // Publishers of readings use QoS 1 only
+    }
+    uint16_t packetId = read16(body, pos);
+    pos += 2;
+    std::string payload = body.substr(pos);
+    counters.publishes++;
+
+    Session& session = sessions[clients[connection.id]];
+    auto previous = session.received.find(packetId);
+    if (previous != session.received.end() && previous->second == payload) {
+        counters.duplicates++;
+    } else {
+        RecordDecoder decoder((const uint8_t*)payload.data(), payload.size());
+        if (!decoder.isValid()) {
+            return false;
+        }
+        session.received[packetId] = payload;
+        deliver(session, payload);
+    }
+
+    if (nextUnit() < settings.dropAckProbability) {
+        counters.acksDropped++;
+        return true;
+    }
+    char puback[4] = {0x40, 0x02, (char)(packetId >> 8), (char)(packetId & 0xFF)};
+    connection.reply(std::string(puback, sizeof(puback)), settings.replyMillis);
+    return true;
+}
+
+void FakeMqttBroker::deliver(Session& session, const std::string& payload) {
+    RecordDecoder decoder((const uint8_t*)payload.data(), payload.size());
+    uint32_t timestamp;
+    SensorData reading;
+    while (decoder.next(timestamp, reading)) {
+        if (!session.timestamps.empty() && timestamp < session.lastTimestamp) {
+            counters.outOfOrder++;
+        }
+        session.timestamps.push_back(timestamp);
+        session.lastTimestamp = timestamp;
+        counters.records++;
+    }
+    if (decoder.hasError()) {
+        counters.malformed++;
+    }
+}
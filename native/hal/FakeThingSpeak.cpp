@@ -0,0 +1,372 @@
+/**
+ * @file FakeThingSpeak.cpp
+ * @brief In-process model of the ThingSpeak write API
+ */
+
+#include "Simulation.h"
+
+#include <Arduino.h>
+
+#include <utility>
+#include <vector>
+
+namespace {
+    /** Value of key in an x-www-form-urlencoded query ("" when absent). */
+    std::string queryValue(const std::string& query, const char* key) {
+        size_t keyLen = strlen(key);
+        size_t pos = 0;
+        while (pos < query.size()) {
+            size_t end = query.find('&', pos);
+            if (end == std::string::npos) end = query.size();
+            if (end - pos > keyLen && query.compare(pos, keyLen, key) == 0 && query[pos + keyLen] == '=') {
+                return query.substr(pos + keyLen + 1, end - pos - keyLen - 1);
+            }
+            pos = end + 1;
+        }
+        return "";
+    }
+
+    bool isNumber(const std::string& text) {
+        if (text.empty()) return false;
+        char* end = nullptr;
+        strtod(text.c_str(), &end);
+        return end && *end == '\0';
+    }
+
+    /** Parsed JSON value; just enough for the bulk-update format. */
+    struct JsonValue {
+        enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+        Type type = NUL;
+        double number = 0;
+        std::string text;
+        std::vector<JsonValue> items;
+        std::vector<std::pair<std::string, JsonValue>> members;
+
+        const JsonValue* find(const char* key) const {
+            for (const auto& member : members) {
+                if (member.first == key) return &member.second;
+            }
+            return nullptr;
+        }
+    };
+
+    /** Strict recursive-descent parser (no trailing commas, no comments). */
+    class JsonParser {
+    public:
+        explicit JsonParser(const std::string& input) : p(input.c_str()), end(input.c_str() + input.size()) {}
+
+        bool parseDocument(JsonValue& value) {
+            if (!parseValue(value)) return false;
+            skipSpace();
+            return p == end;
+        }
+
+    private:
+        const char* p;
+        const char* end;
+
+        void skipSpace() {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+        }
+
+        bool literal(const char* word) {
+            size_t n = strlen(word);
+            if ((size_t)(end - p) < n || strncmp(p, word, n) != 0) return false;
+            p += n;
+            return true;
+        }
+
+        bool parseString(std::string& out) {
+            if (p >= end || *p != '"') return false;
+            p++;
+            while (p < end && *p != '"') {
+                if ((unsigned char)*p < 0x20) return false;
+                if (*p == '\\') {
+                    if (++p >= end) return false;
+                    switch (*p) {
+                        case '"': case '\\': case '/': out += *p; break;
+                        case 'n': out += '\n'; break;
+                        case 't': out += '\t'; break;
+                        case 'r': out += '\r'; break;
+                        case 'b': out += '\b'; break;
+                        case 'f': out += '\f'; break;
+                        default: return false; // \uXXXX never appears in our payloads
+                    }
+                    p++;
+                } else {
+                    out += *p++;
+                }
+            }
+            if (p >= end) return false;
+            p++;
+            return true;
+        }
+
+        bool parseNumber(double& out) {
+            const char* start = p;
+            if (p < end && *p == '-') p++;
+            if (p >= end || !isdigit((unsigned char)*p)) return false;
+            if (*p == '0') p++;
+            else while (p < end && isdigit((unsigned char)*p)) p++;
+            if (p < end && *p == '.') {
+                p++;
+                if (p >= end || !isdigit((unsigned char)*p)) return false;
+                while (p < end && isdigit((unsigned char)*p)) p++;
+            }
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                p++;
+                if (p < end && (*p == '+' || *p == '-')) p++;
+                if (p >= end || !isdigit((unsigned char)*p)) return false;
+                while (p < end && isdigit((unsigned char)*p)) p++;
+            }
+            out = strtod(std::string(start, p).c_str(), nullptr);
+            return true;
+        }
+
+        bool parseValue(JsonValue& value) {
+            skipSpace();
+            if (p >= end) return false;
+            switch (*p) {
+                case '{': {
+                    value.type = JsonValue::OBJECT;
+                    p++;
+                    skipSpace();
+                    if (p < end && *p == '}') { p++; return true; }
+                    while (true) {
+                        skipSpace();
+                        std::pair<std::string, JsonValue> member;
+                        if (!parseString(member.first)) return false;
+                        skipSpace();
+                        if (p >= end || *p++ != ':') return false;
+                        if (!parseValue(member.second)) return false;
+                        value.members.push_back(std::move(member));
+                        skipSpace();
+                        if (p < end && *p == ',') { p++; continue; }
+                        if (p < end && *p == '}') { p++; return true; }
+                        return false;
+                    }
+                }
+                case '[': {
+                    value.type = JsonValue::ARRAY;
+                    p++;
+                    skipSpace();
+                    if (p < end && *p == ']') { p++; return true; }
+                    while (true) {
+                        value.items.emplace_back();
+                        if (!parseValue(value.items.back())) return false;
+                        skipSpace();
+                        if (p < end && *p == ',') { p++; continue; }
+                        if (p < end && *p == ']') { p++; return true; }
+                        return false;
+                    }
+                }
+                case '"':
+                    value.type = JsonValue::STRING;
+                    return parseString(value.text);
+                case 't':
+                    value.type = JsonValue::BOOLEAN;
+                    value.number = 1;
+                    return literal("true");
+                case 'f':
+                    value.type = JsonValue::BOOLEAN;
+                    return literal("false");
+                case 'n':
+                    return literal("null");
+                default:
+                    value.type = JsonValue::NUMBER;
+                    return parseNumber(value.number);
+            }
+        }
+    };
+
+    const int BULK_MAX_ENTRIES = 960;
+
+    bool isFieldKey(const std::string& key) {
+        return key.size() == 6 && key.compare(0, 5, "field") == 0 && key[5] >= '1' && key[5] <= '8';
+    }
+
+    bool isKnownBulkKey(const std::string& key) {
+        return isFieldKey(key) || key == "created_at" || key == "delta_t" || key == "latitude"
+            || key == "longitude" || key == "elevation" || key == "status";
+    }
+
+    void jsonError(SimHttpResponse& response, int status, const char* code) {
+        response.status = status;
+        response.contentType = "application/json";
+        response.body = std::string("{\"status\":\"") + std::to_string(status)
+                      + "\",\"error\":{\"error_code\":\"" + code + "\"}}";
+    }
+}
+
+FakeThingSpeak::FakeThingSpeak(const char* key, uint32_t minInterval)
+    : apiKey(key ? key : ""), minIntervalMillis(minInterval), lastAcceptedMs(0),
+      anyAccepted(false), nextEntryId(1), lastCreatedAt(0), counters{0, 0, 0, 0, 0, 0, 0} {
+}
+
+void FakeThingSpeak::handle(const SimHttpRequest& request, SimHttpResponse& response) {
+    SimHeap::Untracked untracked;
+    counters.requests++;
+    if (request.path.compare(0, 7, "/update") == 0) {
+        handleUpdate(request, response);
+        return;
+    }
+    const std::string BULK_SUFFIX = "/bulk_update.json";
+    if (request.path.compare(0, 10, "/channels/") == 0 && request.path.size() > BULK_SUFFIX.size()
+        && request.path.compare(request.path.size() - BULK_SUFFIX.size(), BULK_SUFFIX.size(), BULK_SUFFIX) == 0) {
+        handleBulkUpdate(request, response);
+        return;
+    }
+    response.status = 404;
+    response.body = "Not Found";
+}
+
+bool FakeThingSpeak::rateLimited() {
+    return anyAccepted && millis() - lastAcceptedMs < minIntervalMillis;
+}
+
+bool FakeThingSpeak::parseTimestamp(const std::string& text, uint64_t& epoch) {
+    struct tm utc = {};
+    int consumed = 0;
+    if (sscanf(text.c_str(), "%4d-%2d-%2dT%2d:%2d:%2dZ%n", &utc.tm_year, &utc.tm_mon, &utc.tm_mday,
+               &utc.tm_hour, &utc.tm_min, &utc.tm_sec, &consumed) != 6 || (size_t)consumed != text.size()) {
+        return false;
+    }
+    utc.tm_year -= 1900;
+    utc.tm_mon -= 1;
+    epoch = (uint64_t)timegm(&utc);
+    return true;
+}
+
+void FakeThingSpeak::handleUpdate(const SimHttpRequest& request, SimHttpResponse& response) {
+    size_t queryStart = request.path.find('?');
+    std::string query = queryStart == std::string::npos ? request.body : request.path.substr(queryStart + 1);
+
+    std::string key = queryValue(query, "api_key");
+    bool keyOk = !key.empty() && (apiKey.empty() || key == apiKey);
+    int fields = 0;
+    bool fieldsOk = true;
+    for (int i = 1; i <= 8; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "field%d", i);
+        std::string value = queryValue(query, name);
+        if (value.empty()) continue;
+        fields++;
+        fieldsOk = fieldsOk && isNumber(value);
+    }
+
+    if (!keyOk) {
+        counters.malformed++;
+        response.status = 400;
+        response.body = "-1";
+        return;
+    }
+    uint64_t now = SimClock::epochAtBoot() + millis() / 1000;
+    uint64_t createdAt = now;
+    std::string created = queryValue(query, "created_at");
+    if (!created.empty() && !parseTimestamp(created, createdAt)) fieldsOk = false;
+
+    if (fields == 0 || !fieldsOk) {
+        counters.malformed++;
+        response.body = "0";
+        return;
+    }
+    if (rateLimited()) {
+        counters.rateLimited++;
+        response.body = "0";
+        return;
+    }
+
+    acceptEntry(createdAt, now);
+    anyAccepted = true;
+    lastAcceptedMs = millis();
+    response.body = std::to_string(nextEntryId - 1);
+}
+
+void FakeThingSpeak::acceptEntry(uint64_t createdAt, uint64_t now) {
+    counters.accepted++;
+    nextEntryId++;
+    if (createdAt + 60 < now) counters.backfilled++;
+    if (createdAt < lastCreatedAt) counters.outOfOrder++;
+    lastCreatedAt = createdAt;
+}
+
+void FakeThingSpeak::handleBulkUpdate(const SimHttpRequest& request, SimHttpResponse& response) {
+    JsonValue root;
+    if (request.method != "POST" || request.headers.find("application/json") == std::string::npos
+        || !JsonParser(request.body).parseDocument(root) || root.type != JsonValue::OBJECT) {
+        counters.malformed++;
+        jsonError(response, 400, "error_bad_request");
+        return;
+    }
+
+    const JsonValue* key = root.find("write_api_key");
+    if (!key || key->type != JsonValue::STRING || key->text.empty() || (!apiKey.empty() && key->text != apiKey)) {
+        counters.malformed++;
+        jsonError(response, 401, "error_auth_required");
+        return;
+    }
+
+    // Validate every entry before accepting any of them
+    const JsonValue* updates = root.find("updates");
+    bool ok = updates && updates->type == JsonValue::ARRAY && !updates->items.empty()
+           && updates->items.size() <= (size_t)BULK_MAX_ENTRIES;
+    uint64_t now = SimClock::epochAtBoot() + millis() / 1000;
+    std::vector<uint64_t> times;
+    int relative = 0;
+    for (size_t i = 0; ok && i < updates->items.size(); i++) {
+        const JsonValue& entry = updates->items[i];
+        ok = entry.type == JsonValue::OBJECT;
+        int fields = 0;
+        const JsonValue* createdAt = nullptr;
+        const JsonValue* deltaT = nullptr;
+        for (size_t m = 0; ok && m < entry.members.size(); m++) {
+            const std::string& name = entry.members[m].first;
+            const JsonValue& value = entry.members[m].second;
+            ok = isKnownBulkKey(name);
+            if (isFieldKey(name)) {
+                fields++;
+                ok = ok && (value.type == JsonValue::NUMBER || (value.type == JsonValue::STRING && isNumber(value.text)));
+            }
+            if (name == "created_at") createdAt = &value;
+            if (name == "delta_t") deltaT = &value;
+        }
+        ok = ok && fields > 0 && (createdAt == nullptr) != (deltaT == nullptr);
+        uint64_t at = 0;
+        if (ok && createdAt) {
+            ok = createdAt->type == JsonValue::STRING && parseTimestamp(createdAt->text, at);
+        } else if (ok) {
+            ok = deltaT->type == JsonValue::NUMBER && deltaT->number >= 0;
+            at = (uint64_t)deltaT->number; // Resolved below
+            relative++;
+        }
+        times.push_back(at);
+    }
+    ok = ok && (relative == 0 || relative == (int)times.size());
+    if (!ok) {
+        counters.malformed++;
+        jsonError(response, 400, "error_bad_request");
+        return;
+    }
+    if (rateLimited()) {
+        counters.rateLimited++;
+        jsonError(response, 429, "error_too_many_requests");
+        return;
+    }
+
+    if (relative) {
+        // delta_t is the gap to the previous entry; the last entry is "now"
+        uint64_t at = now;
+        for (size_t i = times.size(); i-- > 0;) {
+            uint64_t delta = times[i];
+            times[i] = at;
+            at = at > delta ? at - delta : 0;
+        }
+    }
+    for (uint64_t at : times) acceptEntry(at, now);
+    counters.bulkRequests++;
+    anyAccepted = true;
+    lastAcceptedMs = millis();
+    response.status = 202;
+    response.contentType = "application/json";
+    response.body = "{\"success\":true}";
+}
@@ -0,0 +1,238 @@
+/**
+ * @file FreeRTOS.cpp
+ * @brief Virtual clock and deterministic FreeRTOS task scheduler
+ *
+ * Every task owns a clock. Exactly one host thread holds the baton at any
+ * moment; whenever the holder's clock advances, the baton passes to the
+ * task with the earliest clock (the holder keeps it on a tie), so tasks
+ * interleave in virtual-time order no matter how the host schedules the
+ * threads, and no task ever sees data another task produced at a later
+ * virtual time.
+ */
+
+#include "Arduino.h"
+#include "Simulation.h"
+
+#include <freertos/task.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct SimTaskContext {
+    uint64_t micros;
+    BaseType_t core;
+    const char* name;
+    TaskFunction_t function;
+    void* parameter;
+    std::condition_variable* wake; // Created on first switch
+    int untrackedDepth;            // SimHeap::Untracked nesting on this task
+    uint32_t notifications;        // xTaskNotifyGive() count not yet taken
+    bool waitingForNotify;         // Blocked in ulTaskNotifyTake(); clock holds the timeout
+    bool blocked;                  // The clock's last advance was a blocking wait, not work
+};
+
+namespace {
+    // Constant-initialised so the clock works before any static constructor runs
+    SimTaskContext loopTask = {0, 1, "loopTask", nullptr, nullptr, nullptr, 0, 0, false, false};
+    SimTaskContext* running = &loopTask;
+    void (*advanceHook)() = nullptr;
+    uint32_t simEpochAtBoot = 1767225600; // 2026-01-01T00:00:00Z
+    uint64_t switchCount = 0;
+    uint64_t wakeupCount = 0;
+    uint64_t accountedUs = 0;  // Time up to which every task's state has gone to SimPower
+
+    // Never destroyed: task threads stay parked on them until the process exits
+    std::mutex* baton = nullptr;
+    std::vector<SimTaskContext*>* tasks = nullptr;
+
+    std::condition_variable* wakeOf(SimTaskContext* task) {
+        if (!task->wake) {
+            SimHeap::Untracked untracked;
+            task->wake = new std::condition_variable();
+        }
+        return task->wake;
+    }
+
+    /** Task with the earliest clock, preferring `next` on a tie. */
+    SimTaskContext* earliest(SimTaskContext* next) {
+        if (loopTask.micros < next->micros) next = &loopTask;
+        for (SimTaskContext* task : *tasks) {
+            if (task->micros < next->micros) next = task;
+        }
+        return next;
+    }
+
+    /** Hand the baton to next; returns once the caller holds it again, never if it is exiting. */
+    void switchTo(SimTaskContext* next, bool exiting) {
+        std::unique_lock<std::mutex> lock(*baton);
+        SimTaskContext* self = running;
+        std::condition_variable* selfWake = wakeOf(self);
+        running = next;
+        switchCount++;
+        wakeOf(next)->notify_one();
+        selfWake->wait(lock, [self, exiting] { return !exiting && running == self; });
+    }
+
+    /**
+     * Report the time every task has passed since the last call to the power
+     * model. Tasks run in clock order, so each task's latest advance spans
+     * accountedUs up to the earliest clock, and its kind holds throughout.
+     */
+    void accountPower() {
+        uint64_t until = loopTask.micros;
+        bool idle = loopTask.blocked;
+        if (tasks) {
+            for (SimTaskContext* task : *tasks) {
+                if (task->micros < until) until = task->micros;
+                idle = idle && task->blocked;
+            }
+        }
+        if (until > accountedUs) {
+            SimPower::accountInterval(accountedUs, until, idle);
+            accountedUs = until;
+        }
+    }
+
+    void advance(uint64_t us, bool blocking) {
+        running->blocked = blocking;
+        running->micros += us;
+        if (advanceHook) advanceHook();
+        accountPower();
+        SimTasks::yield();
+    }
+
+    void taskMain(SimTaskContext* task) {
+        {
+            std::unique_lock<std::mutex> lock(*baton);
+            task->wake->wait(lock, [task] { return running == task; });
+        }
+        task->function(task->parameter);
+        vTaskDelete(nullptr); // FreeRTOS tasks must not return; treat it as deleting itself (parks the thread)
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Virtual clock
+// ---------------------------------------------------------------------------
+
+uint64_t SimClock::nowMicros() { return running->micros; }
+void SimClock::advanceMicros(uint64_t us) { advance(us, false); }
+void SimClock::sleepMicros(uint64_t us) {
+    if (us > 0) wakeupCount++;
+    advance(us, true);
+}
+void SimClock::setAdvanceHook(void (*hook)()) { advanceHook = hook; }
+void SimClock::setEpochAtBoot(uint32_t epochSeconds) { simEpochAtBoot = epochSeconds; }
+uint32_t SimClock::epochAtBoot() { return simEpochAtBoot; }
+
+// ---------------------------------------------------------------------------
+// Scheduler
+// ---------------------------------------------------------------------------
+
+void SimTasks::yield() {
+    if (!tasks) return;
+    SimTaskContext* next = earliest(running);
+    if (next != running) switchTo(next, false);
+}
+
+uint32_t SimTasks::count() { return tasks ? (uint32_t)tasks->size() : 0; }
+uint64_t SimTasks::switches() { return switchCount; }
+int& SimTasks::untrackedDepth() { return running->untrackedDepth; }
+uint64_t SimTasks::wakeups() { return wakeupCount; }
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackBytes,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core) {
+    (void)stackBytes; (void)priority;
+    SimHeap::Untracked untracked;
+    if (!tasks) {
+        baton = new std::mutex();
+        tasks = new std::vector<SimTaskContext*>();
+    }
+    // A new task starts at its creator's time and first runs when the creator blocks
+    SimTaskContext* task = new SimTaskContext{running->micros, core, name, function, parameter,
+                                              new std::condition_variable(), 0, 0, false, false};
+    tasks->push_back(task);
+    std::thread(taskMain, task).detach();
+    if (handle) *handle = task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task && task != running) {
+        fprintf(stderr, "vTaskDelete: only self-deletion is simulated\n");
+        abort();
+    }
+    if (running == &loopTask) {
+        fprintf(stderr, "vTaskDelete: loopTask cannot delete itself here\n");
+        abort();
+    }
+    {
+        SimHeap::Untracked untracked;
+        for (size_t i = 0; i < tasks->size(); i++) {
+            if ((*tasks)[i] == running) {
+                tasks->erase(tasks->begin() + i);
+                break;
+            }
+        }
+    }
+    switchTo(earliest(&loopTask), true);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks * portTICK_PERIOD_MS);
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment) {
+    *previousWake += increment;
+    uint64_t now = SimClock::nowMicros();
+    int32_t ahead = (int32_t)(*previousWake - (TickType_t)(now / 1000ULL));
+    if (ahead > 0) {
+        // Wake exactly on the tick boundary
+        SimClock::sleepMicros((uint64_t)ahead * 1000ULL - now % 1000ULL);
+    }
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(SimClock::nowMicros() / 1000ULL);
+}
+
+BaseType_t xPortGetCoreID() {
+    return running->core;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return running;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    task->notifications++;
+    // A waiting task's clock holds its timeout; it wakes now instead
+    if (task->waitingForNotify && task->micros > running->micros) {
+        task->micros = running->micros;
+    }
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait) {
+    SimTaskContext* self = running;
+    if (self->notifications == 0 && ticksToWait > 0) {
+        // Sleep on the clock: other tasks run until the timeout or a notification pulls it back
+        uint64_t timeoutUs = ticksToWait == portMAX_DELAY ? UINT64_MAX / 2 : (uint64_t)ticksToWait * 1000ULL;
+        self->waitingForNotify = true;
+        self->blocked = true;
+        self->micros += timeoutUs;
+        accountPower();
+        SimTasks::yield();
+        wakeupCount++;
+        self->waitingForNotify = false;
+        SimClock::advanceMicros(0); // Deliver what became due while asleep (WiFi events)
+    }
+    uint32_t count = self->notifications;
+    if (count) {
+        self->notifications = clearCountOnExit ? 0 : count - 1;
+    }
+    return count;
+}
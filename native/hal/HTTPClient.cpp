@@ -0,0 +1,131 @@
+/**
+ * @file HTTPClient.cpp
+ * @brief HTTP/1.1 client stand-in on top of the simulated WiFiClient
+ */
+
+#include "HTTPClient.h"
+
+#include <strings.h>
+
+bool HTTPClient::begin(WiFiClient& tcpClient, const String& url) {
+    client = &tcpClient;
+    int schemeEnd = url.indexOf("://");
+    int hostStart = schemeEnd < 0 ? 0 : schemeEnd + 3;
+    int pathStart = url.indexOf('/', hostStart);
+    String authority = pathStart < 0 ? url.substring(hostStart) : url.substring(hostStart, pathStart);
+    uri = pathStart < 0 ? String("/") : url.substring(pathStart);
+
+    int colon = authority.indexOf(':');
+    if (colon >= 0) {
+        host = authority.substring(0, colon);
+        port = (uint16_t)authority.substring(colon + 1).toInt();
+    } else {
+        host = authority;
+        port = url.startsWith("https") ? 443 : 80;
+    }
+    extraHeaders = String();
+    return host.length() > 0;
+}
+
+void HTTPClient::end() {
+    if (client && (!keepAlive || !bodyConsumed)) {
+        client->stop();
+    }
+    bodyConsumed = true;
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+    extraHeaders += name;
+    extraHeaders += ": ";
+    extraHeaders += value;
+    extraHeaders += "\r\n";
+}
+
+int HTTPClient::GET() {
+    return sendRequest("GET", nullptr, 0);
+}
+
+int HTTPClient::POST(const String& payload) {
+    return sendRequest("POST", (const uint8_t*)payload.c_str(), payload.length());
+}
+
+int HTTPClient::POST(const uint8_t* payload, size_t size) {
+    return sendRequest("POST", payload, size);
+}
+
+int HTTPClient::sendRequest(const char* method, const uint8_t* payload, size_t size) {
+    if (!client) return HTTPC_ERROR_NOT_CONNECTED;
+    client->setTimeout(timeout);
+
+    if (!client->connected() && !client->connect(host.c_str(), port)) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    String head = String(method) + " " + uri + " HTTP/1.1\r\nHost: " + host + "\r\n";
+    head += "User-Agent: ESP32HTTPClient\r\n";
+    head += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    if (payload) {
+        head += "Content-Length: ";
+        head += String((unsigned long)size);
+        head += "\r\n";
+    }
+    head += extraHeaders;
+    head += "\r\n";
+
+    if (client->write(head.c_str(), head.length()) != head.length()) {
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+    if (payload && size && client->write(payload, size) != size) {
+        return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+    }
+
+    String statusLine = client->readStringUntil('\n');
+    if (!statusLine.startsWith("HTTP/1.")) {
+        client->stop();
+        return statusLine.length() ? HTTPC_ERROR_NO_HTTP_SERVER : HTTPC_ERROR_READ_TIMEOUT;
+    }
+    int code = (int)statusLine.substring(9, 12).toInt();
+
+    contentLength = -1;
+    for (;;) {
+        String line = client->readStringUntil('\n');
+        line.trim();
+        if (line.length() == 0) break;
+        if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0) {
+            contentLength = (int)line.substring(15).toInt();
+        }
+    }
+    bodyConsumed = contentLength == 0;
+    return code;
+}
+
+String HTTPClient::getString() {
+    String body;
+    if (!client || bodyConsumed) return body;
+    if (contentLength > 0) {
+        body.reserve((unsigned int)contentLength);
+        for (int i = 0; i < contentLength; i++) {
+            int c = client->read();
+            if (c < 0) break;
+            body += (char)c;
+        }
+    } else {
+        body = client->readString();
+    }
+    bodyConsumed = true;
+    return body;
+}
+
+String HTTPClient::errorToString(int error) {
+    switch (error) {
+        case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+        case HTTPC_ERROR_SEND_HEADER_FAILED: return "send header failed";
+        case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+        case HTTPC_ERROR_NOT_CONNECTED: return "not connected";
+        case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+        case HTTPC_ERROR_NO_STREAM: return "no stream";
+        case HTTPC_ERROR_NO_HTTP_SERVER: return "no HTTP server";
+        case HTTPC_ERROR_READ_TIMEOUT: return "read Timeout";
+        default: return String();
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ * @file HTTPClient.h
+ * @brief Host stand-in for the ESP32 HTTPClient
+ *
+ * Speaks real HTTP/1.1 over the simulated WiFiClient, so whatever server
+ * model is registered with SimNet sees the same request bytes the device
+ * would send. Like the ESP32 version it stores URL parts and the response
+ * body in String objects, which shows up in the heap counters.
+ */
+
+#ifndef NATIVE_HAL_HTTP_CLIENT_H
+#define NATIVE_HAL_HTTP_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_STREAM (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+class HTTPClient {
+public:
+    bool begin(WiFiClient& client, const String& url);
+    void end();
+    void setTimeout(uint16_t timeoutMs) { timeout = timeoutMs; }
+    void setReuse(bool reuse) { keepAlive = reuse; }
+    void addHeader(const String& name, const String& value);
+
+    int GET();
+    int POST(const String& payload);
+    int POST(const uint8_t* payload, size_t size);
+
+    int getSize() const { return contentLength; }
+    String getString();
+    WiFiClient* getStreamPtr() { return client; }
+
+    static String errorToString(int error);
+
+private:
+    int sendRequest(const char* method, const uint8_t* payload, size_t size);
+
+    WiFiClient* client = nullptr;
+    String host;
+    String uri;
+    uint16_t port = 80;
+    String extraHeaders;
+    uint16_t timeout = 5000;
+    bool keepAlive = false;
+    int contentLength = -1;
+    bool bodyConsumed = true;
+};
+
+#endif // NATIVE_HAL_HTTP_CLIENT_H
@@ -0,0 +1,321 @@
+/**
+ * @file LittleFS.cpp
+ * @brief Host implementation of fs::FS / LittleFS over a plain directory
+ *
+ * Each write() goes straight to the host file, which matches LittleFS'
+ * observable behaviour closely enough for the firmware: data written
+ * before a simulated reboot is visible afterwards, and a harness can
+ * truncate or corrupt files between boots to exercise recovery.
+ */
+
+#include "LittleFS.h"
+#include "Simulation.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+LittleFSFS LittleFS;
+
+namespace {
+    SimFlashConfig flashConfig;
+    SimFlashStats flashStats = {0, 0, 0, 0, 0, 0};
+    std::string flashRoot;
+    bool flashCleanupRegistered = false;
+
+    void removeTree(const std::string& path) {
+        DIR* dir = opendir(path.c_str());
+        if (dir) {
+            while (dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name == "." || name == "..") continue;
+                removeTree(path + "/" + name);
+            }
+            closedir(dir);
+            rmdir(path.c_str());
+        } else {
+            unlink(path.c_str());
+        }
+    }
+
+    void cleanupDefaultRoot() {
+        if (!flashRoot.empty()) removeTree(flashRoot);
+    }
+
+    bool isDirectoryPath(const std::string& hostPath) {
+        struct stat info;
+        return stat(hostPath.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+    }
+
+    size_t treeBytes(const std::string& path) {
+        size_t total = 0;
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return 0;
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..") continue;
+            std::string child = path + "/" + name;
+            struct stat info;
+            if (stat(child.c_str(), &info) != 0) continue;
+            total += S_ISDIR(info.st_mode) ? treeBytes(child) : (size_t)info.st_size;
+        }
+        closedir(dir);
+        return total;
+    }
+}
+
+const std::string& SimFlash::root() {
+    if (flashRoot.empty()) {
+        SimHeap::Untracked untracked;
+        char pattern[] = "/tmp/simflash-XXXXXX";
+        if (!mkdtemp(pattern)) {
+            perror("SimFlash: mkdtemp");
+            abort();
+        }
+        flashRoot = pattern;
+        if (!flashCleanupRegistered) {
+            atexit(cleanupDefaultRoot);
+            flashCleanupRegistered = true;
+        }
+    }
+    return flashRoot;
+}
+
+void SimFlash::setRoot(const std::string& directory) {
+    SimHeap::Untracked untracked;
+    flashRoot = directory;
+    ::mkdir(flashRoot.c_str(), 0755);
+}
+
+void SimFlash::wipe() {
+    SimHeap::Untracked untracked;
+    std::string base = root();
+    DIR* dir = opendir(base.c_str());
+    if (!dir) return;
+    std::vector<std::string> children;
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") children.push_back(base + "/" + name);
+    }
+    closedir(dir);
+    for (const std::string& child : children) removeTree(child);
+}
+
+std::string SimFlash::hostPath(const char* path) {
+    SimHeap::Untracked untracked;
+    std::string result = root();
+    if (path[0] != '/') result += '/';
+    result += path;
+    return result;
+}
+
+SimFlashConfig& SimFlash::config() { return flashConfig; }
+SimFlashStats SimFlash::stats() { return flashStats; }
+
+// ---------------------------------------------------------------------------
+// fs::File
+// ---------------------------------------------------------------------------
+
+namespace fs {
+
+class FileImpl {
+public:
+    std::string fsPath;   // Path as the firmware sees it
+    FILE* handle = nullptr;
+    bool directory = false;
+    std::vector<std::string> entries; // Directory listing (names only)
+    size_t nextEntry = 0;
+
+    ~FileImpl() {
+        if (handle) fclose(handle);
+    }
+};
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!impl || !impl->handle) return 0;
+    SimClock::advanceMicros(flashConfig.writeMicros);
+    size_t written = fwrite(buffer, 1, size, impl->handle);
+    flashStats.writeOps++;
+    flashStats.bytesWritten += written;
+    return written;
+}
+
+int File::available() {
+    if (!impl || !impl->handle) return 0;
+    long here = ftell(impl->handle);
+    return (int)(size() - (size_t)(here < 0 ? 0 : here));
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+    if (!impl || !impl->handle) return -1;
+    int c = fgetc(impl->handle);
+    if (c != EOF) ungetc(c, impl->handle);
+    return c == EOF ? -1 : c;
+}
+
+void File::flush() {
+    if (impl && impl->handle) fflush(impl->handle);
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    if (!impl || !impl->handle) return 0;
+    size_t got = fread(buffer, 1, size, impl->handle);
+    flashStats.readOps++;
+    flashStats.bytesRead += got;
+    return got;
+}
+
+bool File::seek(uint32_t position) {
+    return impl && impl->handle && fseek(impl->handle, (long)position, SEEK_SET) == 0;
+}
+
+size_t File::position() const {
+    if (!impl || !impl->handle) return 0;
+    long here = ftell(impl->handle);
+    return here < 0 ? 0 : (size_t)here;
+}
+
+size_t File::size() const {
+    if (!impl || !impl->handle) return 0;
+    fflush(impl->handle);
+    struct stat info;
+    return fstat(fileno(impl->handle), &info) == 0 ? (size_t)info.st_size : 0;
+}
+
+void File::close() {
+    impl.reset();
+}
+
+File::operator bool() const {
+    return impl && (impl->handle || impl->directory);
+}
+
+const char* File::path() const {
+    return impl ? impl->fsPath.c_str() : nullptr;
+}
+
+const char* File::name() const {
+    if (!impl) return nullptr;
+    size_t slash = impl->fsPath.rfind('/');
+    return impl->fsPath.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+bool File::isDirectory() const {
+    return impl && impl->directory;
+}
+
+File File::openNextFile(const char* mode) {
+    if (!impl || !impl->directory || impl->nextEntry >= impl->entries.size()) return File();
+    std::string child = impl->fsPath;
+    if (child.empty() || child.back() != '/') child += '/';
+    child += impl->entries[impl->nextEntry++];
+    return LittleFS.open(child.c_str(), mode);
+}
+
+// ---------------------------------------------------------------------------
+// fs::FS
+// ---------------------------------------------------------------------------
+
+File FS::open(const char* path, const char* mode, bool create) {
+    (void)create;
+    std::string host = SimFlash::hostPath(path);
+    SimClock::advanceMicros(flashConfig.openMicros);
+
+    // Host-side bookkeeping (paths, listings) is not firmware heap use
+    std::shared_ptr<FileImpl> impl;
+    {
+        SimHeap::Untracked untracked;
+        if (isDirectoryPath(host)) {
+            if (strcmp(mode, FILE_READ) != 0) return File();
+            std::shared_ptr<FileImpl> dir = std::make_shared<FileImpl>();
+            dir->fsPath = path;
+            dir->directory = true;
+            if (DIR* handle = opendir(host.c_str())) {
+                while (dirent* entry = readdir(handle)) {
+                    std::string name = entry->d_name;
+                    if (name != "." && name != "..") dir->entries.push_back(name);
+                }
+                closedir(handle);
+            }
+            std::sort(dir->entries.begin(), dir->entries.end());
+            impl = dir;
+        } else {
+            const char* hostMode = strcmp(mode, FILE_WRITE) == 0 ? "wb"
+                                 : strcmp(mode, FILE_APPEND) == 0 ? "ab" : "rb";
+            FILE* handle = fopen(host.c_str(), hostMode);
+            if (!handle) return File();
+            impl = std::make_shared<FileImpl>();
+            impl->fsPath = path;
+            impl->handle = handle;
+        }
+    }
+    flashStats.opens++;
+    return File(impl);
+}
+
+bool FS::exists(const char* path) {
+    SimHeap::Untracked untracked;
+    struct stat info;
+    return stat(SimFlash::hostPath(path).c_str(), &info) == 0;
+}
+
+bool FS::remove(const char* path) {
+    SimHeap::Untracked untracked;
+    SimClock::advanceMicros(flashConfig.removeMicros);
+    bool removed = unlink(SimFlash::hostPath(path).c_str()) == 0;
+    if (removed) flashStats.removes++;
+    return removed;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    SimHeap::Untracked untracked;
+    return ::rename(SimFlash::hostPath(from).c_str(), SimFlash::hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    SimHeap::Untracked untracked;
+    return ::mkdir(SimFlash::hostPath(path).c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool FS::rmdir(const char* path) {
+    SimHeap::Untracked untracked;
+    return ::rmdir(SimFlash::hostPath(path).c_str()) == 0;
+}
+
+} // namespace fs
+
+// ---------------------------------------------------------------------------
+// LittleFS mount
+// ---------------------------------------------------------------------------
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)formatOnFail; (void)basePath; (void)maxOpenFiles; (void)partitionLabel;
+    SimClock::advanceMillis(20); // Mount: read superblocks
+    return !SimFlash::root().empty();
+}
+
+void LittleFSFS::end() {}
+
+bool LittleFSFS::format() {
+    SimFlash::wipe();
+    return true;
+}
+
+size_t LittleFSFS::totalBytes() {
+    return flashConfig.totalBytes;
+}
+
+size_t LittleFSFS::usedBytes() {
+    SimHeap::Untracked untracked;
+    return treeBytes(SimFlash::root());
+}
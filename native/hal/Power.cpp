@@ -0,0 +1,98 @@
+/**
+ * @file Power.cpp
+ * @brief esp_pm stand-in and the automatic light-sleep model
+ */
+
+#include "Simulation.h"
+
+#include <esp_pm.h>
+
+struct esp_pm_lock {
+    esp_pm_lock_type_t type;
+    int count;
+};
+
+namespace {
+    SimPowerConfig powerConfig;
+    SimPowerStats powerStats = {0, 0, 0, 0};
+    bool lightSleepConfigured = false;
+    int heldLocks = 0;
+    uint64_t peripheralBusyUntilUs = 0;
+    bool inStretch = false;        // Accounting is inside an idle stretch
+    uint64_t stretchStartUs = 0;
+
+    /** Count an idle stretch once it ends: light sleep between beacon wakeups if nothing prevents it. */
+    void closeStretch(uint64_t endUs) {
+        inStretch = false;
+        uint64_t length = endUs - stretchStartUs;
+        powerStats.idleMicros += length;
+        if (!lightSleepConfigured || heldLocks > 0 || !SimWiFi::modemSleeping()
+            || length < powerConfig.minIdleMicros) {
+            return;
+        }
+        uint64_t interval = powerConfig.beaconIntervalMicros;
+        uint64_t beacons = interval ? endUs / interval - stretchStartUs / interval : 0;
+        uint64_t awake = beacons * powerConfig.beaconAwakeMicros;
+        if (awake >= length) {
+            return;
+        }
+        powerStats.lightSleepMicros += length - awake;
+        powerStats.lightSleeps += beacons + 1;
+    }
+}
+
+SimPowerConfig& SimPower::config() { return powerConfig; }
+
+SimPowerStats SimPower::stats() { return powerStats; }
+
+bool SimPower::lightSleepEnabled() { return lightSleepConfigured; }
+int SimPower::locksHeld() { return heldLocks; }
+
+void SimPower::busyUntil(uint64_t atUs) {
+    if (atUs > peripheralBusyUntilUs) peripheralBusyUntilUs = atUs;
+}
+
+void SimPower::accountInterval(uint64_t fromUs, uint64_t toUs, bool tasksIdle) {
+    if (toUs <= fromUs) return;
+    powerStats.accountedMicros += toUs - fromUs;
+    uint64_t idleFromUs = tasksIdle ? (peripheralBusyUntilUs > fromUs ? peripheralBusyUntilUs : fromUs) : toUs;
+    if (idleFromUs > fromUs && inStretch) {
+        closeStretch(fromUs);
+    }
+    if (idleFromUs < toUs && !inStretch) {
+        inStretch = true;
+        stretchStartUs = idleFromUs;
+    }
+}
+
+esp_err_t esp_pm_configure(const void* config) {
+    const esp_pm_config_esp32s3_t* pm = static_cast<const esp_pm_config_esp32s3_t*>(config);
+    if (!pm || pm->min_freq_mhz > pm->max_freq_mhz) return ESP_ERR_INVALID_ARG;
+    if (pm->light_sleep_enable && !powerConfig.ticklessIdle) return ESP_ERR_NOT_SUPPORTED;
+    lightSleepConfigured = pm->light_sleep_enable;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t type, int arg, const char* name, esp_pm_lock_handle_t* handle) {
+    (void)arg;
+    (void)name;
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    SimHeap::Untracked untracked;
+    *handle = new esp_pm_lock{type, 0};
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    handle->count++;
+    heldLocks++;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    if (handle->count == 0) return ESP_ERR_INVALID_STATE;
+    handle->count--;
+    heldLocks--;
+    return ESP_OK;
+}
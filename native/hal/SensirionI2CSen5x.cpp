@@ -0,0 +1,238 @@
+/**
+ * @file SensirionI2CSen5x.cpp
+ * @brief Deterministic SEN55 signal model behind the driver stand-in
+ */
+
+#include "SensirionI2CSen5x.h"
+#include "Simulation.h"
+
+TwoWire Wire;
+
+namespace {
+    const uint16_t ERROR_NACK = 0x0301;
+    const uint16_t ERROR_NOT_MEASURING = 0x0402;
+    const uint64_t NOMINAL_PERIOD_US = 1000000ULL;
+    const uint64_t TEMP_RH_WARMUP_US = 2000000ULL;  // T/RH report NaN at first
+    const uint64_t VOC_NOX_WARMUP_US = 10000000ULL; // Gas indices need ~10 s
+    const double SECONDS_PER_DAY = 86400.0;
+    const uint64_t TRACE_CATCH_UP_US = 10000;        // A poll this early waits for the recorded reading
+
+    SimSensorConfig sensorConfig;
+    SimSensorStats sensorStats = {0, 0, 0, 0, 0, 0};
+    bool measuring = false;
+    uint64_t measureStartUs = 0;
+    uint64_t lastReadSample = 0;
+    bool readSinceStart = false;
+    void (*readHook)() = nullptr;
+    std::vector<SimSensorTraceSample> trace;
+    size_t traceNext = 0;   // First reading not read yet
+    bool tracing = false;
+
+    uint64_t splitmix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    /** Uniform value in [0, 1) derived from the sample index and a stream id. */
+    float unit(uint64_t sample, uint64_t stream) {
+        uint64_t h = splitmix(sample * 0x100000001B3ULL ^ (stream << 48) ^ sensorConfig.seed);
+        return (float)((h >> 40) * (1.0 / 16777216.0));
+    }
+
+    /** Cheap symmetric noise in [-1, 1) (sum of two uniforms, triangle shaped). */
+    float noise(uint64_t sample, uint64_t stream) {
+        return unit(sample, stream) + unit(sample, stream + 1) - 1.0f;
+    }
+
+    // The sensor's own oscillator sets its period, not the host's 1 s
+    uint64_t samplePeriodUs() {
+        return (uint64_t)((int64_t)NOMINAL_PERIOD_US + sensorConfig.clockErrorPpm);
+    }
+
+    bool chance(uint64_t sample, uint64_t stream, float probability) {
+        return probability > 0.0f && unit(sample, stream) < probability;
+    }
+
+    // The driver hands out the sensor's integers scaled (PM and the indices
+    // / 10, humidity / 100, temperature / 200), so values sit on that grid
+    float onGrid(float value, float scale) {
+        return isnan(value) ? value : (float)(int32_t)lroundf(value * scale) / scale;
+    }
+
+    uint16_t readTrace(float& pm1, float& pm25, float& pm4, float& pm10, float& humidity, float& temperature,
+                       float& voc, float& nox) {
+        uint64_t readUs = SimClock::nowMicros() - sensorConfig.i2cReadMicros;
+        if (traceNext >= trace.size() || trace[traceNext].atMillis * 1000ULL > SimClock::nowMicros()) {
+            sensorStats.duplicateReads++; // Nothing new: the sensor repeats its last measurement
+            const SimSensorTraceSample* last = traceNext > 0 ? &trace[traceNext - 1] : nullptr;
+            if (!last || !last->ok) {
+                pm1 = pm25 = pm4 = pm10 = humidity = temperature = voc = nox = NAN;
+                return 0;
+            }
+            pm1 = last->pm1; pm25 = last->pm25; pm4 = last->pm4; pm10 = last->pm10;
+            humidity = last->humidity; temperature = last->temperature; voc = last->voc; nox = last->nox;
+            return 0;
+        }
+        const SimSensorTraceSample& sample = trace[traceNext++];
+        if (readUs / 1000 > sample.atMillis) sensorStats.traceLateReads++;
+        if (!sample.ok) {
+            sensorStats.readErrors++;
+            return ERROR_NACK;
+        }
+        pm1 = sample.pm1; pm25 = sample.pm25; pm4 = sample.pm4; pm10 = sample.pm10;
+        humidity = sample.humidity; temperature = sample.temperature; voc = sample.voc; nox = sample.nox;
+        return 0;
+    }
+}
+
+SimSensorConfig& SimSensor::config() { return sensorConfig; }
+SimSensorStats SimSensor::stats() { return sensorStats; }
+void SimSensor::setReadHook(void (*hook)()) { readHook = hook; }
+
+void SimSensor::setTrace(const std::vector<SimSensorTraceSample>& samples) {
+    SimHeap::Untracked untracked;
+    trace = samples;
+    traceNext = 0;
+    tracing = true;
+}
+
+size_t SimSensor::traceRemaining() { return trace.size() - traceNext; }
+
+uint64_t SimSensor::currentSampleIndex() {
+    if (!measuring) return 0;
+    return (SimClock::nowMicros() - measureStartUs) / samplePeriodUs();
+}
+
+void errorToString(uint16_t error, char errorMessage[], size_t errorMessageSize) {
+    const char* text = "Unknown error";
+    if (error == ERROR_NACK) text = "Received NACK on I2C bus";
+    else if (error == ERROR_NOT_MEASURING) text = "Sensor is not in measurement mode";
+    snprintf(errorMessage, errorMessageSize, "%s (0x%04X)", text, error);
+}
+
+void SensirionI2CSen5x::begin(TwoWire& i2cBus) { (void)i2cBus; }
+
+uint16_t SensirionI2CSen5x::deviceReset() {
+    measuring = false;
+    SimClock::advanceMicros(sensorConfig.i2cReadMicros);
+    SimClock::sleepMicros(200000); // The driver waits out the reset (delay(200)) before returning
+    return 0;
+}
+
+uint16_t SensirionI2CSen5x::startMeasurement() {
+    if (!measuring) {
+        measuring = true;
+        measureStartUs = SimClock::nowMicros();
+        lastReadSample = 0;
+        readSinceStart = false;
+    }
+    return 0;
+}
+
+uint16_t SensirionI2CSen5x::stopMeasurement() {
+    measuring = false;
+    return 0;
+}
+
+uint16_t SensirionI2CSen5x::readDataReady(bool& dataReady) {
+    sensorStats.dataReadyPolls++;
+    SimClock::advanceMicros(sensorConfig.i2cReadMicros / 4);
+    if (tracing) {
+        dataReady = false;
+        if (measuring && traceNext < trace.size()) {
+            uint64_t atUs = trace[traceNext].atMillis * 1000ULL;
+            uint64_t nowUs = SimClock::nowMicros();
+            if (nowUs < atUs && atUs - nowUs <= TRACE_CATCH_UP_US) {
+                SimClock::advanceMicros(atUs - nowUs);
+                nowUs = atUs;
+            }
+            dataReady = nowUs >= atUs;
+        }
+        return 0;
+    }
+    dataReady = measuring && SimSensor::currentSampleIndex() > lastReadSample;
+    return 0;
+}
+
+uint16_t SensirionI2CSen5x::readMeasuredValues(float& pm1, float& pm25, float& pm4, float& pm10,
+                                               float& humidity, float& temperature,
+                                               float& voc, float& nox) {
+    sensorStats.reads++;
+    SimClock::advanceMicros(sensorConfig.i2cReadMicros);
+    if (readHook) readHook();
+
+    if (!measuring) {
+        sensorStats.readErrors++;
+        return ERROR_NOT_MEASURING;
+    }
+    if (tracing) {
+        return readTrace(pm1, pm25, pm4, pm10, humidity, temperature, voc, nox);
+    }
+
+    uint64_t sample = SimSensor::currentSampleIndex();
+    if (chance(sample ^ sensorStats.reads, 90, sensorConfig.i2cErrorProbability)) {
+        sensorStats.readErrors++;
+        return ERROR_NACK;
+    }
+    if (sample > 0) {
+        if (readSinceStart && sample == lastReadSample) sensorStats.duplicateReads++;
+        if (readSinceStart && sample > lastReadSample + 1) sensorStats.missedSamples += sample - lastReadSample - 1;
+        readSinceStart = true;
+    }
+    lastReadSample = sample;
+
+    if (sample == 0) {
+        pm1 = pm25 = pm4 = pm10 = humidity = temperature = voc = nox = NAN;
+        return 0;
+    }
+
+    // Values belong to the measurement, not to the moment it is read: reading
+    // the same measurement twice returns identical values, as on the device
+    uint64_t sinceStart = sample * samplePeriodUs();
+    double timeOfDay = fmod((measureStartUs + sinceStart) / 1e6, SECONDS_PER_DAY) / SECONDS_PER_DAY;
+    float daily = (float)sin(2.0 * M_PI * timeOfDay);
+
+    pm25 = sensorConfig.pm25Base + sensorConfig.pm25DailySwing * daily
+         + sensorConfig.noise * noise(sample, 1);
+    if (pm25 < 0.0f) pm25 = 0.0f;
+    if (chance(sample, 20, sensorConfig.spikeProbability)) {
+        pm25 += sensorConfig.spikeMagnitude * (0.5f + unit(sample, 21));
+    }
+    pm1 = pm25 * 0.82f + 0.2f * sensorConfig.noise * noise(sample, 3);
+    pm4 = pm25 * 1.10f + 0.2f * sensorConfig.noise * noise(sample, 5);
+    pm10 = pm25 * 1.22f + 0.3f * sensorConfig.noise * noise(sample, 7);
+    if (pm1 < 0.0f) pm1 = 0.0f;
+
+    bool climateReady = sinceStart >= TEMP_RH_WARMUP_US;
+    bool gasReady = sinceStart >= VOC_NOX_WARMUP_US;
+
+    temperature = climateReady ? 22.0f - 2.5f * daily + 0.05f * noise(sample, 9) : NAN;
+    humidity = climateReady ? 45.0f + 6.0f * daily + 0.2f * noise(sample, 11) : NAN;
+    voc = gasReady ? roundf(100.0f + 25.0f * daily + 3.0f * noise(sample, 13)) : NAN;
+    nox = gasReady ? roundf(1.0f + 0.6f * (1.0f + daily)) : NAN;
+
+    if (chance(sample, 30, sensorConfig.invalidProbability)) {
+        pm25 = NAN;
+    }
+    pm1 = onGrid(pm1, 10.0f);
+    pm25 = onGrid(pm25, 10.0f);
+    pm4 = onGrid(pm4, 10.0f);
+    pm10 = onGrid(pm10, 10.0f);
+    humidity = onGrid(humidity, 100.0f);
+    temperature = onGrid(temperature, 200.0f);
+    voc = onGrid(voc, 10.0f);
+    nox = onGrid(nox, 10.0f);
+    return 0;
+}
+
+uint16_t SensirionI2CSen5x::setTemperatureOffsetSimple(float tempOffset) {
+    (void)tempOffset;
+    return 0;
+}
+
+uint16_t SensirionI2CSen5x::getSerialNumber(unsigned char serialNumber[], uint8_t serialNumberSize) {
+    snprintf((char*)serialNumber, serialNumberSize, "SIM55%08X", (unsigned)sensorConfig.seed);
+    return 0;
+}
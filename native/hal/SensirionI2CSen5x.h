@@ -0,0 +1,36 @@
+/**
+ * @file SensirionI2CSen5x.h
+ * @brief Host stand-in for the Sensirion SEN5x driver
+ *
+ * Mirrors the subset of the driver API used by SensorManager. Readings come
+ * from a deterministic signal model (see SimSensorConfig): the fake sensor
+ * produces one measurement per second after startMeasurement(), and reading
+ * it twice within the same second returns the same values, like the device.
+ * Values come out at the driver's resolution (PM 0.1, humidity 0.01,
+ * temperature 0.005). SimSensor::setTrace() plays recorded reads back instead.
+ */
+
+#ifndef NATIVE_HAL_SENSIRION_I2C_SEN5X_H
+#define NATIVE_HAL_SENSIRION_I2C_SEN5X_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+void errorToString(uint16_t error, char errorMessage[], size_t errorMessageSize);
+
+class SensirionI2CSen5x {
+public:
+    void begin(TwoWire& i2cBus);
+    uint16_t deviceReset();
+    uint16_t startMeasurement();
+    uint16_t stopMeasurement();
+    uint16_t readDataReady(bool& dataReady);
+    uint16_t readMeasuredValues(float& massConcentrationPm1p0, float& massConcentrationPm2p5,
+                                float& massConcentrationPm4p0, float& massConcentrationPm10p0,
+                                float& ambientHumidity, float& ambientTemperature,
+                                float& vocIndex, float& noxIndex);
+    uint16_t setTemperatureOffsetSimple(float tempOffset);
+    uint16_t getSerialNumber(unsigned char serialNumber[], uint8_t serialNumberSize);
+};
+
+#endif // NATIVE_HAL_SENSIRION_I2C_SEN5X_H
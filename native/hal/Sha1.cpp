@@ -0,0 +1,82 @@
+/**
+ * @file Sha1.cpp
+ * @brief SHA-1 (FIPS 180-4) for the mbedTLS stand-in
+ */
+
+#include <mbedtls/sha1.h>
+
+#include <stdint.h>
+#include <string.h>
+
+namespace {
+    uint32_t rotl(uint32_t value, int bits) {
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    void block(uint32_t state[5], const unsigned char* data) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t)data[4 * i] << 24 | (uint32_t)data[4 * i + 1] << 16 | (uint32_t)data[4 * i + 2] << 8
+                   | data[4 * i + 3];
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = t;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+}
+
+int mbedtls_sha1(const unsigned char* input, size_t length, unsigned char output[20]) {
+    uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    size_t full = length - length % 64;
+    for (size_t i = 0; i < full; i += 64) {
+        block(state, input + i);
+    }
+    // Last block(s): the rest, 0x80, zeros and the length in bits
+    unsigned char tail[128] = {0};
+    size_t rest = length - full;
+    memcpy(tail, input + full, rest);
+    tail[rest] = 0x80;
+    size_t tailLength = rest < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t)length * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tailLength - 1 - i] = (unsigned char)(bits >> (8 * i));
+    }
+    for (size_t i = 0; i < tailLength; i += 64) {
+        block(state, tail + i);
+    }
+    for (int i = 0; i < 5; i++) {
+        output[4 * i] = (unsigned char)(state[i] >> 24);
+        output[4 * i + 1] = (unsigned char)(state[i] >> 16);
+        output[4 * i + 2] = (unsigned char)(state[i] >> 8);
+        output[4 * i + 3] = (unsigned char)state[i];
+    }
+    return 0;
+}
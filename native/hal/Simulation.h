@@ -0,0 +1,557 @@
+/**
+ * @file Simulation.h
+ * @brief Control surface for the native hardware simulation
+ *
+ * The fake Arduino, WiFi, HTTP and SEN5x layers all read their behaviour
+ * from the objects declared here. Benchmarks and harnesses configure them
+ * before calling setup() and inspect their counters afterwards.
+ */
+
+#ifndef NATIVE_HAL_SIMULATION_H
+#define NATIVE_HAL_SIMULATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Virtual clock
+// ---------------------------------------------------------------------------
+
+namespace SimClock {
+    /** Current simulated time of the running task, in microseconds since boot. */
+    uint64_t nowMicros();
+    /** Advance simulated time by modelled work or I/O latency (the chip stays awake). */
+    void advanceMicros(uint64_t us);
+    inline void advanceMillis(uint64_t ms) { advanceMicros(ms * 1000ULL); }
+    /** Advance simulated time in a blocking wait (delay(), vTaskDelay()); the chip may sleep. */
+    void sleepMicros(uint64_t us);
+    /**
+     * @brief Run hook after every advance
+     *
+     * Stands in for work the device does on other tasks while the firmware
+     * waits (the WiFi driver posting events).
+     */
+    void setAdvanceHook(void (*hook)());
+    /** Unix epoch seconds corresponding to boot time (for time()). */
+    void setEpochAtBoot(uint32_t epochSeconds);
+    uint32_t epochAtBoot();
+    /**
+     * @brief When SNTP sets the clock: time() counts from boot before atUs
+     *        (by default configTime() plus a 250 ms exchange)
+     */
+    void setSntpSyncMicros(uint64_t atUs);
+}
+
+// ---------------------------------------------------------------------------
+// FreeRTOS tasks
+// ---------------------------------------------------------------------------
+
+/**
+ * Tasks created with xTaskCreatePinnedToCore() run on their own host
+ * thread, but only one thread runs at a time. Each task, and the thread
+ * that calls setup()/loop() (loopTask), keeps its own clock; whenever the
+ * running task's clock advances (delays and modelled I/O alike) the task
+ * whose clock is furthest behind runs next. A task stuck in modelled I/O
+ * therefore holds no other task back, as on separate cores, nothing a task
+ * reads was produced later in virtual time, and runs stay deterministic.
+ */
+namespace SimTasks {
+    /** Let tasks whose clocks are behind the caller's run first. */
+    void yield();
+    /** Tasks created so far, not counting loopTask. */
+    uint32_t count();
+    /** Hand-overs between tasks. */
+    uint64_t switches();
+    /** SimHeap::Untracked nesting of the running task (each task hides only its own allocations). */
+    int& untrackedDepth();
+    /** Blocking waits (delay(), vTaskDelay(Until)(), ulTaskNotifyTake()) that have ended. */
+    uint64_t wakeups();
+}
+
+// ---------------------------------------------------------------------------
+// Power model (automatic light sleep)
+// ---------------------------------------------------------------------------
+
+struct SimPowerConfig {
+    bool ticklessIdle = true;        // Built with CONFIG_FREERTOS_USE_TICKLESS_IDLE (light sleep possible)
+    uint32_t minIdleMicros = 3000;   // Shortest idle stretch worth sleeping (IDLE_TIME_BEFORE_SLEEP, 3 ticks)
+    uint32_t beaconIntervalMicros = 102400; // AP beacon interval at DTIM 1; a modem-sleeping station wakes for each
+    uint32_t beaconAwakeMicros = 3000;      // Chip and radio awake per beacon
+};
+
+struct SimPowerStats {
+    uint64_t accountedMicros;  // Time covered by the figures below
+    uint64_t idleMicros;       // Every task blocked and no peripheral busy
+    uint64_t lightSleepMicros; // Chip in light sleep
+    uint64_t lightSleeps;      // Light-sleep entries, each ending in a chip wakeup
+};
+
+/**
+ * Every task's clock advances either in a blocking wait (delay(),
+ * vTaskDelay(), vTaskDelayUntil(), ulTaskNotifyTake()) or in modelled work
+ * and I/O (I2C reads, flash, TCP, UART FIFO waits). Where every task is in a
+ * blocking wait and the UART has drained, the chip is idle; with automatic
+ * light sleep configured (esp_pm_configure()), no esp_pm lock held and the
+ * station connected in modem sleep, idle stretches of at least
+ * minIdleMicros are spent in light sleep, less a short wakeup for every AP
+ * beacon. Anything else (radio kept on, association in progress) keeps the
+ * chip awake.
+ */
+namespace SimPower {
+    SimPowerConfig& config();
+    SimPowerStats stats();
+    /** True once esp_pm_configure() has enabled automatic light sleep. */
+    bool lightSleepEnabled();
+    /** esp_pm locks currently held. */
+    int locksHeld();
+    /** A peripheral (the UART draining its FIFO) keeps the chip awake until atUs. */
+    void busyUntil(uint64_t atUs);
+    /** Called by the task scheduler: [fromUs, toUs) passed with every task idle or not. */
+    void accountInterval(uint64_t fromUs, uint64_t toUs, bool tasksIdle);
+}
+
+// ---------------------------------------------------------------------------
+// Heap accounting (global operator new/delete are instrumented)
+// ---------------------------------------------------------------------------
+
+struct SimHeapStats {
+    uint64_t allocations;     // Total number of allocations since start
+    uint64_t frees;           // Total number of frees since start
+    uint64_t bytesAllocated;  // Total bytes handed out since start
+    uint64_t liveBytes;       // Bytes currently allocated
+    uint64_t peakLiveBytes;   // High-water mark of liveBytes
+    uint32_t freeBytes;       // Free bytes in the modelled heap (block overhead included)
+    uint32_t largestFreeBlock;    // Largest single allocation that would succeed now
+    uint32_t minLargestFreeBlock; // Low-water mark of largestFreeBlock
+};
+
+namespace SimHeap {
+    /** Modelled internal heap size reported through ESP.getHeapSize(). */
+    const uint32_t HEAP_SIZE = 320 * 1024;
+    /**
+     * Tracked allocations are also placed in a first-fit model of the
+     * device heap (8-byte block header, 4-byte alignment), so long-lived
+     * blocks stranded between freed ones show up as fragmentation: a
+     * largest free block well below the total free bytes.
+     */
+    SimHeapStats stats();
+    void resetPeak();
+
+    /**
+     * @brief Scope guard that hides simulator-internal allocations
+     *
+     * The fake transport and servers allocate freely; wrapping them in this
+     * guard keeps the counters limited to what the firmware itself does.
+     */
+    class Untracked {
+    public:
+        Untracked();
+        ~Untracked();
+        Untracked(const Untracked&) = delete;
+        Untracked& operator=(const Untracked&) = delete;
+    };
+}
+
+// ---------------------------------------------------------------------------
+// SEN55 sensor model
+// ---------------------------------------------------------------------------
+
+struct SimSensorConfig {
+    uint32_t seed = 1;
+    float pm25Base = 12.0f;          // Baseline PM2.5 (µg/m³)
+    float pm25DailySwing = 8.0f;     // Amplitude of the daily cycle
+    float noise = 0.8f;              // Gaussian-ish noise amplitude
+    float spikeProbability = 0.0f;   // Chance per sample of a single PM spike
+    float spikeMagnitude = 150.0f;   // Size of injected PM spikes
+    float i2cErrorProbability = 0.0f; // Chance a read returns an I2C error
+    float invalidProbability = 0.0f; // Chance a sample comes back as NaN
+    uint32_t i2cReadMicros = 1200;   // Bus time for one readMeasuredValues()
+    int32_t clockErrorPpm = 2500;    // Sensor oscillator vs. the ESP32 crystal (+ = slower than 1 Hz)
+};
+
+struct SimSensorStats {
+    uint64_t reads;          // readMeasuredValues() calls
+    uint64_t readErrors;     // Reads that returned an error
+    uint64_t dataReadyPolls; // readDataReady() calls
+    uint64_t duplicateReads; // Successful reads that returned a measurement already read
+    uint64_t missedSamples;  // Measurements never read (after the first read since start)
+    uint64_t traceLateReads; // Trace readings read a millisecond or more after their recorded time
+};
+
+/** One recorded read, played back instead of the signal model */
+struct SimSensorTraceSample {
+    uint64_t atMillis;       // When the device read it
+    bool ok;                 // false: the read fails with an I2C error
+    float pm1, pm25, pm4, pm10, humidity, temperature, voc, nox;
+};
+
+namespace SimSensor {
+    SimSensorConfig& config();
+    SimSensorStats stats();
+    /** Index of the sensor's internal ~1 Hz measurement at the current time. */
+    uint64_t currentSampleIndex();
+    /** Run hook after every readMeasuredValues(), on the reading task's clock. */
+    void setReadHook(void (*hook)());
+    /**
+     * @brief Play recorded reads back instead of the signal model
+     *
+     * Each reading becomes ready at its recorded time: a data-ready poll
+     * that comes less than 10 ms early (SensorTask::POLL_MS) waits for it,
+     * so a task polling as on the device reads it at exactly that
+     * millisecond. Nothing is ready after the last one.
+     */
+    void setTrace(const std::vector<SimSensorTraceSample>& samples);
+    /** Trace readings not read yet */
+    size_t traceRemaining();
+}
+
+// ---------------------------------------------------------------------------
+// WiFi model
+// ---------------------------------------------------------------------------
+
+struct SimWiFiConfig {
+    uint32_t associateMillis = 2500; // Time from WiFi.begin() to WL_CONNECTED (or to failing)
+    int rssi = -62;
+};
+
+struct SimWiFiStats {
+    uint64_t attempts;      // Association attempts (begin(), reconnect() and auto-reconnect)
+    uint64_t failedAttempts;// Attempts that ended with the AP unreachable
+    uint64_t disconnects;   // Established links that dropped
+    uint64_t events;        // Events delivered to onEvent() handlers
+};
+
+/**
+ * The station model: begin() starts an association attempt that completes
+ * associateMillis later, successfully unless an outage covers that moment.
+ * An outage drops an established link. With auto-reconnect on (the ESP32
+ * default) the driver retries by itself after every failure or drop; with
+ * it off the station stays idle until the firmware calls begin() again.
+ * Transitions are posted as ARDUINO_EVENT_WIFI_STA_* events whenever
+ * simulated time advances, the way the ESP32 event task runs while the
+ * firmware waits.
+ */
+namespace SimWiFi {
+    SimWiFiConfig& config();
+    SimWiFiStats stats();
+    /** Schedule a link outage starting at startMs lasting durationMs. */
+    void addOutage(uint64_t startMs, uint64_t durationMs);
+    void clearOutages();
+    bool linkUp();
+    /** Station connected with modem sleep on (WiFi.setSleep(true)): the radio wakes only for beacons. */
+    bool modemSleeping();
+    /**
+     * @brief True if the link was down (or re-associated) at any point
+     * since sinceUs; sockets open across such a gap are half-open.
+     */
+    bool linkLostSince(uint64_t sinceUs);
+    uint64_t beginCalls();
+}
+
+// ---------------------------------------------------------------------------
+// TCP / HTTP model
+// ---------------------------------------------------------------------------
+
+struct SimHttpRequest {
+    std::string method;
+    std::string path;   // Path including query string
+    std::string headers;
+    std::string body;
+};
+
+struct SimHttpResponse {
+    int status = 200;
+    std::string contentType = "text/plain";
+    std::string body;
+    bool closeConnection = false;
+    bool noResponse = false;   // Never answer (the client times out), like a server that hung;
+                               // with closeConnection, close without answering instead
+};
+
+/**
+ * @brief In-process server bound to a host name
+ *
+ * Implementations play the part of a remote endpoint (ThingSpeak, a broker)
+ * and see the exact bytes the firmware puts on the wire.
+ */
+class SimHttpHandler {
+public:
+    virtual ~SimHttpHandler() = default;
+    virtual void handle(const SimHttpRequest& request, SimHttpResponse& response) = 0;
+};
+
+class SimStreamHandler;
+
+/**
+ * @brief The server's end of a TCP connection to a SimStreamHandler
+ *
+ * The handler consumes what the device sent from input and answers with
+ * reply(). A reply reaches the device delayMillis later (its round trip),
+ * in order, while the device keeps sending: a client that pipelines
+ * requests sees them answered as a real broker would answer them.
+ */
+struct SimStreamConnection {
+    uint64_t id = 0;                  // Unique per connection
+    SimStreamHandler* handler = nullptr;
+    std::string input;                // Sent by the device, not yet consumed by the handler
+    uint32_t idleTimeoutMillis = 0;   // Server drops the connection after this long without input (0: never)
+    bool closing = false;             // Close once the replies queued so far have reached the device
+    bool ended = false;               // onClose() was called
+
+    void reply(const std::string& bytes, uint32_t delayMillis = 0);
+
+    struct Reply {
+        uint64_t atUs;
+        std::string bytes;
+    };
+    std::deque<Reply> replies;        // In flight to the device
+};
+
+/**
+ * @brief In-process server for a raw TCP protocol (an MQTT broker)
+ *
+ * Registered with SimNet::registerStreamHost(); sees every byte the
+ * firmware writes, as it is written.
+ */
+class SimStreamHandler {
+public:
+    virtual ~SimStreamHandler() = default;
+    /** New bytes are in connection.input */
+    virtual void onData(SimStreamConnection& connection) = 0;
+    /** The connection ended: closed by either side, idle too long or lost with the link */
+    virtual void onClose(SimStreamConnection& connection) { (void)connection; }
+};
+
+struct SimNetConfig {
+    uint32_t dnsMillis = 40;         // Name lookup cost per connect
+    uint32_t connectMillis = 120;    // TCP handshake cost per connect
+    uint32_t requestMillis = 180;    // Server think time + transfer per request
+    uint32_t idleTimeoutMillis = 15000; // Server closes idle keep-alive sockets (client sees the FIN)
+    float failureProbability = 0.0f; // Chance a connect attempt is refused
+};
+
+struct SimNetStats {
+    uint64_t connects;
+    uint64_t failedConnects;
+    uint64_t requests;
+    uint64_t lostRequests;  // Requests written to a half-open socket or left unanswered (no response ever comes)
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+};
+
+namespace SimNet {
+    SimNetConfig& config();
+    SimNetStats stats();
+    void registerHost(const char* host, SimHttpHandler* handler);
+    SimHttpHandler* handlerFor(const char* host);
+    void registerStreamHost(const char* host, SimStreamHandler* handler);
+}
+
+// ---------------------------------------------------------------------------
+// LAN peers (browsers and other clients of servers on the device)
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief A LAN client's end of a TCP connection to a WiFiServer on the device
+ *
+ * The peer sends requests with send() and collects what the firmware wrote
+ * with take(). Like a non-blocking lwIP socket, the firmware's write() only
+ * takes what fits in sendBuffer minus the bytes the peer has not taken yet,
+ * so a client on a weak link is modelled by taking rarely or a little at a
+ * time. Delivery is instant; the model counts bytes, not airtime.
+ */
+struct SimLanSocket {
+    std::string toDevice;       // Sent by the peer, not yet read by the firmware
+    size_t toDevicePos = 0;
+    std::string fromDevice;     // Written by the firmware, not yet taken by the peer
+    size_t sendBuffer = 5744;   // TCP_SND_BUF of the ESP32 Arduino core's lwIP
+    bool peerClosed = false;    // close() called; the firmware sees the FIN once it read everything
+    bool deviceClosed = false;  // The firmware called stop()
+
+    void send(const char* data);
+    void send(const char* data, size_t length);
+    /** Up to maxBytes of what the firmware wrote, oldest first */
+    std::string take(size_t maxBytes = (size_t)-1);
+    void close();
+};
+
+struct SimLanStats {
+    uint64_t connects;
+    uint64_t refused;           // Nothing listening, or the listen backlog was full
+    uint64_t bytesToDevice;
+    uint64_t bytesFromDevice;
+    uint64_t shortWrites;       // write() calls cut short by a full send buffer
+};
+
+namespace SimLan {
+    /** Open a connection to a WiFiServer listening on port; nullptr if refused */
+    std::shared_ptr<SimLanSocket> connect(uint16_t port);
+    SimLanStats stats();
+}
+
+// ---------------------------------------------------------------------------
+// Flash filesystem model (LittleFS backed by a host directory)
+// ---------------------------------------------------------------------------
+
+struct SimFlashConfig {
+    size_t totalBytes = 1536 * 1024; // Reported partition size
+    uint32_t writeMicros = 60;       // Cost of one write() call
+    uint32_t openMicros = 150;       // Cost of opening a file (metadata lookup)
+    uint32_t removeMicros = 900;     // Cost of removing a file (metadata commit)
+};
+
+struct SimFlashStats {
+    uint64_t opens;         // Files opened (any mode)
+    uint64_t writeOps;      // write() calls that reached a file
+    uint64_t bytesWritten;
+    uint64_t readOps;       // read() calls on files
+    uint64_t bytesRead;
+    uint64_t removes;       // Files removed
+};
+
+namespace SimFlash {
+    SimFlashConfig& config();
+    SimFlashStats stats();
+    /**
+     * @brief Host directory holding the filesystem contents
+     *
+     * Defaults to a fresh temporary directory that is deleted at exit.
+     */
+    const std::string& root();
+    void setRoot(const std::string& directory);
+    /** Delete everything on the simulated filesystem. */
+    void wipe();
+    /** Host path for a filesystem path, for harnesses that tamper with files. */
+    std::string hostPath(const char* path);
+}
+
+// ---------------------------------------------------------------------------
+// ThingSpeak stand-in
+// ---------------------------------------------------------------------------
+
+struct FakeThingSpeakStats {
+    uint64_t requests;      // Requests seen by the server
+    uint64_t bulkRequests;  // Accepted bulk_update.json requests
+    uint64_t accepted;      // Entries written to the channel (single or bulk)
+    uint64_t rateLimited;   // Requests rejected by the 15 s rule
+    uint64_t malformed;     // Requests with missing key or fields
+    uint64_t backfilled;    // Accepted entries whose created_at is over a minute old
+    uint64_t outOfOrder;    // Accepted entries older than the previous entry
+};
+
+/**
+ * @brief Minimal model of api.thingspeak.com
+ *
+ * Implements the update endpoint with the free-tier rate limit: an update
+ * arriving less than minIntervalMillis after the last accepted one gets
+ * the body "0", exactly like the real service. An optional created_at
+ * (ISO 8601, UTC) timestamps the entry; otherwise the server's clock
+ * (SimClock::epochAtBoot() + uptime) is used.
+ *
+ * POST /channels/<id>/bulk_update.json takes the JSON bulk format and is
+ * checked strictly: write_api_key, a non-empty "updates" array of at most
+ * 960 objects, each with created_at or delta_t (not mixed within one
+ * request), numeric field1..field8 and no unknown keys. delta_t entries
+ * are placed backwards from the time of the request. Bulk requests share
+ * the rate limit with /update (429 when too early).
+ */
+class FakeThingSpeak : public SimHttpHandler {
+public:
+    explicit FakeThingSpeak(const char* apiKey, uint32_t minIntervalMillis = 15000);
+    void handle(const SimHttpRequest& request, SimHttpResponse& response) override;
+    const FakeThingSpeakStats& stats() const { return counters; }
+
+private:
+    void handleUpdate(const SimHttpRequest& request, SimHttpResponse& response);
+    void handleBulkUpdate(const SimHttpRequest& request, SimHttpResponse& response);
+    void acceptEntry(uint64_t createdAt, uint64_t now);
+    bool rateLimited();
+    static bool parseTimestamp(const std::string& text, uint64_t& epoch);
+
+    std::string apiKey;
+    uint32_t minIntervalMillis;
+    uint64_t lastAcceptedMs;
+    bool anyAccepted;
+    uint64_t nextEntryId;
+    uint64_t lastCreatedAt;
+    FakeThingSpeakStats counters;
+};
+
+// ---------------------------------------------------------------------------
+// MQTT broker stand-in
+// ---------------------------------------------------------------------------
+
+struct FakeMqttBrokerConfig {
+    uint32_t replyMillis = 40;        // Round trip until a CONNACK, PUBACK or PINGRESP reaches the device
+    float dropAckProbability = 0.0f;  // Chance a PUBLISH is taken but never acknowledged
+};
+
+struct FakeMqttBrokerStats {
+    uint64_t connects;        // CONNECTs accepted
+    uint64_t sessionsResumed; // ... that found the client's session (clean session 0)
+    uint64_t publishes;       // QoS 1 PUBLISH packets received
+    uint64_t duplicates;      // PUBLISHes repeating a message already received (a DUP crossing its PUBACK)
+    uint64_t records;         // Records in new messages
+    uint64_t acksDropped;     // PUBACKs withheld (dropAckProbability)
+    uint64_t pings;           // PINGREQs answered
+    uint64_t outOfOrder;      // Records older than the client's previous record
+    uint64_t malformed;       // Packets or payloads that did not parse (the connection is closed)
+    uint64_t bytesReceived;
+};
+
+/**
+ * @brief Minimal MQTT 3.1.1 broker for QoS 1 publishers
+ *
+ * Register it with SimNet::registerStreamHost(). It takes CONNECT (clean
+ * session 0 keeps a session per client id across connections),
+ * PUBLISH at QoS 1, PINGREQ and DISCONNECT, and closes a connection idle
+ * for 1.5 keepalive periods, as the specification asks. Replies leave
+ * after replyMillis.
+ *
+ * Payloads are decoded as RecordCodec streams. A PUBLISH whose packet id
+ * and payload match one already received is a retransmission and counted
+ * as a duplicate, not delivered again, which is how a consumer would
+ * de-duplicate; timestamps() lists what was delivered.
+ */
+class FakeMqttBroker : public SimStreamHandler {
+public:
+    FakeMqttBroker();
+    void onData(SimStreamConnection& connection) override;
+    void onClose(SimStreamConnection& connection) override;
+
+    FakeMqttBrokerConfig& config() { return settings; }
+    const FakeMqttBrokerStats& stats() const { return counters; }
+    /** Timestamps of the records delivered for clientId, in arrival order */
+    const std::vector<uint32_t>& timestamps(const char* clientId);
+    /** Connections open now */
+    size_t connectionCount() const { return clients.size(); }
+    /** Forget every session, as a broker restarted without persistence would */
+    void clearSessions();
+
+private:
+    struct Session {
+        std::map<uint16_t, std::string> received; // Last payload per packet id
+        std::vector<uint32_t> timestamps;
+        uint32_t lastTimestamp = 0;
+    };
+
+    bool handlePacket(SimStreamConnection& connection, uint8_t type, const std::string& body);
+    bool handleConnect(SimStreamConnection& connection, const std::string& body);
+    bool handlePublish(SimStreamConnection& connection, uint8_t flags, const std::string& body);
+    void deliver(Session& session, const std::string& payload);
+    float nextUnit();
+
+    FakeMqttBrokerConfig settings;
+    FakeMqttBrokerStats counters;
+    std::map<uint64_t, std::string> clients;   // Connection id -> client id
+    std::map<std::string, Session> sessions;
+    uint32_t randomState;
+};
+
+#endif // NATIVE_HAL_SIMULATION_H
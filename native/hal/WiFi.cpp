@@ -0,0 +1,638 @@
+/**
+ * @file WiFi.cpp
+ * @brief Simulated WiFi link and in-process TCP transport
+ */
+
+#include "WiFi.h"
+#include "ESPmDNS.h"
+#include "Simulation.h"
+
+#include <strings.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+WiFiClass WiFi;
+MDNSResponder MDNS;
+
+// ---------------------------------------------------------------------------
+// Link model
+// ---------------------------------------------------------------------------
+
+namespace {
+    struct Outage {
+        uint64_t startUs;
+        uint64_t endUs;
+    };
+
+    struct EventHandler {
+        WiFiEventFuncCb callback;
+        arduino_event_id_t event; // ARDUINO_EVENT_MAX = all events
+    };
+
+    enum StationState { STATION_IDLE, STATION_CONNECTING, STATION_CONNECTED };
+
+    SimWiFiConfig wifiConfig;
+    SimWiFiStats wifiStats = {0, 0, 0, 0};
+    std::vector<Outage> outages;
+    std::vector<EventHandler> handlers;
+    StationState station = STATION_IDLE;
+    uint64_t attemptDoneUs = 0;   // When the current association attempt completes
+    uint64_t connectedAtUs = 0;
+    uint64_t lastDownUs = 0;      // Last time an established link went away
+    uint64_t beginCount = 0;
+    bool settling = false;
+
+    uint64_t associateUs() { return (uint64_t)wifiConfig.associateMillis * 1000ULL; }
+
+    bool apReachable(uint64_t atUs) {
+        for (const Outage& outage : outages) {
+            if (atUs >= outage.startUs && atUs < outage.endUs) return false;
+        }
+        return true;
+    }
+
+    void startAttempt(uint64_t atUs) {
+        wifiStats.attempts++;
+        station = STATION_CONNECTING;
+        attemptDoneUs = atUs + associateUs();
+    }
+
+    void post(std::vector<std::pair<arduino_event_id_t, uint8_t> >& pending, arduino_event_id_t event,
+              uint8_t reason = 0) {
+        pending.push_back(std::make_pair(event, reason));
+    }
+
+    /** Apply every station transition up to now, in order, then deliver the events. */
+    void settle() {
+        if (settling) return;
+        settling = true;
+        SimHeap::Untracked untracked;
+        std::vector<std::pair<arduino_event_id_t, uint8_t> > pending;
+        uint64_t now = SimClock::nowMicros();
+        for (;;) {
+            if (station == STATION_CONNECTING) {
+                if (attemptDoneUs > now) break;
+                uint64_t at = attemptDoneUs;
+                if (apReachable(at)) {
+                    station = STATION_CONNECTED;
+                    connectedAtUs = at;
+                    post(pending, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+                    post(pending, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+                } else {
+                    wifiStats.failedAttempts++;
+                    station = STATION_IDLE;
+                    post(pending, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_NO_AP_FOUND);
+                    if (WiFi.getAutoReconnect()) startAttempt(at);
+                }
+            } else if (station == STATION_CONNECTED) {
+                uint64_t dropAt = UINT64_MAX;
+                for (const Outage& outage : outages) {
+                    if (outage.startUs > connectedAtUs && outage.startUs <= now && outage.startUs < dropAt) {
+                        dropAt = outage.startUs;
+                    }
+                }
+                if (dropAt == UINT64_MAX) break;
+                wifiStats.disconnects++;
+                station = STATION_IDLE;
+                lastDownUs = dropAt;
+                post(pending, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_BEACON_TIMEOUT);
+                if (WiFi.getAutoReconnect()) startAttempt(dropAt);
+            } else {
+                break;
+            }
+        }
+
+        std::vector<EventHandler> targets = handlers;
+        for (const auto& event : pending) {
+            arduino_event_info_t info;
+            memset(&info, 0, sizeof(info));
+            info.wifi_sta_disconnected.reason = event.second;
+            for (const EventHandler& handler : targets) {
+                if (handler.event != ARDUINO_EVENT_MAX && handler.event != event.first) continue;
+                wifiStats.events++;
+                handler.callback(event.first, info);
+            }
+        }
+        settling = false;
+    }
+}
+
+SimWiFiConfig& SimWiFi::config() { return wifiConfig; }
+SimWiFiStats SimWiFi::stats() { return wifiStats; }
+
+void SimWiFi::addOutage(uint64_t startMs, uint64_t durationMs) {
+    SimHeap::Untracked untracked;
+    outages.push_back({startMs * 1000ULL, (startMs + durationMs) * 1000ULL});
+}
+
+void SimWiFi::clearOutages() { outages.clear(); }
+uint64_t SimWiFi::beginCalls() { return beginCount; }
+
+bool SimWiFi::linkUp() {
+    settle();
+    return station == STATION_CONNECTED;
+}
+
+bool SimWiFi::modemSleeping() {
+    // No settle(): called from the power model while time is being accounted
+    return station == STATION_CONNECTED && WiFi.getSleep();
+}
+
+bool SimWiFi::linkLostSince(uint64_t sinceUs) {
+    return !linkUp() || lastDownUs > sinceUs || connectedAtUs > sinceUs;
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buffer);
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password) {
+    (void)ssid;
+    (void)password;
+    SimClock::setAdvanceHook(settle);
+    settle();
+    beginCount++;
+    if (station == STATION_CONNECTED) lastDownUs = SimClock::nowMicros();
+    startAttempt(SimClock::nowMicros());
+    return WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp) {
+    (void)wifiOff;
+    (void)eraseAp;
+    settle();
+    bool wasActive = station != STATION_IDLE;
+    if (station == STATION_CONNECTED) lastDownUs = SimClock::nowMicros();
+    station = STATION_IDLE;
+    if (wasActive) {
+        SimHeap::Untracked untracked;
+        arduino_event_info_t info;
+        memset(&info, 0, sizeof(info));
+        info.wifi_sta_disconnected.reason = WIFI_REASON_ASSOC_LEAVE;
+        std::vector<EventHandler> targets = handlers;
+        for (const EventHandler& handler : targets) {
+            if (handler.event != ARDUINO_EVENT_MAX && handler.event != ARDUINO_EVENT_WIFI_STA_DISCONNECTED) continue;
+            wifiStats.events++;
+            handler.callback(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+        }
+    }
+    return true;
+}
+
+bool WiFiClass::reconnect() {
+    settle();
+    if (station == STATION_CONNECTED) lastDownUs = SimClock::nowMicros();
+    startAttempt(SimClock::nowMicros());
+    return true;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb callback, arduino_event_id_t event) {
+    SimHeap::Untracked untracked;
+    handlers.push_back({callback, event});
+    return (wifi_event_id_t)handlers.size();
+}
+
+wl_status_t WiFiClass::status() {
+    return SimWiFi::linkUp() ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+IPAddress WiFiClass::localIP() {
+    return SimWiFi::linkUp() ? IPAddress(192, 168, 1, 100) : IPAddress();
+}
+
+int8_t WiFiClass::RSSI() {
+    return SimWiFi::linkUp() ? (int8_t)wifiConfig.rssi : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Transport model
+// ---------------------------------------------------------------------------
+
+namespace {
+    SimNetConfig netConfig;
+    SimNetStats netStats = {0, 0, 0, 0, 0, 0};
+    SimLanStats lanStats = {0, 0, 0, 0, 0};
+    // LAN servers by port. Never destroyed: firmware globals such as the
+    // dashboard's WiFiServer are torn down after this file's statics
+    std::map<uint16_t, WiFiServer*>& listeners() {
+        static auto* byPort = new std::map<uint16_t, WiFiServer*>();
+        return *byPort;
+    }
+    std::map<std::string, SimHttpHandler*> hosts;
+    std::map<std::string, SimStreamHandler*> streamHosts;
+    uint64_t nextStreamId = 1;
+    uint64_t rngState = 0x2545F4914F6CDD1DULL;
+
+    float nextUnit() {
+        rngState ^= rngState << 13;
+        rngState ^= rngState >> 7;
+        rngState ^= rngState << 17;
+        return (float)((rngState >> 40) * (1.0 / 16777216.0));
+    }
+
+    const char* reasonPhrase(int status) {
+        switch (status) {
+            case 200: return "OK";
+            case 202: return "Accepted";
+            case 304: return "Not Modified";
+            case 400: return "Bad Request";
+            case 401: return "Unauthorized";
+            case 404: return "Not Found";
+            case 429: return "Too Many Requests";
+            default: return status >= 500 ? "Internal Server Error" : "Unknown";
+        }
+    }
+
+    /** Case-insensitive lookup of a header value inside a raw header block. */
+    std::string headerValue(const std::string& headers, const char* name) {
+        size_t nameLen = strlen(name);
+        size_t pos = 0;
+        while (pos < headers.size()) {
+            size_t end = headers.find("\r\n", pos);
+            if (end == std::string::npos) end = headers.size();
+            if (end - pos > nameLen && headers[pos + nameLen] == ':'
+                && strncasecmp(headers.c_str() + pos, name, nameLen) == 0) {
+                size_t valueStart = headers.find_first_not_of(' ', pos + nameLen + 1);
+                return valueStart < end ? headers.substr(valueStart, end - valueStart) : "";
+            }
+            pos = end + 2;
+        }
+        return "";
+    }
+}
+
+SimNetConfig& SimNet::config() { return netConfig; }
+SimNetStats SimNet::stats() { return netStats; }
+void SimNet::registerHost(const char* host, SimHttpHandler* handler) {
+    SimHeap::Untracked untracked;
+    hosts[host] = handler;
+}
+
+SimHttpHandler* SimNet::handlerFor(const char* host) {
+    auto it = hosts.find(host);
+    return it == hosts.end() ? nullptr : it->second;
+}
+
+void SimNet::registerStreamHost(const char* host, SimStreamHandler* handler) {
+    SimHeap::Untracked untracked;
+    streamHosts[host] = handler;
+}
+
+void SimStreamConnection::reply(const std::string& bytes, uint32_t delayMillis) {
+    SimHeap::Untracked untracked;
+    uint64_t atUs = SimClock::nowMicros() + (uint64_t)delayMillis * 1000ULL;
+    if (!replies.empty() && replies.back().atUs > atUs) {
+        atUs = replies.back().atUs; // One TCP stream: nothing overtakes
+    }
+    replies.push_back({atUs, bytes});
+}
+
+WiFiClient::WiFiClient() : open(false), halfOpen(false), lastActivityUs(0), rxPos(0) {}
+
+WiFiClient::WiFiClient(const std::shared_ptr<SimLanSocket>& socket)
+    : open(true), halfOpen(false), lastActivityUs(SimClock::nowMicros()), rxPos(0), lan(socket) {}
+
+WiFiClient::WiFiClient(WiFiClient&& other) : open(false), halfOpen(false), lastActivityUs(0), rxPos(0) {
+    *this = std::move(other);
+}
+
+WiFiClient& WiFiClient::operator=(WiFiClient&& other) {
+    SimHeap::Untracked untracked;
+    if (this != &other) {
+        stop();
+        host = std::move(other.host);
+        open = other.open;
+        halfOpen = other.halfOpen;
+        lastActivityUs = other.lastActivityUs;
+        txBuffer = std::move(other.txBuffer);
+        rxBuffer = std::move(other.rxBuffer);
+        rxPos = other.rxPos;
+        lan = std::move(other.lan);
+        stream = std::move(other.stream);
+        other.open = false;
+        other.halfOpen = false;
+        other.rxPos = 0;
+        other.rxBuffer.clear();
+        other.txBuffer.clear();
+    }
+    return *this;
+}
+
+WiFiClient::~WiFiClient() {
+    SimHeap::Untracked untracked;
+    stop();
+}
+
+int WiFiClient::connect(const char* hostName, uint16_t port) {
+    SimHeap::Untracked untracked;
+    (void)port;
+    stop();
+    if (!SimWiFi::linkUp()) {
+        netStats.failedConnects++;
+        return 0;
+    }
+    SimClock::advanceMillis(netConfig.dnsMillis + netConfig.connectMillis);
+    auto streamHost = streamHosts.find(hostName);
+    bool known = SimNet::handlerFor(hostName) || streamHost != streamHosts.end();
+    if (!known || nextUnit() < netConfig.failureProbability) {
+        netStats.failedConnects++;
+        return 0;
+    }
+    netStats.connects++;
+    host = hostName;
+    open = true;
+    lastActivityUs = SimClock::nowMicros();
+    if (streamHost != streamHosts.end()) {
+        stream = std::make_shared<SimStreamConnection>();
+        stream->id = nextStreamId++;
+        stream->handler = streamHost->second;
+    }
+    return 1;
+}
+
+void WiFiClient::endStream() {
+    if (!stream || stream->ended) return;
+    stream->ended = true;
+    stream->handler->onClose(*stream);
+}
+
+void WiFiClient::deliverReplies() {
+    if (!stream) return;
+    SimHeap::Untracked untracked;
+    uint64_t now = SimClock::nowMicros();
+    while (!stream->replies.empty() && stream->replies.front().atUs <= now) {
+        if (!halfOpen) {
+            if (rxPos == rxBuffer.size()) {
+                rxBuffer.clear();
+                rxPos = 0;
+            }
+            rxBuffer += stream->replies.front().bytes;
+        }
+        stream->replies.pop_front();
+    }
+    if (stream->closing && stream->replies.empty() && open) {
+        open = false; // The server closed after its last reply; the FIN was seen
+        endStream();
+    }
+}
+
+void WiFiClient::dropIfIdle() {
+    if (!open || halfOpen) return;
+    if (SimWiFi::linkLostSince(lastActivityUs)) {
+        // Neither FIN nor RST reaches us across a link loss: the socket still
+        // looks connected, but the server has forgotten it
+        halfOpen = true;
+        endStream();
+        return;
+    }
+    uint32_t idleLimitMillis = stream ? stream->idleTimeoutMillis : netConfig.idleTimeoutMillis;
+    uint64_t idleUs = SimClock::nowMicros() - lastActivityUs;
+    if (idleLimitMillis != 0 && idleUs > (uint64_t)idleLimitMillis * 1000ULL) {
+        open = false; // Server closed the idle socket; the FIN was seen
+        endStream();
+    }
+}
+
+uint8_t WiFiClient::connected() {
+    if (lan) {
+        return !lan->peerClosed || lan->toDevicePos < lan->toDevice.size();
+    }
+    deliverReplies();
+    dropIfIdle();
+    return open || rxPos < rxBuffer.size();
+}
+
+void WiFiClient::stop() {
+    if (lan) {
+        SimHeap::Untracked untracked;
+        lan->deviceClosed = true;
+        lan.reset();
+    }
+    if (stream) {
+        SimHeap::Untracked untracked;
+        endStream();
+        stream.reset();
+    }
+    open = false;
+    halfOpen = false;
+    txBuffer.clear();
+    rxBuffer.clear();
+    rxPos = 0;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    SimHeap::Untracked untracked;
+    if (lan) {
+        if (lan->peerClosed) return 0;
+        size_t space = lan->fromDevice.size() < lan->sendBuffer ? lan->sendBuffer - lan->fromDevice.size() : 0;
+        size_t count = size < space ? size : space;
+        if (count < size) lanStats.shortWrites++;
+        lan->fromDevice.append((const char*)buffer, count);
+        lanStats.bytesFromDevice += count;
+        return count;
+    }
+    deliverReplies();
+    dropIfIdle();
+    if (!open) return 0;
+    netStats.bytesSent += size;
+    lastActivityUs = SimClock::nowMicros();
+    if (stream) {
+        if (!halfOpen && !stream->ended) {
+            stream->input.append((const char*)buffer, size);
+            stream->handler->onData(*stream);
+        }
+        return size; // Across a lost link the bytes vanish
+    }
+    txBuffer.append((const char*)buffer, size);
+    serviceRequests();
+    return size;
+}
+
+void WiFiClient::serviceRequests() {
+    for (;;) {
+        size_t headerEnd = txBuffer.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) return;
+
+        std::string head = txBuffer.substr(0, headerEnd + 2);
+        size_t lineEnd = head.find("\r\n");
+        std::string requestLine = head.substr(0, lineEnd);
+        std::string headers = head.substr(lineEnd + 2);
+        size_t contentLength = (size_t)strtoul(headerValue(headers, "Content-Length").c_str(), nullptr, 10);
+        if (txBuffer.size() < headerEnd + 4 + contentLength) return;
+
+        SimHttpRequest request;
+        size_t sp1 = requestLine.find(' ');
+        size_t sp2 = requestLine.find(' ', sp1 + 1);
+        request.method = requestLine.substr(0, sp1);
+        request.path = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+        request.headers = headers;
+        request.body = txBuffer.substr(headerEnd + 4, contentLength);
+        txBuffer.erase(0, headerEnd + 4 + contentLength);
+        if (halfOpen) {
+            netStats.lostRequests++; // Reads will time out
+            continue;
+        }
+
+        SimHttpResponse response;
+        SimNet::handlerFor(host.c_str())->handle(request, response);
+        netStats.requests++;
+        if (response.noResponse) {
+            netStats.lostRequests++;
+            if (response.closeConnection) open = false;
+            continue;
+        }
+        SimClock::advanceMillis(netConfig.requestMillis);
+
+        bool closing = response.closeConnection
+            || strcasecmp(headerValue(headers, "Connection").c_str(), "close") == 0;
+        char statusLine[160];
+        snprintf(statusLine, sizeof(statusLine),
+                 "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: %s\r\n\r\n",
+                 response.status, reasonPhrase(response.status), response.contentType.c_str(),
+                 response.body.size(), closing ? "close" : "keep-alive");
+        if (rxPos == rxBuffer.size()) {
+            rxBuffer.clear();
+            rxPos = 0;
+        }
+        rxBuffer += statusLine;
+        rxBuffer += response.body;
+        lastActivityUs = SimClock::nowMicros();
+        if (closing) open = false;
+    }
+}
+
+int WiFiClient::available() {
+    if (lan) return (int)(lan->toDevice.size() - lan->toDevicePos);
+    deliverReplies();
+    return (int)(rxBuffer.size() - rxPos);
+}
+
+int WiFiClient::read() {
+    if (lan) {
+        if (lan->toDevicePos >= lan->toDevice.size()) return -1;
+        return (unsigned char)lan->toDevice[lan->toDevicePos++];
+    }
+    deliverReplies();
+    if (rxPos >= rxBuffer.size()) return -1;
+    netStats.bytesReceived++;
+    return (unsigned char)rxBuffer[rxPos++];
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    if (lan) {
+        size_t count = lan->toDevice.size() - lan->toDevicePos;
+        if (count > size) count = size;
+        memcpy(buffer, lan->toDevice.data() + lan->toDevicePos, count);
+        lan->toDevicePos += count;
+        return (int)count;
+    }
+    deliverReplies();
+    size_t count = rxBuffer.size() - rxPos;
+    if (count > size) count = size;
+    memcpy(buffer, rxBuffer.data() + rxPos, count);
+    rxPos += count;
+    netStats.bytesReceived += count;
+    return (int)count;
+}
+
+int WiFiClient::peek() {
+    if (lan) {
+        return lan->toDevicePos < lan->toDevice.size() ? (unsigned char)lan->toDevice[lan->toDevicePos] : -1;
+    }
+    deliverReplies();
+    return rxPos < rxBuffer.size() ? (unsigned char)rxBuffer[rxPos] : -1;
+}
+
+// ---------------------------------------------------------------------------
+// LAN peers and WiFiServer
+// ---------------------------------------------------------------------------
+
+struct SimLanListener {
+    static bool enqueue(WiFiServer& server, const std::shared_ptr<SimLanSocket>& socket) {
+        if (server.pending.size() >= server.backlog) return false;
+        server.pending.push_back(socket);
+        return true;
+    }
+};
+
+void SimLanSocket::send(const char* data) {
+    send(data, strlen(data));
+}
+
+void SimLanSocket::send(const char* data, size_t length) {
+    SimHeap::Untracked untracked;
+    if (peerClosed) return;
+    if (toDevicePos == toDevice.size()) {
+        toDevice.clear();
+        toDevicePos = 0;
+    }
+    toDevice.append(data, length);
+    lanStats.bytesToDevice += length;
+}
+
+std::string SimLanSocket::take(size_t maxBytes) {
+    SimHeap::Untracked untracked;
+    size_t count = fromDevice.size() < maxBytes ? fromDevice.size() : maxBytes;
+    std::string taken = fromDevice.substr(0, count);
+    fromDevice.erase(0, count);
+    return taken;
+}
+
+void SimLanSocket::close() {
+    peerClosed = true;
+}
+
+std::shared_ptr<SimLanSocket> SimLan::connect(uint16_t port) {
+    SimHeap::Untracked untracked;
+    auto it = listeners().find(port);
+    std::shared_ptr<SimLanSocket> socket = std::make_shared<SimLanSocket>();
+    if (it == listeners().end() || !SimLanListener::enqueue(*it->second, socket)) {
+        lanStats.refused++;
+        return nullptr;
+    }
+    lanStats.connects++;
+    return socket;
+}
+
+SimLanStats SimLan::stats() { return lanStats; }
+
+WiFiServer::WiFiServer(uint16_t port, uint8_t maxClients)
+    : port(port), backlog(maxClients), listening(false) {}
+
+WiFiServer::~WiFiServer() {
+    SimHeap::Untracked untracked;
+    end();
+}
+
+void WiFiServer::begin(uint16_t newPort) {
+    SimHeap::Untracked untracked;
+    if (newPort) port = newPort;
+    listeners()[port] = this;
+    listening = true;
+}
+
+void WiFiServer::end() {
+    SimHeap::Untracked untracked;
+    if (!listening) return;
+    auto it = listeners().find(port);
+    if (it != listeners().end() && it->second == this) listeners().erase(it);
+    for (auto& socket : pending) socket->deviceClosed = true;
+    pending.clear();
+    listening = false;
+}
+
+bool WiFiServer::hasClient() {
+    return !pending.empty();
+}
+
+WiFiClient WiFiServer::accept() {
+    SimHeap::Untracked untracked;
+    if (pending.empty()) return WiFiClient();
+    std::shared_ptr<SimLanSocket> socket = pending.front();
+    pending.erase(pending.begin());
+    return WiFiClient(socket);
+}
@@ -0,0 +1,183 @@
+/**
+ * @file WiFi.h
+ * @brief Host stand-in for the ESP32 WiFi station and TCP client
+ *
+ * Link state follows SimWiFi (association attempts, scheduled outages,
+ * auto-reconnect, events posted through onEvent()) and
+ * TCP connections are routed to in-process SimHttpHandler servers with
+ * modelled DNS, handshake and request latency (SimNet). An idle keep-alive
+ * socket is closed by the server after SimNetConfig::idleTimeoutMillis
+ * (connected() turns false); a socket left open across a link outage
+ * stays "connected" but is half-open, like lwIP after a silent drop.
+ *
+ * WiFiServer accepts connections that LAN peers open with SimLan::connect();
+ * the accepted WiFiClient reads what the peer sent and writes into the
+ * peer's receive side, a send buffer's worth at a time.
+ */
+
+#ifndef NATIVE_HAL_WIFI_H
+#define NATIVE_HAL_WIFI_H
+
+#include <Arduino.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct SimLanSocket;
+struct SimStreamConnection;
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_STA_START = 0,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef enum {
+    WIFI_REASON_ASSOC_LEAVE = 8,
+    WIFI_REASON_BEACON_TIMEOUT = 200,
+    WIFI_REASON_NO_AP_FOUND = 201
+} wifi_err_reason_t;
+
+typedef struct {
+    uint8_t reason;
+} wifi_event_sta_disconnected_t;
+
+typedef union {
+    wifi_event_sta_disconnected_t wifi_sta_disconnected;
+} arduino_event_info_t;
+
+typedef size_t wifi_event_id_t;
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+
+class IPAddress : public Printable {
+public:
+    IPAddress() : octets{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+    String toString() const;
+    uint8_t operator[](int index) const { return octets[index]; }
+    size_t printTo(Print& p) const override { return p.print(toString()); }
+
+private:
+    uint8_t octets[4];
+};
+
+class WiFiClient : public Stream {
+public:
+    WiFiClient();
+    ~WiFiClient() override;
+    WiFiClient(const WiFiClient&) = delete;
+    WiFiClient& operator=(const WiFiClient&) = delete;
+    // The device's WiFiClient is a shared handle; moving is enough for accept()
+    WiFiClient(WiFiClient&& other);
+    WiFiClient& operator=(WiFiClient&& other);
+
+    int connect(const char* host, uint16_t port);
+    int connect(const char* host, uint16_t port, int32_t timeoutMs) { (void)timeoutMs; return connect(host, port); }
+    uint8_t connected();
+    void stop();
+    void setTimeout(uint32_t timeoutMs) { Stream::setTimeout(timeoutMs); }
+    void setNoDelay(bool enabled) { (void)enabled; }
+
+    using Print::write;
+    /** Connections from WiFiServer take only what fits in the send buffer (see SimLanSocket) */
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    int read(uint8_t* buffer, size_t size);
+
+    operator bool() { return connected(); }
+
+private:
+    friend class WiFiServer;
+    explicit WiFiClient(const std::shared_ptr<SimLanSocket>& socket);
+
+    void serviceRequests();
+    void dropIfIdle();
+    void deliverReplies();
+    void endStream();
+
+    std::string host;
+    bool open;
+    bool halfOpen;  // Link dropped under an open socket; writes vanish, reads time out
+    uint64_t lastActivityUs;
+    std::string txBuffer;
+    std::string rxBuffer;
+    size_t rxPos;
+    std::shared_ptr<SimLanSocket> lan;  // Set for connections accepted by a WiFiServer
+    std::shared_ptr<SimStreamConnection> stream; // Set for connections to a SimStreamHandler host
+};
+
+class WiFiServer {
+public:
+    /** @param maxClients Listen backlog: further connects are refused until accept() */
+    explicit WiFiServer(uint16_t port = 80, uint8_t maxClients = 4);
+    ~WiFiServer();
+    WiFiServer(const WiFiServer&) = delete;
+    WiFiServer& operator=(const WiFiServer&) = delete;
+
+    void begin(uint16_t port = 0);
+    void end();
+    void setNoDelay(bool enabled) { (void)enabled; }
+    bool hasClient();
+    /** Next pending connection; an unconnected client if there is none */
+    WiFiClient accept();
+    WiFiClient available() { return accept(); }
+    operator bool() { return listening; }
+
+private:
+    friend struct SimLanListener;
+    uint16_t port;
+    uint8_t backlog;
+    bool listening;
+    std::vector<std::shared_ptr<SimLanSocket> > pending;
+};
+
+class WiFiClass {
+public:
+    wifi_mode_t mode(wifi_mode_t m) { currentMode = m; return m; }
+    wl_status_t begin(const char* ssid, const char* password = nullptr);
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    bool reconnect();
+    wl_status_t status();
+    bool isConnected() { return status() == WL_CONNECTED; }
+    IPAddress localIP();
+    int8_t RSSI();
+    bool setSleep(bool enabled) { sleepEnabled = enabled; return true; }
+    bool getSleep() const { return sleepEnabled; }
+    bool setAutoReconnect(bool enabled) { autoReconnect = enabled; return true; }
+    bool getAutoReconnect() const { return autoReconnect; }
+    /** Handlers run from the driver while simulated time advances. */
+    wifi_event_id_t onEvent(WiFiEventFuncCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+    bool setHostname(const char* name) { (void)name; return true; }
+
+private:
+    wifi_mode_t currentMode = WIFI_OFF;
+    bool sleepEnabled = true;
+    bool autoReconnect = true;
+};
+
+extern WiFiClass WiFi;
+
+#endif // NATIVE_HAL_WIFI_H
@@ -0,0 +1,27 @@
+/**
+ * @file Wire.h
+ * @brief Host stand-in for the Arduino I2C bus object
+ */
+
+#ifndef NATIVE_HAL_WIRE_H
+#define NATIVE_HAL_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+        sdaPin = sda;
+        sclPin = scl;
+        (void)frequency;
+        return true;
+    }
+
+private:
+    int sdaPin = -1;
+    int sclPin = -1;
+};
+
+extern TwoWire Wire;
+
+#endif // NATIVE_HAL_WIRE_H
@@ -0,0 +1,19 @@
+// config.h - Credentials for the native simulation build
+// The firmware build uses the gitignored config.h created from config.example.h
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// WiFi credentials
+const char* WIFI_SSID = "sim-ssid";
+const char* WIFI_PASSWORD = "sim-password";
+
+// ThingSpeak settings
+const char* THINGSPEAK_API_KEY = "SIMULATEDKEY0000";
+const unsigned long THINGSPEAK_CHANNEL_ID = 1;
+
+// OTA settings
+const char* OTA_HOSTNAME = "SEN55-AirQuality";
+const char* OTA_PASSWORD = "sim-ota";
+
+#endif
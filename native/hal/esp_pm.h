@@ -0,0 +1,42 @@
+/**
+ * @file esp_pm.h
+ * @brief Host stand-in for ESP-IDF power management (frequency scaling, automatic light sleep)
+ *
+ * The configuration and locks feed the simulated power model (SimPower in
+ * Simulation.h), which decides when the chip would light-sleep.
+ */
+
+#ifndef NATIVE_HAL_ESP_PM_H
+#define NATIVE_HAL_ESP_PM_H
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_NOT_SUPPORTED 0x106
+
+typedef struct {
+    int max_freq_mhz;
+    int min_freq_mhz;
+    bool light_sleep_enable;  // Needs CONFIG_FREERTOS_USE_TICKLESS_IDLE, else ESP_ERR_NOT_SUPPORTED
+} esp_pm_config_esp32s3_t;
+
+typedef enum {
+    ESP_PM_CPU_FREQ_MAX,  // CPU at max_freq_mhz; no light sleep while held
+    ESP_PM_APB_FREQ_MAX,  // APB at 80 MHz; no light sleep while held
+    ESP_PM_NO_LIGHT_SLEEP
+} esp_pm_lock_type_t;
+
+typedef struct esp_pm_lock* esp_pm_lock_handle_t;
+
+esp_err_t esp_pm_configure(const void* config);
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t type, int arg, const char* name, esp_pm_lock_handle_t* handle);
+/** Locks count: each acquire needs its own release. */
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle);
+
+#endif // NATIVE_HAL_ESP_PM_H
@@ -0,0 +1,40 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for the FreeRTOS task API
+ *
+ * Tasks run on host threads under the deterministic scheduler described
+ * with SimTasks in Simulation.h. Priorities are accepted and ignored: each
+ * task is modelled as having its core to itself.
+ */
+
+#ifndef NATIVE_HAL_FREERTOS_TASK_H
+#define NATIVE_HAL_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef struct SimTaskContext* TaskHandle_t;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackBytes,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core);
+/** Delete a task; only a task deleting itself (nullptr) is supported. */
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+/** Block until *previousWake + increment, then advance *previousWake by increment. */
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment);
+TickType_t xTaskGetTickCount();
+/** Core the calling task is pinned to (loop() runs on core 1). */
+BaseType_t xPortGetCoreID();
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+/** Increment the task's notification count, waking it if it waits in ulTaskNotifyTake(). */
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+/**
+ * @brief Block until the calling task's notification count is non-zero or ticksToWait pass
+ *
+ * @return The count before it was cleared (or decremented), 0 on timeout
+ */
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
+
+#endif // NATIVE_HAL_FREERTOS_TASK_H
@@ -0,0 +1,14 @@
+/**
+ * @file sha1.h
+ * @brief Host stand-in for mbedTLS's one-shot SHA-1 (as used for the WebSocket handshake)
+ */
+
+#ifndef NATIVE_HAL_MBEDTLS_SHA1_H
+#define NATIVE_HAL_MBEDTLS_SHA1_H
+
+#include <stddef.h>
+
+/** Returns 0 (mbedTLS 3); mbedTLS 2 declares it void, so callers ignore the result */
+int mbedtls_sha1(const unsigned char* input, size_t length, unsigned char output[20]);
+
+#endif // NATIVE_HAL_MBEDTLS_SHA1_H
@@ -0,0 +1,168 @@
+/**
+ * @file BulkUploader.cpp
+ * @brief Implementation of the ThingSpeak bulk-update batching
+ * 
+ * Body format:
+ *   {"write_api_key":"KEY","updates":[
+ *     {"created_at":"2026-01-01T00:00:15Z","field1":8.20,...,"field8":45.20},
+ *     ...]}
+ * Field mapping matches the channel layout used by the single update:
+ * PM1.0, PM2.5, PM4.0, PM10, temperature, VOC, NOx, humidity.
+ */
+
+#include "BulkUploader.h"
+#include <time.h>
+
+BulkUploader::BulkUploader(const char* writeApiKey, uint32_t recordSpacingSeconds)
+    : apiKey(writeApiKey), recordSpacing(recordSpacingSeconds), batchCount(0), length(0) {
+    payload[0] = '\0';
+}
+
+bool BulkUploader::add(const QueuedRecord& record) {
+    if (batchCount >= BATCH_SIZE) {
+        return false;
+    }
+    batch[batchCount++] = record;
+    return true;
+}
+
+bool BulkUploader::isFull() const {
+    return batchCount >= BATCH_SIZE;
+}
+
+int BulkUploader::size() const {
+    return batchCount;
+}
+
+const QueuedRecord* BulkUploader::records() const {
+    return batch;
+}
+
+void BulkUploader::clear() {
+    batchCount = 0;
+}
+
+void BulkUploader::append(const char* text) {
+    while (*text) {
+        payload[length++] = *text++;
+    }
+}
+
+void BulkUploader::appendUnsigned(uint32_t value, int minDigits) {
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0 || count < minDigits);
+    while (count > 0) {
+        payload[length++] = digits[--count];
+    }
+}
+
+void BulkUploader::appendFixed2(float value) {
+    // Same digits as "%.2f": a float times 100 is exact in a double, so the
+    // rounding below sees the true value and ties go to even like printf
+    const double LIMIT = 99999999.99;
+    double v = value;
+    if (!(v == v)) v = 0.0; // NaN never reaches the queue, but keep the JSON valid
+    if (v > LIMIT) v = LIMIT;
+    if (v < -LIMIT) v = -LIMIT;
+    
+    bool negative = v < 0.0;
+    double scaled = (negative ? -v : v) * 100.0;
+    uint64_t hundredths = (uint64_t)scaled;
+    double remainder = scaled - (double)hundredths;
+    if (remainder > 0.5 || (remainder == 0.5 && (hundredths & 1))) {
+        hundredths++;
+    }
+    if (negative && hundredths != 0) {
+        payload[length++] = '-';
+    }
+    appendUnsigned((uint32_t)(hundredths / 100));
+    payload[length++] = '.';
+    appendUnsigned((uint32_t)(hundredths % 100), 2);
+}
+
+void BulkUploader::appendWhole(float value) {
+    // Index values (VOC, NOx) are sent truncated like "%d" of (int)value
+    const float LIMIT = 99999999.0f;
+    if (!(value == value)) value = 0.0f;
+    if (value > LIMIT) value = LIMIT;
+    if (value < -LIMIT) value = -LIMIT;
+    
+    int32_t whole = (int32_t)value;
+    if (whole < 0) {
+        payload[length++] = '-';
+        whole = -whole;
+    }
+    appendUnsigned((uint32_t)whole);
+}
+
+void BulkUploader::appendEntry(const QueuedRecord& record, bool first) {
+    if (!first) {
+        payload[length++] = ',';
+    }
+    
+    if (record.timestamp != 0) {
+        time_t seconds = record.timestamp;
+        struct tm utc;
+        gmtime_r(&seconds, &utc);
+        append("{\"created_at\":\"");
+        appendUnsigned((uint32_t)(utc.tm_year + 1900), 4);
+        payload[length++] = '-';
+        appendUnsigned((uint32_t)(utc.tm_mon + 1), 2);
+        payload[length++] = '-';
+        appendUnsigned((uint32_t)utc.tm_mday, 2);
+        payload[length++] = 'T';
+        appendUnsigned((uint32_t)utc.tm_hour, 2);
+        payload[length++] = ':';
+        appendUnsigned((uint32_t)utc.tm_min, 2);
+        payload[length++] = ':';
+        appendUnsigned((uint32_t)utc.tm_sec, 2);
+        append("Z\"");
+    } else {
+        append("{\"delta_t\":");
+        appendUnsigned(recordSpacing);
+    }
+    
+    const SensorData& d = record.data;
+    append(",\"field1\":"); appendFixed2(d.pm1);
+    append(",\"field2\":"); appendFixed2(d.pm25);
+    append(",\"field3\":"); appendFixed2(d.pm4);
+    append(",\"field4\":"); appendFixed2(d.pm10);
+    append(",\"field5\":"); appendFixed2(d.temperature);
+    append(",\"field6\":"); appendWhole(d.voc);
+    append(",\"field7\":"); appendWhole(d.nox);
+    append(",\"field8\":"); appendFixed2(d.humidity);
+    payload[length++] = '}';
+}
+
+const char* BulkUploader::encode(const QueuedRecord* records, int count, int& encoded) {
+    encoded = 0;
+    length = 0;
+    if (count > MAX_RECORDS) count = MAX_RECORDS;
+    if (count <= 0 || strlen(apiKey) > MAX_API_KEY) {
+        return nullptr;
+    }
+    
+    // MAX_PAYLOAD covers the worst case, so no per-write bounds checks are needed
+    append("{\"write_api_key\":\"");
+    append(apiKey);
+    append("\",\"updates\":[");
+    bool timestamped = records[0].timestamp != 0;
+    for (int i = 0; i < count; i++) {
+        if ((records[i].timestamp != 0) != timestamped) break;
+        appendEntry(records[i], i == 0);
+        encoded++;
+    }
+    
+    payload[length++] = ']';
+    payload[length++] = '}';
+    payload[length] = '\0';
+    return payload;
+}
+
+size_t BulkUploader::payloadLength() const {
+    return length;
+}
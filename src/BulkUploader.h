@@ -0,0 +1,86 @@
+/**
+ * @file BulkUploader.h
+ * @brief Batching of averaged records for the ThingSpeak bulk-update API
+ * 
+ * Records are collected in a fixed RAM batch and shipped together as one
+ * JSON POST to /channels/<id>/bulk_update.json. Each entry carries its own
+ * timestamp (created_at, or delta_t when the clock was never synced), so a
+ * batch of BATCH_SIZE records costs one request and one TCP setup instead
+ * of BATCH_SIZE, and the 15-second rate limit no longer caps resolution.
+ * The JSON body is written into a fixed buffer whose size is derived from
+ * the worst-case length of every element (numbers are clamped and printed
+ * with a fixed-point formatter, not printf), so encoding never allocates
+ * and can only run out of room for API keys longer than MAX_API_KEY.
+ */
+
+#ifndef BULK_UPLOADER_H
+#define BULK_UPLOADER_H
+
+#include <Arduino.h>
+#include "UploadQueue.h"
+
+class BulkUploader {
+public:
+    static const int BATCH_SIZE = 8;            // Records per regular upload (one POST every 2 min)
+    static const int MAX_RECORDS = 32;          // Records per POST when draining the offline queue
+    static const size_t MAX_API_KEY = 32;       // ThingSpeak write keys are 16 characters
+    static const size_t MAX_NUMBER_JSON = 12;   // "-99999999.99", values are clamped to this
+    // ',{"created_at":"2026-01-01T00:00:00Z"' plus 8 x ',"fieldN":<number>' plus '}'
+    static const size_t MAX_ENTRY_JSON = 38 + SENSOR_FIELD_COUNT * (10 + MAX_NUMBER_JSON) + 1;
+    // '{"write_api_key":"<key>","updates":[' entries ']}' and the terminator
+    static const size_t MAX_PAYLOAD = 31 + MAX_API_KEY + MAX_RECORDS * MAX_ENTRY_JSON + 3;
+    
+    /**
+     * @param writeApiKey Channel write API key
+     * @param recordSpacingSeconds Nominal time between records, used as delta_t
+     *        for records that have no timestamp
+     */
+    BulkUploader(const char* writeApiKey, uint32_t recordSpacingSeconds);
+    
+    /**
+     * @brief Add a record to the RAM batch
+     * 
+     * @return false if the batch is already full
+     */
+    bool add(const QueuedRecord& record);
+    
+    bool isFull() const;
+    int size() const;
+    const QueuedRecord* records() const;
+    void clear();
+    
+    /**
+     * @brief Encode records as a bulk-update JSON body
+     * 
+     * Entries are written in order until the first one whose timestamp
+     * kind (created_at vs. delta_t) differs from the first record, since
+     * ThingSpeak does not accept both in one request.
+     * 
+     * @param records Records to encode, oldest first
+     * @param count Number of records (at most MAX_RECORDS)
+     * @param encoded Receives the number of records included in the body
+     * @return The JSON body (valid until the next call), or nullptr if nothing fit
+     */
+    const char* encode(const QueuedRecord* records, int count, int& encoded);
+    
+    /**
+     * @brief Length of the body returned by the last encode()
+     */
+    size_t payloadLength() const;
+    
+private:
+    const char* apiKey;
+    uint32_t recordSpacing;
+    QueuedRecord batch[BATCH_SIZE];
+    int batchCount;
+    char payload[MAX_PAYLOAD];
+    size_t length;
+    
+    void append(const char* text);
+    void appendUnsigned(uint32_t value, int minDigits = 1);
+    void appendFixed2(float value);
+    void appendWhole(float value);
+    void appendEntry(const QueuedRecord& record, bool first);
+};
+
+#endif // BULK_UPLOADER_H
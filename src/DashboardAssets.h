@@ -0,0 +1,141 @@
+/**
+ * @file DashboardAssets.h
+ * @brief Dashboard page, stylesheet and script, minified and gzipped
+ *
+ * Generated by tools/build_web.py from web/ before each build; do not edit.
+ * Sources: b4fc8368efc9b195
+ */
+
+#ifndef DASHBOARD_ASSETS_H
+#define DASHBOARD_ASSETS_H
+
+#include <Arduino.h>
+
+struct DashboardAsset {
+    const char* path;
+    const char* contentType;
+    const uint8_t* body;       // gzip
+    size_t length;
+    const char* etag;          // Strong: hash of the gzip bytes
+    bool immutable;            // Content hash in the path: cache for good
+    size_t sourceLength;       // web/ file
+    size_t minifiedLength;     // Before gzip
+};
+
+// style.css: 849 bytes, 586 minified, 374 gzipped
+const uint8_t DASHBOARD_STYLE_CSS_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x55, 0x50, 0xcb, 0x4e, 0xc3, 0x30,
+    0x10, 0xfc, 0x95, 0x4a, 0xbd, 0x50, 0xa9, 0x0e, 0x75, 0x1f, 0xa8, 0xb2, 0x4f, 0x48, 0xad, 0xe0,
+    0x00, 0x54, 0x42, 0x70, 0xe0, 0xb8, 0x89, 0xd7, 0xc1, 0x60, 0x3b, 0x96, 0xed, 0x40, 0x42, 0x94,
+    0x7f, 0xc7, 0x69, 0x29, 0x4a, 0xb5, 0xd2, 0x1e, 0xd6, 0x33, 0xe3, 0x99, 0xc9, 0x2b, 0xd1, 0x76,
+    0x06, 0x7c, 0xa9, 0x2c, 0x5b, 0x70, 0x59, 0xd9, 0x48, 0x24, 0x18, 0xa5, 0x5b, 0x16, 0xda, 0x10,
+    0xd1, 0x90, 0x5a, 0xcd, 0x03, 0xd8, 0x40, 0x02, 0x7a, 0x25, 0x79, 0x0e, 0xc5, 0x67, 0xe9, 0xab,
+    0xda, 0x0a, 0x36, 0xa5, 0x94, 0xf2, 0xa2, 0xd2, 0x95, 0x67, 0x53, 0x44, 0xec, 0xdf, 0x11, 0x04,
+    0xfa, 0xce, 0x81, 0x10, 0xca, 0x96, 0x8c, 0x2e, 0x5d, 0x33, 0xa1, 0x37, 0xae, 0xb9, 0xe4, 0x14,
+    0xc3, 0x70, 0xa1, 0x82, 0xd3, 0xd0, 0x32, 0xa9, 0xb1, 0xe1, 0x1f, 0x75, 0x88, 0x4a, 0xb6, 0xa4,
+    0x48, 0x9f, 0xa3, 0x8d, 0x2c, 0x38, 0x28, 0x90, 0xe4, 0x18, 0xbf, 0x11, 0x2d, 0x1f, 0x20, 0xe4,
+    0xdb, 0x83, 0x63, 0xc3, 0xea, 0x0d, 0x28, 0xdb, 0x9d, 0xe9, 0xa5, 0x57, 0x82, 0x0f, 0x8b, 0x24,
+    0xa7, 0xe9, 0x12, 0x31, 0x89, 0xe8, 0xda, 0xd8, 0xc0, 0x3c, 0x3a, 0x84, 0x78, 0x05, 0x75, 0xac,
+    0x88, 0x54, 0x71, 0x6e, 0x94, 0x35, 0xd0, 0x5c, 0xd1, 0xcd, 0xc2, 0x35, 0x73, 0x2a, 0xfd, 0x6c,
+    0xc6, 0xcb, 0xa4, 0x39, 0xb8, 0xe4, 0xff, 0x96, 0x93, 0xdb, 0x3e, 0x2b, 0xc0, 0x8b, 0xee, 0xc2,
+    0x33, 0x0e, 0xc3, 0xf3, 0xca, 0xa7, 0x7c, 0xc4, 0x83, 0x50, 0x75, 0x60, 0xdb, 0x31, 0x6f, 0x39,
+    0xf0, 0x34, 0xe4, 0xa8, 0xbb, 0x63, 0x83, 0x41, 0xfd, 0x20, 0xcb, 0xb6, 0x68, 0xce, 0xfd, 0x00,
+    0x40, 0x9f, 0x7d, 0x81, 0xae, 0x71, 0x04, 0xa0, 0x47, 0xc4, 0xa9, 0x7b, 0x12, 0x2b, 0xc7, 0xd6,
+    0x83, 0x4c, 0x6d, 0x55, 0x1c, 0xab, 0x6c, 0x2e, 0x55, 0xa6, 0xce, 0x2c, 0x37, 0x47, 0x8b, 0xc7,
+    0xdc, 0xa7, 0xb8, 0x8c, 0x4e, 0xae, 0x27, 0x84, 0xf2, 0x88, 0x4d, 0x24, 0xa0, 0x55, 0x69, 0x59,
+    0x91, 0x9a, 0x44, 0x7f, 0x82, 0x8f, 0xe4, 0x56, 0x68, 0xfa, 0xec, 0xee, 0x70, 0xd8, 0x75, 0x7f,
+    0x9a, 0xeb, 0x02, 0xe4, 0x66, 0xd1, 0x67, 0x8f, 0x87, 0xdd, 0xfe, 0xf9, 0xf6, 0x65, 0x7f, 0xbe,
+    0x4b, 0x89, 0xf9, 0x2a, 0xef, 0xb3, 0xd7, 0xa7, 0xfb, 0xfd, 0xed, 0xc3, 0xcb, 0xfd, 0xdb, 0xff,
+    0xc3, 0x7a, 0xbd, 0x5a, 0xdd, 0xf4, 0xd3, 0x10, 0x53, 0xdd, 0xdd, 0xc8, 0xd9, 0x2f, 0x87, 0x1f,
+    0xab, 0x79, 0x4a, 0x02, 0x00, 0x00,
+};
+
+// app.js: 1702 bytes, 1411 minified, 696 gzipped
+const uint8_t DASHBOARD_APP_JS_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x9d, 0x54, 0x4d, 0x4f, 0xdc, 0x30,
+    0x10, 0xbd, 0xef, 0xaf, 0x98, 0x4a, 0x54, 0x76, 0xc4, 0xd6, 0xbb, 0x2c, 0xb0, 0xaa, 0x58, 0x6d,
+    0x2b, 0x51, 0x51, 0x89, 0x4a, 0xa5, 0x52, 0xa9, 0xc4, 0x01, 0x71, 0x70, 0x93, 0x09, 0x71, 0x9b,
+    0xd8, 0xc1, 0x76, 0x08, 0x2b, 0xb4, 0xbf, 0xab, 0xf7, 0xfe, 0xb2, 0x8e, 0x9d, 0x90, 0x5d, 0xba,
+    0x2a, 0x87, 0x9e, 0xc6, 0xce, 0x7c, 0xbd, 0x79, 0x6f, 0x9c, 0xd4, 0x68, 0xe7, 0x61, 0x0f, 0x96,
+    0xa0, 0x32, 0x58, 0xbe, 0x83, 0xcc, 0xa4, 0x4d, 0x85, 0xda, 0x8b, 0x5b, 0xf4, 0x67, 0x25, 0x86,
+    0xe3, 0xe9, 0xea, 0x3c, 0xe3, 0x2a, 0x4b, 0x16, 0xa3, 0x34, 0x06, 0xe7, 0x0a, 0xcb, 0xcc, 0x51,
+    0xc6, 0x35, 0xab, 0xab, 0x03, 0x36, 0x06, 0x32, 0xb3, 0xe3, 0xce, 0x1e, 0x75, 0xe6, 0x60, 0x1a,
+    0xac, 0xc7, 0xaa, 0x46, 0x2b, 0x7d, 0x63, 0x31, 0x5c, 0x8b, 0xa6, 0x52, 0x99, 0xf2, 0xab, 0x70,
+    0xbe, 0x37, 0x69, 0x30, 0xda, 0x3c, 0xb0, 0x9b, 0xc5, 0x28, 0x6f, 0x74, 0xea, 0x95, 0xd1, 0xd0,
+    0xd4, 0x5e, 0x55, 0xc8, 0x5d, 0x02, 0x8f, 0x7d, 0x33, 0x02, 0x05, 0x9f, 0xa5, 0x2f, 0x44, 0x5e,
+    0x1a, 0x63, 0xb9, 0x83, 0x09, 0xbc, 0x9d, 0x1f, 0x4d, 0xa7, 0xc9, 0x18, 0x8a, 0x5d, 0xd7, 0xe1,
+    0x9c, 0x3c, 0xf0, 0x1a, 0x66, 0x47, 0x63, 0xa8, 0x76, 0xdd, 0xf3, 0xe8, 0x9c, 0x4f, 0x17, 0x23,
+    0x8b, 0x84, 0x4a, 0x03, 0xcf, 0xe0, 0x3d, 0xb5, 0xd8, 0x07, 0x96, 0x01, 0x83, 0x13, 0x60, 0x2c,
+    0xa1, 0x4b, 0x11, 0x3e, 0x14, 0xf4, 0x61, 0x9f, 0x8a, 0xd0, 0xb1, 0x62, 0x8b, 0xd1, 0x7a, 0x03,
+    0xd2, 0x15, 0xa6, 0xe5, 0x59, 0x80, 0xd8, 0x31, 0x21, 0x72, 0x63, 0xcf, 0x64, 0x5a, 0xf0, 0x3c,
+    0x10, 0xb8, 0xc7, 0xf3, 0x44, 0x78, 0x7c, 0xf0, 0x1f, 0x8c, 0xf6, 0xc4, 0x1e, 0xa1, 0xc8, 0xae,
+    0xf3, 0x1b, 0x62, 0x6f, 0x8f, 0xb3, 0xbb, 0x46, 0x96, 0x81, 0x81, 0x9d, 0x08, 0xd1, 0x7b, 0xfe,
+    0x8a, 0x4a, 0x4b, 0xe9, 0xdc, 0x85, 0xac, 0x70, 0x3b, 0x46, 0xb8, 0x9a, 0x0c, 0x67, 0xc0, 0x92,
+    0xeb, 0xe9, 0xcd, 0x73, 0x68, 0x9e, 0xd8, 0x76, 0x1d, 0x7f, 0x54, 0x28, 0x5c, 0x71, 0xa7, 0x19,
+    0x77, 0xa2, 0x55, 0xb9, 0xa2, 0xc9, 0xd9, 0x95, 0xfa, 0xa8, 0xe2, 0x9c, 0x4e, 0x58, 0xe7, 0x54,
+    0x18, 0x16, 0xb2, 0xd3, 0x2a, 0x52, 0x11, 0x7d, 0x99, 0x69, 0x75, 0xe4, 0x84, 0xc1, 0xef, 0x5f,
+    0x24, 0x4f, 0x0c, 0x7e, 0x52, 0x49, 0x74, 0x87, 0x64, 0xd4, 0xbb, 0xbb, 0x42, 0x77, 0x0d, 0x36,
+    0x18, 0x39, 0x85, 0xee, 0x18, 0xd9, 0x93, 0x6e, 0xa5, 0x53, 0x18, 0x80, 0x5a, 0xcc, 0x2d, 0xba,
+    0x82, 0x07, 0xa0, 0xde, 0xae, 0x06, 0xb9, 0x2d, 0xe1, 0x93, 0xad, 0x54, 0xb4, 0x65, 0xe8, 0x89,
+    0x52, 0x36, 0x91, 0xb5, 0x9a, 0xa4, 0x8d, 0xb5, 0x84, 0x9d, 0x36, 0xe6, 0x31, 0x25, 0xa2, 0xf1,
+    0x24, 0x6c, 0xce, 0x1b, 0xe7, 0x0d, 0x2d, 0xd6, 0x9a, 0x98, 0x55, 0x39, 0x70, 0x2b, 0xba, 0xe1,
+    0x61, 0xb9, 0x84, 0xe3, 0xe9, 0xe1, 0x8b, 0x0c, 0x30, 0x87, 0xda, 0x19, 0x0b, 0xad, 0xb4, 0x95,
+    0xd2, 0xb7, 0x34, 0x50, 0xc0, 0x08, 0x58, 0x3a, 0xa4, 0xb4, 0xa8, 0x6f, 0x07, 0xc2, 0x8a, 0x1f,
+    0xce, 0x68, 0x9e, 0x24, 0x61, 0x84, 0x9e, 0xdc, 0xce, 0xc3, 0x77, 0x51, 0x76, 0xfe, 0x7f, 0x80,
+    0x4c, 0xb6, 0x2a, 0x41, 0x2a, 0x29, 0x0b, 0x38, 0xbe, 0x0c, 0xd2, 0xe4, 0x79, 0xa9, 0x34, 0x46,
+    0xfa, 0xd6, 0xa3, 0x12, 0x3d, 0x04, 0xb6, 0x03, 0x43, 0xba, 0x29, 0xcb, 0xad, 0x57, 0x43, 0xd4,
+    0x69, 0x4c, 0x3d, 0xdf, 0xbc, 0x9a, 0x36, 0x3c, 0x4f, 0x8d, 0x2d, 0x5c, 0xe1, 0xf7, 0x4b, 0x93,
+    0xfe, 0x44, 0x5a, 0x97, 0xd6, 0x9d, 0x4c, 0x26, 0x41, 0xa2, 0xd2, 0x50, 0x7f, 0xca, 0x13, 0x85,
+    0xa1, 0x50, 0xd2, 0x69, 0xd2, 0x3a, 0x46, 0xb8, 0x5a, 0x27, 0x8c, 0x36, 0x35, 0xea, 0xb0, 0x23,
+    0x49, 0xd8, 0x65, 0x2a, 0x57, 0xa2, 0xb4, 0xe7, 0x04, 0xc9, 0xde, 0xcb, 0x92, 0xc7, 0xfe, 0x14,
+    0xf9, 0x1c, 0xc7, 0xba, 0x4f, 0xad, 0xd0, 0x39, 0x79, 0x1b, 0x56, 0x15, 0xfb, 0xe4, 0x88, 0x25,
+    0xbc, 0xc3, 0x4f, 0x97, 0x5f, 0x2e, 0x44, 0x2d, 0xad, 0x43, 0x8e, 0x22, 0x93, 0x5e, 0x52, 0x91,
+    0x9e, 0xce, 0xaa, 0xd7, 0xad, 0x97, 0xb1, 0x12, 0xbd, 0xd8, 0xc9, 0x93, 0x12, 0x9b, 0x2f, 0x83,
+    0x46, 0x21, 0xf0, 0xd5, 0x53, 0xa2, 0xe8, 0xc4, 0xfc, 0x8a, 0x32, 0x5b, 0xfd, 0x87, 0xea, 0x03,
+    0xfc, 0xb4, 0x34, 0x0e, 0xb7, 0x46, 0x8f, 0x4d, 0xba, 0x89, 0xe9, 0x36, 0x2c, 0xec, 0x66, 0x7a,
+    0x87, 0x7e, 0x60, 0xa6, 0x77, 0x8f, 0x61, 0x36, 0xa5, 0x3f, 0x50, 0xdc, 0x16, 0xf4, 0xdf, 0x28,
+    0xd0, 0x34, 0x9e, 0xf7, 0xfa, 0x8c, 0x69, 0x2f, 0x3b, 0x67, 0xf0, 0x0f, 0xa2, 0x2d, 0xfe, 0x00,
+    0x85, 0x6a, 0x47, 0x35, 0x83, 0x05, 0x00, 0x00,
+};
+
+// index.html: 1587 bytes, 1476 minified, 462 gzipped
+const uint8_t DASHBOARD_INDEX_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb5, 0x94, 0xd1, 0x4e, 0xdb, 0x30,
+    0x14, 0x86, 0xef, 0x79, 0x0a, 0xcf, 0xd2, 0xee, 0x96, 0x84, 0x74, 0xb4, 0xf4, 0x22, 0xb1, 0x84,
+    0x3a, 0xa4, 0xdd, 0x8c, 0x32, 0x0d, 0x4d, 0xda, 0xa5, 0x63, 0x9f, 0x36, 0x06, 0xc7, 0xc9, 0x6c,
+    0x27, 0xb4, 0x6f, 0x35, 0x69, 0xda, 0x0b, 0xf0, 0x64, 0xd8, 0x4e, 0x06, 0x45, 0x1b, 0x34, 0x54,
+    0xe2, 0xca, 0x8a, 0xff, 0x73, 0xfe, 0xff, 0x3b, 0x96, 0x72, 0xb2, 0x77, 0x9f, 0x96, 0x8b, 0xab,
+    0x1f, 0x97, 0xe7, 0xa8, 0xb4, 0x95, 0x24, 0x47, 0x99, 0x3f, 0x90, 0xa4, 0x6a, 0x9d, 0x63, 0x50,
+    0xd8, 0x5f, 0x00, 0xe5, 0xee, 0xa8, 0xc0, 0x52, 0xc4, 0x4a, 0xaa, 0x0d, 0xd8, 0x1c, 0xb7, 0x76,
+    0x15, 0xcd, 0xf1, 0xdf, 0x6b, 0x45, 0x2b, 0xc8, 0x71, 0x27, 0xe0, 0xb6, 0xa9, 0xb5, 0xc5, 0x88,
+    0xd5, 0xca, 0x82, 0x72, 0x65, 0xb7, 0x82, 0xdb, 0x32, 0xe7, 0xd0, 0x09, 0x06, 0x51, 0xf8, 0xf8,
+    0x20, 0x94, 0xb0, 0x82, 0xca, 0xc8, 0x30, 0x2a, 0x21, 0x4f, 0xbd, 0x87, 0x15, 0x56, 0x02, 0xf9,
+    0x76, 0x7e, 0x31, 0x9d, 0xa2, 0x33, 0xa1, 0xd1, 0xd7, 0x96, 0x4a, 0x61, 0xb7, 0x59, 0xd2, 0x0b,
+    0x47, 0x99, 0x14, 0xea, 0x06, 0x69, 0x90, 0x39, 0x36, 0x76, 0x2b, 0xc1, 0x94, 0x00, 0x2e, 0xa5,
+    0xd4, 0xb0, 0xca, 0x71, 0x12, 0xae, 0xe2, 0x22, 0x85, 0xf9, 0xc7, 0xd9, 0x84, 0xc6, 0xcc, 0x18,
+    0xef, 0x99, 0x0c, 0xd8, 0x45, 0xcd, 0xb7, 0xc3, 0x10, 0xa0, 0x49, 0x56, 0xfc, 0x2f, 0xa6, 0x20,
+    0x99, 0x69, 0xa8, 0x42, 0x82, 0xfb, 0x00, 0x6a, 0x01, 0x13, 0x37, 0x81, 0x02, 0x66, 0x85, 0x5a,
+    0xc7, 0x71, 0x9c, 0x25, 0x5e, 0x26, 0xbd, 0xa7, 0x73, 0x71, 0x53, 0x53, 0xa1, 0xdc, 0xc1, 0x45,
+    0x87, 0x98, 0xa4, 0xc6, 0xe4, 0x98, 0x51, 0xcd, 0x71, 0x70, 0x68, 0xaa, 0xc9, 0x34, 0x7c, 0x91,
+    0x5d, 0x5d, 0xd2, 0x02, 0x24, 0x26, 0x97, 0x5f, 0x26, 0xf1, 0x34, 0x4b, 0x9c, 0xf0, 0xb4, 0xbd,
+    0xa3, 0xb2, 0x75, 0xb1, 0x8f, 0x1c, 0xde, 0x05, 0x93, 0x28, 0x1a, 0xb2, 0x51, 0xaf, 0x0c, 0xd5,
+    0xad, 0x7b, 0x43, 0x4c, 0xee, 0xfe, 0xac, 0x93, 0xea, 0xee, 0xf7, 0x03, 0x9d, 0x37, 0x0d, 0x9e,
+    0xbe, 0xff, 0x67, 0x3f, 0x5c, 0x6f, 0x11, 0x94, 0x7f, 0x43, 0x5f, 0xa0, 0x4c, 0xe3, 0xe3, 0x1d,
+    0xc3, 0xe7, 0x21, 0xd3, 0x43, 0x18, 0x5f, 0x45, 0x72, 0x32, 0x8a, 0xe3, 0xe4, 0xcd, 0x39, 0xd2,
+    0x91, 0x0f, 0x72, 0xfc, 0xc6, 0x24, 0x57, 0x50, 0x35, 0xa0, 0xa9, 0x6d, 0x35, 0x8c, 0x00, 0xb2,
+    0x8f, 0xd5, 0xfb, 0xb8, 0x7e, 0x2d, 0x0e, 0x66, 0xfa, 0xdc, 0x56, 0x82, 0x87, 0x5f, 0x69, 0x2f,
+    0x50, 0x39, 0x94, 0xee, 0xa1, 0x79, 0x7f, 0x30, 0xcb, 0xf7, 0xe5, 0x02, 0x09, 0xc5, 0x61, 0x33,
+    0x02, 0xa6, 0xab, 0xd9, 0x0e, 0xc7, 0xeb, 0xb3, 0x2e, 0x96, 0x9b, 0xd1, 0x59, 0xaa, 0xde, 0x3c,
+    0x9b, 0x95, 0x0c, 0xfb, 0xc4, 0x30, 0x2d, 0x1a, 0x8b, 0x8c, 0x66, 0x6e, 0xaf, 0xd1, 0xa6, 0x89,
+    0x4f, 0x67, 0x33, 0x36, 0x67, 0xab, 0xd3, 0xf8, 0xda, 0x2d, 0x35, 0xd7, 0x1a, 0x74, 0xdf, 0x30,
+    0xac, 0xb5, 0x24, 0x2c, 0xed, 0x7b, 0xca, 0x70, 0xdf, 0x1a, 0xc4, 0x05, 0x00, 0x00,
+};
+
+const DashboardAsset DASHBOARD_ASSETS[] = {
+    {"/style.b1e8362a.css", "text/css", DASHBOARD_STYLE_CSS_GZ, sizeof(DASHBOARD_STYLE_CSS_GZ), "\"f1ca641d23db4623\"", true, 849, 586},
+    {"/app.766c8cf7.js", "application/javascript", DASHBOARD_APP_JS_GZ, sizeof(DASHBOARD_APP_JS_GZ), "\"acf199a13ccbd93d\"", true, 1702, 1411},
+    {"/", "text/html; charset=utf-8", DASHBOARD_INDEX_HTML_GZ, sizeof(DASHBOARD_INDEX_HTML_GZ), "\"b25de34c48f05d67\"", false, 1587, 1476},
+};
+const size_t DASHBOARD_ASSET_COUNT = sizeof(DASHBOARD_ASSETS) / sizeof(DASHBOARD_ASSETS[0]);
+
+#endif // DASHBOARD_ASSETS_H
@@ -0,0 +1,177 @@
+/**
+ * @file DashboardJson.cpp
+ * @brief Implementation of the dashboard API bodies
+ */
+
+#include "DashboardJson.h"
+#include "SensorUtils.h"
+
+namespace {
+    size_t result(int written, size_t capacity) {
+        return written < 0 ? capacity : (size_t)written;
+    }
+
+    // /api/history field names (SensorField order) and the decimals of their stored resolution
+    const char* const FIELD_NAMES[SENSOR_FIELD_COUNT] = {"pm1", "pm25", "pm4", "pm10", "humidity", "temperature",
+                                                         "voc", "nox"};
+    const int FIELD_DECIMALS[SENSOR_FIELD_COUNT] = {1, 1, 1, 1, 2, 3, 1, 1};
+
+    struct HistoryWriter {
+        char* out;
+        size_t capacity;
+        size_t length;
+        int decimals;
+        bool first;
+    };
+
+    void writeHistoryPoint(const HistoryPoint& point, void* context) {
+        HistoryWriter& writer = *(HistoryWriter*)context;
+        if (writer.length >= writer.capacity) {
+            return;
+        }
+        int decimals = writer.decimals;
+        writer.length += result(snprintf(writer.out + writer.length, writer.capacity - writer.length,
+                                         "%s[%lu,%.*f,%.*f,%.*f]", writer.first ? "" : ",",
+                                         (unsigned long)point.time, decimals, point.min, decimals, point.mean,
+                                         decimals, point.max),
+                                writer.capacity - writer.length);
+        writer.first = false;
+    }
+
+    // Decimal query value of up to 32 bits; false if it is empty, not a number or too large
+    bool parseNumber(const char* value, size_t length, uint32_t& number) {
+        if (length == 0 || length > 10) {
+            return false;
+        }
+        uint64_t parsed = 0;
+        for (size_t i = 0; i < length; i++) {
+            if (value[i] < '0' || value[i] > '9') {
+                return false;
+            }
+            parsed = parsed * 10 + (uint64_t)(value[i] - '0');
+        }
+        if (parsed > 0xFFFFFFFFULL) {
+            return false;
+        }
+        number = (uint32_t)parsed;
+        return true;
+    }
+}
+
+size_t formatCurrentJson(char* out, size_t capacity, const SensorData& reading, uint32_t timestamp) {
+    const char* quality;
+    const char* color;
+    getPM25Quality(reading.pm25, quality, color);
+    return result(snprintf(out, capacity,
+                           "{\"pm1\":%.1f,\"pm25\":%.1f,\"pm4\":%.1f,\"pm10\":%.1f,\"temperature\":%.1f,"
+                           "\"humidity\":%.1f,\"voc\":%d,\"nox\":%d,\"timestamp\":%lu,\"quality\":\"%s\"}",
+                           reading.pm1, reading.pm25, reading.pm4, reading.pm10, reading.temperature,
+                           reading.humidity, (int)reading.voc, (int)reading.nox, (unsigned long)timestamp,
+                           quality),
+                  capacity);
+}
+
+size_t formatAverageJson(char* out, size_t capacity, const SensorStats& stats) {
+    const SensorData& mean = stats.mean;
+    return result(snprintf(out, capacity,
+                           "{\"samples\":%d,\"pm1\":%.1f,\"pm25\":%.1f,\"pm4\":%.1f,\"pm10\":%.1f,"
+                           "\"temperature\":%.1f,\"humidity\":%.1f,\"voc\":%.0f,\"nox\":%.0f,"
+                           "\"pm25Min\":%.1f,\"pm25Max\":%.1f}",
+                           stats.count, mean.pm1, mean.pm25, mean.pm4, mean.pm10, mean.temperature,
+                           mean.humidity, mean.voc, mean.nox, stats.min.pm25, stats.max.pm25),
+                  capacity);
+}
+
+size_t formatStatusJson(char* out, size_t capacity, const DashboardStatus& status) {
+    return result(snprintf(out, capacity,
+                           "{\"uptime\":%lu,\"wifi\":%s,\"rssi\":%d,\"ip\":\"%u.%u.%u.%u\",\"sensorReady\":%s,"
+                           "\"firstValidMs\":%lu,\"queued\":%lu,\"batch\":%d,\"freeHeap\":%lu,"
+                           "\"largestFreeBlock\":%lu,\"clients\":%d}",
+                           (unsigned long)status.uptimeSeconds, status.wifiConnected ? "true" : "false",
+                           status.rssi, status.ip[0], status.ip[1], status.ip[2], status.ip[3],
+                           status.sensorReady ? "true" : "false", (unsigned long)status.firstValidMs,
+                           (unsigned long)status.queuedRecords, status.batchRecords,
+                           (unsigned long)status.freeHeap, (unsigned long)status.largestFreeBlock,
+                           status.dashboardClients),
+                  capacity);
+}
+
+size_t formatUpdateJson(char* out, size_t capacity, const DashboardStatus& status, const SensorData* reading,
+                        uint32_t timestamp) {
+    size_t length = result(snprintf(out, capacity, "{\"status\":"), capacity);
+    if (length < capacity) {
+        length += formatStatusJson(out + length, capacity - length, status);
+    }
+    if (reading && length < capacity) {
+        length += result(snprintf(out + length, capacity - length, ",\"current\":"), capacity - length);
+        if (length < capacity) {
+            length += formatCurrentJson(out + length, capacity - length, *reading, timestamp);
+        }
+    }
+    if (length < capacity) {
+        length += result(snprintf(out + length, capacity - length, "}"), capacity - length);
+    }
+    return length;
+}
+
+size_t formatHistoryJson(char* out, size_t capacity, HistoryStore& store, const char* query) {
+    uint32_t from = 0;
+    uint32_t to = store.newest();
+    uint32_t points = HISTORY_DEFAULT_POINTS;
+    int field = FIELD_PM25;
+    bool haveFrom = false;
+    while (*query) {
+        size_t length = strcspn(query, "&");
+        const char* value = (const char*)memchr(query, '=', length);
+        size_t nameLength = value ? (size_t)(value - query) : length;
+        size_t valueLength = value ? length - nameLength - 1 : 0;
+        value = value ? value + 1 : query + length;
+        bool ok = true;
+        if (nameLength == 4 && strncmp(query, "from", 4) == 0) {
+            ok = parseNumber(value, valueLength, from);
+            haveFrom = true;
+        } else if (nameLength == 2 && strncmp(query, "to", 2) == 0) {
+            ok = parseNumber(value, valueLength, to);
+        } else if (nameLength == 6 && strncmp(query, "points", 6) == 0) {
+            ok = parseNumber(value, valueLength, points) && points >= 1 && points <= HISTORY_MAX_POINTS;
+        } else if (nameLength == 5 && strncmp(query, "field", 5) == 0) {
+            for (field = 0; field < SENSOR_FIELD_COUNT; field++) {
+                if (strlen(FIELD_NAMES[field]) == valueLength && strncmp(FIELD_NAMES[field], value, valueLength) == 0) {
+                    break;
+                }
+            }
+            ok = field < SENSOR_FIELD_COUNT;
+        }
+        if (!ok) {
+            return 0;
+        }
+        query += length;
+        if (*query == '&') {
+            query++;
+        }
+    }
+    if (!haveFrom) {
+        from = to >= HISTORY_DEFAULT_SPAN ? to - HISTORY_DEFAULT_SPAN + 1 : 0;
+    }
+    if (from > to) {
+        return 0;
+    }
+
+    HistoryWriter writer;
+    writer.out = out;
+    writer.capacity = capacity;
+    writer.decimals = FIELD_DECIMALS[field];
+    writer.first = true;
+    writer.length = result(snprintf(out, capacity, "{\"field\":\"%s\",\"from\":%lu,\"to\":%lu,\"step\":%lu,\"points\":[",
+                                    FIELD_NAMES[field], (unsigned long)from, (unsigned long)to,
+                                    (unsigned long)HistoryStore::bucketSeconds(from, to, (int)points)),
+                           capacity);
+    if (writer.length < capacity) {
+        store.query(from, to, (SensorField)field, (int)points, writeHistoryPoint, &writer);
+    }
+    if (writer.length < capacity) {
+        writer.length += result(snprintf(out + writer.length, capacity - writer.length, "]}"),
+                                capacity - writer.length);
+    }
+    return writer.length;
+}
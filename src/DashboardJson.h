@@ -0,0 +1,61 @@
+/**
+ * @file DashboardJson.h
+ * @brief JSON bodies of the dashboard API (/api/current, /api/average, /api/status, /api/history, /ws)
+ *
+ * Each formatter writes one body into a caller's buffer (a JsonSnapshot's
+ * or WebSocketBroadcaster's edit() buffer) and returns its length as snprintf() does: a result of
+ * capacity or more means the body did not fit.
+ */
+
+#ifndef DASHBOARD_JSON_H
+#define DASHBOARD_JSON_H
+
+#include <Arduino.h>
+#include "SensorData.h"
+#include "HistoryStore.h"
+
+// /api/history query limits
+const int HISTORY_DEFAULT_POINTS = 240;
+const int HISTORY_MAX_POINTS = 480;          // At most 40 bytes each: fits DashboardServer::QUERY_RESPONSE_BYTES
+const uint32_t HISTORY_DEFAULT_SPAN = 86400; // Seconds before to when from is not given
+
+// What /api/status reports; filled by main.cpp from the subsystems
+struct DashboardStatus {
+    uint32_t uptimeSeconds;
+    bool wifiConnected;
+    int rssi;              // dBm, 0 while disconnected
+    uint8_t ip[4];
+    bool sensorReady;      // A valid reading has arrived since boot
+    uint32_t firstValidMs; // Time from boot to the first valid reading
+    uint32_t queuedRecords; // Records on flash waiting for upload
+    int batchRecords;      // Records in the RAM batch
+    uint32_t freeHeap;
+    uint32_t largestFreeBlock;
+    int dashboardClients;
+};
+
+/** Latest reading: {"pm1":..,"pm25":..,...,"nox":..,"timestamp":<unix s or 0>,"quality":"GOOD"} */
+size_t formatCurrentJson(char* out, size_t capacity, const SensorData& reading, uint32_t timestamp);
+
+/** Means over the averaging window, with the PM2.5 range: {"samples":n,"pm1":..,...,"pm25Min":..,"pm25Max":..} */
+size_t formatAverageJson(char* out, size_t capacity, const SensorStats& stats);
+
+size_t formatStatusJson(char* out, size_t capacity, const DashboardStatus& status);
+
+/** Message pushed on /ws per sample: {"status":{..},"current":{..}}, without "current" if reading is nullptr */
+size_t formatUpdateJson(char* out, size_t capacity, const DashboardStatus& status, const SensorData* reading,
+                        uint32_t timestamp);
+
+/**
+ * @brief /api/history body for a query string "from=&to=&points=&field=" (any subset, any order)
+ *
+ * {"field":"pm25","from":..,"to":..,"step":..,"points":[[time,min,mean,max],..]}, one entry per
+ * bucket of step seconds that holds readings. from and to are Unix seconds (default: the
+ * HISTORY_DEFAULT_SPAN up to the newest reading), points at most HISTORY_MAX_POINTS, field one
+ * of the /api/current names. Unknown parameters are ignored.
+ *
+ * @return 0 if a parameter is malformed or out of range
+ */
+size_t formatHistoryJson(char* out, size_t capacity, HistoryStore& store, const char* query);
+
+#endif // DASHBOARD_JSON_H
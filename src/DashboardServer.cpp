@@ -0,0 +1,668 @@
+/**
+ * @file DashboardServer.cpp
+ * @brief Implementation of the dashboard HTTP server
+ */
+
+#include "DashboardServer.h"
+
+#include <mbedtls/sha1.h>
+#include <strings.h>
+
+namespace {
+    // Error responses are constant, so they go out like any other buffer
+    const char RESPONSE_400[] = "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\n"
+                                "Content-Length: 11\r\nConnection: close\r\n\r\nBad request";
+    const char RESPONSE_404[] = "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n"
+                                "Content-Length: 9\r\n\r\nNot found";
+    const char RESPONSE_405[] = "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Type: text/plain\r\n"
+                                "Content-Length: 18\r\n\r\nMethod not allowed";
+    const char RESPONSE_414[] = "HTTP/1.1 414 URI Too Long\r\nContent-Type: text/plain\r\n"
+                                "Content-Length: 12\r\nConnection: close\r\n\r\nURI too long";
+    const char RESPONSE_503[] = "HTTP/1.1 503 Service Unavailable\r\nRetry-After: 1\r\nContent-Type: application/json\r\n"
+                                "Cache-Control: no-store\r\nContent-Length: 22\r\n\r\n{\"error\":\"warming up\"}";
+    // Followed by the accept key and the blank line
+    const char RESPONSE_101[] = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                                "Sec-WebSocket-Accept: ";
+    const char CACHE_IMMUTABLE[] = "public, max-age=31536000, immutable";
+    const char CACHE_REVALIDATE[] = "no-cache"; // Store, but ask (If-None-Match) before each use
+
+    const char WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+    // WebSocket opcodes (RFC 6455)
+    const uint8_t OP_CLOSE = 0x8;
+    const uint8_t OP_PING = 0x9;
+    const uint8_t OP_PONG = 0xA;
+    const uint8_t FIN = 0x80;
+    const uint8_t MASKED = 0x80;
+    const uint8_t PING_FRAME[] = {FIN | OP_PING, 0};
+    const uint8_t CLOSE_PROTOCOL_ERROR[] = {0x03, 0xEA}; // 1002
+
+    size_t base64(const uint8_t* data, size_t length, char* out) {
+        static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        size_t written = 0;
+        for (size_t i = 0; i < length; i += 3) {
+            uint32_t group = (uint32_t)data[i] << 16;
+            if (i + 1 < length) group |= (uint32_t)data[i + 1] << 8;
+            if (i + 2 < length) group |= data[i + 2];
+            out[written++] = ALPHABET[(group >> 18) & 0x3F];
+            out[written++] = ALPHABET[(group >> 12) & 0x3F];
+            out[written++] = i + 1 < length ? ALPHABET[(group >> 6) & 0x3F] : '=';
+            out[written++] = i + 2 < length ? ALPHABET[group & 0x3F] : '=';
+        }
+        return written;
+    }
+
+    /** Bytes of the frame header once the first two are known: length and mask key included */
+    size_t frameHeaderSize(const uint8_t* header, size_t received) {
+        if (received < 2) {
+            return 2;
+        }
+        uint8_t length = header[1] & 0x7F;
+        return 2 + (length == 126 ? 2 : length == 127 ? 8 : 0) + ((header[1] & MASKED) ? 4 : 0);
+    }
+}
+
+DashboardServer::DashboardServer(uint16_t port) : server(port, MAX_CLIENTS), running(false), routeCount(0) {
+    memset(routes, 0, sizeof(routes));
+    memset(&stats, 0, sizeof(stats));
+    for (Connection& connection : connections) {
+        connection.open = false;
+        connection.pinned = nullptr;
+        connection.feed = nullptr;
+        connection.heldFrame = WebSocketBroadcaster::NONE;
+        connection.response = nullptr;
+        resetRequest(connection);
+    }
+}
+
+bool DashboardServer::addPage(const char* path, const char* contentType, const uint8_t* body, size_t length) {
+    return addStatic(path, contentType, body, length, nullptr, nullptr);
+}
+
+bool DashboardServer::addAsset(const char* path, const char* contentType, const uint8_t* gzipBody, size_t length,
+                               const char* etag, bool immutable) {
+    return addStatic(path, contentType, gzipBody, length, etag, immutable ? CACHE_IMMUTABLE : CACHE_REVALIDATE);
+}
+
+bool DashboardServer::addStatic(const char* path, const char* contentType, const uint8_t* body, size_t length,
+                                const char* etag, const char* cacheControl) {
+    if (routeCount >= MAX_ROUTES) {
+        return false;
+    }
+    Route& route = routes[routeCount];
+    int headerLength;
+    if (etag) {
+        headerLength = snprintf(route.header, sizeof(route.header),
+                                "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Encoding: gzip\r\n"
+                                "Content-Length: %u\r\nETag: %s\r\nCache-Control: %s\r\n\r\n",
+                                contentType, (unsigned)length, etag, cacheControl);
+    } else {
+        headerLength = snprintf(route.header, sizeof(route.header),
+                                "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %u\r\n\r\n",
+                                contentType, (unsigned)length);
+    }
+    if (headerLength <= 0 || (size_t)headerLength >= sizeof(route.header)) {
+        return false;
+    }
+    route.path = path;
+    route.snapshot = nullptr;
+    route.broadcaster = nullptr;
+    route.body = body;
+    route.length = length;
+    route.etag = etag;
+    route.cacheControl = cacheControl;
+    route.headerLength = (size_t)headerLength;
+    routeCount++;
+    return true;
+}
+
+bool DashboardServer::addSnapshot(const char* path, JsonSnapshot& snapshot) {
+    if (routeCount >= MAX_ROUTES) {
+        return false;
+    }
+    Route& route = routes[routeCount++];
+    route.path = path;
+    route.snapshot = &snapshot;
+    route.broadcaster = nullptr;
+    return true;
+}
+
+bool DashboardServer::addWebSocket(const char* path, WebSocketBroadcaster& broadcaster) {
+    if (routeCount >= MAX_ROUTES) {
+        return false;
+    }
+    Route& route = routes[routeCount++];
+    route.path = path;
+    route.snapshot = nullptr;
+    route.broadcaster = &broadcaster;
+    return true;
+}
+
+bool DashboardServer::addQuery(const char* path, DashboardQueryHandler handler, void* context,
+                               const char* contentType) {
+    if (routeCount >= MAX_ROUTES) {
+        return false;
+    }
+    for (Connection& connection : connections) {
+        if (!connection.response) {
+            void* buffer = psramFound() ? ps_malloc(QUERY_RESPONSE_BYTES) : malloc(QUERY_RESPONSE_BYTES);
+            if (!buffer) {
+                return false;
+            }
+            connection.response = (char*)buffer;
+        }
+    }
+    Route& route = routes[routeCount++];
+    route.path = path;
+    route.snapshot = nullptr;
+    route.broadcaster = nullptr;
+    route.handler = handler;
+    route.context = context;
+    route.contentType = contentType;
+    return true;
+}
+
+void DashboardServer::begin() {
+    if (running) {
+        return;
+    }
+    server.begin();
+    server.setNoDelay(true); // Responses are written whole; don't hold the last segment back
+    running = true;
+}
+
+bool DashboardServer::isRunning() const {
+    return running;
+}
+
+int DashboardServer::clientCount() const {
+    int count = 0;
+    for (const Connection& connection : connections) {
+        count += connection.open;
+    }
+    return count;
+}
+
+const DashboardServerStats& DashboardServer::getStats() const {
+    return stats;
+}
+
+const DashboardRouteStats* DashboardServer::getRouteStats(const char* path) const {
+    for (int i = 0; i < routeCount; i++) {
+        if (strcmp(routes[i].path, path) == 0) {
+            return &routes[i].stats;
+        }
+    }
+    return nullptr;
+}
+
+bool DashboardServer::poll() {
+    if (!running) {
+        return false;
+    }
+    unsigned long now = millis();
+    accept(now);
+
+    bool active = false;
+    for (Connection& connection : connections) {
+        if (!connection.open) {
+            continue;
+        }
+        if (connection.segment < 2) {
+            send(connection, now);
+        }
+        if (connection.open && connection.segment == 2) {
+            receive(connection, now);
+        }
+        if (connection.open && connection.feed && connection.segment == 2) {
+            push(connection, now);
+        }
+        if (!connection.open) {
+            continue;
+        }
+        if ((connection.segment == 2 || connection.feed) && !connection.client.connected()) {
+            close(connection); // The browser went away between requests, or left a WebSocket
+        } else if (now - connection.lastActivity > IDLE_TIMEOUT_MS) {
+            stats.timeouts++;
+            close(connection);
+        } else if (!connection.feed || connection.segment < 2) {
+            active = true;
+        }
+    }
+    return active;
+}
+
+void DashboardServer::accept(unsigned long now) {
+    // Connections beyond MAX_CLIENTS wait in the listen backlog until a slot frees
+    for (Connection& connection : connections) {
+        if (connection.open) {
+            continue;
+        }
+        if (!server.hasClient()) {
+            break;
+        }
+        connection.client = server.accept();
+        if (!connection.client) {
+            continue;
+        }
+        connection.open = true;
+        connection.lastActivity = now;
+        resetRequest(connection);
+        stats.connections++;
+        uint32_t open = (uint32_t)clientCount();
+        if (open > stats.maxClients) {
+            stats.maxClients = open;
+        }
+    }
+}
+
+void DashboardServer::receive(Connection& connection, unsigned long now) {
+    if (connection.feed) {
+        receiveWebSocket(connection, now);
+        return;
+    }
+    for (size_t budget = MAX_READ_PER_POLL; budget > 0 && connection.client.available() > 0; budget--) {
+        int c = connection.client.read();
+        if (c < 0) {
+            break;
+        }
+        connection.lastActivity = now;
+        if (c == '\n') {
+            parseLine(connection);
+            if (connection.segment < 2) {
+                send(connection, now); // Pipelined requests wait until this response is out
+                return;
+            }
+        } else if (c != '\r') {
+            if (connection.lineLength < LINE_BYTES - 1) {
+                connection.line[connection.lineLength++] = (char)c;
+            } else {
+                connection.lineOverflow = true;
+            }
+        }
+    }
+}
+
+void DashboardServer::parseLine(Connection& connection) {
+    connection.line[connection.lineLength] = '\0';
+    if (!connection.haveRequestLine) {
+        if (connection.lineLength > 0 || connection.lineOverflow) { // Stray empty lines are allowed before it
+            parseRequestLine(connection);
+            connection.haveRequestLine = true;
+        }
+    } else if (connection.lineLength == 0 && !connection.lineOverflow) {
+        respond(connection); // End of the headers (GET requests have no body)
+    } else if (!connection.lineOverflow && strncasecmp(connection.line, "If-None-Match:", 14) == 0) {
+        const Route* route = connection.route;
+        connection.notModified = route && route->etag && strstr(connection.line + 14, route->etag) != nullptr;
+    } else if (!connection.lineOverflow && strncasecmp(connection.line, "Upgrade:", 8) == 0) {
+        const char* value = connection.line + 8;
+        while (*value == ' ') {
+            value++;
+        }
+        connection.upgrade = strcasecmp(value, "websocket") == 0;
+    } else if (!connection.lineOverflow && strncasecmp(connection.line, "Sec-WebSocket-Key:", 18) == 0) {
+        const char* value = connection.line + 18;
+        while (*value == ' ') {
+            value++;
+        }
+        size_t length = strcspn(value, " ");
+        if (length == WS_KEY_LENGTH) {
+            memcpy(connection.key, value, length);
+            connection.key[length] = '\0';
+        }
+    } else if (!connection.lineOverflow && strncasecmp(connection.line, "Connection:", 11) == 0) {
+        const char* value = connection.line + 11;
+        while (*value == ' ') {
+            value++;
+        }
+        if (strncasecmp(value, "close", 5) == 0) {
+            connection.closeAfter = true;
+        } else if (strncasecmp(value, "keep-alive", 10) == 0) {
+            connection.closeAfter = false;
+        }
+    }
+    connection.lineLength = 0;
+    connection.lineOverflow = false;
+}
+
+void DashboardServer::parseRequestLine(Connection& connection) {
+    if (connection.lineOverflow) {
+        connection.status = 414;
+        return;
+    }
+    char* target = strchr(connection.line, ' ');
+    char* version = target ? strchr(target + 1, ' ') : nullptr;
+    if (!target || !version || strncmp(version + 1, "HTTP/1.", 7) != 0) {
+        connection.status = 400;
+        return;
+    }
+    *target++ = '\0';
+    *version++ = '\0';
+    connection.closeAfter = strcmp(version, "HTTP/1.0") == 0; // 1.0 closes unless it asks otherwise
+    if (strcmp(connection.line, "GET") != 0) {
+        connection.status = 405;
+        return;
+    }
+    connection.route = findRoute(target);
+    if (!connection.route) {
+        connection.status = 404;
+    } else if (connection.route->handler) {
+        const char* query = strchr(target, '?');
+        query = query ? query + 1 : "";
+        if (strlen(query) >= QUERY_BYTES) {
+            connection.status = 414;
+        } else {
+            strcpy(connection.query, query);
+        }
+    }
+}
+
+DashboardServer::Route* DashboardServer::findRoute(const char* target) {
+    size_t pathLength = strcspn(target, "?"); // Only query routes look at the query
+    for (int i = 0; i < routeCount; i++) {
+        if (strlen(routes[i].path) == pathLength && strncmp(routes[i].path, target, pathLength) == 0) {
+            return &routes[i];
+        }
+    }
+    return nullptr;
+}
+
+void DashboardServer::respond(Connection& connection) {
+    stats.requests++;
+    if (connection.status != 0) {
+        respondError(connection, connection.status);
+        return;
+    }
+    Route& route = *connection.route;
+    route.stats.requests++;
+    if (route.broadcaster) {
+        respondUpgrade(connection, route);
+    } else if (route.handler) {
+        respondQuery(connection, route);
+    } else if (route.snapshot) {
+        const uint8_t* data;
+        size_t length;
+        int buffer = route.snapshot->acquire(data, length);
+        if (buffer == JsonSnapshot::NONE) {
+            stats.unavailable++;
+            connection.segments[0] = (const uint8_t*)RESPONSE_503;
+            connection.segmentLengths[0] = sizeof(RESPONSE_503) - 1;
+            connection.segmentLengths[1] = 0;
+        } else {
+            connection.pinned = route.snapshot;
+            connection.pinnedBuffer = buffer;
+            connection.segments[0] = data;
+            connection.segmentLengths[0] = length;
+            connection.segmentLengths[1] = 0;
+        }
+    } else if (connection.notModified) {
+        respondNotModified(connection, route);
+    } else {
+        connection.segments[0] = (const uint8_t*)route.header;
+        connection.segmentLengths[0] = route.headerLength;
+        connection.segments[1] = route.body;
+        connection.segmentLengths[1] = route.length;
+    }
+    connection.segment = 0;
+}
+
+void DashboardServer::respondError(Connection& connection, int status) {
+    const char* response = RESPONSE_400;
+    if (status == 404) {
+        response = RESPONSE_404;
+    } else if (status == 405) {
+        response = RESPONSE_405;
+    } else if (status == 414) {
+        response = RESPONSE_414;
+    }
+    if (status == 400 || status == 414) {
+        connection.closeAfter = true; // The rest of the request cannot be trusted
+    }
+    stats.errors++;
+    connection.segments[0] = (const uint8_t*)response;
+    connection.segmentLengths[0] = strlen(response);
+    connection.segmentLengths[1] = 0;
+    connection.segment = 0;
+}
+
+void DashboardServer::respondNotModified(Connection& connection, Route& route) {
+    // The request is parsed, so the line buffer is free until the next one
+    int length = snprintf(connection.line, sizeof(connection.line),
+                          "HTTP/1.1 304 Not Modified\r\nETag: %s\r\nCache-Control: %s\r\n\r\n",
+                          route.etag, route.cacheControl);
+    stats.notModified++;
+    route.stats.notModified++;
+    connection.segments[0] = (const uint8_t*)connection.line;
+    connection.segmentLengths[0] = length > 0 && (size_t)length < sizeof(connection.line) ? (size_t)length : 0;
+    connection.segmentLengths[1] = 0;
+    connection.segment = 0;
+}
+
+void DashboardServer::respondQuery(Connection& connection, const Route& route) {
+    // The body goes after room for the header, which is then put right in front of it
+    char* body = connection.response + QUERY_HEADER_ROOM;
+    size_t capacity = QUERY_RESPONSE_BYTES - QUERY_HEADER_ROOM;
+    size_t length = route.handler(connection.query, body, capacity, route.context);
+    if (length == 0 || length >= capacity) {
+        respondError(connection, 400);
+        return;
+    }
+    char header[QUERY_HEADER_ROOM];
+    int headerLength = snprintf(header, sizeof(header),
+                                "HTTP/1.1 200 OK\r\nContent-Type: %s\r\n"
+                                "Cache-Control: no-store\r\nContent-Length: %u\r\n\r\n", route.contentType,
+                                (unsigned)length);
+    if (headerLength <= 0 || (size_t)headerLength >= sizeof(header)) {
+        respondError(connection, 400);
+        return;
+    }
+    memcpy(body - headerLength, header, headerLength);
+    stats.queries++;
+    connection.segments[0] = (const uint8_t*)body - headerLength;
+    connection.segmentLengths[0] = headerLength + length;
+    connection.segmentLengths[1] = 0;
+    connection.segment = 0;
+}
+
+void DashboardServer::respondUpgrade(Connection& connection, const Route& route) {
+    if (!connection.upgrade || connection.key[0] == '\0' || connection.closeAfter) {
+        respondError(connection, 400); // A plain GET, or HTTP/1.0
+        return;
+    }
+    char input[WS_KEY_LENGTH + sizeof(WS_GUID) - 1];
+    memcpy(input, connection.key, WS_KEY_LENGTH);
+    memcpy(input + WS_KEY_LENGTH, WS_GUID, sizeof(WS_GUID) - 1);
+    uint8_t digest[20];
+    mbedtls_sha1((const unsigned char*)input, sizeof(input), digest);
+    size_t length = base64(digest, sizeof(digest), connection.line);
+    memcpy(connection.line + length, "\r\n\r\n", 4);
+
+    connection.segments[0] = (const uint8_t*)RESPONSE_101;
+    connection.segmentLengths[0] = sizeof(RESPONSE_101) - 1;
+    connection.segments[1] = (const uint8_t*)connection.line;
+    connection.segmentLengths[1] = length + 4;
+    connection.segment = 0;
+    connection.feed = route.broadcaster;
+    connection.lastFrame = 0;
+    connection.frameHeaderLength = 0;
+    stats.upgrades++;
+}
+
+void DashboardServer::receiveWebSocket(Connection& connection, unsigned long now) {
+    for (size_t budget = MAX_READ_PER_POLL; budget > 0 && connection.client.available() > 0; budget--) {
+        int c = connection.client.read();
+        if (c < 0) {
+            break;
+        }
+        connection.lastActivity = now;
+        size_t headerSize = frameHeaderSize(connection.frameHeader, connection.frameHeaderLength);
+        if (connection.frameHeaderLength < headerSize) {
+            connection.frameHeader[connection.frameHeaderLength++] = (uint8_t)c;
+            if (connection.frameHeaderLength < frameHeaderSize(connection.frameHeader, connection.frameHeaderLength)) {
+                continue;
+            }
+            startFrame(connection);
+            if (connection.segment < 2) {
+                send(connection, now); // Protocol error: closing
+                return;
+            }
+            if (connection.payloadRemaining > 0) {
+                continue;
+            }
+        } else {
+            // Messages are ignored; control payloads (<= 125 bytes) are kept for the reply
+            const uint8_t* mask = connection.frameHeader + headerSize - 4;
+            uint8_t byte = (uint8_t)c ^ mask[connection.payloadPosition % 4];
+            if ((connection.frameHeader[0] & 0x08) && connection.payloadPosition < LINE_BYTES - 2) {
+                connection.line[2 + connection.payloadPosition] = (char)byte;
+            }
+            connection.payloadPosition++;
+            if (--connection.payloadRemaining > 0) {
+                continue;
+            }
+        }
+        finishFrame(connection);
+        if (connection.segment < 2) {
+            send(connection, now); // Reply before reading on
+            return;
+        }
+    }
+}
+
+void DashboardServer::startFrame(Connection& connection) {
+    const uint8_t* header = connection.frameHeader;
+    uint8_t length = header[1] & 0x7F;
+    bool control = (header[0] & 0x08) != 0;
+    uint64_t payload = length;
+    if (length == 126) {
+        payload = ((uint32_t)header[2] << 8) | header[3];
+    } else if (length == 127) {
+        payload = 0;
+        for (int i = 2; i < 10; i++) {
+            payload = (payload << 8) | header[i];
+        }
+    }
+    // Browsers mask every frame; control frames are single and short
+    if (!(header[1] & MASKED) || (control && (!(header[0] & FIN) || length > 125)) || payload > 0xFFFFFFFFULL) {
+        stats.errors++;
+        closeWebSocket(connection, CLOSE_PROTOCOL_ERROR, sizeof(CLOSE_PROTOCOL_ERROR));
+        return;
+    }
+    connection.payloadRemaining = (uint32_t)payload;
+    connection.payloadPosition = 0;
+}
+
+void DashboardServer::finishFrame(Connection& connection) {
+    uint8_t opcode = connection.frameHeader[0] & 0x0F;
+    size_t length = connection.payloadPosition;
+    connection.frameHeaderLength = 0;
+    if (opcode == OP_CLOSE) {
+        closeWebSocket(connection, (const uint8_t*)connection.line + 2, length >= 2 ? 2 : 0); // Echo the code
+    } else if (opcode == OP_PING) {
+        connection.line[0] = (char)(FIN | OP_PONG);
+        connection.line[1] = (char)length;
+        connection.segments[0] = (const uint8_t*)connection.line;
+        connection.segmentLengths[0] = 2 + length;
+        connection.segmentLengths[1] = 0;
+        connection.segment = 0;
+    }
+}
+
+void DashboardServer::closeWebSocket(Connection& connection, const uint8_t* payload, size_t length) {
+    memmove(connection.line + 2, payload, length);
+    connection.line[0] = (char)(FIN | OP_CLOSE);
+    connection.line[1] = (char)length;
+    connection.segments[0] = (const uint8_t*)connection.line;
+    connection.segmentLengths[0] = 2 + length;
+    connection.segmentLengths[1] = 0;
+    connection.segment = 0;
+    connection.closeAfter = true;
+}
+
+void DashboardServer::push(Connection& connection, unsigned long now) {
+    const uint8_t* data;
+    size_t length;
+    int frame = connection.feed->acquire(connection.lastFrame, data, length);
+    if (frame != WebSocketBroadcaster::NONE) {
+        connection.heldFrame = frame;
+        connection.segments[0] = data;
+        connection.segmentLengths[0] = length;
+    } else if (now - connection.lastActivity >= PING_INTERVAL_MS) {
+        stats.pings++;
+        connection.segments[0] = PING_FRAME;
+        connection.segmentLengths[0] = sizeof(PING_FRAME);
+    } else {
+        return;
+    }
+    connection.segmentLengths[1] = 0;
+    connection.segment = 0;
+    send(connection, now);
+}
+
+void DashboardServer::send(Connection& connection, unsigned long now) {
+    while (connection.segment < 2) {
+        size_t remaining = connection.segmentLengths[connection.segment];
+        if (remaining > 0) {
+            size_t written = connection.client.write(connection.segments[connection.segment], remaining);
+            stats.bytesSent += written;
+            if (connection.route) {
+                connection.route->stats.bytesSent += written;
+            }
+            if (written > 0) {
+                connection.lastActivity = now;
+            }
+            if (written < remaining) {
+                stats.shortWrites++;
+                connection.segments[connection.segment] += written;
+                connection.segmentLengths[connection.segment] -= written;
+                return; // Send buffer full: resume on the next poll
+            }
+        }
+        connection.segment++;
+    }
+
+    bool closeAfter = connection.closeAfter;
+    if (connection.pinned) {
+        connection.pinned->release(connection.pinnedBuffer);
+        connection.pinned = nullptr;
+    }
+    if (connection.heldFrame != WebSocketBroadcaster::NONE) {
+        connection.feed->release(connection.heldFrame);
+        connection.heldFrame = WebSocketBroadcaster::NONE;
+    }
+    resetRequest(connection);
+    if (closeAfter) {
+        close(connection);
+    }
+}
+
+void DashboardServer::resetRequest(Connection& connection) {
+    connection.lineLength = 0;
+    connection.lineOverflow = false;
+    connection.haveRequestLine = false;
+    connection.status = 0;
+    connection.route = nullptr;
+    connection.notModified = false;
+    connection.closeAfter = false;
+    connection.upgrade = false;
+    connection.key[0] = '\0';
+    connection.segment = 2;
+    connection.segmentLengths[0] = 0;
+    connection.segmentLengths[1] = 0;
+}
+
+void DashboardServer::close(Connection& connection) {
+    if (connection.pinned) {
+        connection.pinned->release(connection.pinnedBuffer);
+        connection.pinned = nullptr;
+    }
+    if (connection.heldFrame != WebSocketBroadcaster::NONE) {
+        connection.feed->release(connection.heldFrame);
+        connection.heldFrame = WebSocketBroadcaster::NONE;
+    }
+    connection.feed = nullptr;
+    connection.client.stop();
+    connection.open = false;
+    resetRequest(connection);
+}
@@ -0,0 +1,209 @@
+/**
+ * @file DashboardServer.h
+ * @brief Minimal HTTP/1.1 server for the local web dashboard
+ *
+ * Serves a fixed table of routes: static pages and gzipped assets kept in
+ * flash (the dashboard, see DashboardAssets.h) and JsonSnapshot endpoints
+ * whose responses are precomposed once per reading, plus query routes
+ * whose handler builds each response from the request's query string into
+ * a buffer of the connection's. poll() runs from loop() and never blocks: it accepts connections
+ * into MAX_CLIENTS fixed slots, reads requests a line at a time (only the
+ * request line and the Connection header are kept, other headers are
+ * skipped), and writes each response straight from the page or snapshot
+ * buffer, resuming on the next poll when the socket's send buffer is full.
+ * Assets carry a strong ETag: a request whose If-None-Match names it gets
+ * a 304 without a body. Keep-alive connections are reused; connections that neither send nor
+ * accept data for IDLE_TIMEOUT_MS are closed. Nothing is allocated after
+ * begin().
+ *
+ * A WebSocket route upgrades its connection in place: from then on the
+ * slot writes the broadcaster's newest frame whenever the previous one is
+ * out (see WebSocketBroadcaster), answers pings and closes, and ignores
+ * messages from the browser. An idle WebSocket is pinged every
+ * PING_INTERVAL_MS; one that takes nothing for IDLE_TIMEOUT_MS is closed,
+ * which frees the frame it held.
+ */
+
+#ifndef DASHBOARD_SERVER_H
+#define DASHBOARD_SERVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "JsonSnapshot.h"
+#include "WebSocketBroadcaster.h"
+
+struct DashboardServerStats {
+    uint32_t connections;  // Accepted
+    uint32_t requests;     // Answered, whatever the status
+    uint32_t errors;       // 400, 404, 405 and 414 answers, and WebSocket protocol errors
+    uint32_t unavailable;  // 503 answers: the snapshot was not published yet
+    uint32_t notModified;  // 304 answers
+    uint32_t queries;      // Responses built by a query handler
+    uint32_t upgrades;     // Connections switched to WebSocket
+    uint32_t pings;        // Pings sent to idle WebSockets
+    uint32_t timeouts;     // Connections closed for inactivity
+    uint32_t shortWrites;  // write() calls that took less than offered (send buffer full)
+    uint32_t maxClients;   // Most connections open at once
+    uint64_t bytesSent;
+};
+
+/**
+ * Builds a query route's body for query (the text after '?', empty if
+ * there is none) into body and returns its length as snprintf() does; 0 or
+ * a length of capacity or more answers 400 Bad Request
+ */
+typedef size_t (*DashboardQueryHandler)(const char* query, char* body, size_t capacity, void* context);
+
+struct DashboardRouteStats {
+    uint32_t requests;     // Answered from this route (200, 304 or 503)
+    uint32_t notModified;  // 304 answers
+    uint64_t bytesSent;    // Headers and bodies (WebSocket frames not included)
+};
+
+class DashboardServer {
+public:
+    static const int MAX_CLIENTS = 4;           // Of lwIP's 10 sockets; OTA and uploads need theirs
+    static const int MAX_ROUTES = 12;
+    static const size_t LINE_BYTES = 128;       // Request line limit; longer header lines are skipped
+    static const size_t PAGE_HEADER_BYTES = 224; // Type, encoding, length, ETag and Cache-Control
+    static const uint32_t IDLE_TIMEOUT_MS = 15000;
+    static const size_t MAX_READ_PER_POLL = 1024; // Request bytes taken from one connection per poll()
+    static const uint32_t PING_INTERVAL_MS = 10000; // Idle WebSockets are pinged, so the idle timeout needs a dead peer
+    static const size_t WS_KEY_LENGTH = 24;     // Sec-WebSocket-Key: base64 of 16 bytes
+    static const size_t QUERY_BYTES = 96;       // Query string kept for a query route; longer ones get 414
+    static const size_t QUERY_RESPONSE_BYTES = 20480; // Per connection, in PSRAM, once a query route exists
+    static const size_t QUERY_HEADER_ROOM = 128;
+
+    explicit DashboardServer(uint16_t port);
+
+    /**
+     * @brief Serve a static body (e.g. a page in flash) at path
+     *
+     * @return false if the route table is full
+     */
+    bool addPage(const char* path, const char* contentType, const uint8_t* body, size_t length);
+
+    /**
+     * @brief Serve a gzipped body at path with a strong ETag
+     *
+     * @param immutable The path carries a content hash: browsers may cache it for a year
+     *                  without asking again; otherwise they revalidate on every load
+     * @return false if the route table is full or the header does not fit
+     */
+    bool addAsset(const char* path, const char* contentType, const uint8_t* gzipBody, size_t length,
+                  const char* etag, bool immutable);
+
+    /** Serve the snapshot's current response at path; 503 until it is first published */
+    bool addSnapshot(const char* path, JsonSnapshot& snapshot);
+
+    /**
+     * @brief Answer GET path?query with the body handler builds, per request
+     *
+     * The first query route allocates a QUERY_RESPONSE_BYTES buffer per connection (PSRAM
+     * when the board has it). The handler runs inside poll(), so it must take bounded time.
+     *
+     * @return false if the route table is full or the buffers cannot be allocated
+     */
+    bool addQuery(const char* path, DashboardQueryHandler handler, void* context,
+                  const char* contentType = "application/json");
+
+    /** Push the broadcaster's frames to WebSocket clients connecting to path */
+    bool addWebSocket(const char* path, WebSocketBroadcaster& broadcaster);
+
+    /** Start listening; needs the network interface up */
+    void begin();
+    bool isRunning() const;
+
+    /**
+     * @brief Accept connections, read requests and send what fits, without blocking
+     *
+     * @return true while an HTTP connection is open or a WebSocket frame is part-way out (poll
+     *         again soon); idle WebSockets only need polling when a new frame is published
+     */
+    bool poll();
+
+    int clientCount() const;
+    const DashboardServerStats& getStats() const;
+
+    /** Counters of the route at path; nullptr if there is none */
+    const DashboardRouteStats* getRouteStats(const char* path) const;
+
+private:
+    struct Route {
+        const char* path;
+        JsonSnapshot* snapshot;  // nullptr for a static page
+        WebSocketBroadcaster* broadcaster;  // Set for a WebSocket route
+        DashboardQueryHandler handler;      // Set for a query route
+        void* context;
+        const char* contentType;            // Of a query route's bodies
+        const uint8_t* body;
+        size_t length;
+        const char* etag;          // Assets only
+        const char* cacheControl;
+        char header[PAGE_HEADER_BYTES];
+        size_t headerLength;
+        DashboardRouteStats stats;
+    };
+
+    struct Connection {
+        WiFiClient client;
+        bool open;
+        char line[LINE_BYTES];
+        size_t lineLength;
+        bool lineOverflow;
+        bool haveRequestLine;
+        int status;                   // 0 while the request line is acceptable, else the error to answer
+        Route* route;
+        bool notModified;             // If-None-Match named the route's ETag
+        char query[QUERY_BYTES];      // After '?' in the target, for a query route
+        char* response;               // Query responses are built here (QUERY_RESPONSE_BYTES)
+        bool closeAfter;              // Connection: close, HTTP/1.0 or an error
+        const uint8_t* segments[2];   // Response still to write: header, then body
+        size_t segmentLengths[2];
+        int segment;                  // Next segment to write; 2 = nothing to send
+        JsonSnapshot* pinned;         // Snapshot buffer held until the response is written
+        int pinnedBuffer;
+        unsigned long lastActivity;
+        bool upgrade;                 // Upgrade: websocket
+        char key[WS_KEY_LENGTH + 1];  // Sec-WebSocket-Key, empty if absent
+
+        // Once upgraded; pong and close replies are built in line
+        WebSocketBroadcaster* feed;
+        uint32_t lastFrame;           // Sequence number of the newest frame sent
+        int heldFrame;                // Frame held until it is written, or NONE
+        uint8_t frameHeader[14];      // Frame being received: header, then payload
+        size_t frameHeaderLength;
+        uint32_t payloadRemaining;
+        uint32_t payloadPosition;
+    };
+
+    WiFiServer server;
+    bool running;
+    Route routes[MAX_ROUTES];
+    int routeCount;
+    Connection connections[MAX_CLIENTS];
+    DashboardServerStats stats;
+
+    void accept(unsigned long now);
+    void receive(Connection& connection, unsigned long now);
+    void parseLine(Connection& connection);
+    void parseRequestLine(Connection& connection);
+    void respond(Connection& connection);
+    void respondError(Connection& connection, int status);
+    void respondNotModified(Connection& connection, Route& route);
+    void respondUpgrade(Connection& connection, const Route& route);
+    void respondQuery(Connection& connection, const Route& route);
+    void receiveWebSocket(Connection& connection, unsigned long now);
+    void startFrame(Connection& connection);
+    void finishFrame(Connection& connection);
+    void closeWebSocket(Connection& connection, const uint8_t* payload, size_t length);
+    void push(Connection& connection, unsigned long now);
+    void send(Connection& connection, unsigned long now);
+    void resetRequest(Connection& connection);
+    void close(Connection& connection);
+    bool addStatic(const char* path, const char* contentType, const uint8_t* body, size_t length,
+                   const char* etag, const char* cacheControl);
+    Route* findRoute(const char* target);
+};
+
+#endif // DASHBOARD_SERVER_H
@@ -1,6 +1,6 @@
 /*
  * DataAveraging.cpp
- * Implementation of running average calculation for sensor readings
+ * Implementation of the sliding-window statistics for sensor readings
  */
 
 #include "DataAveraging.h"
@@ -9,43 +9,93 @@ DataAveraging::DataAveraging() {
     reset();
 }
 
-void DataAveraging::addReading(float pm1, float pm25, float pm4, float pm10,
-                               float humidity, float temperature, float voc, float nox) {
-    data.pm1 += pm1;
-    data.pm25 += pm25;
-    data.pm4 += pm4;
-    data.pm10 += pm10;
-    data.humidity += humidity;
-    data.temperature += temperature;
-    data.voc += voc;
-    data.nox += nox;
-    data.count++;
+void DataAveraging::addReading(const SensorData& reading) {
+    if (history.isFull()) {
+        // Window full: replace the oldest reading (sliding Welford update)
+        SensorData outgoing = history.oldest();
+        history.push(reading);
+        const float invCount = 1.0f / AVERAGING_SAMPLES;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            float x = reading.*SENSOR_FIELDS[f];
+            float evicted = outgoing.*SENSOR_FIELDS[f];
+            float oldMean = means[f];
+            float newMean = oldMean + (x - evicted) * invCount;
+            m2[f] += (x - evicted) * (x - newMean + evicted - oldMean);
+            if (m2[f] < 0) m2[f] = 0;
+            means[f] = newMean;
+        }
+    } else {
+        // Window filling: plain Welford update
+        history.push(reading);
+        int count = history.size();
+        const float invCount = 1.0f / count;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            float x = reading.*SENSOR_FIELDS[f];
+            float delta = x - means[f];
+            means[f] += delta * invCount;
+            m2[f] += delta * (x - means[f]);
+        }
+    }
+    
+    lapPosition++;
+    if (lapPosition == AVERAGING_SAMPLES) {
+        lapPosition = 0;
+        // Once per lap, rebuild mean/M2 from the buffer with a two-pass sum so
+        // rounding error from repeated sliding updates cannot accumulate
+        // (amortized O(1))
+        recomputeStats();
+    }
 }
 
-void DataAveraging::getAveraged(float &pm1, float &pm25, float &pm4, float &pm10,
-                                float &humidity, float &temperature, float &voc, float &nox) {
-    if (data.count == 0) return; // Prevent division by zero
-    
-    pm1 = data.pm1 / data.count;
-    pm25 = data.pm25 / data.count;
-    pm4 = data.pm4 / data.count;
-    pm10 = data.pm10 / data.count;
-    humidity = data.humidity / data.count;
-    temperature = data.temperature / data.count;
-    voc = data.voc / data.count;
-    nox = data.nox / data.count;
-    
-    // NOTE: Caller must explicitly call reset() after successful upload
+void DataAveraging::recomputeStats() {
+    int count = history.size();
+    SensorStats stats = history.reduce(count);
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        float SensorData::* member = SENSOR_FIELDS[f];
+        means[f] = stats.mean.*member;
+        m2[f] = stats.variance.*member * (count - 1);
+    }
+}
+
+SensorData DataAveraging::getAveraged() const {
+    int count = history.size();
+    SensorData result;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        result.*SENSOR_FIELDS[f] = count ? means[f] : NAN;
+    }
+    return result;
+}
+
+SensorStats DataAveraging::getStats() const {
+    int count = history.size();
+    SensorStats stats;
+    stats.count = count;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        float SensorData::* member = SENSOR_FIELDS[f];
+        // Extremes are only needed at upload time, so one contiguous pass
+        // over the field here is cheaper than maintaining them per reading
+        FieldSummary summary = history.summarizeField(f, count);
+        stats.mean.*member = count ? means[f] : NAN;
+        stats.variance.*member = count > 1 ? m2[f] / (count - 1) : 0.0f;
+        stats.min.*member = count ? summary.min : NAN;
+        stats.max.*member = count ? summary.max : NAN;
+    }
+    return stats;
 }
 
 void DataAveraging::reset() {
-    data = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    history.clear();
+    lapPosition = 0;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        means[f] = 0;
+        m2[f] = 0;
+    }
 }
 
 int DataAveraging::getCount() const {
-    return data.count;
+    return history.size();
 }
 
 bool DataAveraging::hasEnoughSamples() const {
-    return data.count >= AVERAGING_SAMPLES;
+    return history.size() >= MIN_RECORD_SAMPLES;
 }
@@ -1,45 +1,75 @@
 /*
  * DataAveraging.h
- * Handles running average calculation for sensor readings
+ * Sliding-window statistics of sensor readings backed by a fixed ring buffer
  */
 
 #ifndef DATA_AVERAGING_H
 #define DATA_AVERAGING_H
 
 #include <Arduino.h>
+#include "SensorData.h"
+#include "SensorHistory.h"
 
 // Data averaging settings
-const int AVERAGING_SAMPLES = 20;  // Average 20 readings before upload
-
-struct SensorData {
-    float pm1;
-    float pm25;
-    float pm4;
-    float pm10;
-    float humidity;
-    float temperature;
-    float voc;
-    float nox;
-    int count;
-};
+const int AVERAGING_SAMPLES = 20;  // Window capacity: a 15 s record at 1 Hz holds ~15 readings, with room for drift
+const int MIN_RECORD_SAMPLES = 8;  // Fewest readings a record is averaged from (failed or invalid reads cut a window short)
 
+/**
+ * @brief Sliding-window mean, variance, min and max of the last readings
+ *
+ * Readings live in a statically sized struct-of-arrays ring buffer
+ * (SensorHistory). Mean and variance are maintained with Welford's update
+ * (and its sliding-window form once the buffer is full), so each
+ * addReading() is O(1) and numerically stable; min/max come from one
+ * contiguous pass per field in getStats(). The window always covers
+ * exactly the most recent AVERAGING_SAMPLES readings no matter how long
+ * uploads keep failing. No heap is used and the footprint is fixed at
+ * compile time.
+ */
 class DataAveraging {
 private:
-    SensorData data;
+    SensorHistory<AVERAGING_SAMPLES> history;
+    // Single precision on purpose: the ESP32-S3 FPU has no double support,
+    // and recomputeStats() rebuilds the state from the buffer every lap
+    float means[SENSOR_FIELD_COUNT];
+    float m2[SENSOR_FIELD_COUNT];   // Sum of squared deviations from the mean
+    int lapPosition;                // Readings added since the last recomputeStats()
+
+    void recomputeStats();
     
 public:
     DataAveraging();
     
-    void addReading(float pm1, float pm25, float pm4, float pm10,
-                   float humidity, float temperature, float voc, float nox);
+    /**
+     * @brief Push a reading into the window, evicting the oldest when full
+     */
+    void addReading(const SensorData& reading);
+    
+    /**
+     * @brief Per-field mean of the readings in the window
+     *
+     * All fields are NaN when the window is empty.
+     */
+    SensorData getAveraged() const;
     
-    void getAveraged(float &pm1, float &pm25, float &pm4, float &pm10,
-                    float &humidity, float &temperature, float &voc, float &nox);
+    /**
+     * @brief Mean, variance, min and max of every field over the window
+     */
+    SensorStats getStats() const;
     
+    /**
+     * @brief Empty the window (call after a successful upload)
+     */
     void reset();
     
+    /**
+     * @brief Number of readings in the window (at most AVERAGING_SAMPLES)
+     */
     int getCount() const;
     
+    /**
+     * @brief True once the window holds MIN_RECORD_SAMPLES readings, enough for a record
+     */
     bool hasEnoughSamples() const;
 };
 
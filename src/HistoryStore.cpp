@@ -0,0 +1,235 @@
+/**
+ * @file HistoryStore.cpp
+ * @brief Implementation of the PSRAM reading history
+ */
+
+#include "HistoryStore.h"
+
+// SEN55 output resolution: PM 0.1 µg/m³, humidity 0.01 %, temperature
+// 0.005 °C, VOC and NOx index 0.1
+const float HistoryStore::SCALE[SENSOR_FIELD_COUNT] = {10, 10, 10, 10, 100, 200, 10, 10};
+
+HistoryStore::HistoryStore()
+    : memory(nullptr), blocks(nullptr), values(nullptr), deltas(nullptr), blockCount(0), head(0), usedBlocks(0),
+      total(0) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+HistoryStore::~HistoryStore() {
+    free(memory);
+}
+
+bool HistoryStore::begin(uint32_t capacity) {
+    if (memory) {
+        return true;
+    }
+    int count = (int)((capacity + BLOCK_SAMPLES - 1) / BLOCK_SAMPLES);
+    size_t valueBytes = (size_t)count * SENSOR_FIELD_COUNT * BLOCK_SAMPLES * sizeof(int16_t);
+    size_t bytes = (size_t)count * sizeof(Block) + valueBytes + (size_t)count * BLOCK_SAMPLES;
+    memory = (uint8_t*)(psramFound() ? ps_malloc(bytes) : malloc(bytes));
+    if (!memory) {
+        return false;
+    }
+    blocks = (Block*)memory;
+    values = (int16_t*)(memory + (size_t)count * sizeof(Block));
+    deltas = memory + (size_t)count * sizeof(Block) + valueBytes;
+    blockCount = count;
+    return true;
+}
+
+bool HistoryStore::add(uint32_t timestamp, const SensorData& reading) {
+    if (!memory) {
+        return false;
+    }
+    if (usedBlocks > 0 && timestamp <= blocks[head].end) {
+        if (timestamp < blocks[head].end) {
+            stats.rejected++;
+            return false;
+        }
+        stats.sameSecond++;
+    }
+    if (usedBlocks == 0 || blocks[head].count == BLOCK_SAMPLES || timestamp - blocks[head].end > MAX_DELTA) {
+        openBlock(timestamp);
+    }
+
+    Block& block = blocks[head];
+    uint32_t slot = block.count;
+    deltas[(size_t)head * BLOCK_SAMPLES + slot] = (uint8_t)(slot == 0 ? 0 : timestamp - block.end);
+    int16_t* fields = values + (size_t)head * SENSOR_FIELD_COUNT * BLOCK_SAMPLES;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        int16_t value = quantize((SensorField)f, reading.*SENSOR_FIELDS[f]);
+        fields[f * BLOCK_SAMPLES + slot] = value;
+        if (value < block.min[f]) block.min[f] = value;
+        if (value > block.max[f]) block.max[f] = value;
+        block.sum[f] += value;
+    }
+    block.end = timestamp;
+    block.count++;
+    total++;
+    stats.added++;
+    return true;
+}
+
+void HistoryStore::openBlock(uint32_t timestamp) {
+    if (usedBlocks == 0) {
+        head = 0;
+        usedBlocks = 1;
+    } else {
+        head = head + 1 == blockCount ? 0 : head + 1;
+        if (usedBlocks == blockCount) {
+            total -= blocks[head].count; // The ring is full: the oldest block goes
+            stats.blocksDropped++;
+        } else {
+            usedBlocks++;
+        }
+    }
+    Block& block = blocks[head];
+    block.start = timestamp;
+    block.end = timestamp;
+    block.count = 0;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        block.min[f] = INT16_MAX;
+        block.max[f] = INT16_MIN;
+        block.sum[f] = 0;
+    }
+}
+
+int HistoryStore::query(uint32_t from, uint32_t to, SensorField field, int points, Visitor visit, void* context) {
+    stats.queries++;
+    if (usedBlocks == 0 || points <= 0 || to < from) {
+        return 0;
+    }
+    Query query;
+    query.from = from;
+    query.step = bucketSeconds(from, to, points);
+    query.field = field;
+    query.visit = visit;
+    query.context = context;
+    query.bucket = -1;
+    query.count = 0;
+    query.reported = 0;
+
+    // First block that ends at or after from (blocks are in time order)
+    int low = 0;
+    int high = usedBlocks;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (blockAt(middle).end < from) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (int i = low; i < usedBlocks; i++) {
+        int index = physical(i);
+        const Block& block = blocks[index];
+        if (block.start > to) {
+            break;
+        }
+        // Inside the range and inside one bucket: the header is enough
+        if (block.start >= from && block.end <= to
+            && (block.start - from) / query.step == (block.end - from) / query.step) {
+            merge(query, (block.start - from) / query.step, block.min[field], block.max[field], block.sum[field],
+                  block.count);
+            stats.blocksSummarized++;
+            continue;
+        }
+        const uint8_t* delta = deltas + (size_t)index * BLOCK_SAMPLES;
+        const int16_t* value = values + ((size_t)index * SENSOR_FIELD_COUNT + field) * BLOCK_SAMPLES;
+        uint32_t time = block.start;
+        for (uint32_t slot = 0; slot < block.count; slot++) {
+            time += delta[slot];
+            if (time < from) {
+                continue;
+            }
+            if (time > to) {
+                break;
+            }
+            merge(query, (time - from) / query.step, value[slot], value[slot], value[slot], 1);
+        }
+        stats.samplesScanned += block.count;
+    }
+    if (query.count > 0) {
+        emit(query);
+    }
+    return query.reported;
+}
+
+void HistoryStore::merge(Query& query, int64_t bucket, int32_t min, int32_t max, int64_t sum, uint32_t count) {
+    if (bucket != query.bucket) {
+        if (query.count > 0) {
+            emit(query);
+        }
+        query.bucket = bucket;
+        query.min = min;
+        query.max = max;
+        query.sum = 0;
+        query.count = 0;
+    }
+    if (min < query.min) query.min = min;
+    if (max > query.max) query.max = max;
+    query.sum += sum;
+    query.count += count;
+}
+
+void HistoryStore::emit(Query& query) {
+    float scale = SCALE[query.field];
+    HistoryPoint point;
+    point.time = (uint32_t)(query.from + query.bucket * query.step);
+    point.count = query.count;
+    point.min = query.min / scale;
+    point.mean = (float)((double)query.sum / query.count / scale);
+    point.max = query.max / scale;
+    query.visit(point, query.context);
+    query.reported++;
+}
+
+uint32_t HistoryStore::size() const {
+    return total;
+}
+
+uint32_t HistoryStore::capacity() const {
+    return (uint32_t)blockCount * BLOCK_SAMPLES;
+}
+
+uint32_t HistoryStore::oldest() const {
+    return usedBlocks == 0 ? 0 : blockAt(0).start;
+}
+
+uint32_t HistoryStore::newest() const {
+    return usedBlocks == 0 ? 0 : blocks[head].end;
+}
+
+size_t HistoryStore::memoryBytes() const {
+    return (size_t)blockCount * (sizeof(Block) + SENSOR_FIELD_COUNT * BLOCK_SAMPLES * sizeof(int16_t) + BLOCK_SAMPLES);
+}
+
+uint64_t HistoryStore::bucketSeconds(uint32_t from, uint32_t to, int points) {
+    return points <= 0 || to < from ? 0 : ((uint64_t)to - from + (uint64_t)points) / (uint64_t)points;
+}
+
+float HistoryStore::quantized(SensorField field, float value) {
+    return quantize(field, value) / SCALE[field];
+}
+
+int16_t HistoryStore::quantize(SensorField field, float value) {
+    float scaled = roundf(value * SCALE[field]);
+    if (isnan(scaled)) return 0;
+    if (scaled > INT16_MAX) return INT16_MAX;
+    if (scaled < INT16_MIN) return INT16_MIN;
+    return (int16_t)scaled;
+}
+
+int HistoryStore::physical(int index) const {
+    int slot = head - usedBlocks + 1 + index;
+    return slot < 0 ? slot + blockCount : slot;
+}
+
+const HistoryStore::Block& HistoryStore::blockAt(int index) const {
+    return blocks[physical(index)];
+}
+
+const HistoryStoreStats& HistoryStore::getStats() const {
+    return stats;
+}
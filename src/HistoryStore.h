@@ -0,0 +1,148 @@
+/**
+ * @file HistoryStore.h
+ * @brief Days of per-second readings in PSRAM, with downsampled range queries
+ *
+ * Readings are kept in blocks of BLOCK_SAMPLES. Each field is stored as a
+ * 16-bit integer at the SEN55's own output resolution (SCALE), so what
+ * comes back is exactly what the sensor reported; each timestamp is the
+ * seconds since the previous reading in one byte, and the block header
+ * holds the first and last timestamp and per-field min, max and sum. That
+ * is under 18 bytes per reading, against 36 for a SensorData and its
+ * timestamp. The blocks form a ring: when it is full, the oldest block is
+ * dropped. A gap of more than MAX_DELTA seconds starts a new block. Two
+ * readings in the same second (a sensor period drifting under a second,
+ * samples queued during a stall) are both kept, with a step of 0.
+ *
+ * query() splits a time range into equal buckets and reports min, mean and
+ * max per bucket. A min/max envelope keeps a short spike that LTTB or
+ * plain decimation may drop, and unlike them needs no pass over every
+ * reading: a block that lies inside one bucket contributes its header,
+ * and only blocks that straddle a bucket edge are decoded reading by
+ * reading. A query therefore costs at most every block header plus
+ * BLOCK_SAMPLES readings per bucket, however long the range.
+ *
+ * Storage is allocated once by begin(), in PSRAM when the board has it.
+ * Readings and queries run in the same task.
+ */
+
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <Arduino.h>
+#include "SensorData.h"
+
+/**
+ * @brief One bucket of a query: the readings from time to time + step - 1
+ */
+struct HistoryPoint {
+    uint32_t time;   // Bucket start (same clock as add())
+    uint32_t count;  // Readings in the bucket (empty buckets are not reported)
+    float min;
+    float mean;
+    float max;
+};
+
+struct HistoryStoreStats {
+    uint32_t added;           // Readings stored
+    uint32_t sameSecond;      // Readings stored with the newest one's timestamp (two samples in one second)
+    uint32_t rejected;        // Readings older than the newest stored (clock stepped back)
+    uint32_t blocksDropped;   // Oldest blocks overwritten when the ring was full
+    uint32_t queries;
+    uint64_t blocksSummarized; // Blocks a query took from their header
+    uint64_t samplesScanned;  // Readings a query decoded one by one
+};
+
+class HistoryStore {
+public:
+    static const int BLOCK_SAMPLES = 128;
+    static const uint32_t MAX_DELTA = 255;                 // Seconds one timestamp byte can hold
+    static const uint32_t DEFAULT_CAPACITY = 3 * 86400;    // Three days at one reading per second
+    static const float SCALE[SENSOR_FIELD_COUNT];          // Stored value = reading * SCALE
+
+    /** Called by query() for each non-empty bucket, oldest first */
+    typedef void (*Visitor)(const HistoryPoint& point, void* context);
+
+    HistoryStore();
+    ~HistoryStore();
+
+    /**
+     * @brief Allocate room for capacity readings (rounded up to whole blocks)
+     *
+     * @return false if the memory is not available; add() then stores nothing
+     */
+    bool begin(uint32_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Store a validated reading
+     *
+     * @param timestamp Seconds (Unix time on the device); must not decrease
+     * @return false if the store is not allocated or timestamp is older than the newest
+     */
+    bool add(uint32_t timestamp, const SensorData& reading);
+
+    /**
+     * @brief Min, mean and max of one field per bucket over [from, to]
+     *
+     * @param points Number of buckets; each spans ceil((to - from + 1) / points) seconds
+     * @return Buckets reported (those holding at least one reading)
+     */
+    int query(uint32_t from, uint32_t to, SensorField field, int points, Visitor visit, void* context);
+
+    uint32_t size() const;
+    uint32_t capacity() const;
+    uint32_t oldest() const;  // Time of the oldest reading held; 0 when empty
+    uint32_t newest() const;  // Time of the newest; 0 when empty
+    size_t memoryBytes() const;
+
+    /** Seconds per bucket of query(from, to, ..., points, ...) */
+    static uint64_t bucketSeconds(uint32_t from, uint32_t to, int points);
+
+    /** Value a reading's field is stored and reported as (rounded to SCALE) */
+    static float quantized(SensorField field, float value);
+
+    const HistoryStoreStats& getStats() const;
+
+private:
+    struct Block {
+        uint32_t start;  // Time of the first reading
+        uint32_t end;    // Time of the last
+        uint32_t count;
+        int16_t min[SENSOR_FIELD_COUNT];
+        int16_t max[SENSOR_FIELD_COUNT];
+        int32_t sum[SENSOR_FIELD_COUNT];
+    };
+
+    // A query in progress: the bucket being accumulated and where it goes
+    struct Query {
+        uint32_t from;
+        uint64_t step;     // Seconds per bucket
+        SensorField field;
+        Visitor visit;
+        void* context;
+        int64_t bucket;    // Index of the bucket accumulated; -1 before the first reading
+        int32_t min;
+        int32_t max;
+        int64_t sum;
+        uint32_t count;
+        int reported;
+    };
+
+    uint8_t* memory;  // One allocation: blocks, then values, then deltas
+    Block* blocks;
+    int16_t* values;  // Per block, per field, BLOCK_SAMPLES values
+    uint8_t* deltas;  // Per block, seconds since the previous reading (0 for the first)
+    int blockCount;
+    int head;         // Block being filled
+    int usedBlocks;
+    uint32_t total;
+    HistoryStoreStats stats;
+
+    static int16_t quantize(SensorField field, float value);
+    const Block& blockAt(int index) const;  // 0 = oldest held
+    int physical(int index) const;
+    void openBlock(uint32_t timestamp);
+    static void merge(Query& query, int64_t bucket, int32_t min, int32_t max, int64_t sum, uint32_t count);
+    static void emit(Query& query);
+};
+
+#endif // HISTORY_STORE_H
@@ -0,0 +1,71 @@
+/**
+ * @file JsonSnapshot.cpp
+ * @brief Implementation of the double-buffered JSON response
+ */
+
+#include "JsonSnapshot.h"
+
+JsonSnapshot::JsonSnapshot() : current(NONE), editing(NONE) {
+    memset(buffers, 0, sizeof(buffers));
+    memset(&stats, 0, sizeof(stats));
+}
+
+char* JsonSnapshot::edit() {
+    int spare = current == NONE ? 0 : 1 - current;
+    if (buffers[spare].readers > 0) {
+        stats.skipped++;
+        editing = NONE;
+        return nullptr;
+    }
+    editing = spare;
+    return buffers[spare].data + HEADER_ROOM;
+}
+
+bool JsonSnapshot::publish(size_t length) {
+    if (editing == NONE) {
+        return false;
+    }
+    Buffer& buffer = buffers[editing];
+    editing = NONE;
+    if (length >= MAX_BODY) {
+        stats.overflows++; // snprintf() truncated it: not valid JSON
+        return false;
+    }
+
+    char header[HEADER_ROOM];
+    int headerLength = snprintf(header, sizeof(header),
+                                "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                "Cache-Control: no-store\r\nContent-Length: %u\r\n\r\n", (unsigned)length);
+    buffer.start = (uint16_t)(HEADER_ROOM - headerLength);
+    memcpy(buffer.data + buffer.start, header, headerLength);
+    buffer.length = (uint16_t)(headerLength + length);
+    current = (int)(&buffer - buffers);
+    stats.published++;
+    return true;
+}
+
+bool JsonSnapshot::isEmpty() const {
+    return current == NONE;
+}
+
+int JsonSnapshot::acquire(const uint8_t*& data, size_t& length) {
+    if (current == NONE) {
+        return NONE;
+    }
+    Buffer& buffer = buffers[current];
+    buffer.readers++;
+    data = (const uint8_t*)buffer.data + buffer.start;
+    length = buffer.length;
+    stats.served++;
+    return current;
+}
+
+void JsonSnapshot::release(int buffer) {
+    if (buffer != NONE && buffers[buffer].readers > 0) {
+        buffers[buffer].readers--;
+    }
+}
+
+const JsonSnapshotStats& JsonSnapshot::getStats() const {
+    return stats;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file JsonSnapshot.h
+ * @brief Double-buffered, precomposed HTTP response for a JSON endpoint
+ *
+ * Data that changes once per reading is serialized once per reading, not
+ * once per request: the producer writes the JSON body with edit() and
+ * publish(), which puts the HTTP status line and headers (with the
+ * Content-Length) in front of it in the same buffer, and every request
+ * until the next publish() is answered by writing that one buffer to the
+ * socket as it is. Nothing is copied or allocated per request.
+ *
+ * A response to a slow client can still be going out when the next reading
+ * arrives, so there are two buffers: new requests get the current one, the
+ * producer fills the other. A sender pins its buffer with acquire() until
+ * release(); if the other buffer is still pinned when the producer wants
+ * it, that update is skipped and the current response stays in place (the
+ * next reading will try again). Producer and servers run in the same task.
+ */
+
+#ifndef JSON_SNAPSHOT_H
+#define JSON_SNAPSHOT_H
+
+#include <Arduino.h>
+
+struct JsonSnapshotStats {
+    uint32_t published;  // Bodies made current
+    uint32_t skipped;    // Updates dropped because both buffers were being sent
+    uint32_t overflows;  // Bodies that did not fit MAX_BODY (not published)
+    uint32_t served;     // Responses started from this snapshot
+};
+
+class JsonSnapshot {
+public:
+    static const size_t CAPACITY = 768;     // Header and body of one response
+    static const size_t HEADER_ROOM = 128;  // Reserved in front of the body for the status line and headers
+    static const size_t MAX_BODY = CAPACITY - HEADER_ROOM;
+    static const int NONE = -1;
+
+    JsonSnapshot();
+
+    /**
+     * @brief Buffer for the next body (MAX_BODY bytes)
+     *
+     * @return nullptr if the spare buffer is still being sent; skip this update
+     */
+    char* edit();
+
+    /**
+     * @brief Make the body written into edit()'s buffer the current response
+     *
+     * @return false if nothing was being edited or length does not fit MAX_BODY
+     */
+    bool publish(size_t length);
+
+    bool isEmpty() const;
+
+    /**
+     * @brief Pin the current response for sending
+     *
+     * @param data Receives the complete response (header and body)
+     * @param length Receives its length
+     * @return Buffer to pass to release(), or NONE if nothing was published yet
+     */
+    int acquire(const uint8_t*& data, size_t& length);
+    void release(int buffer);
+
+    const JsonSnapshotStats& getStats() const;
+
+private:
+    struct Buffer {
+        char data[CAPACITY];
+        uint16_t start;    // Offset of the status line in data
+        uint16_t length;   // Header and body
+        uint16_t readers;  // Responses still being written from this buffer
+    };
+
+    Buffer buffers[2];
+    int current;  // Served to new requests; NONE before the first publish()
+    int editing;  // Handed out by edit(); NONE otherwise
+    JsonSnapshotStats stats;
+};
+
+#endif // JSON_SNAPSHOT_H
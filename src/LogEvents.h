@@ -0,0 +1,89 @@
+/**
+ * @file LogEvents.h
+ * @brief Every message the firmware logs at run time, by event id
+ *
+ * Each entry pairs an id with a printf-style format. Call sites pass only
+ * the id and the numeric arguments; the format is looked up when the log
+ * task prints the record. `%s` arguments must point to storage that
+ * outlives the record (string literals, config constants). Integer
+ * conversions take 32-bit values, so length modifiers (`%lu`) are optional.
+ */
+
+#ifndef LOG_EVENTS_H
+#define LOG_EVENTS_H
+
+#define LOG_EVENTS(X) \
+    /* Sensor */ \
+    X(LOG_SENSOR_TASK_RUNNING, "✓ Sensor task running on core %d") \
+    X(LOG_SENSOR_STARTED, "✓ Sensor measurements started") \
+    X(LOG_SENSOR_STOPPED, "✓ Sensor measurements stopped") \
+    X(LOG_SENSOR_START_ERROR, "✗ ERROR starting measurement (error 0x%04x)") \
+    X(LOG_SENSOR_STOP_ERROR, "✗ ERROR stopping measurement (error 0x%04x)") \
+    X(LOG_SENSOR_NOT_INITIALIZED, "✗ Sensor not initialized") \
+    X(LOG_SENSOR_READ_ERROR, "✗ ERROR reading sensor (error 0x%04x)") \
+    X(LOG_SENSOR_READY_ERROR, "✗ ERROR reading data-ready flag (error 0x%04x)") \
+    X(LOG_SENSOR_WARMING_UP, "⏳ Sensor warming up | PM2.5:%.1f µg/m³ | Temp/Hum %s | VOC/NOx %s") \
+    X(LOG_SENSOR_READY, "✓ Sensor ready: first valid sample %lu ms after boot (%u warm-up readings)") \
+    X(LOG_SAMPLE_READ_FAILED, "⚠️  Check wiring! Skipping this reading...") \
+    X(LOG_SAMPLE_INVALID, "⚠️  WARNING: Invalid sensor data detected\n   Check I2C connections and power supply!") \
+    X(LOG_SAMPLE, "PM1.0:%.1f | PM2.5:%.1f µg/m³ %s [%s] | PM4:%.1f | PM10:%.1f | Temp:%.1f°C | Hum:%.1f%%" \
+                  " | VOC:%d | NOx:%d | Avg:%u/%u | Record in %us | Batch:%u/%u") \
+    X(LOG_SAMPLE_RECORD_DUE, "PM1.0:%.1f | PM2.5:%.1f µg/m³ %s [%s] | PM4:%.1f | PM10:%.1f | Temp:%.1f°C" \
+                             " | Hum:%.1f%% | VOC:%d | NOx:%d | Avg:%u/%u | Batch:%u/%u") \
+    /* Records */ \
+    X(LOG_RECORD_AVERAGED, "\n📊 Averaged record (%u samples, PM2.5 %.1f-%.1f σ %.2f)") \
+    X(LOG_RECORD_INVALID, "✗ Skipping record - invalid data detected") \
+    X(LOG_RECORD_COLLECTING, "\n⏳ Collecting more samples (%u/%u) before the next record...") \
+    X(LOG_RECORD_LOST, "⚠️  Offline queue unavailable - record lost") \
+    X(LOG_RECORDS_QUEUED, "💾 Queued for later upload (%u waiting)") \
+    /* Uploads */ \
+    X(LOG_UPLOAD_ENCODE_FAILED, "✗ Skipping upload - records could not be encoded") \
+    X(LOG_UPLOAD_WIFI_DOWN, "✗ WiFi down - keeping records for later") \
+    X(LOG_UPLOAD_BACKLOG, "📤 Uploading queued records (%u waiting)") \
+    X(LOG_UPLOAD_START, "\n--- Uploading %d records to ThingSpeak ---") \
+    X(LOG_UPLOAD_ACCEPTED, "HTTP Response Code: %d\n✓ SUCCESS! Bulk update accepted") \
+    X(LOG_UPLOAD_REJECTED, "HTTP Response Code: %d\n✗ Upload failed - check API key or rate limit") \
+    X(LOG_UPLOAD_HTTP_ERROR, "✗ HTTP Error Code: %d\nError: %s") \
+    X(LOG_UPLOAD_TIMING_REUSED, "Connect: reused | Transfer: %u ms") \
+    X(LOG_UPLOAD_TIMING, "Connect: %u ms | Transfer: %u ms") \
+    X(LOG_UPLOAD_END, "-------------------------------\n") \
+    /* MQTT */ \
+    X(LOG_MQTT_CONNECTED, "✓ MQTT connected to %s (%s session, %u messages to resend)") \
+    X(LOG_MQTT_CONNECT_FAILED, "✗ MQTT connect to %s failed: %s - retrying in %u s") \
+    X(LOG_MQTT_TIMEOUT, "⚠️  MQTT broker silent for %u s - reconnecting") \
+    X(LOG_MQTT_PUBLISHED, "📤 MQTT: %d records published (%d unacknowledged)") \
+    X(LOG_MQTT_WINDOW_FULL, "⚠️  MQTT window full (%d unacknowledged) - keeping records for later") \
+    /* WiFi */ \
+    X(LOG_WIFI_CONNECTING, "Connecting to WiFi: %s") \
+    X(LOG_WIFI_RETRY, "⟳ WiFi attempt %u failed (reason %u), retrying in %.1f s") \
+    X(LOG_WIFI_CONNECTED, "✓ WiFi connected after %u %s, IP address: %u.%u.%u.%u") \
+    X(LOG_WIFI_LINK_LOST, "✗ WiFi link lost (reason %u), reconnecting in the background") \
+    /* OTA */ \
+    X(LOG_OTA_CONFIGURING, "Configuring OTA updates...") \
+    X(LOG_OTA_READY, "✓ OTA Ready!\n  Hostname: %s\n  IP: %u.%u.%u.%u\n  Upload via: Tools → Port → Network ports\n") \
+    X(LOG_OTA_START, "\n🔄 OTA: Starting update (%s)\n⚠️  Do not power off!") \
+    X(LOG_OTA_PROGRESS, "OTA Progress: %u%%") \
+    X(LOG_OTA_END, "\n✓ OTA: Update complete!\nRebooting...") \
+    X(LOG_OTA_ERROR, "\n✗ OTA Error[%u]: %s") \
+    /* Dashboard */ \
+    X(LOG_WEB_READY, "🌐 Web Dashboard: http://%u.%u.%u.%u/\n📱 Mobile Access: http://%s.local/\n") \
+    /* Power */ \
+    X(LOG_POWER_MODE, "⚡ Power mode: %s (light sleep %s, WiFi modem sleep %s)") \
+    X(LOG_POWER_STATS, "⚡ loop() idle %.1f%%, %u wakeups (%u by samples) in the last %u s") \
+    /* Metrics */ \
+    X(LOG_METRICS_TIMING, "📈 loop p50 %u p99 %u max %u us | sensor read p99 %u max %u us | upload p99 %u max %u ms | web poll p99 %u us") \
+    X(LOG_METRICS_HEAP, "📈 heap %u free (low %u), largest block %u (%.0f%% fragmented) | PSRAM %u free | %u readings in history") \
+    X(LOG_METRICS_FILTER, "📈 filter: %u readings | outliers pm1 %u pm2.5 %u pm4 %u pm10 %u rh %u t %u voc %u nox %u | %u rate-limited") \
+    /* Trace */ \
+    X(LOG_TRACE_FULL, "⚠️  Trace flash budget (%u KB) full - recording stopped") \
+    /* Logger */ \
+    X(LOG_RECORDS_DROPPED, "⚠️  Log buffer full: %u messages dropped")
+
+#define LOG_EVENT_ID(id, format) id,
+enum LogEvent {
+    LOG_EVENTS(LOG_EVENT_ID)
+    LOG_EVENT_COUNT
+};
+#undef LOG_EVENT_ID
+
+#endif // LOG_EVENTS_H
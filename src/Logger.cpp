@@ -0,0 +1,222 @@
+/**
+ * @file Logger.cpp
+ * @brief Implementation of the deferred logger and its print task
+ */
+
+#include "Logger.h"
+
+Logger Log;
+
+namespace {
+    #define LOG_EVENT_FORMAT(id, format) format,
+    const char* const FORMATS[LOG_EVENT_COUNT] = {
+        LOG_EVENTS(LOG_EVENT_FORMAT)
+    };
+    #undef LOG_EVENT_FORMAT
+
+    int32_t asInt(LogValue value, int type) {
+        if (type == LOG_ARG_FLOAT) return (int32_t)value.f;
+        if (type == LOG_ARG_STRING) return 0;
+        return value.i;
+    }
+
+    uint32_t asUnsigned(LogValue value, int type) {
+        if (type == LOG_ARG_FLOAT) return (uint32_t)value.f;
+        if (type == LOG_ARG_STRING) return 0;
+        return value.u;
+    }
+
+    double asDouble(LogValue value, int type) {
+        if (type == LOG_ARG_INT) return value.i;
+        if (type == LOG_ARG_UINT) return value.u;
+        if (type == LOG_ARG_STRING) return 0.0;
+        return value.f;
+    }
+}
+
+Logger::Logger()
+    : threshold(LOG_LEVEL_DEBUG), handle(nullptr), printedThrough(0), idle(false), reportedDrops(0) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void Logger::setLevel(LogLevel level) {
+    threshold.store(level, std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() const {
+    return (LogLevel)threshold.load(std::memory_order_relaxed);
+}
+
+bool Logger::start(BaseType_t core, UBaseType_t priority) {
+    if (handle) {
+        return true;
+    }
+    return xTaskCreatePinnedToCore(taskEntry, "log", STACK_BYTES, this, priority, &handle, core) == pdPASS;
+}
+
+void Logger::flush(uint32_t timeoutMs) {
+    if (!handle) {
+        return;
+    }
+    unsigned long start = millis();
+    while ((!ring.isEmpty() || printedThrough.load(std::memory_order_acquire) != ring.popped())
+           && millis() - start < timeoutMs) {
+        vTaskDelay(1);
+    }
+}
+
+LoggerStats Logger::getStats() const {
+    LoggerStats snapshot = stats;
+    snapshot.dropped = ring.getDropped();
+    return snapshot;
+}
+
+const char* Logger::formatOf(LogEvent event) {
+    return (unsigned)event < LOG_EVENT_COUNT ? FORMATS[event] : "?";
+}
+
+void Logger::append(LogLevel level, LogEvent event, const LogArg* values, int count) {
+    LogRecord record;
+    record.level = (uint8_t)level;
+    record.event = (uint8_t)event;
+    record.argCount = (uint8_t)count;
+    record.types = 0;
+    for (int i = 0; i < count; i++) {
+        record.args[i] = values[i].value;
+        record.types |= (uint32_t)values[i].type << (2 * i);
+    }
+
+    if (!handle) {
+        print(record); // Not started yet: keep boot output in order
+        return;
+    }
+    if (!ring.push(record)) {
+        return; // A full ring counts the drop; the log task is awake and reports it
+    }
+    // Pairs with the fence in run(): either the task sees this record or we see it idle
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idle.load(std::memory_order_relaxed) && idle.exchange(false)) {
+        xTaskNotifyGive(handle);
+    }
+}
+
+size_t Logger::format(const LogRecord& record, char* out, size_t size) {
+    const char* fmt = formatOf((LogEvent)record.event);
+    size_t length = 0;
+    int arg = 0;
+    char spec[16];
+
+    while (*fmt && length + 1 < size) {
+        if (*fmt != '%') {
+            out[length++] = *fmt++;
+            continue;
+        }
+        if (fmt[1] == '%') {
+            out[length++] = '%';
+            fmt += 2;
+            continue;
+        }
+
+        // Keep flags, width and precision; drop length modifiers (all integers are 32-bit)
+        size_t n = 0;
+        spec[n++] = *fmt++;
+        while (*fmt && strchr("-+ #0123456789.", *fmt) && n < sizeof(spec) - 2) {
+            spec[n++] = *fmt++;
+        }
+        while (*fmt && strchr("hlLjzt", *fmt)) {
+            fmt++;
+        }
+        char conversion = *fmt;
+        if (!conversion) {
+            break;
+        }
+        fmt++;
+        spec[n++] = conversion;
+        spec[n] = '\0';
+
+        char* dest = out + length;
+        size_t room = size - length;
+        int written = 0;
+        if (arg >= record.argCount) {
+            written = snprintf(dest, room, "?");
+        } else {
+            LogValue value = record.args[arg];
+            int type = (record.types >> (2 * arg)) & 3;
+            arg++;
+            switch (conversion) {
+                case 'd': case 'i': case 'c':
+                    written = snprintf(dest, room, spec, (int)asInt(value, type));
+                    break;
+                case 'u': case 'x': case 'X': case 'o':
+                    written = snprintf(dest, room, spec, (unsigned)asUnsigned(value, type));
+                    break;
+                case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+                    written = snprintf(dest, room, spec, asDouble(value, type));
+                    break;
+                case 's':
+                    written = snprintf(dest, room, spec,
+                                       type == LOG_ARG_STRING && value.s ? value.s : "?");
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (written > 0) {
+            length += (size_t)written < room ? (size_t)written : room - 1;
+        }
+    }
+    out[length] = '\0';
+    return length;
+}
+
+void Logger::print(const LogRecord& record) {
+    char line[LINE_BYTES + 2];
+    size_t length = format(record, line, LINE_BYTES);
+    line[length++] = '\r';
+    line[length++] = '\n';
+    Serial.write((const uint8_t*)line, length);
+    stats.printed++;
+    stats.bytes += length;
+}
+
+void Logger::taskEntry(void* self) {
+    static_cast<Logger*>(self)->run();
+}
+
+void Logger::run() {
+    for (;;) {
+        uint32_t depth = ring.size();
+        if (depth > stats.maxDepth) {
+            stats.maxDepth = depth;
+        }
+
+        LogRecord record;
+        while (ring.pop(record)) {
+            print(record);
+            printedThrough.store(ring.popped(), std::memory_order_release);
+        }
+
+        uint32_t dropped = ring.getDropped();
+        if (dropped != reportedDrops) {
+            LogRecord notice;
+            notice.level = LOG_LEVEL_WARN;
+            notice.event = LOG_RECORDS_DROPPED;
+            notice.argCount = 1;
+            notice.types = LOG_ARG_UINT;
+            notice.args[0].u = dropped - reportedDrops;
+            reportedDrops = dropped;
+            print(notice);
+        }
+
+        idle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ring.isEmpty()) {
+            idle.store(false, std::memory_order_relaxed); // Arrived meanwhile; the writer may not have seen idle
+            if (!ring.headReady()) {
+                vTaskDelay(1); // Claimed but not yet published: let the (preempted) writer finish
+            }
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
@@ -0,0 +1,166 @@
+/**
+ * @file Logger.h
+ * @brief Deferred, ring-buffered logging
+ *
+ * Formatting a status line with Serial.print costs the caller far more
+ * than the line is worth: the UART drains at 11.5 kB/s and Serial.write
+ * blocks once the 128-byte FIFO is full, so a 200-byte line holds loop()
+ * for several milliseconds. Here the caller only stores a compact binary
+ * record (level, event id, up to 16 numeric or static-string arguments)
+ * in a lock-free ring and returns; a low-priority task looks up the
+ * event's format (LogEvents.h), prints the text and absorbs the UART wait.
+ * Once the ring is empty the task blocks until the next record arrives
+ * (only the caller that finds it idle notifies it), so an idle logger
+ * never wakes the chip from light sleep.
+ *
+ * Records below the runtime level are discarded before anything is copied.
+ * A full ring drops the new record, never blocks, and the log task reports
+ * how many were lost. Until start() is called (during setup()) records are
+ * printed synchronously, so boot messages keep their order with direct
+ * Serial output.
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "LogEvents.h"
+#include "MpscQueue.h"
+
+#include <atomic>
+
+enum LogLevel {
+    LOG_LEVEL_NONE,   // Logging off
+    LOG_LEVEL_ERROR,  // The device cannot do its job (sensor, bus)
+    LOG_LEVEL_WARN,   // Something failed and will be retried or skipped
+    LOG_LEVEL_INFO,   // Records, uploads, connectivity
+    LOG_LEVEL_DEBUG   // Every sample and upload timing
+};
+
+enum LogArgType {
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_FLOAT,
+    LOG_ARG_STRING
+};
+
+union LogValue {
+    int32_t i;
+    uint32_t u;
+    float f;
+    const char* s;  // Must outlive the record
+};
+
+/**
+ * @brief One argument, tagged with its type so the formatter can convert
+ */
+struct LogArg {
+    LogArg(int v) : type(LOG_ARG_INT) { value.i = v; }
+    LogArg(long v) : type(LOG_ARG_INT) { value.i = (int32_t)v; }
+    LogArg(unsigned int v) : type(LOG_ARG_UINT) { value.u = v; }
+    LogArg(unsigned long v) : type(LOG_ARG_UINT) { value.u = (uint32_t)v; }
+    LogArg(float v) : type(LOG_ARG_FLOAT) { value.f = v; }
+    LogArg(double v) : type(LOG_ARG_FLOAT) { value.f = (float)v; }
+    LogArg(const char* v) : type(LOG_ARG_STRING) { value.s = v; }
+
+    uint8_t type;
+    LogValue value;
+};
+
+static const int LOG_MAX_ARGS = 16;
+
+/**
+ * @brief What travels through the ring: 72 bytes on the ESP32
+ */
+struct LogRecord {
+    uint8_t level;
+    uint8_t event;
+    uint8_t argCount;
+    uint32_t types;  // 2 bits per argument (LogArgType)
+    LogValue args[LOG_MAX_ARGS];
+};
+
+struct LoggerStats {
+    uint32_t printed;  // Records formatted and written to Serial
+    uint32_t dropped;  // Records lost to a full ring
+    uint32_t maxDepth; // Most records waiting at once
+    uint32_t bytes;    // Text written to Serial
+};
+
+class Logger {
+public:
+    static const uint32_t CAPACITY = 64;      // Records; absorbs an upload's burst plus a second of samples
+    static const uint32_t STACK_BYTES = 3072;
+    static const size_t LINE_BYTES = 256;     // Longest formatted message
+
+    Logger();
+
+    /** Messages above this level are discarded at the call site */
+    void setLevel(LogLevel level);
+    LogLevel getLevel() const;
+
+    /**
+     * @brief Create the log task; from then on records are deferred
+     *
+     * @return false if FreeRTOS could not create it (logging stays synchronous)
+     */
+    bool start(BaseType_t core, UBaseType_t priority);
+
+    /** Wait (up to timeoutMs) until the log task has printed everything queued, e.g. before a reboot */
+    void flush(uint32_t timeoutMs);
+
+    template <typename... Args>
+    void log(LogLevel level, LogEvent event, Args... args) {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+        if (level > threshold.load(std::memory_order_relaxed)) {
+            return;
+        }
+        const LogArg values[] = {LogArg(args)...};
+        append(level, event, values, sizeof...(Args));
+    }
+
+    void log(LogLevel level, LogEvent event) {
+        if (level > threshold.load(std::memory_order_relaxed)) {
+            return;
+        }
+        append(level, event, nullptr, 0);
+    }
+
+    template <typename... Args> void error(LogEvent event, Args... args) { log(LOG_LEVEL_ERROR, event, args...); }
+    template <typename... Args> void warn(LogEvent event, Args... args) { log(LOG_LEVEL_WARN, event, args...); }
+    template <typename... Args> void info(LogEvent event, Args... args) { log(LOG_LEVEL_INFO, event, args...); }
+    template <typename... Args> void debug(LogEvent event, Args... args) { log(LOG_LEVEL_DEBUG, event, args...); }
+
+    /**
+     * @brief Render a record as text (no line ending)
+     *
+     * @return Length written, truncated to size - 1
+     */
+    static size_t format(const LogRecord& record, char* out, size_t size);
+
+    /** The printf-style format of an event */
+    static const char* formatOf(LogEvent event);
+
+    /** Written only by the log task; 32-bit fields, so reads from other tasks are never torn */
+    LoggerStats getStats() const;
+
+private:
+    MpscQueue<LogRecord, CAPACITY> ring;
+    std::atomic<int> threshold;
+    TaskHandle_t handle;
+    std::atomic<uint32_t> printedThrough;  // ring.popped() once the popped record is on the UART
+    std::atomic<bool> idle;   // Log task found the ring empty and waits for a notification
+    uint32_t reportedDrops;  // Ring drops already announced
+    LoggerStats stats;
+
+    void append(LogLevel level, LogEvent event, const LogArg* values, int count);
+    void print(const LogRecord& record);
+    static void taskEntry(void* self);
+    void run();
+};
+
+extern Logger Log;
+
+#endif // LOGGER_H
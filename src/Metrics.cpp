@@ -0,0 +1,129 @@
+/**
+ * @file Metrics.cpp
+ * @brief Implementation of the metrics and their Prometheus rendering
+ */
+
+#include "Metrics.h"
+
+namespace {
+    size_t result(int written, size_t capacity) {
+        return written < 0 ? capacity : (size_t)written;
+    }
+}
+
+MetricHistogram::MetricHistogram() : sumMicros(0), maxMicros(0) {
+    for (int i = 0; i < BUCKETS; i++) {
+        counts[i] = 0;
+    }
+}
+
+uint32_t MetricHistogram::count() const {
+    uint32_t total = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        total += counts[i];
+    }
+    return total;
+}
+
+uint32_t MetricHistogram::bucketBound(int bucket) {
+    return bucket >= BUCKETS - 1 ? UINT32_MAX : (uint32_t)1 << bucket;
+}
+
+uint32_t MetricHistogram::percentile(float q) const {
+    uint32_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)ceilf(q * total);
+    if (rank < 1) rank = 1;
+    uint32_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint32_t bound = bucketBound(i);
+            return bound < maxMicros ? bound : maxMicros;
+        }
+    }
+    return maxMicros;
+}
+
+MetricsRegistry::MetricsRegistry() : count(0) {
+    memset(entries, 0, sizeof(entries));
+}
+
+bool MetricsRegistry::addCounter(const char* name, const char* help, const MetricCounter& counter) {
+    return add(name, help, COUNTER, &counter);
+}
+
+bool MetricsRegistry::addGauge(const char* name, const char* help, const MetricGauge& gauge) {
+    return add(name, help, GAUGE, &gauge);
+}
+
+bool MetricsRegistry::addHistogram(const char* name, const char* help, const MetricHistogram& histogram) {
+    return add(name, help, HISTOGRAM, &histogram);
+}
+
+bool MetricsRegistry::add(const char* name, const char* help, MetricType type, const void* metric) {
+    if (count >= MAX_METRICS) {
+        return false;
+    }
+    Entry& entry = entries[count++];
+    entry.name = name;
+    entry.help = help;
+    entry.type = type;
+    entry.metric = metric;
+    return true;
+}
+
+int MetricsRegistry::size() const {
+    return count;
+}
+
+size_t MetricsRegistry::formatPrometheus(char* out, size_t capacity) const {
+    static const char* const TYPE_NAMES[] = {"counter", "gauge", "histogram"};
+    size_t length = 0;
+    for (int e = 0; e < count && length < capacity; e++) {
+        const Entry& entry = entries[e];
+        length += result(snprintf(out + length, capacity - length, "# HELP %s %s\n# TYPE %s %s\n", entry.name,
+                                  entry.help, entry.name, TYPE_NAMES[entry.type]),
+                         capacity - length);
+        if (length >= capacity) {
+            break;
+        }
+        if (entry.type == COUNTER) {
+            length += result(snprintf(out + length, capacity - length, "%s %lu\n", entry.name,
+                                      (unsigned long)((const MetricCounter*)entry.metric)->get()),
+                             capacity - length);
+        } else if (entry.type == GAUGE) {
+            length += result(snprintf(out + length, capacity - length, "%s %.9g\n", entry.name,
+                                      (double)((const MetricGauge*)entry.metric)->get()),
+                             capacity - length);
+        } else {
+            // Cumulative buckets, bounds in seconds; _count is their total, so it always equals +Inf
+            const MetricHistogram& histogram = *(const MetricHistogram*)entry.metric;
+            uint32_t cumulative = 0;
+            for (int i = 0; i < MetricHistogram::BUCKETS && length < capacity; i++) {
+                cumulative += histogram.bucketCount(i);
+                uint32_t bound = MetricHistogram::bucketBound(i);
+                if (i == MetricHistogram::BUCKETS - 1) {
+                    length += result(snprintf(out + length, capacity - length, "%s_bucket{le=\"+Inf\"} %lu\n",
+                                              entry.name, (unsigned long)cumulative),
+                                     capacity - length);
+                } else {
+                    length += result(snprintf(out + length, capacity - length, "%s_bucket{le=\"%lu.%06lu\"} %lu\n",
+                                              entry.name, (unsigned long)(bound / 1000000),
+                                              (unsigned long)(bound % 1000000), (unsigned long)cumulative),
+                                     capacity - length);
+                }
+            }
+            if (length < capacity) {
+                uint64_t sum = histogram.sum();
+                length += result(snprintf(out + length, capacity - length, "%s_sum %lu.%06lu\n%s_count %lu\n",
+                                          entry.name, (unsigned long)(sum / 1000000),
+                                          (unsigned long)(sum % 1000000), entry.name, (unsigned long)cumulative),
+                                 capacity - length);
+            }
+        }
+    }
+    return length;
+}
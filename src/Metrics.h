@@ -0,0 +1,134 @@
+/**
+ * @file Metrics.h
+ * @brief Allocation-free counters, gauges and log-scale latency histograms
+ *
+ * Instrumented code owns its metrics as plain members or globals and
+ * updates them in constant time: a counter adds, a gauge stores, a
+ * histogram increments the bucket found from the value's highest set bit.
+ * MetricsRegistry is a fixed table of names pointing at those metrics;
+ * it renders them in the Prometheus text format for /metrics, walking the
+ * table into the caller's buffer, so nothing is allocated either way.
+ *
+ * Histograms count microseconds in power-of-two buckets (le 1 µs, 2 µs,
+ * ... 2^24 µs = 16.8 s, then +Inf): a fixed 2x resolution over the whole
+ * range from a cache hit to a stalled upload, in 120 bytes. Quantiles are
+ * reported as the bound of the bucket they fall in; the maximum is exact.
+ *
+ * Each metric has a single writer task. Fields are 32-bit, so another
+ * core never reads a torn count; a histogram read while it is being
+ * recorded into can be one reading short in one bucket (the exported
+ * _count is the sum of the buckets, so it always matches +Inf) and its
+ * 64-bit sum can be off by one update.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+class MetricCounter {
+public:
+    MetricCounter() : value(0) {}
+
+    void add(uint32_t count = 1) { value = value + count; }
+    /** Mirror a total counted elsewhere (e.g. a subsystem's stats struct) */
+    void set(uint32_t total) { value = total; }
+    uint32_t get() const { return value; }
+
+private:
+    volatile uint32_t value;
+};
+
+class MetricGauge {
+public:
+    MetricGauge() : value(0) {}
+
+    void set(float level) { value = level; }
+    float get() const { return value; }
+
+private:
+    volatile float value;
+};
+
+class MetricHistogram {
+public:
+    static const int BUCKETS = 26;  // le 2^0 .. 2^24 µs, then +Inf
+
+    MetricHistogram();
+
+    /** Count one duration */
+    void record(uint32_t micros) {
+        // Smallest i with micros <= 2^i
+        int bucket = micros <= 1 ? 0 : 32 - __builtin_clz(micros - 1);
+        if (bucket > BUCKETS - 1) bucket = BUCKETS - 1;
+        counts[bucket] = counts[bucket] + 1;
+        sumMicros += micros;
+        if (micros > maxMicros) maxMicros = micros;
+    }
+
+    /** Readings counted (the sum of every bucket) */
+    uint32_t count() const;
+    uint64_t sum() const { return sumMicros; }
+    uint32_t max() const { return maxMicros; }
+    uint32_t bucketCount(int bucket) const { return counts[bucket]; }
+
+    /** Upper bound of bucket in µs; UINT32_MAX for +Inf */
+    static uint32_t bucketBound(int bucket);
+
+    /**
+     * @brief Upper bound of the bucket holding quantile q (0..1), capped at max()
+     *
+     * @return 0 when nothing was recorded
+     */
+    uint32_t percentile(float q) const;
+
+private:
+    volatile uint32_t counts[BUCKETS];
+    uint64_t sumMicros;
+    volatile uint32_t maxMicros;
+};
+
+class MetricsRegistry {
+public:
+    static const int MAX_METRICS = 40;
+
+    MetricsRegistry();
+
+    /**
+     * @brief Export a metric under name (Prometheus naming: [a-z_:][a-z0-9_:]*)
+     *
+     * name and help must outlive the registry. Histograms are exported in
+     * seconds, so their names end in _seconds.
+     *
+     * @return false if the table is full
+     */
+    bool addCounter(const char* name, const char* help, const MetricCounter& counter);
+    bool addGauge(const char* name, const char* help, const MetricGauge& gauge);
+    bool addHistogram(const char* name, const char* help, const MetricHistogram& histogram);
+
+    int size() const;
+
+    /**
+     * @brief Every metric in the Prometheus text exposition format (version 0.0.4)
+     *
+     * @return Length as snprintf() returns it: capacity or more means it did not fit
+     */
+    size_t formatPrometheus(char* out, size_t capacity) const;
+
+private:
+    enum MetricType { COUNTER, GAUGE, HISTOGRAM };
+
+    struct Entry {
+        const char* name;
+        const char* help;
+        MetricType type;
+        const void* metric;
+    };
+
+    Entry entries[MAX_METRICS];
+    int count;
+
+    bool add(const char* name, const char* help, MetricType type, const void* metric);
+};
+
+#endif // METRICS_H
@@ -0,0 +1,115 @@
+/**
+ * @file MpscQueue.h
+ * @brief Lock-free multi-producer / single-consumer ring buffer
+ *
+ * Like SpscQueue, but any number of tasks (on either core) may push.
+ * Producers claim a slot by advancing `tail` with a compare-and-swap, fill
+ * it, then publish it through the slot's own sequence number; the consumer
+ * takes a slot only once its sequence says it is complete, so a producer
+ * preempted between claim and publish delays the items behind it but never
+ * exposes a half-written one. Nobody blocks or spins on another task: a
+ * full queue rejects the new item and counts it as dropped.
+ *
+ * Indices run freely and wrap at 2^32; CAPACITY must be a power of two.
+ * Storage is static, so the queue never allocates.
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stdint.h>
+
+#include <atomic>
+
+template <typename T, uint32_t CAPACITY>
+class MpscQueue {
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+public:
+    MpscQueue() : head(0), tail(0), dropped(0) {
+        for (uint32_t i = 0; i < CAPACITY; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Append an item; safe from any task
+     *
+     * @return false if the queue was full (the item is dropped)
+     */
+    bool push(const T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[t & MASK];
+            int32_t state = (int32_t)(slot->sequence.load(std::memory_order_acquire) - t);
+            if (state == 0) {
+                // Free for position t: claim it (on failure t is reloaded)
+                if (tail.compare_exchange_weak(t, t + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (state < 0) {
+                // Still holds the item from one lap ago: full
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                t = tail.load(std::memory_order_relaxed); // Another producer claimed it first
+            }
+        }
+        slot->item = item;
+        slot->sequence.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest item; consumer side only
+     *
+     * @return false if the queue is empty, or the oldest item is still being written
+     */
+    bool pop(T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        Slot& slot = slots[h & MASK];
+        if (slot.sequence.load(std::memory_order_acquire) != h + 1) {
+            return false;
+        }
+        item = slot.item;
+        slot.sequence.store(h + CAPACITY, std::memory_order_release); // Free for the next lap
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Items claimed and not yet popped; a snapshot */
+    uint32_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool isEmpty() const { return size() == 0; }
+
+    /** The oldest item is published, so pop() would succeed; consumer side only */
+    bool headReady() const {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        return slots[h & MASK].sequence.load(std::memory_order_acquire) == h + 1;
+    }
+    uint32_t capacity() const { return CAPACITY; }
+
+    /** Items ever popped (wraps at 2^32) */
+    uint32_t popped() const { return head.load(std::memory_order_acquire); }
+
+    /** Items rejected because the queue was full */
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    static const uint32_t MASK = CAPACITY - 1;
+
+    struct Slot {
+        std::atomic<uint32_t> sequence;  // Position the slot is free for, or position + 1 once filled
+        T item;
+    };
+
+    Slot slots[CAPACITY];
+    alignas(64) std::atomic<uint32_t> head;  // Next slot to read, written by the consumer
+    alignas(64) std::atomic<uint32_t> tail;  // Next slot to claim, advanced by producers
+    std::atomic<uint32_t> dropped;
+};
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,342 @@
+/**
+ * @file MqttPublisher.cpp
+ * @brief Implementation of the QoS 1 MQTT publisher
+ */
+
+#include "MqttPublisher.h"
+#include "Logger.h"
+
+namespace {
+    // MQTT 3.1.1 control packet types (high nibble of the first byte)
+    const uint8_t CONNECT = 0x10;
+    const uint8_t CONNACK = 0x20;
+    const uint8_t PUBLISH_QOS1 = 0x32;
+    const uint8_t PUBLISH_DUP = 0x08;
+    const uint8_t PUBACK = 0x40;
+    const uint8_t PINGREQ = 0xC0;
+    const uint8_t PINGRESP = 0xD0;
+
+    size_t writeLength(uint8_t* out, size_t value) {
+        size_t length = 0;
+        do {
+            uint8_t byte = value % 128;
+            value /= 128;
+            out[length++] = value > 0 ? (byte | 0x80) : byte;
+        } while (value > 0);
+        return length;
+    }
+
+    size_t writeString(uint8_t* out, const char* text) {
+        size_t length = strlen(text);
+        out[0] = (uint8_t)(length >> 8);
+        out[1] = (uint8_t)length;
+        memcpy(out + 2, text, length);
+        return 2 + length;
+    }
+}
+
+MqttPublisher::MqttPublisher(const char* host, uint16_t port, const char* clientId, int window)
+    : host(host), port(port), window(window < 1 ? 1 : (window > MAX_INFLIGHT ? MAX_INFLIGHT : window)),
+      connected(false), lastAttemptMs(0), backoffMs(0), lastSentMs(0), pingSentMs(0), pingOutstanding(false),
+      nextPacketId(1), head(0), used(0), unacked(0), delivered(0), rxLength(0) {
+    snprintf(this->clientId, sizeof(this->clientId), "%s", clientId);
+    snprintf(topic, sizeof(topic), "aqm/%s/records", this->clientId);
+    memset(slots, 0, sizeof(slots));
+    memset(&stats, 0, sizeof(stats));
+}
+
+void MqttPublisher::setServer(const char* host, uint16_t port) {
+    this->host = host;
+    this->port = port;
+}
+
+int MqttPublisher::publish(const QueuedRecord* records, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+    if (unacked >= window) {
+        stats.windowFull++;
+        return 0;
+    }
+    if (!ensureConnected()) {
+        return 0;
+    }
+    // Acknowledged slots at the head were collected; a hole further in
+    // (an out-of-order PUBACK) can leave the ring full before the window is
+    if (used >= MAX_INFLIGHT) {
+        stats.windowFull++;
+        return 0;
+    }
+
+    // The payload goes where it ends up; the fixed header, whose length
+    // depends on the payload's, is written in front of it afterwards
+    Slot& slot = slotAt(used);
+    size_t offset = 1 + 4;
+    uint8_t* variable = slot.packet + offset;
+    size_t variableLength = writeString(variable, topic);
+    uint16_t packetId = nextPacketId;
+    nextPacketId = nextPacketId == 0xFFFF ? 1 : nextPacketId + 1;
+    variable[variableLength++] = (uint8_t)(packetId >> 8);
+    variable[variableLength++] = (uint8_t)packetId;
+
+    RecordEncoder encoder(variable + variableLength, MAX_PAYLOAD);
+    int taken = 0;
+    while (taken < count && taken < MAX_RECORDS && encoder.add(records[taken].timestamp, records[taken].data)) {
+        taken++;
+    }
+    size_t remaining = variableLength + encoder.length();
+    uint8_t header[5];
+    header[0] = PUBLISH_QOS1;
+    size_t headerLength = 1 + writeLength(header + 1, remaining);
+    slot.start = (uint16_t)(offset - headerLength);
+    memcpy(slot.packet + slot.start, header, headerLength);
+    slot.length = (uint16_t)(headerLength + remaining);
+    slot.packetId = packetId;
+    slot.records = (uint16_t)taken;
+    slot.firstSentMicros = micros();
+    slot.sentMs = millis();
+    used++;
+    unacked++;
+    stats.published++;
+    stats.records += taken;
+
+    // A failed write leaves the message in flight; it goes out again after the reconnect
+    sendPacket(slot.packet + slot.start, slot.length);
+    return taken;
+}
+
+void MqttPublisher::poll() {
+    if (!connected) {
+        if (unacked > 0) {
+            ensureConnected();
+        }
+        return;
+    }
+    readIncoming();
+    if (!connected) {
+        return;
+    }
+    unsigned long now = millis();
+    if (!client.connected()) {
+        drop(); // The broker closed the connection; reconnect on the next poll
+        return;
+    }
+    // On a live TCP connection a PUBACK is late, not lost: the broker or
+    // the path is gone, and only a new connection brings the message through
+    bool ackOverdue = unacked > 0 && now - slotAt(0).sentMs >= ACK_TIMEOUT_MS;
+    bool pingOverdue = pingOutstanding && now - pingSentMs >= ACK_TIMEOUT_MS;
+    if (ackOverdue || pingOverdue) {
+        stats.timeouts++;
+        Log.warn(LOG_MQTT_TIMEOUT, (unsigned)(ACK_TIMEOUT_MS / 1000));
+        drop();
+        return;
+    }
+    if (!pingOutstanding && now - lastSentMs >= (unsigned long)KEEPALIVE_S * 750UL) {
+        static const uint8_t ping[2] = {PINGREQ, 0};
+        if (sendPacket(ping, sizeof(ping))) {
+            pingOutstanding = true;
+            pingSentMs = now;
+            stats.pings++;
+        }
+    }
+}
+
+void MqttPublisher::linkLost() {
+    if (connected) {
+        drop();
+    }
+}
+
+bool MqttPublisher::isConnected() const {
+    return connected;
+}
+
+int MqttPublisher::takeDelivered() {
+    int count = delivered;
+    delivered = 0;
+    return count;
+}
+
+int MqttPublisher::inFlight() const {
+    return unacked;
+}
+
+int MqttPublisher::getWindow() const {
+    return window;
+}
+
+const char* MqttPublisher::getTopic() const {
+    return topic;
+}
+
+const MqttStats& MqttPublisher::getStats() const {
+    return stats;
+}
+
+const MetricHistogram& MqttPublisher::getAckLatency() const {
+    return ackLatency;
+}
+
+bool MqttPublisher::ensureConnected() {
+    if (connected) {
+        if (client.connected()) {
+            readIncoming(); // Frees slots acknowledged since the last poll
+            if (connected) {
+                return true;
+            }
+        } else {
+            drop();
+        }
+    }
+    if (backoffMs > 0 && millis() - lastAttemptMs < backoffMs) {
+        return false;
+    }
+    return connect();
+}
+
+bool MqttPublisher::connect() {
+    lastAttemptMs = millis();
+    rxLength = 0;
+    if (!client.connect(host, port, TIMEOUT_MS)) {
+        connectFailed("connection refused");
+        return false;
+    }
+
+    // Clean session 0: the broker keeps the session (and what it acknowledged) across connections
+    uint8_t packet[2 + 10 + 2 + MAX_CLIENT_ID];
+    uint8_t* variable = packet + 2;
+    size_t length = writeString(variable, "MQTT");
+    variable[length++] = 4;    // Protocol level 3.1.1
+    variable[length++] = 0x00; // No clean session, will, user or password
+    variable[length++] = (uint8_t)(KEEPALIVE_S >> 8);
+    variable[length++] = (uint8_t)KEEPALIVE_S;
+    length += writeString(variable + length, clientId);
+    packet[0] = CONNECT;
+    packet[1] = (uint8_t)length;
+    if (!sendPacket(packet, 2 + length)) {
+        connectFailed("write failed");
+        return false;
+    }
+
+    uint8_t connack[4];
+    size_t received = 0;
+    unsigned long start = millis();
+    while (received < sizeof(connack)) {
+        if (client.available()) {
+            connack[received++] = (uint8_t)client.read();
+        } else if (!client.connected() || millis() - start >= TIMEOUT_MS) {
+            connectFailed("no CONNACK");
+            return false;
+        } else {
+            delay(1);
+        }
+    }
+    if (connack[0] != CONNACK || connack[1] != 2 || connack[3] != 0) {
+        connectFailed("refused by broker");
+        return false;
+    }
+
+    bool resumed = (connack[2] & 0x01) != 0;
+    connected = true;
+    backoffMs = 0;
+    pingOutstanding = false;
+    stats.connects++;
+    stats.sessionsResumed += resumed ? 1 : 0;
+    Log.info(LOG_MQTT_CONNECTED, host, resumed ? "resumed" : "new", (unsigned)unacked);
+
+    // Everything unacknowledged goes out again, in the order it was first sent
+    for (int i = 0; i < used && connected; i++) {
+        Slot& slot = slotAt(i);
+        if (slot.packetId != 0) {
+            resend(slot);
+        }
+    }
+    return connected;
+}
+
+void MqttPublisher::connectFailed(const char* reason) {
+    client.stop();
+    connected = false;
+    stats.connectFailures++;
+    backoffMs = backoffMs == 0 ? MIN_BACKOFF_MS : backoffMs * 2;
+    if (backoffMs > MAX_BACKOFF_MS) {
+        backoffMs = MAX_BACKOFF_MS;
+    }
+    Log.warn(LOG_MQTT_CONNECT_FAILED, host, reason, (unsigned)(backoffMs / 1000));
+}
+
+void MqttPublisher::drop() {
+    client.stop();
+    connected = false;
+    pingOutstanding = false;
+    rxLength = 0;
+}
+
+bool MqttPublisher::sendPacket(const uint8_t* packet, size_t length) {
+    if (client.write(packet, length) != length) {
+        drop();
+        return false;
+    }
+    lastSentMs = millis();
+    return true;
+}
+
+void MqttPublisher::resend(Slot& slot) {
+    slot.packet[slot.start] |= PUBLISH_DUP;
+    slot.sentMs = millis();
+    stats.retransmits++;
+    sendPacket(slot.packet + slot.start, slot.length);
+}
+
+void MqttPublisher::readIncoming() {
+    while (connected && client.available() > 0) {
+        int byte = client.read();
+        if (byte < 0) {
+            break;
+        }
+        rx[rxLength++] = (uint8_t)byte;
+        // Both expected packets are short: a one-byte remaining length of 0 or 2
+        if (rxLength == 2 && rx[1] > 2) {
+            drop(); // Not something this client subscribed to or can parse
+            return;
+        }
+        if (rxLength >= 2 && rxLength == 2 + rx[1]) {
+            handlePacket();
+            rxLength = 0;
+        }
+    }
+}
+
+void MqttPublisher::handlePacket() {
+    uint8_t type = rx[0] & 0xF0;
+    if (type == PUBACK && rx[1] == 2) {
+        acknowledge((uint16_t)(rx[2] << 8 | rx[3]));
+    } else if (type == PINGRESP && rx[1] == 0) {
+        pingOutstanding = false;
+    } else {
+        drop();
+    }
+}
+
+void MqttPublisher::acknowledge(uint16_t packetId) {
+    for (int i = 0; i < used; i++) {
+        Slot& slot = slotAt(i);
+        if (slot.packetId == packetId) {
+            ackLatency.record(micros() - slot.firstSentMicros);
+            slot.packetId = 0;
+            unacked--;
+            stats.acked++;
+            break;
+        }
+    }
+    // A PUBACK for a message already acknowledged (its DUP crossed the first ack) is ignored
+    while (used > 0 && slotAt(0).packetId == 0) {
+        delivered += slotAt(0).records;
+        head = (head + 1) % MAX_INFLIGHT;
+        used--;
+    }
+}
+
+MqttPublisher::Slot& MqttPublisher::slotAt(int position) {
+    return slots[(head + position) % MAX_INFLIGHT];
+}
@@ -0,0 +1,171 @@
+/**
+ * @file MqttPublisher.h
+ * @brief Batched QoS 1 publishing of records over one persistent MQTT session
+ *
+ * An alternative to one HTTP request per batch: the device keeps a single
+ * MQTT 3.1.1 connection open to a broker and publishes each batch as one
+ * message on "aqm/<clientId>/records", its payload a RecordCodec stream:
+ * a batch of 8 records costs about 16 bytes per record on the wire, the
+ * bulk-update JSON body alone about 160.
+ *
+ * Delivery is QoS 1 (at least once). Up to window messages may be
+ * unacknowledged at a time; each is kept, packet and all, in a fixed
+ * in-flight slot until its PUBACK arrives, so publishing never waits for
+ * the broker's round trip and a slow broker only fills the window:
+ * publish() then returns 0 and the caller keeps the records (on flash).
+ *
+ * The session is persistent (CONNECT with clean session 0): after a lost
+ * link, a broker restart or an acknowledgement that never came
+ * (ACK_TIMEOUT_MS; TCP does not lose one on a live connection), the
+ * publisher reconnects with exponential backoff and sends every
+ * unacknowledged message again, in order, with the DUP flag set. A
+ * message can therefore arrive twice, never not at all; consumers drop
+ * duplicates by packet id and timestamp. The in-flight slots are RAM, so
+ * the caller keeps records on flash until takeDelivered() reports them
+ * acknowledged, and a reboot sends them again. A
+ * PINGREQ goes out when nothing was sent for three quarters of the
+ * keepalive, so the broker keeps the session.
+ *
+ * Connecting blocks (up to TIMEOUT_MS for the CONNACK), like
+ * UploadSession; everything else only writes to or reads from the socket.
+ * Nothing is allocated.
+ */
+
+#ifndef MQTT_PUBLISHER_H
+#define MQTT_PUBLISHER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "Metrics.h"
+#include "RecordCodec.h"
+#include "UploadQueue.h"
+
+struct MqttStats {
+    uint32_t connects;        // Sessions established (CONNACK accepted)
+    uint32_t connectFailures; // TCP connects, CONNACKs or session setups that failed
+    uint32_t sessionsResumed; // Connects where the broker still held the session
+    uint32_t published;       // PUBLISH packets sent, retransmissions not counted
+    uint32_t records;         // Records in them
+    uint32_t acked;           // PUBACKs matched to an in-flight message
+    uint32_t retransmits;     // PUBLISH packets sent again with DUP after a reconnect
+    uint32_t windowFull;      // publish() calls refused because window messages were unacknowledged
+    uint32_t pings;           // PINGREQ sent
+    uint32_t timeouts;        // Connections given up on: no PUBACK or PINGRESP in time
+};
+
+class MqttPublisher {
+public:
+    static const int MAX_INFLIGHT = 4;              // Slots; the window can be smaller
+    static const int MAX_RECORDS = 32;              // Records per PUBLISH
+    static const uint16_t KEEPALIVE_S = 60;
+    static const unsigned long ACK_TIMEOUT_MS = 20000; // PUBACK or PINGRESP, else reconnect
+    static const unsigned long TIMEOUT_MS = 10000;     // Connect and CONNACK
+    static const unsigned long MIN_BACKOFF_MS = 1000;
+    static const unsigned long MAX_BACKOFF_MS = 60000;
+    static const size_t MAX_CLIENT_ID = 23;         // The 3.1.1 limit every broker accepts
+    static const size_t MAX_TOPIC = 4 + MAX_CLIENT_ID + 8; // "aqm/<clientId>/records"
+    // Fixed header (type and up to 4 length bytes), topic, packet id, payload
+    static const size_t MAX_PAYLOAD = RecordEncoder::HEADER_BYTES + MAX_RECORDS * RecordEncoder::MAX_RECORD_BYTES;
+    static const size_t MAX_PACKET = 1 + 4 + 2 + MAX_TOPIC + 2 + MAX_PAYLOAD;
+
+    /**
+     * @param host Broker host name (the string must outlive the publisher)
+     * @param port Broker TCP port
+     * @param clientId Session key at the broker, and part of the topic;
+     *        cut to MAX_CLIENT_ID characters
+     * @param window Unacknowledged messages allowed, 1..MAX_INFLIGHT
+     */
+    MqttPublisher(const char* host, uint16_t port, const char* clientId, int window = MAX_INFLIGHT);
+
+    /** Broker for the next connection (the current one is kept) */
+    void setServer(const char* host, uint16_t port);
+
+    /**
+     * @brief Publish records, oldest first, as one QoS 1 message
+     *
+     * Connects first if needed (and the backoff allows).
+     *
+     * @return Records taken (at most MAX_RECORDS): they are the publisher's
+     *         until acknowledged. 0 if the window is full or the broker
+     *         cannot be reached.
+     */
+    int publish(const QueuedRecord* records, int count);
+
+    /**
+     * @brief Read acknowledgements, keep the session alive and reconnect
+     *        while messages are unacknowledged; call regularly (never blocks
+     *        unless it reconnects)
+     */
+    void poll();
+
+    /**
+     * @brief Drop the socket without a DISCONNECT, e.g. after the WiFi link
+     *        was lost (unacknowledged messages are kept)
+     */
+    void linkLost();
+
+    bool isConnected() const;
+    /**
+     * @brief Records acknowledged since the last call, in the order
+     *        publish() took them
+     *
+     * A message acknowledged ahead of an older one is counted once the
+     * older one is acknowledged too.
+     */
+    int takeDelivered();
+
+    /** Messages sent and not yet acknowledged */
+    int inFlight() const;
+    int getWindow() const;
+    const char* getTopic() const;
+    const MqttStats& getStats() const;
+    /** First send of a message to its PUBACK, as seen when it is read */
+    const MetricHistogram& getAckLatency() const;
+
+private:
+    struct Slot {
+        uint16_t packetId;        // 0: free
+        uint16_t start;           // Offset of the packet in packet[] (its fixed header varies)
+        uint16_t length;
+        uint16_t records;         // Records in the payload
+        uint32_t firstSentMicros; // micros() at the first send
+        unsigned long sentMs;     // millis() at the last send
+        uint8_t packet[MAX_PACKET];
+    };
+
+    const char* host;
+    uint16_t port;
+    char clientId[MAX_CLIENT_ID + 1];
+    char topic[MAX_TOPIC + 1];
+    int window;
+    WiFiClient client;
+    bool connected;
+    unsigned long lastAttemptMs;
+    unsigned long backoffMs;        // Wait before the next connect attempt (0 after a success)
+    unsigned long lastSentMs;       // Any packet; drives the keepalive
+    unsigned long pingSentMs;
+    bool pingOutstanding;
+    uint16_t nextPacketId;
+    Slot slots[MAX_INFLIGHT];       // Ring in send order; acknowledged slots leave holes until the head
+    int head;
+    int used;                       // Ring positions from head, holes included
+    int unacked;
+    int delivered;                  // Records acknowledged in order, not yet taken
+    uint8_t rx[4];                  // Incoming packet being assembled (only PUBACK and PINGRESP are expected)
+    uint8_t rxLength;
+    MqttStats stats;
+    MetricHistogram ackLatency;
+
+    bool ensureConnected();
+    bool connect();
+    void connectFailed(const char* reason);
+    void drop();
+    bool sendPacket(const uint8_t* packet, size_t length);
+    void resend(Slot& slot);
+    void readIncoming();
+    void handlePacket();
+    void acknowledge(uint16_t packetId);
+    Slot& slotAt(int position);
+};
+
+#endif // MQTT_PUBLISHER_H
@@ -1,105 +1,127 @@
 /**
  * @file NetworkManager.cpp
- * @brief Implementation of WiFi connection management
+ * @brief Implementation of the non-blocking WiFi state machine
  */
 
 #include "NetworkManager.h"
+#include "Logger.h"
 
-NetworkManager::NetworkManager(const char* ssid, const char* password) 
-    : ssid(ssid), password(password), reconnectAttempts(0), lastReconnectAttempt(0) {
+NetworkManager::NetworkManager(const char* ssid, const char* password)
+    : ssid(ssid), password(password), state(NETWORK_IDLE), stateSince(0), backoffMs(MIN_BACKOFF),
+      retryWait(0), attempts(0), disconnects(0), downSince(0), gotIpEvent(false), disconnectedEvent(false),
+      lastReason(0) {
 }
 
-bool NetworkManager::connect() {
-    Serial.print("Connecting to WiFi: ");
-    Serial.println(ssid);
-    
+void NetworkManager::onEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    // Runs on the WiFi event task: only record what happened
+    if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+        gotIpEvent = true;
+    } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+        lastReason = info.wifi_sta_disconnected.reason;
+        disconnectedEvent = true;
+    }
+}
+
+void NetworkManager::begin() {
+    Log.info(LOG_WIFI_CONNECTING, ssid);
+
     WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false); // Retries are paced by the backoff below
+    WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { onEvent(event, info); });
+    downSince = millis();
+    startAttempt(downSince);
+}
+
+void NetworkManager::startAttempt(unsigned long now) {
+    attempts++;
+    gotIpEvent = false;
+    disconnectedEvent = false;
+    state = NETWORK_CONNECTING;
+    stateSince = now;
     WiFi.begin(ssid, password);
-    
-    int dots = 0;
-    int timeout = 0;
-    const int MAX_TIMEOUT = 60; // 30 seconds (60 * 500ms)
-    
-    while (WiFi.status() != WL_CONNECTED && timeout < MAX_TIMEOUT) {
-        delay(500);
-        Serial.print(".");
-        dots++;
-        timeout++;
-        
-        if (dots % 40 == 0) {
-            Serial.println();
-        }
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println();
-        Serial.println("✓ WiFi connected!");
-        Serial.print("  IP address: ");
-        Serial.println(WiFi.localIP());
-        reconnectAttempts = 0;
-        return true;
-    } else {
-        Serial.println();
-        Serial.println("✗ WiFi connection failed!");
-        return false;
-    }
 }
 
-bool NetworkManager::isConnected() {
-    return WiFi.status() == WL_CONNECTED;
+void NetworkManager::scheduleRetry(unsigned long now) {
+    // Full backoff plus up to 25% jitter
+    retryWait = backoffMs + (unsigned long)random((long)(backoffMs / 4 + 1));
+    state = NETWORK_BACKOFF;
+    stateSince = now;
+    backoffMs = backoffMs * 2 > MAX_BACKOFF ? MAX_BACKOFF : backoffMs * 2;
+
+    Log.warn(LOG_WIFI_RETRY, attempts, (unsigned)lastReason, retryWait / 1000.0f);
 }
 
-bool NetworkManager::reconnect() {
-    unsigned long currentTime = millis();
-    
-    // Check if already connected
-    if (isConnected()) {
-        reconnectAttempts = 0;
-        return true;
-    }
-    
-    // Check if we've exceeded max attempts
-    if (reconnectAttempts >= MAX_RECONNECT_ATTEMPTS) {
-        Serial.println("✗ Max reconnection attempts reached. Please check WiFi credentials.");
-        return false;
-    }
-    
-    // Non-blocking reconnection with interval
-    if (currentTime - lastReconnectAttempt >= RECONNECT_INTERVAL) {
-        reconnectAttempts++;
-        lastReconnectAttempt = currentTime;
-        
-        Serial.print("⟳ WiFi reconnection attempt ");
-        Serial.print(reconnectAttempts);
-        Serial.print("/");
-        Serial.println(MAX_RECONNECT_ATTEMPTS);
-        
-        WiFi.disconnect();
-        delay(100);
-        WiFi.begin(ssid, password);
-        
-        // Give it a moment to attempt connection
-        delay(3000);
-        
-        if (isConnected()) {
-            Serial.println("✓ WiFi reconnected successfully!");
-            Serial.print("  IP address: ");
-            Serial.println(WiFi.localIP());
-            reconnectAttempts = 0;
-            return true;
-        }
+bool NetworkManager::update() {
+    unsigned long now = millis();
+
+    switch (state) {
+        case NETWORK_IDLE:
+            break;
+
+        case NETWORK_CONNECTING:
+            if (gotIpEvent) {
+                gotIpEvent = false;
+                disconnectedEvent = false;
+                state = NETWORK_CONNECTED;
+                stateSince = now;
+                backoffMs = MIN_BACKOFF;
+                reconnectLatency.record(now - downSince >= UINT32_MAX / 1000 ? UINT32_MAX
+                                                                              : (uint32_t)(now - downSince) * 1000);
+                IPAddress ip = WiFi.localIP();
+                Log.info(LOG_WIFI_CONNECTED, attempts, attempts == 1 ? "attempt" : "attempts",
+                         ip[0], ip[1], ip[2], ip[3]);
+                attempts = 0;
+                return true;
+            }
+            if (disconnectedEvent || now - stateSince >= CONNECT_TIMEOUT) {
+                disconnectedEvent = false;
+                WiFi.disconnect();
+                // Our own disconnect() posts an event too; it lands during the
+                // backoff and startAttempt() clears it
+                disconnectedEvent = false;
+                scheduleRetry(now);
+            }
+            break;
+
+        case NETWORK_CONNECTED:
+            if (disconnectedEvent) {
+                disconnectedEvent = false;
+                disconnects++;
+                downSince = now;
+                backoffMs = MIN_BACKOFF;
+                Log.warn(LOG_WIFI_LINK_LOST, (unsigned)lastReason);
+                startAttempt(now);
+            }
+            break;
+
+        case NETWORK_BACKOFF:
+            if (now - stateSince >= retryWait) {
+                startAttempt(now);
+            }
+            break;
     }
-    
     return false;
 }
 
+bool NetworkManager::isConnected() {
+    return state == NETWORK_CONNECTED && WiFi.status() == WL_CONNECTED;
+}
+
+NetworkState NetworkManager::getState() const {
+    return state;
+}
+
+uint32_t NetworkManager::getDisconnectCount() const {
+    return disconnects;
+}
+
+const MetricHistogram& NetworkManager::getReconnectLatency() const {
+    return reconnectLatency;
+}
+
 String NetworkManager::getIP() {
     if (isConnected()) {
         return WiFi.localIP().toString();
     }
     return "Not Connected";
 }
-
-void NetworkManager::resetReconnectAttempts() {
-    reconnectAttempts = 0;
-}
@@ -1,9 +1,14 @@
 /**
  * @file NetworkManager.h
- * @brief WiFi connection management with automatic reconnection
- * 
- * Handles WiFi connectivity, reconnection logic, and connection monitoring
- * for ESP32-based IoT devices.
+ * @brief Non-blocking WiFi connection state machine
+ *
+ * Connection state is driven by WiFi driver events (got IP, disconnected)
+ * and advanced from loop() by update(), which never waits: association
+ * runs in the background, a failed attempt or a dropped link schedules
+ * the next attempt with exponential backoff (1 s doubling to 60 s, with
+ * jitter so a fleet does not hammer the AP in step), and the caller just
+ * asks isConnected() before doing network work. The sensor loop and
+ * ArduinoOTA.handle() keep their cadence through outages.
  */
 
 #ifndef NETWORK_MANAGER_H
@@ -11,60 +16,90 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include "Metrics.h"
+
+enum NetworkState {
+    NETWORK_IDLE,        // begin() not called yet
+    NETWORK_CONNECTING,  // Association attempt in progress
+    NETWORK_CONNECTED,   // Link up with an IP address
+    NETWORK_BACKOFF      // Waiting before the next attempt
+};
 
 class NetworkManager {
 private:
     const char* ssid;
     const char* password;
-    int reconnectAttempts;
-    unsigned long lastReconnectAttempt;
-    static const unsigned long RECONNECT_INTERVAL = 5000; // 5 seconds between attempts
-    static const int MAX_RECONNECT_ATTEMPTS = 3;
-    
+    NetworkState state;
+    unsigned long stateSince;      // millis() when the current state was entered
+    unsigned long backoffMs;       // Base wait after the next failure
+    unsigned long retryWait;       // Wait (with jitter) in the current backoff
+    uint32_t attempts;             // Attempts since the last successful connection
+    uint32_t disconnects;          // Established links that dropped
+    unsigned long downSince;       // millis() when the link was lost (or begin() was called)
+    MetricHistogram reconnectLatency;
+
+    // Set from the WiFi event task, consumed by update()
+    volatile bool gotIpEvent;
+    volatile bool disconnectedEvent;
+    volatile uint8_t lastReason;
+
+    static const unsigned long CONNECT_TIMEOUT = 15000;  // Give up on one attempt after 15 s
+    static const unsigned long MIN_BACKOFF = 1000;
+    static const unsigned long MAX_BACKOFF = 60000;
+
+    void onEvent(arduino_event_id_t event, arduino_event_info_t info);
+    void startAttempt(unsigned long now);
+    void scheduleRetry(unsigned long now);
+
 public:
     /**
      * @brief Construct a new Network Manager object
-     * 
+     *
      * @param ssid WiFi network SSID
      * @param password WiFi network password
      */
     NetworkManager(const char* ssid, const char* password);
-    
+
     /**
-     * @brief Initial WiFi connection with blocking wait
-     * 
-     * @return true if connection successful
-     * @return false if connection failed
+     * @brief Register for WiFi events and start the first attempt
+     *
+     * Returns immediately; the link comes up in the background.
      */
-    bool connect();
-    
+    void begin();
+
+    /**
+     * @brief Advance the state machine; call from every loop()
+     *
+     * @return true on the call where the link has just come up
+     */
+    bool update();
+
     /**
      * @brief Check if WiFi is currently connected
-     * 
+     *
      * @return true if connected
      * @return false if disconnected
      */
     bool isConnected();
-    
+
+    NetworkState getState() const;
+
     /**
-     * @brief Attempt to reconnect to WiFi (non-blocking)
-     * 
-     * @return true if reconnection successful or in progress
-     * @return false if max attempts reached
+     * @brief Number of established links that dropped since boot
+     *
+     * Sockets opened before a change of this count may be half-open.
      */
-    bool reconnect();
-    
+    uint32_t getDisconnectCount() const;
+
+    /** Time from begin() or a lost link to the next connection, backoff included */
+    const MetricHistogram& getReconnectLatency() const;
+
     /**
      * @brief Get the current IP address
-     * 
+     *
      * @return String IP address or "Not Connected"
      */
     String getIP();
-    
-    /**
-     * @brief Reset reconnection attempt counter
-     */
-    void resetReconnectAttempts();
 };
 
 #endif // NETWORK_MANAGER_H
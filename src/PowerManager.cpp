@@ -0,0 +1,102 @@
+/**
+ * @file PowerManager.cpp
+ * @brief Implementation of the power modes and loop() sleep
+ */
+
+#include "PowerManager.h"
+#include "Logger.h"
+
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+PowerManager::PowerManager(PowerMode mode)
+    : mode(mode), lightSleep(false), awakeLock(nullptr), holds(0), lastWakeUs(0) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void PowerManager::setMode(PowerMode mode) {
+    this->mode = mode;
+}
+
+PowerMode PowerManager::getMode() const {
+    return mode;
+}
+
+bool PowerManager::begin() {
+    memset(&stats, 0, sizeof(stats));
+    lastWakeUs = micros();
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "awake", &awakeLock) != ESP_OK) {
+        awakeLock = nullptr;
+    }
+
+    if (mode == POWER_PERFORMANCE) {
+        WiFi.setSleep(false);
+        lightSleep = false;
+        Log.info(LOG_POWER_MODE, "performance", "off", "off");
+        return false;
+    }
+
+    // Minimum modem sleep: the radio wakes for every DTIM beacon, so the AP
+    // buffers nothing for long and OTA and TCP keep working
+    WiFi.setSleep(true);
+    esp_pm_config_esp32s3_t config = {MAX_CPU_MHZ, MIN_CPU_MHZ, true};
+    lightSleep = esp_pm_configure(&config) == ESP_OK;
+    if (!lightSleep) {
+        config.light_sleep_enable = false; // Core built without tickless idle
+        esp_pm_configure(&config);
+    }
+    Log.info(LOG_POWER_MODE, "low", lightSleep ? "on" : "unavailable", "on");
+    return lightSleep;
+}
+
+bool PowerManager::lightSleepEnabled() const {
+    return lightSleep;
+}
+
+uint32_t PowerManager::sleep(uint32_t maxMs) {
+    unsigned long start = micros();
+    stats.awakeUs += (unsigned long)(start - lastWakeUs);
+    uint32_t count = ulTaskNotifyTake(pdTRUE, maxMs == FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(maxMs));
+    lastWakeUs = micros();
+    stats.sleptUs += (unsigned long)(lastWakeUs - start);
+    stats.wakeups++;
+    if (count) {
+        stats.notified++;
+    }
+    return count;
+}
+
+void PowerManager::holdAwake() {
+    if (holds++ > 0) {
+        return;
+    }
+    if (awakeLock) {
+        esp_pm_lock_acquire(awakeLock);
+    }
+    if (mode == POWER_LOW) {
+        WiFi.setSleep(false); // Full throughput for the transfer
+    }
+}
+
+void PowerManager::release() {
+    if (holds == 0 || --holds > 0) {
+        return;
+    }
+    if (awakeLock) {
+        esp_pm_lock_release(awakeLock);
+    }
+    if (mode == POWER_LOW) {
+        WiFi.setSleep(true);
+    }
+}
+
+PowerStats PowerManager::getStats() const {
+    return stats;
+}
+
+float PowerManager::idlePercent(const PowerStats& from, const PowerStats& to) {
+    uint64_t slept = to.sleptUs - from.sleptUs;
+    uint64_t total = slept + (to.awakeUs - from.awakeUs);
+    return total ? 100.0f * (float)slept / (float)total : 0.0f;
+}
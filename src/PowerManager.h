@@ -0,0 +1,85 @@
+/**
+ * @file PowerManager.h
+ * @brief Power mode, loop() sleep and wakeup accounting
+ *
+ * In POWER_LOW the CPU scales between 80 and 240 MHz and the chip enters
+ * light sleep by itself whenever every task is blocked (ESP-IDF automatic
+ * light sleep), while WiFi stays associated in modem sleep and wakes for
+ * each DTIM beacon, so OTA invitations and keep-alive sockets keep working.
+ * Firmware built without tickless idle cannot light-sleep; begin() then
+ * keeps frequency scaling and modem sleep and reports it. POWER_PERFORMANCE
+ * leaves the CPU at full speed and the radio always on.
+ *
+ * Light sleep only pays when tasks block for long stretches, so loop()
+ * waits in sleep(): a FreeRTOS notification wait (the sensor task notifies
+ * per sample) bounded by the next scheduler deadline, timed so the share
+ * of time loop() was idle and how often it woke can be reported.
+ * holdAwake() keeps the chip awake and the radio on, e.g. for an OTA
+ * transfer, until the matching release().
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include <esp_pm.h>
+
+enum PowerMode {
+    POWER_PERFORMANCE,  // CPU at 240 MHz, radio always on: lowest latency
+    POWER_LOW           // Frequency scaling, automatic light sleep, WiFi modem sleep
+};
+
+struct PowerStats {
+    uint32_t wakeups;        // sleep() calls that returned
+    uint32_t notified;       // ... woken by a notification (a sample) rather than the deadline
+    uint64_t sleptUs;        // Time loop() spent in sleep()
+    uint64_t awakeUs;        // Time loop() spent between sleep() calls
+};
+
+class PowerManager {
+public:
+    static const int MAX_CPU_MHZ = 240;
+    static const int MIN_CPU_MHZ = 80;     // APB stays at 80 MHz, so UART, I2C and LED timing hold
+    static const uint32_t FOREVER = 0xFFFFFFFFUL;  // sleep() without a deadline (Scheduler::NO_DEADLINE)
+
+    explicit PowerManager(PowerMode mode);
+
+    /** Choose the mode; call before begin() */
+    void setMode(PowerMode mode);
+    PowerMode getMode() const;
+
+    /**
+     * @brief Apply the mode (after WiFi is started) and start counting
+     *
+     * @return true if automatic light sleep is enabled
+     */
+    bool begin();
+    bool lightSleepEnabled() const;
+
+    /**
+     * @brief Block the calling task until notified or maxMs pass
+     *
+     * @return Notification count taken (0 = the deadline came first)
+     */
+    uint32_t sleep(uint32_t maxMs);
+
+    /** No light sleep and no modem sleep until the matching release() */
+    void holdAwake();
+    void release();
+
+    /** Counters up to the last wakeup */
+    PowerStats getStats() const;
+
+    /** Share of the time between two snapshots that loop() spent in sleep(), in percent */
+    static float idlePercent(const PowerStats& from, const PowerStats& to);
+
+private:
+    PowerMode mode;
+    bool lightSleep;
+    esp_pm_lock_handle_t awakeLock;
+    int holds;
+    unsigned long lastWakeUs;   // micros() when sleep() last returned
+    PowerStats stats;
+};
+
+#endif // POWER_MANAGER_H
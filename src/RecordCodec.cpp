@@ -0,0 +1,222 @@
+/**
+ * @file RecordCodec.cpp
+ * @brief Implementation of the binary reading format
+ */
+
+#include "RecordCodec.h"
+
+// SEN55 output resolution, as in HistoryStore
+const uint16_t RecordEncoder::SCALE[SENSOR_FIELD_COUNT] = {10, 10, 10, 10, 100, 200, 10, 10};
+
+namespace {
+    const uint8_t MAGIC[2] = {'A', 'Q'};
+    const int32_t NAN_CODE = INT32_MIN; // Quantized values are clamped above it
+
+    uint32_t zigzag(int32_t value) {
+        return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    }
+
+    int32_t unzigzag(uint32_t value) {
+        return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+    }
+
+    size_t writeVarint(uint8_t* out, uint32_t value) {
+        size_t length = 0;
+        while (value >= 0x80) {
+            out[length++] = (uint8_t)(value | 0x80);
+            value >>= 7;
+        }
+        out[length++] = (uint8_t)value;
+        return length;
+    }
+
+    // Wrapping difference: any two 32-bit values are a 32-bit delta apart
+    int32_t difference(int32_t value, int32_t previous) {
+        return (int32_t)((uint32_t)value - (uint32_t)previous);
+    }
+
+    float fromCode(int32_t code, float scale) {
+        return code == NAN_CODE ? NAN : (float)code / scale;
+    }
+}
+
+RecordEncoder::RecordEncoder(uint8_t* out, size_t capacity) : out(out), capacity(capacity) {
+    reset();
+}
+
+void RecordEncoder::reset() {
+    used = 0;
+    lastTimestamp = 0;
+    lastInterval = 0;
+    memset(last, 0, sizeof(last));
+    memset(&stats, 0, sizeof(stats));
+    if (capacity < HEADER_BYTES) {
+        return;
+    }
+    out[used++] = MAGIC[0];
+    out[used++] = MAGIC[1];
+    out[used++] = VERSION;
+    out[used++] = SENSOR_FIELD_COUNT;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        out[used++] = (uint8_t)f;
+        used += writeVarint(out + used, SCALE[f]);
+    }
+}
+
+bool RecordEncoder::add(uint32_t timestamp, const SensorData& reading) {
+    if (used == 0 || capacity - used < MAX_RECORD_BYTES) {
+        return false;
+    }
+    int32_t interval = (int32_t)(timestamp - lastTimestamp);
+    // The first timestamp goes in whole (as a delta from 0); the first
+    // interval is a delta of delta from 0
+    used += writeVarint(out + used, zigzag(difference(interval, lastInterval)));
+    lastInterval = stats.records == 0 ? 0 : interval;
+    lastTimestamp = timestamp;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        bool clamped = false;
+        int32_t value = quantize((SensorField)f, reading.*SENSOR_FIELDS[f], clamped);
+        stats.clamped += clamped ? 1 : 0;
+        used += writeVarint(out + used, zigzag(difference(value, last[f])));
+        last[f] = value;
+    }
+    stats.records++;
+    return true;
+}
+
+size_t RecordEncoder::length() const {
+    return used;
+}
+
+uint32_t RecordEncoder::count() const {
+    return stats.records;
+}
+
+const RecordCodecStats& RecordEncoder::getStats() const {
+    return stats;
+}
+
+float RecordEncoder::quantized(SensorField field, float value) {
+    bool clamped;
+    return fromCode(quantize(field, value, clamped), SCALE[field]);
+}
+
+float RecordEncoder::dequantize(SensorField field, int32_t code) {
+    return fromCode(code, SCALE[field]);
+}
+
+int32_t RecordEncoder::quantize(SensorField field, float value, bool& clamped) {
+    clamped = false;
+    if (isnan(value)) {
+        return NAN_CODE;
+    }
+    double scaled = round((double)value * SCALE[field]);
+    if (scaled > INT32_MAX) {
+        clamped = true;
+        return INT32_MAX;
+    }
+    if (scaled < (double)NAN_CODE + 1) {
+        clamped = true;
+        return NAN_CODE + 1;
+    }
+    return (int32_t)scaled;
+}
+
+RecordDecoder::RecordDecoder(const uint8_t* in, size_t length)
+    : in(in), length(length), position(0), valid(false), error(false), fields(0), lastTimestamp(0),
+      lastInterval(0) {
+    memset(last, 0, sizeof(last));
+    memset(&stats, 0, sizeof(stats));
+    if (length < 4 || in[0] != MAGIC[0] || in[1] != MAGIC[1] || in[2] != RecordEncoder::VERSION
+        || in[3] > MAX_FIELDS) {
+        error = true;
+        return;
+    }
+    fields = in[3];
+    position = 4;
+    for (int i = 0; i < fields; i++) {
+        uint32_t scale = 0;
+        if (position >= length) {
+            error = true;
+            return;
+        }
+        fieldIds[i] = in[position++];
+        if (!readVarint(scale) || scale == 0) {
+            error = true;
+            return;
+        }
+        fieldScales[i] = (float)scale;
+    }
+    valid = true;
+}
+
+bool RecordDecoder::isValid() const {
+    return valid;
+}
+
+bool RecordDecoder::next(uint32_t& timestamp, SensorData& reading) {
+    if (!valid || error || position >= length) {
+        return false;
+    }
+    uint32_t code;
+    if (!readVarint(code)) {
+        return false;
+    }
+    int32_t interval = (int32_t)((uint32_t)lastInterval + (uint32_t)unzigzag(code));
+    uint32_t time = lastTimestamp + (uint32_t)interval;
+
+    // Decode into locals first, so a record cut off leaves the last whole one in place
+    int32_t values[MAX_FIELDS];
+    for (int i = 0; i < fields; i++) {
+        if (!readVarint(code)) {
+            return false;
+        }
+        values[i] = (int32_t)((uint32_t)last[i] + (uint32_t)unzigzag(code));
+    }
+
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        reading.*SENSOR_FIELDS[f] = NAN;
+    }
+    for (int i = 0; i < fields; i++) {
+        last[i] = values[i];
+        if (fieldIds[i] < SENSOR_FIELD_COUNT) {
+            reading.*SENSOR_FIELDS[fieldIds[i]] = fromCode(values[i], fieldScales[i]);
+        }
+    }
+    lastInterval = stats.records == 0 ? 0 : interval;
+    lastTimestamp = time;
+    timestamp = time;
+    stats.records++;
+    return true;
+}
+
+bool RecordDecoder::hasError() const {
+    return error;
+}
+
+int RecordDecoder::fieldCount() const {
+    return fields;
+}
+
+const RecordCodecStats& RecordDecoder::getStats() const {
+    return stats;
+}
+
+bool RecordDecoder::readVarint(uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (position >= length) {
+            break;
+        }
+        uint8_t byte = in[position++];
+        if (shift == 28 && byte > 0x0F) {
+            break; // More than 32 bits
+        }
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    error = true;
+    return false;
+}
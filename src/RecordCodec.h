@@ -0,0 +1,141 @@
+/**
+ * @file RecordCodec.h
+ * @brief Compact, self-describing binary format for timestamped readings
+ *
+ * A stream starts with a short header: the magic "AQ", the format
+ * VERSION, and the fields it carries, each with its id and the scale its
+ * values were quantized with. Records follow with no framing:
+ *   - the timestamp: absolute in the first record, the change in spacing
+ *     (delta of delta) after that, so readings at a steady interval cost
+ *     one byte and a gap costs a few;
+ *   - each field: the quantized value minus the previous record's.
+ * Every number is zigzag-mapped (small negative values stay small) and
+ * written as a base-128 varint. In steady air every number fits one byte,
+ * so a reading at a steady interval takes 9 bytes against 36 raw.
+ *
+ * Values are rounded to the SEN55's own output resolution (SCALE: PM 0.1
+ * µg/m³, humidity 0.01 %, temperature 0.005 °C, VOC and NOx index 0.1),
+ * so nothing the sensor reported is lost. NaN, for a field that was not
+ * valid, has its own code and survives the round trip.
+ *
+ * A decoder reads any stream of its VERSION: fields it does not know are
+ * skipped and fields the stream lacks come back as NaN, so fields can be
+ * added without breaking older readers. Records depend on the previous
+ * one, so a stream is decoded from its start; a stream cut off inside a
+ * record ends at the last whole one and reports an error.
+ *
+ * Encoder and decoder work in the caller's buffer and never allocate.
+ */
+
+#ifndef RECORD_CODEC_H
+#define RECORD_CODEC_H
+
+#include <Arduino.h>
+#include "SensorData.h"
+
+struct RecordCodecStats {
+    uint32_t records;   // Records encoded or decoded
+    uint32_t clamped;   // Values outside the 32-bit quantized range, stored as the nearest end
+};
+
+class RecordEncoder {
+public:
+    static const uint8_t VERSION = 1;
+    static const uint16_t SCALE[SENSOR_FIELD_COUNT];  // Stored value = round(reading * SCALE)
+    static const size_t MAX_VARINT = 5;                // Bytes of a 32-bit varint
+    // "AQ", version, field count, then an id and a varint scale per field
+    static const size_t HEADER_BYTES = 4 + SENSOR_FIELD_COUNT * (1 + 3);
+    static const size_t MAX_RECORD_BYTES = (1 + SENSOR_FIELD_COUNT) * MAX_VARINT;
+
+    /**
+     * @brief Start a stream in out, header included
+     *
+     * capacity should hold at least HEADER_BYTES; if it does not, add()
+     * fails and length() is 0.
+     */
+    RecordEncoder(uint8_t* out, size_t capacity);
+
+    /**
+     * @brief Append one reading
+     *
+     * @return false if the buffer may not hold it (less than MAX_RECORD_BYTES
+     *         left); nothing is written then and the stream stays valid
+     */
+    bool add(uint32_t timestamp, const SensorData& reading);
+
+    /** Start over in the same buffer (a new header and no records) */
+    void reset();
+
+    size_t length() const;
+    uint32_t count() const;
+    const RecordCodecStats& getStats() const;
+
+    /** Value a reading's field comes back as after a round trip */
+    static float quantized(SensorField field, float value);
+
+    /**
+     * @brief Stored code of a field's value (NaN has its own), for formats
+     *        built on the same resolution
+     *
+     * @param clamped Set if the value was outside the 32-bit range
+     */
+    static int32_t quantize(SensorField field, float value, bool& clamped);
+    /** Value of a code from quantize() */
+    static float dequantize(SensorField field, int32_t code);
+
+private:
+    uint8_t* out;
+    size_t capacity;
+    size_t used;
+    uint32_t lastTimestamp;
+    int32_t lastInterval;
+    int32_t last[SENSOR_FIELD_COUNT];
+    RecordCodecStats stats;
+};
+
+class RecordDecoder {
+public:
+    /**
+     * @brief Read a stream from in; the header is checked here
+     *
+     * @see isValid()
+     */
+    RecordDecoder(const uint8_t* in, size_t length);
+
+    /** The header was read and has a known magic and VERSION */
+    bool isValid() const;
+
+    /**
+     * @brief Read the next reading
+     *
+     * @return false at the end of the stream, or if it is invalid or damaged
+     */
+    bool next(uint32_t& timestamp, SensorData& reading);
+
+    /** Stopped early: bad header, a record cut off or a varint longer than 32 bits */
+    bool hasError() const;
+
+    /** Fields the stream carries (known or not) */
+    int fieldCount() const;
+    const RecordCodecStats& getStats() const;
+
+private:
+    static const int MAX_FIELDS = 32;
+
+    const uint8_t* in;
+    size_t length;
+    size_t position;
+    bool valid;
+    bool error;
+    int fields;
+    uint8_t fieldIds[MAX_FIELDS];
+    float fieldScales[MAX_FIELDS];
+    uint32_t lastTimestamp;
+    int32_t lastInterval;
+    int32_t last[MAX_FIELDS];
+    RecordCodecStats stats;
+
+    bool readVarint(uint32_t& value);
+};
+
+#endif // RECORD_CODEC_H
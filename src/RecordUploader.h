@@ -0,0 +1,45 @@
+/**
+ * @file RecordUploader.h
+ * @brief Upload backend for averaged records, chosen at run time
+ *
+ * Record handling (the RAM batch, the offline queue and the order records
+ * leave in) is the same whatever they are sent to; only the transport
+ * differs. A backend is a set of plain function pointers with a context
+ * pointer, the way Scheduler jobs and dashboard queries are registered:
+ *   - send() ships up to maxRecords records, oldest first, and returns how
+ *     many of them the backend took over (a prefix; the rest stay queued);
+ *   - delivered(), if set, marks a backend that confirms records after
+ *     send() returns (MQTT PUBACKs): it returns how many of the records
+ *     taken have been confirmed since the last call, in the order they
+ *     were taken. Records for such a backend are always sent from the
+ *     flash queue and removed from it only once confirmed, so a reboot
+ *     with records in flight sends them again instead of losing them.
+ *     Without it, records are delivered when send() returns;
+ *   - poll(), if set, runs as a scheduler job while WiFi is up, for
+ *     backends that keep a session open (acknowledgements, keepalive);
+ *   - linkLost(), if set, is called when the WiFi link dropped, since
+ *     sockets do not survive it.
+ * send() is not called more often than every minIntervalMs (ThingSpeak's
+ * rate limit).
+ */
+
+#ifndef RECORD_UPLOADER_H
+#define RECORD_UPLOADER_H
+
+#include <Arduino.h>
+#include "UploadQueue.h"
+
+struct RecordUploader {
+    static const int MAX_BATCH = 32;  // Largest maxRecords of any backend (the drain buffer's size)
+
+    const char* name;                 // For the log
+    int (*send)(const QueuedRecord* records, int count, void* context);
+    void (*poll)(void* context);      // Optional
+    void (*linkLost)(void* context);  // Optional
+    int (*delivered)(void* context);  // Optional
+    void* context;
+    unsigned long minIntervalMs;      // Between two send() calls
+    int maxRecords;                   // Per send() call, at most MAX_BATCH
+};
+
+#endif // RECORD_UPLOADER_H
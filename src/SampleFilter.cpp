@@ -0,0 +1,232 @@
+/**
+ * @file SampleFilter.cpp
+ * @brief Implementation of the running median and the outlier filter
+ */
+
+#include "SampleFilter.h"
+
+namespace {
+    const float MAD_TO_SIGMA = 1.4826f; // MAD of a normal distribution, in standard deviations
+}
+
+MedianWindow::MedianWindow() {
+    reset(CAPACITY);
+}
+
+void MedianWindow::reset(int length) {
+    this->length = length < 1 ? 1 : (length > CAPACITY ? CAPACITY : length);
+    count = 0;
+    oldest = 0;
+    lowCount = 0;
+    highCount = 0;
+}
+
+void MedianWindow::push(float value) {
+    if (count < length) {
+        uint8_t slot = (uint8_t)count++;
+        values[slot] = value;
+        insert(lowCount > 0 && value > values[low[0]], slot);
+        // Keep the halves balanced: low holds the extra value of an odd count
+        if (lowCount > highCount + 1) {
+            insert(true, removeTop(false));
+        } else if (highCount > lowCount) {
+            insert(false, removeTop(true));
+        }
+        return;
+    }
+
+    // Overwrite the oldest value where it is, then restore its heap; at most
+    // the two tops can end up on the wrong side, and swapping them fixes it
+    uint8_t slot = (uint8_t)oldest;
+    oldest = oldest + 1 == length ? 0 : oldest + 1;
+    values[slot] = value;
+    bool side = inHigh[slot];
+    siftUp(side, position[slot]);
+    siftDown(side, position[slot]);
+    if (highCount > 0 && values[low[0]] > values[high[0]]) {
+        uint8_t smaller = high[0];
+        uint8_t larger = low[0];
+        place(false, 0, smaller);
+        place(true, 0, larger);
+        siftDown(false, 0);
+        siftDown(true, 0);
+    }
+}
+
+float MedianWindow::median() const {
+    if (count == 0) {
+        return NAN;
+    }
+    if (lowCount > highCount) {
+        return values[low[0]];
+    }
+    return (values[low[0]] + values[high[0]]) * 0.5f;
+}
+
+int MedianWindow::size() const {
+    return count;
+}
+
+bool MedianWindow::isFull() const {
+    return count == length;
+}
+
+bool MedianWindow::above(bool inHighHeap, uint8_t a, uint8_t b) const {
+    return inHighHeap ? values[a] < values[b] : values[a] > values[b];
+}
+
+void MedianWindow::place(bool inHighHeap, int index, uint8_t slot) {
+    (inHighHeap ? high : low)[index] = slot;
+    position[slot] = (uint8_t)index;
+    inHigh[slot] = inHighHeap;
+}
+
+void MedianWindow::siftUp(bool inHighHeap, int index) {
+    uint8_t* heap = inHighHeap ? high : low;
+    uint8_t slot = heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!above(inHighHeap, slot, heap[parent])) {
+            break;
+        }
+        place(inHighHeap, index, heap[parent]);
+        index = parent;
+    }
+    place(inHighHeap, index, slot);
+}
+
+void MedianWindow::siftDown(bool inHighHeap, int index) {
+    uint8_t* heap = inHighHeap ? high : low;
+    int heapCount = inHighHeap ? highCount : lowCount;
+    uint8_t slot = heap[index];
+    while (true) {
+        int child = 2 * index + 1;
+        if (child >= heapCount) {
+            break;
+        }
+        if (child + 1 < heapCount && above(inHighHeap, heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!above(inHighHeap, heap[child], slot)) {
+            break;
+        }
+        place(inHighHeap, index, heap[child]);
+        index = child;
+    }
+    place(inHighHeap, index, slot);
+}
+
+void MedianWindow::insert(bool inHighHeap, uint8_t slot) {
+    int index = inHighHeap ? highCount++ : lowCount++;
+    place(inHighHeap, index, slot);
+    siftUp(inHighHeap, index);
+}
+
+uint8_t MedianWindow::removeTop(bool inHighHeap) {
+    uint8_t* heap = inHighHeap ? high : low;
+    int& heapCount = inHighHeap ? highCount : lowCount;
+    uint8_t top = heap[0];
+    heapCount--;
+    if (heapCount > 0) {
+        place(inHighHeap, 0, heap[heapCount]);
+        siftDown(inHighHeap, 0);
+    }
+    return top;
+}
+
+SampleFilter::SampleFilter(const SampleFilterConfig& config) {
+    memset(&stats, 0, sizeof(stats));
+    configure(config);
+}
+
+void SampleFilter::configure(const SampleFilterConfig& config) {
+    this->config = config;
+    if (this->config.window > MAX_WINDOW) {
+        this->config.window = MAX_WINDOW;
+    }
+    reset();
+}
+
+SensorData SampleFilter::apply(const SensorData& reading, unsigned long timestampMs) {
+    SensorData output = reading;
+    bool useMedian = config.window >= 3;
+    float seconds = hasLast ? (timestampMs - lastMs) / 1000.0f : 0.0f;
+    stats.readings++;
+
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        float value = reading.*SENSOR_FIELDS[f];
+        if (isnan(value)) {
+            continue;
+        }
+        MedianWindow& window = readings[f];
+        float median = window.median();
+        bool ready = useMedian && window.isFull();
+        float result = value;
+
+        float maxRate = config.maxRate[f];
+        float previous = lastOutput[f];
+        if (maxRate > 0.0f && hasLast && !isnan(previous) && fabsf(value - previous) > maxRate * seconds) {
+            // Back to the median; without one yet, move at the limit
+            float step = maxRate * seconds;
+            result = ready ? median : (value > previous ? previous + step : previous - step);
+            stats.rateLimited[f]++;
+        } else if (ready) {
+            float scale = MAD_TO_SIGMA * deviations[f].median();
+            if (!(scale >= config.minScale[f])) {
+                scale = config.minScale[f];
+            }
+            if (fabsf(value - median) > config.threshold * scale) {
+                result = median;
+                stats.outliers[f]++;
+            }
+        }
+
+        if (useMedian) {
+            // Raw values go in, so a lasting change takes the median with it
+            if (window.size() > 0) {
+                deviations[f].push(fabsf(value - median));
+            }
+            window.push(value);
+        }
+        output.*SENSOR_FIELDS[f] = result;
+        lastOutput[f] = result;
+    }
+    lastMs = timestampMs;
+    hasLast = true;
+    return output;
+}
+
+void SampleFilter::reset() {
+    int length = config.window < 1 ? 1 : config.window;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        readings[f].reset(length);
+        deviations[f].reset(length);
+        lastOutput[f] = NAN;
+    }
+    lastMs = 0;
+    hasLast = false;
+}
+
+const SampleFilterConfig& SampleFilter::getConfig() const {
+    return config;
+}
+
+const SampleFilterStats& SampleFilter::getStats() const {
+    return stats;
+}
+
+uint32_t SampleFilter::totalOutliers() const {
+    uint32_t total = 0;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        total += stats.outliers[f];
+    }
+    return total;
+}
+
+uint32_t SampleFilter::totalRateLimited() const {
+    uint32_t total = 0;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        total += stats.rateLimited[f];
+    }
+    return total;
+}
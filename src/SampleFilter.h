@@ -0,0 +1,130 @@
+/**
+ * @file SampleFilter.h
+ * @brief Streaming outlier rejection between the sensor and the averager
+ *
+ * A dust grain or an insect passing the SEN55's fan inlet shows up as one
+ * reading of a few hundred µg/m³; averaged in, it moves a 15-reading record
+ * by ten or more. SampleFilter sits between a valid reading and
+ * DataAveraging and, per field:
+ *   - rate limit: a value that moved further from the previous output than
+ *     maxRate per second allows is replaced by the running median (moved
+ *     towards at maxRate until the window has filled; 0 turns it off);
+ *   - Hampel identifier: a value further than threshold x scale from the
+ *     median of the last window readings is replaced by that median. The
+ *     scale is 1.4826 x the median of the recent absolute deviations from
+ *     the running median (the MAD, streaming), floored at minScale, the
+ *     field's noise, so a flat stretch of identical readings does not
+ *     reject the next honest change.
+ * The median window holds raw readings, so a real step (smoke, a window
+ * opened) passes once it lasts more than half the window; only shorter
+ * excursions are removed.
+ *
+ * Each running median is two heaps over a ring of the window's readings,
+ * the smaller half in a max-heap and the larger in a min-heap, so the
+ * median is at the tops and a new reading replaces the oldest in
+ * O(log window). Memory is fixed (MAX_WINDOW readings per field, twice);
+ * nothing is allocated.
+ */
+
+#ifndef SAMPLE_FILTER_H
+#define SAMPLE_FILTER_H
+
+#include <Arduino.h>
+#include "SensorData.h"
+
+struct SampleFilterConfig {
+    int window;                          // Readings in the running median; below 3 turns the median test off
+    float threshold;                     // Outlier: further than threshold x scale from the median
+    float minScale[SENSOR_FIELD_COUNT];  // Smallest scale, in field units (the sensor's own noise)
+    float maxRate[SENSOR_FIELD_COUNT];   // Largest change per second from the previous output; 0: no limit
+};
+
+struct SampleFilterStats {
+    uint32_t readings;                        // Readings filtered
+    uint32_t outliers[SENSOR_FIELD_COUNT];    // Values replaced by the running median
+    uint32_t rateLimited[SENSOR_FIELD_COUNT]; // Values replaced for changing too fast
+};
+
+/**
+ * @brief Median of the last length values, updated in O(log length)
+ *
+ * Values sit in a ring in arrival order; the heaps hold ring slots, and
+ * each slot knows its heap and position, so the oldest value can be
+ * overwritten in place and sifted to where it belongs.
+ */
+class MedianWindow {
+public:
+    static const int CAPACITY = 61;
+
+    MedianWindow();
+
+    /** Empty the window and set its length (1..CAPACITY) */
+    void reset(int length);
+
+    /** Add a value, replacing the oldest once the window is full */
+    void push(float value);
+
+    /** Median of the values (the mean of the middle two for an even count); NaN when empty */
+    float median() const;
+
+    int size() const;
+    bool isFull() const;
+
+private:
+    float values[CAPACITY];
+    uint8_t low[CAPACITY / 2 + 1];   // Max-heap of slots: the smaller half, one more for an odd count
+    uint8_t high[CAPACITY / 2 + 1];  // Min-heap of slots: the larger half
+    uint8_t position[CAPACITY];      // Slot's index in its heap
+    bool inHigh[CAPACITY];           // Slot's heap
+    int length;
+    int count;
+    int oldest;                      // Slot the next value replaces once full
+    int lowCount;
+    int highCount;
+
+    bool above(bool inHighHeap, uint8_t a, uint8_t b) const;
+    void place(bool inHighHeap, int index, uint8_t slot);
+    void siftUp(bool inHighHeap, int index);
+    void siftDown(bool inHighHeap, int index);
+    void insert(bool inHighHeap, uint8_t slot);
+    uint8_t removeTop(bool inHighHeap);
+};
+
+class SampleFilter {
+public:
+    static const int MAX_WINDOW = MedianWindow::CAPACITY;
+
+    explicit SampleFilter(const SampleFilterConfig& config);
+
+    /** Replace the configuration; the windows start empty again */
+    void configure(const SampleFilterConfig& config);
+
+    /**
+     * @brief Filter one reading
+     *
+     * The median test starts once window readings have been seen; NaN
+     * fields pass through and are left out of the windows.
+     *
+     * @param timestampMs millis() of the reading, for the rate limits
+     */
+    SensorData apply(const SensorData& reading, unsigned long timestampMs);
+
+    /** Forget the readings seen so far (counters are kept) */
+    void reset();
+
+    const SampleFilterConfig& getConfig() const;
+    const SampleFilterStats& getStats() const;
+    uint32_t totalOutliers() const;
+    uint32_t totalRateLimited() const;
+
+private:
+    SampleFilterConfig config;
+    MedianWindow readings[SENSOR_FIELD_COUNT];
+    MedianWindow deviations[SENSOR_FIELD_COUNT]; // |reading - running median| as each reading arrived
+    float lastOutput[SENSOR_FIELD_COUNT];
+    unsigned long lastMs;
+    bool hasLast;
+    SampleFilterStats stats;
+};
+
+#endif // SAMPLE_FILTER_H
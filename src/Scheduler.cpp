@@ -0,0 +1,182 @@
+/**
+ * @file Scheduler.cpp
+ * @brief Implementation of the deadline-ordered job scheduler
+ */
+
+#include "Scheduler.h"
+
+Scheduler::Scheduler() : heapSize(0), count(0), runningId(INVALID_JOB) {
+    memset(jobs, 0, sizeof(jobs));
+    for (int i = 0; i < MAX_JOBS; i++) {
+        jobs[i].heapIndex = -1;
+    }
+}
+
+int Scheduler::every(const char* name, uint32_t periodMs, SchedulerCallback callback, void* context,
+                     uint32_t now, uint32_t firstInMs) {
+    if (periodMs == 0) {
+        return INVALID_JOB; // Would be due forever
+    }
+    return allocate(name, callback, context, periodMs, now + firstInMs);
+}
+
+int Scheduler::after(const char* name, uint32_t delayMs, SchedulerCallback callback, void* context, uint32_t now) {
+    return allocate(name, callback, context, 0, now + delayMs);
+}
+
+int Scheduler::allocate(const char* name, SchedulerCallback callback, void* context, uint32_t periodMs,
+                        uint32_t deadline) {
+    if (!name || !callback) {
+        return INVALID_JOB;
+    }
+    for (int id = 0; id < MAX_JOBS; id++) {
+        if (jobs[id].name || id == runningId) {
+            continue; // The running job's slot stays reserved until its stats are written
+        }
+        Job& job = jobs[id];
+        job.name = name;
+        job.callback = callback;
+        job.context = context;
+        job.periodMs = periodMs;
+        job.deadline = deadline;
+        memset(&job.stats, 0, sizeof(job.stats));
+        count++;
+        push(id);
+        return id;
+    }
+    return INVALID_JOB;
+}
+
+bool Scheduler::cancel(int id) {
+    if (id < 0 || id >= MAX_JOBS || !jobs[id].name) {
+        return false;
+    }
+    if (jobs[id].heapIndex >= 0) {
+        remove(jobs[id].heapIndex);
+    }
+    jobs[id].name = nullptr; // A running job sees this and is not rescheduled
+    count--;
+    return true;
+}
+
+int Scheduler::runDue(uint32_t now) {
+    int ran = 0;
+    // Jobs scheduled by callbacks for "now" run in this pass too; a periodic
+    // job cannot run twice in one pass because its next deadline is after now
+    while (heapSize > 0 && !earlier(now, jobs[heap[0]].deadline)) {
+        int id = heap[0];
+        remove(0);
+        Job& job = jobs[id];
+        SchedulerCallback callback = job.callback;
+        void* context = job.context;
+
+        uint32_t lateMs = now - job.deadline;
+        if (lateMs > job.stats.maxLateMs) {
+            job.stats.maxLateMs = lateMs;
+        }
+        job.stats.runs++;
+
+        runningId = id;
+        unsigned long start = micros();
+        callback(context);
+        uint32_t runUs = (uint32_t)(micros() - start);
+        runningId = INVALID_JOB;
+        job.stats.totalRunUs += runUs;
+        if (runUs > job.stats.maxRunUs) {
+            job.stats.maxRunUs = runUs;
+        }
+        ran++;
+
+        if (!job.name) {
+            continue; // Cancelled itself
+        }
+        if (job.periodMs == 0) {
+            job.name = nullptr; // One-shot: done
+            count--;
+        } else {
+            job.deadline += job.periodMs;
+            if (!earlier(now, job.deadline)) {
+                // A period or more behind: skip to the next deadline after now
+                uint32_t behind = (now - job.deadline) / job.periodMs + 1;
+                job.stats.overruns += behind;
+                job.deadline += behind * job.periodMs;
+            }
+            push(id);
+        }
+    }
+    return ran;
+}
+
+uint32_t Scheduler::msUntilNext(uint32_t now) const {
+    if (heapSize == 0) {
+        return NO_DEADLINE;
+    }
+    uint32_t deadline = jobs[heap[0]].deadline;
+    return earlier(now, deadline) ? deadline - now : 0;
+}
+
+int Scheduler::jobCount() const {
+    return count;
+}
+
+const char* Scheduler::jobName(int id) const {
+    return id >= 0 && id < MAX_JOBS ? jobs[id].name : nullptr;
+}
+
+const SchedulerJobStats& Scheduler::jobStats(int id) const {
+    return jobs[id >= 0 && id < MAX_JOBS ? id : 0].stats;
+}
+
+void Scheduler::push(int id) {
+    place(heapSize++, id);
+    siftUp(jobs[id].heapIndex);
+}
+
+void Scheduler::remove(int heapIndex) {
+    jobs[heap[heapIndex]].heapIndex = -1;
+    heapSize--;
+    if (heapIndex == heapSize) {
+        return;
+    }
+    // Move the last entry into the hole and restore the heap in whichever direction it violates
+    place(heapIndex, heap[heapSize]);
+    siftDown(heapIndex);
+    siftUp(heapIndex);
+}
+
+void Scheduler::place(int heapIndex, int id) {
+    heap[heapIndex] = id;
+    jobs[id].heapIndex = heapIndex;
+}
+
+void Scheduler::siftUp(int heapIndex) {
+    int id = heap[heapIndex];
+    while (heapIndex > 0) {
+        int parent = (heapIndex - 1) / 2;
+        if (!earlier(jobs[id].deadline, jobs[heap[parent]].deadline)) {
+            break;
+        }
+        place(heapIndex, heap[parent]);
+        heapIndex = parent;
+    }
+    place(heapIndex, id);
+}
+
+void Scheduler::siftDown(int heapIndex) {
+    int id = heap[heapIndex];
+    for (;;) {
+        int child = 2 * heapIndex + 1;
+        if (child >= heapSize) {
+            break;
+        }
+        if (child + 1 < heapSize && earlier(jobs[heap[child + 1]].deadline, jobs[heap[child]].deadline)) {
+            child++;
+        }
+        if (!earlier(jobs[heap[child]].deadline, jobs[id].deadline)) {
+            break;
+        }
+        place(heapIndex, heap[child]);
+        heapIndex = child;
+    }
+    place(heapIndex, id);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file Scheduler.h
+ * @brief Allocation-free cooperative scheduler for loop()'s periodic work
+ *
+ * Jobs are plain function pointers with a context pointer, kept in a fixed
+ * table and ordered by deadline in a binary min-heap, so adding a job never
+ * allocates and finding the next one is O(1). runDue() runs every job whose
+ * deadline has passed, earliest first; msUntilNext() tells the caller how
+ * long it may sleep. Periodic jobs keep a fixed cadence (the next deadline
+ * is the previous one plus the period, not the finish time), and a job
+ * that falls a whole period behind skips the missed runs instead of
+ * running back to back, counting each as an overrun.
+ *
+ * Jobs run on the caller's task, one at a time, and must not block for
+ * long: a job that runs late delays every job behind it. Each job's
+ * run count, run time and worst start delay are kept for diagnostics.
+ *
+ * All times are millis() values; deadlines compare with wrap-safe
+ * arithmetic, so the scheduler survives the 49-day millis() wrap.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+typedef void (*SchedulerCallback)(void* context);
+
+struct SchedulerJobStats {
+    uint32_t runs;        // Times the job ran
+    uint32_t overruns;    // Whole periods skipped because the job ran that late
+    uint32_t maxLateMs;   // Worst start delay past the deadline
+    uint32_t maxRunUs;    // Longest single run
+    uint64_t totalRunUs;  // Time spent in the job
+};
+
+class Scheduler {
+public:
+    static const int MAX_JOBS = 8;
+    static const int INVALID_JOB = -1;
+    static const uint32_t NO_DEADLINE = 0xFFFFFFFFUL;  // msUntilNext() with nothing scheduled
+
+    Scheduler();
+
+    /**
+     * @brief Run callback every periodMs
+     *
+     * @param firstInMs Delay before the first run (0 = at the next runDue())
+     * @return Job id, or INVALID_JOB if the table is full or periodMs is 0
+     */
+    int every(const char* name, uint32_t periodMs, SchedulerCallback callback, void* context,
+              uint32_t now, uint32_t firstInMs = 0);
+
+    /**
+     * @brief Run callback once, delayMs from now
+     *
+     * The callback may schedule itself again (it gets a new id).
+     * @return Job id, or INVALID_JOB if the table is full
+     */
+    int after(const char* name, uint32_t delayMs, SchedulerCallback callback, void* context, uint32_t now);
+
+    /** Remove a job; safe from inside any callback, including the job's own */
+    bool cancel(int id);
+
+    /**
+     * @brief Run every job that is due, earliest deadline first
+     *
+     * @return Number of jobs run
+     */
+    int runDue(uint32_t now);
+
+    /** Milliseconds until the next deadline: 0 if a job is due, NO_DEADLINE if none is scheduled */
+    uint32_t msUntilNext(uint32_t now) const;
+
+    int jobCount() const;
+
+    /** Name of a job slot, nullptr if the slot is free */
+    const char* jobName(int id) const;
+    const SchedulerJobStats& jobStats(int id) const;
+
+private:
+    struct Job {
+        const char* name;       // nullptr while the slot is free
+        SchedulerCallback callback;
+        void* context;
+        uint32_t periodMs;      // 0 for one-shot jobs
+        uint32_t deadline;      // millis() when due
+        int heapIndex;          // Position in heap, -1 while running or free
+        SchedulerJobStats stats;
+    };
+
+    Job jobs[MAX_JOBS];
+    int heap[MAX_JOBS];         // Job ids, min-heap on deadline
+    int heapSize;
+    int count;
+    int runningId;              // Job whose callback is running; its slot is not reused meanwhile
+
+    static bool earlier(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+    int allocate(const char* name, SchedulerCallback callback, void* context, uint32_t periodMs, uint32_t deadline);
+    void push(int id);
+    void remove(int heapIndex);
+    void place(int heapIndex, int id);
+    void siftUp(int heapIndex);
+    void siftDown(int heapIndex);
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,53 @@
+/*
+ * SensorData.h
+ * Canonical SEN55 reading type shared by acquisition, averaging and upload
+ */
+
+#ifndef SENSOR_DATA_H
+#define SENSOR_DATA_H
+
+#include <Arduino.h>
+
+// One complete SEN55 reading
+struct SensorData {
+    float pm1;          // PM1.0 concentration (µg/m³)
+    float pm25;         // PM2.5 concentration (µg/m³)
+    float pm4;          // PM4.0 concentration (µg/m³)
+    float pm10;         // PM10 concentration (µg/m³)
+    float humidity;     // Relative humidity (%)
+    float temperature;  // Temperature (°C)
+    float voc;          // VOC index
+    float nox;          // NOx index
+};
+
+// Field indices, in SensorData declaration order
+enum SensorField {
+    FIELD_PM1,
+    FIELD_PM25,
+    FIELD_PM4,
+    FIELD_PM10,
+    FIELD_HUMIDITY,
+    FIELD_TEMPERATURE,
+    FIELD_VOC,
+    FIELD_NOX,
+    SENSOR_FIELD_COUNT
+};
+
+// Member pointers indexed by SensorField, for code that treats every field the
+// same way. Defined here (const, so internal linkage) rather than extern so
+// the offsets are compile-time constants and per-field loops fully unroll.
+float SensorData::* const SENSOR_FIELDS[SENSOR_FIELD_COUNT] = {
+    &SensorData::pm1, &SensorData::pm25, &SensorData::pm4, &SensorData::pm10,
+    &SensorData::humidity, &SensorData::temperature, &SensorData::voc, &SensorData::nox
+};
+
+// Per-field statistics over a window of readings
+struct SensorStats {
+    SensorData mean;
+    SensorData variance;  // Sample variance (n - 1); 0 with fewer than 2 readings
+    SensorData min;
+    SensorData max;
+    int count;
+};
+
+#endif
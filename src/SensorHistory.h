@@ -0,0 +1,127 @@
+/*
+ * SensorHistory.h
+ * Fixed-capacity struct-of-arrays ring buffer of sensor readings
+ */
+
+#ifndef SENSOR_HISTORY_H
+#define SENSOR_HISTORY_H
+
+#include <Arduino.h>
+#include "SensorData.h"
+#include "SensorKernels.h"
+
+/**
+ * @brief Ring buffer storing each SensorData field in its own array
+ * 
+ * Keeping a field's samples contiguous turns window statistics into one
+ * pass of SensorKernels per field (two when the window wraps the ring),
+ * instead of striding through 32-byte SensorData records. Storage is
+ * SENSOR_FIELD_COUNT * CAPACITY floats, allocated statically.
+ * 
+ * @tparam CAPACITY Maximum number of readings kept
+ */
+template <int CAPACITY>
+class SensorHistory {
+public:
+    SensorHistory() : head(0), count(0) {}
+    
+    /**
+     * @brief Append a reading, overwriting the oldest when full
+     */
+    void push(const SensorData& reading) {
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            values[f][head] = reading.*SENSOR_FIELDS[f];
+        }
+        head = head + 1 == CAPACITY ? 0 : head + 1;
+        if (count < CAPACITY) count++;
+    }
+    
+    /**
+     * @brief Reading at position index, 0 = oldest still held
+     */
+    SensorData at(int index) const {
+        int slot = head - count + index;
+        if (slot < 0) slot += CAPACITY;
+        SensorData reading;
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            reading.*SENSOR_FIELDS[f] = values[f][slot];
+        }
+        return reading;
+    }
+    
+    /**
+     * @brief Reading that the next push() will overwrite (only meaningful when full)
+     */
+    SensorData oldest() const { return at(0); }
+    
+    int size() const { return count; }
+    bool isFull() const { return count == CAPACITY; }
+    static int capacity() { return CAPACITY; }
+    
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+    
+    /**
+     * @brief Sum, min and max of one field over the newest window readings
+     */
+    FieldSummary summarizeField(int field, int window) const {
+        FieldSummary summary = emptyFieldSummary();
+        int firstStart, firstLength, secondLength;
+        spans(window, firstStart, firstLength, secondLength);
+        summarizeSpan(&values[field][firstStart], firstLength, summary);
+        summarizeSpan(&values[field][0], secondLength, summary);
+        return summary;
+    }
+    
+    /**
+     * @brief Mean, sample variance, min and max of every field over the newest window readings
+     */
+    SensorStats reduce(int window) const {
+        SensorStats stats;
+        int firstStart, firstLength, secondLength;
+        spans(window, firstStart, firstLength, secondLength);
+        stats.count = firstLength + secondLength;
+        
+        for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+            float SensorData::* member = SENSOR_FIELDS[f];
+            FieldSummary summary = emptyFieldSummary();
+            summarizeSpan(&values[f][firstStart], firstLength, summary);
+            summarizeSpan(&values[f][0], secondLength, summary);
+            
+            float mean = stats.count ? summary.sum / stats.count : NAN;
+            float squares = sumSquaredDeviations(&values[f][firstStart], firstLength, mean)
+                          + sumSquaredDeviations(&values[f][0], secondLength, mean);
+            stats.mean.*member = mean;
+            stats.variance.*member = stats.count > 1 ? squares / (stats.count - 1) : 0.0f;
+            stats.min.*member = stats.count ? summary.min : NAN;
+            stats.max.*member = stats.count ? summary.max : NAN;
+        }
+        return stats;
+    }
+    
+private:
+    float values[SENSOR_FIELD_COUNT][CAPACITY];
+    int head;   // Slot the next reading is written to
+    int count;  // Readings held
+    
+    // The newest window readings as [firstStart, firstStart + firstLength)
+    // followed by [0, secondLength) when they wrap around the ring
+    void spans(int window, int& firstStart, int& firstLength, int& secondLength) const {
+        if (window > count) window = count;
+        if (window < 0) window = 0;
+        int start = head - window;
+        if (start >= 0) {
+            firstStart = start;
+            firstLength = window;
+            secondLength = 0;
+        } else {
+            firstStart = start + CAPACITY;
+            firstLength = CAPACITY - firstStart;
+            secondLength = head;
+        }
+    }
+};
+
+#endif
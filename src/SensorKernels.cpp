@@ -0,0 +1,68 @@
+/*
+ * SensorKernels.cpp
+ * Lane-parallel reduction kernels for struct-of-arrays sensor history
+ */
+
+#include "SensorKernels.h"
+
+FieldSummary emptyFieldSummary() {
+    FieldSummary summary = {0.0f, INFINITY, -INFINITY, 0};
+    return summary;
+}
+
+void summarizeSpan(const float* values, int n, FieldSummary& summary) {
+    if (n <= 0) return;
+    float sum[SENSOR_KERNEL_LANES];
+    float lo[SENSOR_KERNEL_LANES];
+    float hi[SENSOR_KERNEL_LANES];
+    for (int k = 0; k < SENSOR_KERNEL_LANES; k++) {
+        sum[k] = 0.0f;
+        lo[k] = INFINITY;
+        hi[k] = -INFINITY;
+    }
+    
+    int i = 0;
+    for (; i + SENSOR_KERNEL_LANES <= n; i += SENSOR_KERNEL_LANES) {
+        for (int k = 0; k < SENSOR_KERNEL_LANES; k++) {
+            float x = values[i + k];
+            sum[k] += x;
+            lo[k] = x < lo[k] ? x : lo[k];
+            hi[k] = x > hi[k] ? x : hi[k];
+        }
+    }
+    for (int k = 0; i < n; i++, k++) {
+        float x = values[i];
+        sum[k] += x;
+        lo[k] = x < lo[k] ? x : lo[k];
+        hi[k] = x > hi[k] ? x : hi[k];
+    }
+    
+    for (int k = 0; k < SENSOR_KERNEL_LANES; k++) {
+        summary.sum += sum[k];
+        if (lo[k] < summary.min) summary.min = lo[k];
+        if (hi[k] > summary.max) summary.max = hi[k];
+    }
+    summary.count += n;
+}
+
+float sumSquaredDeviations(const float* values, int n, float mean) {
+    if (n <= 0) return 0.0f;
+    float acc[SENSOR_KERNEL_LANES];
+    for (int k = 0; k < SENSOR_KERNEL_LANES; k++) acc[k] = 0.0f;
+    
+    int i = 0;
+    for (; i + SENSOR_KERNEL_LANES <= n; i += SENSOR_KERNEL_LANES) {
+        for (int k = 0; k < SENSOR_KERNEL_LANES; k++) {
+            float d = values[i + k] - mean;
+            acc[k] += d * d;
+        }
+    }
+    for (int k = 0; i < n; i++, k++) {
+        float d = values[i] - mean;
+        acc[k] += d * d;
+    }
+    
+    float total = 0.0f;
+    for (int k = 0; k < SENSOR_KERNEL_LANES; k++) total += acc[k];
+    return total;
+}
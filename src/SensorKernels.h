@@ -0,0 +1,35 @@
+/*
+ * SensorKernels.h
+ * Batch reduction kernels over contiguous arrays of one sensor field
+ *
+ * The loops keep SENSOR_KERNEL_LANES independent accumulators so the
+ * compiler can map them onto SIMD registers on the host (no -ffast-math
+ * needed, the summation order is fixed by the code) and unroll them on the
+ * Xtensa. Inputs are expected to be validated (finite) readings.
+ */
+
+#ifndef SENSOR_KERNELS_H
+#define SENSOR_KERNELS_H
+
+#include <Arduino.h>
+
+const int SENSOR_KERNEL_LANES = 4;
+
+// Running summary of one field across one or more spans
+struct FieldSummary {
+    float sum;
+    float min;
+    float max;
+    int count;
+};
+
+// Start a summary with no values (min = +inf, max = -inf)
+FieldSummary emptyFieldSummary();
+
+// Fold values[0..n) into summary
+void summarizeSpan(const float* values, int n, FieldSummary& summary);
+
+// Sum of (values[i] - mean)^2 over values[0..n)
+float sumSquaredDeviations(const float* values, int n, float mean);
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "SensorManager.h"
 #include "SensorUtils.h"
+#include "Logger.h"
 
 SensorManager::SensorManager(SensirionI2CSen5x* sen5x) 
     : sensor(sen5x), initialized(false), tempOffset(0.0) {
@@ -31,9 +32,7 @@ bool SensorManager::begin(uint8_t sda, uint8_t scl, float temperatureOffset) {
         Serial.println(errorMessage);
         return false;
     }
-    Serial.println("  ✓ Sensor reset OK");
-    
-    delay(1000); // Wait for sensor to stabilize after reset
+    Serial.println("  ✓ Sensor reset OK"); // deviceReset() already waited out the reset time
     
     // Set temperature offset
     error = sensor->setTemperatureOffsetSimple(tempOffset);
@@ -65,21 +64,33 @@ bool SensorManager::begin(uint8_t sda, uint8_t scl, float temperatureOffset) {
     return true;
 }
 
-bool SensorManager::readData(float &pm1, float &pm25, float &pm4, float &pm10,
-                              float &humidity, float &temperature, float &voc, float &nox) {
+bool SensorManager::readData(SensorData &reading) {
     if (!initialized) {
-        Serial.println("✗ Sensor not initialized");
+        Log.error(LOG_SENSOR_NOT_INITIALIZED);
         return false;
     }
     
-    uint16_t error = sensor->readMeasuredValues(pm1, pm25, pm4, pm10, 
-                                                 humidity, temperature, voc, nox);
+    uint16_t error = sensor->readMeasuredValues(reading.pm1, reading.pm25, reading.pm4, reading.pm10,
+                                                 reading.humidity, reading.temperature, reading.voc, reading.nox);
     
     if (error) {
-        char errorMessage[256];
-        errorToString(error, errorMessage, 256);
-        Serial.print("✗ ERROR reading sensor: ");
-        Serial.println(errorMessage);
+        // Runs on the sensor task: queue the code rather than format the text here
+        Log.error(LOG_SENSOR_READ_ERROR, (unsigned)error);
+        return false;
+    }
+    
+    return true;
+}
+
+bool SensorManager::readDataReady(bool &ready) {
+    ready = false;
+    if (!initialized) {
+        return false;
+    }
+    
+    uint16_t error = sensor->readDataReady(ready);
+    if (error) {
+        Log.error(LOG_SENSOR_READY_ERROR, (unsigned)error);
         return false;
     }
     
@@ -88,39 +99,33 @@ bool SensorManager::readData(float &pm1, float &pm25, float &pm4, float &pm10,
 
 bool SensorManager::startMeasurement() {
     if (!initialized) {
-        Serial.println("✗ Sensor not initialized");
+        Log.error(LOG_SENSOR_NOT_INITIALIZED);
         return false;
     }
     
     uint16_t error = sensor->startMeasurement();
     if (error) {
-        char errorMessage[256];
-        errorToString(error, errorMessage, 256);
-        Serial.print("✗ ERROR starting measurement: ");
-        Serial.println(errorMessage);
+        Log.error(LOG_SENSOR_START_ERROR, (unsigned)error);
         return false;
     }
     
-    Serial.println("✓ Sensor measurements started");
+    Log.info(LOG_SENSOR_STARTED);
     return true;
 }
 
 bool SensorManager::stopMeasurement() {
     if (!initialized) {
-        Serial.println("✗ Sensor not initialized");
+        Log.error(LOG_SENSOR_NOT_INITIALIZED);
         return false;
     }
     
     uint16_t error = sensor->stopMeasurement();
     if (error) {
-        char errorMessage[256];
-        errorToString(error, errorMessage, 256);
-        Serial.print("✗ ERROR stopping measurement: ");
-        Serial.println(errorMessage);
+        Log.error(LOG_SENSOR_STOP_ERROR, (unsigned)error);
         return false;
     }
     
-    Serial.println("✓ Sensor measurements stopped");
+    Log.info(LOG_SENSOR_STOPPED);
     return true;
 }
 
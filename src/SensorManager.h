@@ -12,6 +12,7 @@
 #include <Arduino.h>
 #include <SensirionI2CSen5x.h>
 #include <Wire.h>
+#include "SensorData.h"
 
 class SensorManager {
 private:
@@ -41,19 +42,24 @@ public:
     /**
      * @brief Read all sensor measurements
      * 
-     * @param pm1 PM1.0 concentration (µg/m³)
-     * @param pm25 PM2.5 concentration (µg/m³)
-     * @param pm4 PM4.0 concentration (µg/m³)
-     * @param pm10 PM10 concentration (µg/m³)
-     * @param humidity Relative humidity (%)
-     * @param temperature Temperature (°C)
-     * @param voc VOC index
-     * @param nox NOx index
+     * @param reading Filled with the latest measurement
      * @return true if read successful
      * @return false if read failed
      */
-    bool readData(float &pm1, float &pm25, float &pm4, float &pm10,
-                  float &humidity, float &temperature, float &voc, float &nox);
+    bool readData(SensorData &reading);
+    
+    /**
+     * @brief Ask the sensor whether a measurement not yet read is available
+     * 
+     * Uses the SEN5x "read data-ready flag" command (one short I2C
+     * transaction); the flag clears when readData() fetches the values.
+     * Reading without it returns the previous measurement again.
+     * 
+     * @param ready Set to true if new data is waiting
+     * @return true if the flag could be read
+     * @return false on an I2C error
+     */
+    bool readDataReady(bool &ready);
     
     /**
      * @brief Start continuous measurements
@@ -0,0 +1,174 @@
+/**
+ * @file SensorTask.cpp
+ * @brief Implementation of the sensor acquisition task
+ */
+
+#include "SensorTask.h"
+#include "Logger.h"
+#include "SensorUtils.h"
+
+SensorTask::SensorTask(SensorManager& sensor, SampleQueue& queue, uint32_t intervalMs)
+    : sensor(sensor), queue(queue), intervalMs(intervalMs), mode(ACQUIRE_DATA_READY), handle(nullptr),
+      consumer(nullptr), pauseRequested(false), paused(false), haveLastData(false), haveLastTick(false),
+      warm(false), lastReadTick(0), periodX16(pdMS_TO_TICKS(intervalMs) * 16) {
+    memset(&lastData, 0, sizeof(lastData));
+    memset(&stats, 0, sizeof(stats));
+}
+
+void SensorTask::setMode(AcquisitionMode mode) {
+    this->mode = mode;
+}
+
+void SensorTask::setConsumer(TaskHandle_t task) {
+    consumer = task;
+}
+
+bool SensorTask::start(BaseType_t core, UBaseType_t priority) {
+    if (handle) {
+        return true;
+    }
+    return xTaskCreatePinnedToCore(taskEntry, "sensor", STACK_BYTES, this, priority, &handle, core) == pdPASS;
+}
+
+void SensorTask::pause() {
+    pauseRequested = true;
+}
+
+void SensorTask::resume() {
+    pauseRequested = false;
+}
+
+const SensorTaskStats& SensorTask::getStats() const {
+    return stats;
+}
+
+const MetricHistogram& SensorTask::getReadLatency() const {
+    return readLatency;
+}
+
+void SensorTask::taskEntry(void* self) {
+    static_cast<SensorTask*>(self)->run();
+}
+
+void SensorTask::applyPause() {
+    bool requested = pauseRequested;
+    if (requested == paused) {
+        return;
+    }
+    paused = requested;
+    // The sensor restarts its sample clock; a gap here is not a miss
+    haveLastData = false;
+    haveLastTick = false;
+    warm = false;
+    // SensorManager logs the outcome
+    if (paused) {
+        sensor.stopMeasurement();
+    } else {
+        sensor.startMeasurement();
+    }
+}
+
+void SensorTask::readAndQueue() {
+    SensorSample sample;
+    sample.timestamp = millis();
+    uint32_t started = micros();
+    sample.ok = sensor.readData(sample.data);
+    readLatency.record(micros() - started);
+    stats.reads++;
+    if (!sample.ok) {
+        stats.readErrors++;
+    } else {
+        // The SEN5x hands back its last measurement again if nothing new arrived
+        if (haveLastData && memcmp(&sample.data, &lastData, sizeof(lastData)) == 0) {
+            stats.duplicates++;
+        }
+        lastData = sample.data;
+        haveLastData = true;
+        if (!warm && isValidReading(sample.data)) {
+            warm = true;
+            if (stats.firstValidMs == 0) {
+                stats.firstValidMs = sample.timestamp;
+            }
+        }
+    }
+    sample.warmingUp = !warm;
+    if (!warm && stats.firstValidMs == 0) {
+        stats.warmupReads++;
+    }
+
+    if (!queue.push(sample)) {
+        return; // loop() is far behind; counted by the queue
+    }
+    if (consumer) {
+        xTaskNotifyGive(consumer);
+    }
+    uint32_t depth = queue.size();
+    if (depth > stats.maxDepth) {
+        stats.maxDepth = depth;
+    }
+}
+
+TickType_t SensorTask::pollDataReady() {
+    bool ready = false;
+    stats.readyPolls++;
+    if (!sensor.readDataReady(ready)) {
+        stats.readErrors++;
+        return pdMS_TO_TICKS(intervalMs); // Bus trouble: do not flood it (or the log) with retries
+    }
+    if (!ready) {
+        return pdMS_TO_TICKS(POLL_MS);
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    readAndQueue();
+    if (haveLastTick) {
+        TickType_t period = pdMS_TO_TICKS(intervalMs);
+        TickType_t gap = now - lastReadTick;
+        if (gap > period + period / 2) {
+            // A gap of about n periods means n - 1 measurements went unread
+            stats.missed += (gap + period / 2) / period - 1;
+        } else if (gap > period / 2) {
+            // Track the sensor's own clock (EMA, 1/8 weight per read)
+            periodX16 += ((int32_t)(gap * 16) - (int32_t)periodX16) / 8;
+        }
+    }
+    haveLastTick = true;
+    lastReadTick = now;
+
+    // The next measurement lands one sensor period after this one
+    TickType_t expected = periodX16 / 16;
+    return expected > pdMS_TO_TICKS(GUARD_MS) ? expected - pdMS_TO_TICKS(GUARD_MS) : pdMS_TO_TICKS(POLL_MS);
+}
+
+void SensorTask::run() {
+    Log.info(LOG_SENSOR_TASK_RUNNING, (int)xPortGetCoreID());
+
+    const TickType_t period = pdMS_TO_TICKS(intervalMs);
+    TickType_t lastWake = xTaskGetTickCount();
+    TickType_t wait = 0;
+    for (;;) {
+        if (mode == ACQUIRE_INTERVAL) {
+            // Absolute deadlines: time spent reading does not push the next read back
+            vTaskDelayUntil(&lastWake, period);
+        } else {
+            lastWake = xTaskGetTickCount() + wait;
+            vTaskDelay(wait);
+        }
+        uint32_t lateMs = (xTaskGetTickCount() - lastWake) * portTICK_PERIOD_MS;
+        if (lateMs > stats.maxLateMs) {
+            stats.maxLateMs = lateMs;
+        }
+
+        applyPause();
+        if (paused) {
+            wait = period;
+            continue;
+        }
+
+        if (mode == ACQUIRE_INTERVAL) {
+            readAndQueue();
+        } else {
+            wait = pollDataReady();
+        }
+    }
+}
@@ -0,0 +1,137 @@
+/**
+ * @file SensorTask.h
+ * @brief Sensor acquisition task pinned to its own core
+ *
+ * Reads the SEN55 from a dedicated FreeRTOS task and hands each reading
+ * to loop() through a lock-free SampleQueue. The task never waits on
+ * loop(): an upload stalled on the network (on the other core) only lets
+ * samples pile up in the queue, it no longer delays or skips them.
+ * Timestamps are taken at acquisition, so the consumer can fall behind and
+ * catch up without skewing averaging windows.
+ *
+ * Reads follow the sensor's own clock. The SEN55 produces a measurement
+ * about once a second from its internal oscillator, which drifts against
+ * the ESP32's tick, so a fixed 1 s timer slowly slides across the sample
+ * boundary and then reads one measurement twice (or skips one). In
+ * ACQUIRE_DATA_READY mode the task learns the sensor's actual period from
+ * the spacing of its reads, sleeps until GUARD_MS before the next
+ * measurement is due, polls the data-ready flag every POLL_MS until it is
+ * set and reads exactly then: each measurement once, at most POLL_MS old,
+ * for about three short flag reads per measurement.
+ *
+ * The sensor is ready when its data says so, not after a fixed wait: after
+ * a (re)start the SEN55 reports NaN for the values it is still settling
+ * (temperature and humidity for a few seconds, the VOC and NOx indices for
+ * about ten), and samples are flagged warmingUp until the first reading
+ * that passes isValidReading(). How long that took after boot is kept in
+ * the stats (firstValidMs).
+ *
+ * Once started, the task is the only user of the I2C bus; other code asks
+ * it to pause() and resume() instead of stopping the sensor directly.
+ */
+
+#ifndef SENSOR_TASK_H
+#define SENSOR_TASK_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "SensorData.h"
+#include "Metrics.h"
+#include "SensorManager.h"
+#include "SpscQueue.h"
+
+/**
+ * @brief One acquisition, as handed from the sensor task to loop()
+ */
+struct SensorSample {
+    uint32_t timestamp;  // millis() when the reading was taken
+    bool ok;             // false if the I2C read failed (data is then undefined)
+    bool warmingUp;      // No valid reading yet since measurements (re)started: NaN fields are expected
+    SensorData data;
+};
+
+// 64 s of readings at 1 Hz: longer than the worst-case upload (two 10 s timeouts)
+typedef SpscQueue<SensorSample, 64> SampleQueue;
+
+enum AcquisitionMode {
+    ACQUIRE_DATA_READY, // Read when the sensor flags a new measurement
+    ACQUIRE_INTERVAL    // Read every intervalMs regardless (duplicates and misses as the clocks drift)
+};
+
+// Samples lost because loop() let the queue fill up are counted by the queue (getDropped())
+struct SensorTaskStats {
+    uint32_t reads;      // Acquisitions attempted
+    uint32_t readErrors; // Reads (or data-ready polls) that failed on the bus
+    uint32_t readyPolls; // Data-ready flag reads
+    uint32_t duplicates; // Reads that returned exactly the previous measurement
+    uint32_t missed;     // Measurements never read, estimated from gaps between data-ready reads
+    uint32_t maxDepth;   // Most samples waiting in the queue at once
+    uint32_t maxLateMs;  // Worst wake-up delay past the scheduled time
+    uint32_t warmupReads; // Reads before the first valid one (isValidReading())
+    uint32_t firstValidMs; // millis() of the first valid reading, 0 until there is one
+};
+
+class SensorTask {
+public:
+    static const uint32_t STACK_BYTES = 4096;
+    static const uint32_t POLL_MS = 10;   // Data-ready poll spacing while a measurement is due
+    static const uint32_t GUARD_MS = 20;  // Start polling this early (covers poll-granularity jitter)
+
+    /**
+     * @param sensor Initialised sensor; owned by the task once started
+     * @param queue Queue that loop() drains
+     * @param intervalMs Nominal measurement period of the sensor
+     */
+    SensorTask(SensorManager& sensor, SampleQueue& queue, uint32_t intervalMs);
+
+    /** Choose how reads are timed; call before start() */
+    void setMode(AcquisitionMode mode);
+
+    /** Task to wake (xTaskNotifyGive) after each queued sample, so it can sleep until one arrives; call before start() */
+    void setConsumer(TaskHandle_t task);
+
+    /**
+     * @brief Create the task pinned to a core
+     *
+     * @return false if FreeRTOS could not create it
+     */
+    bool start(BaseType_t core, UBaseType_t priority);
+
+    /** Stop measurements at the next tick (e.g. for OTA); samples stop arriving */
+    void pause();
+    /** Restart measurements at the next tick */
+    void resume();
+
+    /** Written only by the task; 32-bit fields, so reads from the other core are never torn */
+    const SensorTaskStats& getStats() const;
+
+    /** Duration of each SensorManager::readData() (the I2C transfer), written only by the task */
+    const MetricHistogram& getReadLatency() const;
+
+private:
+    SensorManager& sensor;
+    SampleQueue& queue;
+    uint32_t intervalMs;
+    AcquisitionMode mode;
+    TaskHandle_t handle;
+    TaskHandle_t consumer;         // Woken per sample; nullptr = none
+    volatile bool pauseRequested;  // Set by other tasks, applied by the task itself
+    bool paused;
+    bool haveLastData;        // lastData is valid
+    bool haveLastTick;        // lastReadTick is valid
+    bool warm;                // A valid reading arrived since measurements (re)started
+    SensorData lastData;      // Previous successful read, for duplicate detection
+    TickType_t lastReadTick;  // When the previous data-ready read happened
+    uint32_t periodX16;       // Learned sensor period in ticks, times 16
+    SensorTaskStats stats;
+    MetricHistogram readLatency;
+
+    static void taskEntry(void* self);
+    void run();
+    void applyPause();
+    void readAndQueue();
+    TickType_t pollDataReady();
+};
+
+#endif // SENSOR_TASK_H
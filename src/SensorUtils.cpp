@@ -5,7 +5,7 @@
 
 #include "SensorUtils.h"
 
-void getPM25Quality(float pm25, String &quality, String &colorIcon) {
+void getPM25Quality(float pm25, const char* &quality, const char* &colorIcon) {
     if (pm25 <= 15) {
         quality = "GOOD";
         colorIcon = "🟢";
@@ -21,34 +21,18 @@ void getPM25Quality(float pm25, String &quality, String &colorIcon) {
     }
 }
 
-bool isValidReading(float pm1, float pm25, float pm4, float pm10,
-                   float humidity, float temperature, float voc, float nox) {
+bool isValidReading(const SensorData &reading) {
     // Check for NaN values
-    if (isnan(pm1) || isnan(pm25) || isnan(pm4) || isnan(pm10) || 
-        isnan(humidity) || isnan(temperature) || isnan(voc) || isnan(nox)) {
-        return false;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        if (isnan(reading.*SENSOR_FIELDS[f])) {
+            return false;
+        }
     }
     
     // Sanity check for extreme values
-    if (voc < 0 || voc > 500 || nox < 0 || nox > 500) {
+    if (reading.voc < 0 || reading.voc > 500 || reading.nox < 0 || reading.nox > 500) {
         return false;
     }
     
     return true;
 }
-
-void waitForSensorStabilization() {
-    Serial.println();
-    Serial.println("Waiting for sensor to stabilize...");
-    Serial.println("(SEN55 needs ~10 seconds after power-on)");
-    
-    for (int i = 10; i > 0; i--) {
-        Serial.print("Starting in ");
-        Serial.print(i);
-        Serial.println(" seconds...");
-        delay(1000);
-    }
-    
-    Serial.println();
-    Serial.println("Sensor ready! Starting measurements...");
-}
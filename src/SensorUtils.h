@@ -7,15 +7,12 @@
 #define SENSOR_UTILS_H
 
 #include <Arduino.h>
+#include "SensorData.h"
 
-// Function to get PM2.5 air quality status
-void getPM25Quality(float pm25, String &quality, String &colorIcon);
+// Function to get PM2.5 air quality status (points at static strings, no allocation)
+void getPM25Quality(float pm25, const char* &quality, const char* &colorIcon);
 
 // Validate sensor reading values
-bool isValidReading(float pm1, float pm25, float pm4, float pm10,
-                   float humidity, float temperature, float voc, float nox);
-
-// Wait for sensor to stabilize with countdown
-void waitForSensorStabilization();
+bool isValidReading(const SensorData &reading);
 
 #endif
@@ -0,0 +1,89 @@
+/**
+ * @file SpscQueue.h
+ * @brief Lock-free single-producer / single-consumer ring buffer
+ *
+ * Hands items from one task to one other task, possibly on the other core,
+ * without a mutex: the producer only writes `tail`, the consumer only
+ * writes `head`, and each publishes its index with a release store that
+ * the other side reads with an acquire load, so a slot's contents are
+ * visible before the index that covers it. Neither side ever blocks; a
+ * full queue rejects the new item and counts it as dropped (the producer
+ * cannot discard the oldest item without racing the consumer).
+ *
+ * Indices run freely and wrap at 2^32; CAPACITY must be a power of two so
+ * `index & MASK` stays correct across the wrap. Storage is static, so the
+ * queue never allocates.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+
+#include <atomic>
+
+template <typename T, uint32_t CAPACITY>
+class SpscQueue {
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0), dropped(0) {}
+
+    /**
+     * @brief Append an item; producer side only
+     *
+     * @return false if the queue was full (the item is dropped)
+     */
+    bool push(const T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[t & MASK] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest item; consumer side only
+     *
+     * @return false if the queue was empty
+     */
+    bool pop(T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots[h & MASK];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Items waiting; exact from either side, a snapshot from anywhere else. */
+    uint32_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool isEmpty() const { return size() == 0; }
+    uint32_t capacity() const { return CAPACITY; }
+
+    /** Items ever pushed / popped (wraps at 2^32) */
+    uint32_t pushed() const { return tail.load(std::memory_order_acquire); }
+    uint32_t popped() const { return head.load(std::memory_order_acquire); }
+
+    /** Items rejected because the queue was full */
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    static const uint32_t MASK = CAPACITY - 1;
+
+    T slots[CAPACITY];
+    // Separate cache lines so producer and consumer do not contend for one
+    // (internal SRAM is uncached on the ESP32-S3; this matters on the host)
+    alignas(64) std::atomic<uint32_t> head;  // Next slot to read, written by the consumer
+    alignas(64) std::atomic<uint32_t> tail;  // Next slot to write, written by the producer
+    std::atomic<uint32_t> dropped;           // Written by the producer
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,457 @@
+/**
+ * @file TraceRecorder.cpp
+ * @brief Implementation of the field trace writer and reader
+ *
+ * On-flash layout:
+ *   /trace/00000003.trc       blocks of the current boot's trace, in order
+ *   /trace.prev/00000000.trc  the previous boot's
+ */
+
+#include "TraceRecorder.h"
+#include <LittleFS.h>
+#include "Logger.h"
+#include "RecordCodec.h"
+
+const char TraceRecorder::LINE_PREFIX[] = "#T:";
+
+namespace {
+    const char* TRACE_DIR = "/trace";
+    const char* PREVIOUS_DIR = "/trace.prev";
+    const uint8_t MAGIC[2] = {'A', 'T'};
+    const uint8_t SAMPLE_OK = 0x01;
+    const uint8_t SAMPLE_WARMING_UP = 0x02;
+    const uint8_t UPLOAD_MQTT = 0x01;
+
+    // CRC-32 (IEEE 802.3), bitwise like the upload queue's: one block every
+    // 45 s or so is not worth a lookup table
+    uint32_t crc32(const uint8_t* data, size_t length) {
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+
+    uint32_t zigzag(int32_t value) {
+        return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    }
+
+    int32_t unzigzag(uint32_t value) {
+        return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+    }
+
+    uint8_t* writeVarint(uint8_t* out, uint32_t value) {
+        while (value >= 0x80) {
+            *out++ = (uint8_t)(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = (uint8_t)value;
+        return out;
+    }
+
+    size_t base64(const uint8_t* data, size_t length, char* out) {
+        static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        size_t written = 0;
+        for (size_t i = 0; i < length; i += 3) {
+            uint32_t group = (uint32_t)data[i] << 16;
+            if (i + 1 < length) group |= (uint32_t)data[i + 1] << 8;
+            if (i + 2 < length) group |= data[i + 2];
+            out[written++] = ALPHABET[(group >> 18) & 0x3F];
+            out[written++] = ALPHABET[(group >> 12) & 0x3F];
+            out[written++] = i + 1 < length ? ALPHABET[(group >> 6) & 0x3F] : '=';
+            out[written++] = i + 2 < length ? ALPHABET[group & 0x3F] : '=';
+        }
+        return written;
+    }
+
+    void segmentPath(const char* dir, uint32_t segment, char* path, size_t length) {
+        snprintf(path, length, "%s/%08lx.trc", dir, (unsigned long)segment);
+    }
+
+    /** Name of the first file in dir, false if there is none */
+    bool firstFile(const char* dir, char* name, size_t length) {
+        File directory = LittleFS.open(dir);
+        File entry = directory ? directory.openNextFile() : File();
+        bool found = false;
+        while (entry && !found) {
+            if (!entry.isDirectory()) {
+                snprintf(name, length, "%s", entry.name());
+                found = true;
+            }
+            entry.close();
+            if (!found) {
+                entry = directory.openNextFile();
+            }
+        }
+        directory.close();
+        return found;
+    }
+}
+
+TraceRecorder::TraceRecorder()
+    : sink(TRACE_OFF), output(&Serial), full(false), segment(0), segmentBytes(0), used(0), blockFrames(0),
+      lastMs(0) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void TraceRecorder::setOutput(Print& output) {
+    this->output = &output;
+}
+
+bool TraceRecorder::begin(TraceSink sink) {
+    this->sink = TRACE_OFF;
+    if (sink == TRACE_FLASH) {
+        // Keep one earlier trace: the previous boot's replaces the one before it
+        char name[32];
+        char from[48];
+        char to[48];
+        LittleFS.mkdir(PREVIOUS_DIR);
+        while (firstFile(PREVIOUS_DIR, name, sizeof(name))) {
+            snprintf(from, sizeof(from), "%s/%s", PREVIOUS_DIR, name);
+            if (!LittleFS.remove(from)) {
+                return false;
+            }
+        }
+        LittleFS.mkdir(TRACE_DIR);
+        while (firstFile(TRACE_DIR, name, sizeof(name))) {
+            snprintf(from, sizeof(from), "%s/%s", TRACE_DIR, name);
+            snprintf(to, sizeof(to), "%s/%s", PREVIOUS_DIR, name);
+            if (!LittleFS.rename(from, to)) {
+                return false;
+            }
+        }
+        Serial.printf("✓ Trace: recording to %s (%u KB budget)\n", TRACE_DIR,
+                      (unsigned)(SEGMENT_BYTES * MAX_SEGMENTS / 1024));
+    } else if (sink == TRACE_SERIAL) {
+        Serial.printf("✓ Trace: recording to serial (%s lines)\n", LINE_PREFIX);
+    } else {
+        return false;
+    }
+    this->sink = sink;
+    full = false;
+    segment = 0;
+    segmentBytes = 0;
+    startBlock();
+    return true;
+}
+
+bool TraceRecorder::isActive() const {
+    return sink != TRACE_OFF && !full;
+}
+
+void TraceRecorder::sample(const SensorSample& sample) {
+    uint8_t* out = beginFrame(TRACE_SAMPLE, sample.timestamp);
+    if (!out) {
+        return;
+    }
+    *out++ = (sample.ok ? SAMPLE_OK : 0) | (sample.warmingUp ? SAMPLE_WARMING_UP : 0);
+    if (sample.ok) {
+        out = writeValues(out, sample.data, lastSample);
+    }
+    endFrame(out);
+}
+
+void TraceRecorder::wifi(bool up) {
+    uint8_t* out = beginFrame(TRACE_WIFI, millis());
+    if (!out) {
+        return;
+    }
+    *out++ = up ? 1 : 0;
+    endFrame(out);
+}
+
+void TraceRecorder::clock(uint32_t epoch) {
+    uint8_t* out = beginFrame(TRACE_CLOCK, millis());
+    if (!out) {
+        return;
+    }
+    endFrame(writeVarint(out, epoch));
+}
+
+void TraceRecorder::upload(unsigned long startedMs, bool mqtt, int result, int records, uint32_t durationMs) {
+    uint8_t* out = beginFrame(TRACE_UPLOAD, startedMs);
+    if (!out) {
+        return;
+    }
+    *out++ = mqtt ? UPLOAD_MQTT : 0;
+    out = writeVarint(out, zigzag(result));
+    out = writeVarint(out, (uint32_t)records);
+    endFrame(writeVarint(out, durationMs));
+}
+
+void TraceRecorder::record(const QueuedRecord& record) {
+    uint8_t* out = beginFrame(TRACE_RECORD, millis());
+    if (!out) {
+        return;
+    }
+    out = writeVarint(out, record.timestamp);
+    endFrame(writeValues(out, record.data, lastRecord));
+}
+
+void TraceRecorder::flush() {
+    if (isActive() && used > BLOCK_HEADER_BYTES) {
+        writeBlock();
+    }
+}
+
+const TraceStats& TraceRecorder::getStats() const {
+    return stats;
+}
+
+uint8_t* TraceRecorder::beginFrame(uint8_t type, uint32_t ms) {
+    if (sink == TRACE_OFF) {
+        return nullptr;
+    }
+    if (full) {
+        stats.dropped++;
+        return nullptr;
+    }
+    if (used + MAX_FRAME_BYTES > BLOCK_BYTES) {
+        writeBlock();
+        if (full) {
+            stats.dropped++;
+            return nullptr;
+        }
+    }
+    uint8_t* out = block + used;
+    *out++ = type;
+    out = writeVarint(out, zigzag((int32_t)(ms - lastMs)));
+    lastMs = ms;
+    return out;
+}
+
+void TraceRecorder::endFrame(uint8_t* end) {
+    used = end - block;
+    blockFrames++;
+}
+
+void TraceRecorder::startBlock() {
+    used = BLOCK_HEADER_BYTES;
+    blockFrames = 0;
+    lastMs = 0;
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        lastSample[f] = 0;
+        lastRecord[f] = 0;
+    }
+}
+
+void TraceRecorder::writeBlock() {
+    size_t frames = used - BLOCK_HEADER_BYTES;
+    uint32_t crc = crc32(block + BLOCK_HEADER_BYTES, frames);
+    block[0] = MAGIC[0];
+    block[1] = MAGIC[1];
+    block[2] = VERSION;
+    block[3] = (uint8_t)frames;
+    block[4] = (uint8_t)(frames >> 8);
+    memcpy(block + 5, &crc, sizeof(crc));
+    if (sink == TRACE_SERIAL) {
+        writeLine();
+        stats.frames += blockFrames;
+    } else if (writeSegment()) {
+        stats.frames += blockFrames;
+    } else {
+        stats.dropped += blockFrames;
+    }
+    startBlock();
+}
+
+void TraceRecorder::writeLine() {
+    // One write() per line, so log lines printed from the other core never split it
+    static char line[sizeof(LINE_PREFIX) + (BLOCK_BYTES + 2) / 3 * 4 + 1];
+    size_t length = strlen(LINE_PREFIX);
+    memcpy(line, LINE_PREFIX, length);
+    length += base64(block, used, line + length);
+    line[length++] = '\n';
+    output->write((const uint8_t*)line, length);
+    stats.blocks++;
+    stats.bytes += used;
+}
+
+bool TraceRecorder::writeSegment() {
+    if (segmentBytes + used > SEGMENT_BYTES) {
+        if (segment + 1 >= (uint32_t)MAX_SEGMENTS) {
+            full = true;
+            Log.warn(LOG_TRACE_FULL, (unsigned)(SEGMENT_BYTES * MAX_SEGMENTS / 1024));
+            return false;
+        }
+        segment++;
+        segmentBytes = 0;
+    }
+    char path[32];
+    segmentPath(TRACE_DIR, segment, path, sizeof(path));
+    File file = LittleFS.open(path, FILE_APPEND);
+    size_t written = file ? file.write(block, used) : 0;
+    if (file) {
+        file.close();
+    }
+    if (written != used) {
+        // The partial block fails its CRC and is skipped by the reader;
+        // continue in a fresh segment so later blocks stay aligned
+        segment++;
+        segmentBytes = 0;
+        full = segment >= (uint32_t)MAX_SEGMENTS;
+        return false;
+    }
+    segmentBytes += used;
+    stats.blocks++;
+    stats.bytes += used;
+    return true;
+}
+
+uint8_t* TraceRecorder::writeValues(uint8_t* out, const SensorData& data, int32_t* last) {
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        bool clamped;
+        int32_t code = RecordEncoder::quantize((SensorField)f, data.*SENSOR_FIELDS[f], clamped);
+        out = writeVarint(out, zigzag((int32_t)((uint32_t)code - (uint32_t)last[f])));
+        last[f] = code;
+    }
+    return out;
+}
+
+TraceReader::TraceReader(const uint8_t* in, size_t length)
+    : in(in), length(length), position(0), frame(0), blockEnd(0), lastMs(0), blockCount(0), damaged(0) {
+    memset(lastSample, 0, sizeof(lastSample));
+    memset(lastRecord, 0, sizeof(lastRecord));
+}
+
+bool TraceReader::next(TraceEvent& event) {
+    for (;;) {
+        if (frame < blockEnd) {
+            if (readFrame(event)) {
+                return true;
+            }
+            damaged++; // The rest of the block cannot be trusted
+            frame = blockEnd;
+        }
+        if (!openBlock()) {
+            return false;
+        }
+    }
+}
+
+uint32_t TraceReader::blocks() const {
+    return blockCount;
+}
+
+uint32_t TraceReader::damagedBlocks() const {
+    return damaged;
+}
+
+bool TraceReader::openBlock() {
+    bool skipping = false; // Damage found since the last good block counts once
+    while (position + TraceRecorder::BLOCK_HEADER_BYTES <= length) {
+        const uint8_t* header = in + position;
+        size_t frames = header[3] | (size_t)header[4] << 8;
+        size_t end = position + TraceRecorder::BLOCK_HEADER_BYTES + frames;
+        if (header[0] != MAGIC[0] || header[1] != MAGIC[1] || header[2] != TraceRecorder::VERSION
+            || frames > TraceRecorder::BLOCK_BYTES - TraceRecorder::BLOCK_HEADER_BYTES || end > length) {
+            // Not a block start (a torn write): look for the next one
+            damaged += skipping ? 0 : 1;
+            skipping = true;
+            position++;
+            while (position < length && in[position] != MAGIC[0]) {
+                position++;
+            }
+            continue;
+        }
+        uint32_t crc;
+        memcpy(&crc, header + 5, sizeof(crc));
+        frame = position + TraceRecorder::BLOCK_HEADER_BYTES;
+        position = end;
+        if (crc != crc32(in + frame, frames)) {
+            damaged += skipping ? 0 : 1;
+            skipping = true;
+            continue;
+        }
+        blockEnd = end;
+        lastMs = 0;
+        memset(lastSample, 0, sizeof(lastSample));
+        memset(lastRecord, 0, sizeof(lastRecord));
+        blockCount++;
+        return true;
+    }
+    if (position < length) {
+        damaged += skipping ? 0 : 1; // A header cut off at the end
+        position = length;
+    }
+    return false;
+}
+
+bool TraceReader::readFrame(TraceEvent& event) {
+    memset(&event, 0, sizeof(event));
+    event.type = in[frame++];
+    uint32_t delta;
+    if (!readVarint(delta)) {
+        return false;
+    }
+    lastMs += (uint32_t)unzigzag(delta);
+    event.ms = lastMs;
+
+    uint32_t value;
+    switch (event.type) {
+        case TRACE_SAMPLE:
+            if (frame >= blockEnd) {
+                return false;
+            }
+            event.ok = (in[frame] & SAMPLE_OK) != 0;
+            event.warmingUp = (in[frame] & SAMPLE_WARMING_UP) != 0;
+            frame++;
+            return !event.ok || readValues(event.data, lastSample);
+        case TRACE_WIFI:
+            if (frame >= blockEnd) {
+                return false;
+            }
+            event.up = in[frame++] != 0;
+            return true;
+        case TRACE_CLOCK:
+            return readVarint(event.epoch);
+        case TRACE_UPLOAD:
+            if (frame >= blockEnd) {
+                return false;
+            }
+            event.mqtt = (in[frame++] & UPLOAD_MQTT) != 0;
+            if (!readVarint(value)) {
+                return false;
+            }
+            event.result = unzigzag(value);
+            if (!readVarint(value)) {
+                return false;
+            }
+            event.records = (uint16_t)value;
+            return readVarint(event.durationMs);
+        case TRACE_RECORD:
+            return readVarint(event.epoch) && readValues(event.data, lastRecord);
+        default:
+            return false; // Unknown frames have no length to skip them by
+    }
+}
+
+bool TraceReader::readVarint(uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (frame >= blockEnd) {
+            return false;
+        }
+        uint8_t byte = in[frame++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TraceReader::readValues(SensorData& data, int32_t* last) {
+    for (int f = 0; f < SENSOR_FIELD_COUNT; f++) {
+        uint32_t value;
+        if (!readVarint(value)) {
+            return false;
+        }
+        last[f] = (int32_t)((uint32_t)last[f] + (uint32_t)unzigzag(value));
+        data.*SENSOR_FIELDS[f] = RecordEncoder::dequantize((SensorField)f, last[f]);
+    }
+    return true;
+}
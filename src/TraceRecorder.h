@@ -0,0 +1,192 @@
+/**
+ * @file TraceRecorder.h
+ * @brief Field trace of what the device saw: readings, network and timing
+ *
+ * Problems in the field happen under conditions the bench does not have:
+ * sensor glitches, WiFi that flaps, a server answering 429. The recorder
+ * writes down the inputs that drive the firmware, each with the millis()
+ * it happened at, so the native replay (the loop suite's --replay) can
+ * play them back through the real sensor task, averaging and upload code:
+ *   - TRACE_SAMPLE: every sensor read, failed or not, with its values;
+ *   - TRACE_WIFI: the link coming up or going down;
+ *   - TRACE_CLOCK: the first valid wall-clock time (SNTP);
+ *   - TRACE_UPLOAD: each request or publish, with its outcome and duration;
+ *   - TRACE_RECORD: each averaged record, the output a replay must match.
+ *
+ * Frames are a type byte, the time since the previous frame (a zigzag
+ * varint, since samples are handled a little after later events) and the
+ * payload; readings are stored as RecordCodec codes, at the SEN55's own
+ * resolution, as differences from the previous reading. At one read per
+ * second a day's trace is about 1.2 MB, 14 bytes per read with the
+ * records and uploads included.
+ *
+ * Frames are collected in a BLOCK_BYTES buffer and written a block at a
+ * time: "AT", VERSION, the frame bytes' length and CRC32, the frames.
+ * Each block starts from zero again (time and reading differences), so
+ * any block decodes on its own and a torn or damaged one costs only its
+ * own frames. Blocks go to one of two sinks:
+ *   - TRACE_FLASH: segment files under /trace, SEGMENT_BYTES each, at most
+ *     MAX_SEGMENTS; when they are full recording stops, so the trace
+ *     always starts at boot (the first few hours; replay needs the start).
+ *     The previous boot's trace is kept in /trace.prev, for a device that
+ *     restarted on its own; copy it off with the LittleFS image.
+ *   - TRACE_SERIAL: each block as one "#T:<base64>" line on the serial
+ *     port (about 60 ms of UART time every 35 s), for captures of any
+ *     length; the log lines around it are ignored by the reader.
+ * Up to one block is lost if power fails. Nothing is allocated.
+ */
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <Arduino.h>
+#include "SensorData.h"
+#include "SensorTask.h"
+#include "UploadQueue.h"
+
+enum TraceSink {
+    TRACE_OFF,
+    TRACE_FLASH,   // Segment files on LittleFS
+    TRACE_SERIAL   // "#T:" lines between the log output
+};
+
+enum TraceEventType {
+    TRACE_SAMPLE = 1,
+    TRACE_WIFI = 2,
+    TRACE_CLOCK = 3,
+    TRACE_UPLOAD = 4,
+    TRACE_RECORD = 5
+};
+
+/**
+ * @brief One decoded frame; which fields are set depends on the type
+ */
+struct TraceEvent {
+    uint8_t type;        // TraceEventType
+    uint32_t ms;         // millis() when it happened (a sample: when it was read)
+    bool ok;             // SAMPLE: the read succeeded
+    bool warmingUp;      // SAMPLE: flagged as warming up by the sensor task
+    bool up;             // WIFI: the link came up (false: it went down)
+    bool mqtt;           // UPLOAD: published to the MQTT broker (false: ThingSpeak)
+    int32_t result;      // UPLOAD: HTTP status or UploadSession error; MQTT: records taken
+    uint16_t records;    // UPLOAD: records offered
+    uint32_t durationMs; // UPLOAD: ThingSpeak: request sent to response read; MQTT: the publish call
+    uint32_t epoch;      // CLOCK: time() then; RECORD: the record's timestamp
+    SensorData data;     // SAMPLE (if ok) and RECORD
+};
+
+struct TraceStats {
+    uint32_t frames;   // Frames written to the sink
+    uint32_t blocks;   // Blocks written to the sink
+    uint32_t bytes;    // Bytes written, block headers included (before base64)
+    uint32_t dropped;  // Frames lost: flash budget full or a flash write that failed
+};
+
+class TraceRecorder {
+public:
+    static const uint8_t VERSION = 1;
+    static const size_t BLOCK_HEADER_BYTES = 9;       // "AT", version, length (2), CRC32 (4)
+    static const size_t BLOCK_BYTES = 512;            // Frames and header
+    static const size_t MAX_FRAME_BYTES = 2 + 3 * 5 + SENSOR_FIELD_COUNT * 5;
+    static const size_t SEGMENT_BYTES = 32 * 1024;
+    static const int MAX_SEGMENTS = 8;                // 256 KB: about 5 h of readings at 1 Hz
+    static const char LINE_PREFIX[];                  // "#T:"
+
+    TraceRecorder();
+
+    /** Where TRACE_SERIAL lines go (Serial unless set); call before begin() */
+    void setOutput(Print& output);
+
+    /**
+     * @brief Start a new trace
+     *
+     * TRACE_FLASH moves the previous trace to /trace.prev (mount LittleFS
+     * first, UploadQueue::begin() does).
+     *
+     * @return false if the sink is TRACE_OFF or the trace directory could
+     *         not be prepared; the recording calls do nothing then
+     */
+    bool begin(TraceSink sink);
+
+    bool isActive() const;
+
+    void sample(const SensorSample& sample);
+    void wifi(bool up);
+    void clock(uint32_t epoch);
+    /**
+     * @param startedMs millis() when the request started
+     * @param result HTTP status or negative UploadSession error (ThingSpeak),
+     *        records taken (MQTT)
+     * @param durationMs The server's part (ThingSpeak: request sent to
+     *        response read, connect excluded), or the whole publish (MQTT)
+     */
+    void upload(unsigned long startedMs, bool mqtt, int result, int records, uint32_t durationMs);
+    void record(const QueuedRecord& record);
+
+    /** Write out the frames collected so far (a part-filled block) */
+    void flush();
+
+    const TraceStats& getStats() const;
+
+private:
+    TraceSink sink;
+    Print* output;
+    bool full;                       // Flash budget used up
+    uint32_t segment;                // Current segment file
+    size_t segmentBytes;
+    uint8_t block[BLOCK_BYTES];
+    size_t used;                     // Bytes in block, header included
+    uint32_t blockFrames;            // Frames in block
+    uint32_t lastMs;                 // Time of the previous frame in the block
+    int32_t lastSample[SENSOR_FIELD_COUNT]; // Previous codes in the block
+    int32_t lastRecord[SENSOR_FIELD_COUNT];
+    TraceStats stats;
+
+    uint8_t* beginFrame(uint8_t type, uint32_t ms);
+    void endFrame(uint8_t* end);
+    void startBlock();
+    void writeBlock();
+    void writeLine();
+    bool writeSegment();
+    static uint8_t* writeValues(uint8_t* out, const SensorData& data, int32_t* last);
+};
+
+/**
+ * @brief Reads frames back from blocks laid end to end (flash segments
+ *        concatenated, or the decoded serial lines)
+ *
+ * A block whose header or CRC does not check out is skipped and counted.
+ */
+class TraceReader {
+public:
+    TraceReader(const uint8_t* in, size_t length);
+
+    /** @return false at the end of the input */
+    bool next(TraceEvent& event);
+
+    uint32_t blocks() const;
+    /**
+     * Damaged stretches skipped: a bad header, CRC mismatch or a frame that
+     * did not parse, with whatever was skipped to the next good block
+     */
+    uint32_t damagedBlocks() const;
+
+private:
+    const uint8_t* in;
+    size_t length;
+    size_t position;     // Next block
+    size_t frame;        // Next frame in the current block
+    size_t blockEnd;     // End of the current block's frames
+    uint32_t lastMs;
+    int32_t lastSample[SENSOR_FIELD_COUNT];
+    int32_t lastRecord[SENSOR_FIELD_COUNT];
+    uint32_t blockCount;
+    uint32_t damaged;
+
+    bool openBlock();
+    bool readFrame(TraceEvent& event);
+    bool readVarint(uint32_t& value);
+    bool readValues(SensorData& data, int32_t* last);
+};
+
+#endif // TRACE_RECORDER_H
@@ -0,0 +1,355 @@
+/**
+ * @file UploadQueue.cpp
+ * @brief Implementation of the LittleFS store-and-forward upload queue
+ * 
+ * On-flash layout:
+ *   /queue/0000002a.seg  fixed-size records [timestamp][SensorData][crc32]
+ *   /queue/cursor        [segment][index][crc32] of the next record to upload
+ */
+
+#include "UploadQueue.h"
+#include <LittleFS.h>
+
+namespace {
+    const char* QUEUE_DIR = "/queue";
+    const char* CURSOR_PATH = "/queue/cursor";
+    const char* SEGMENT_SUFFIX = ".seg";
+    const size_t SEGMENT_NAME_LENGTH = 12; // 8 hex digits + ".seg"
+    
+    // CRC-32 (IEEE 802.3), bitwise: records are tiny and written rarely,
+    // so a 1 KB lookup table would cost more than it saves
+    uint32_t crc32(const uint8_t* data, size_t length) {
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+    
+    struct Cursor {
+        uint32_t segment;
+        uint32_t index;
+        uint32_t crc;
+    };
+    
+    uint32_t cursorCrc(const Cursor& cursor) {
+        return crc32((const uint8_t*)&cursor, offsetof(Cursor, crc));
+    }
+}
+
+UploadQueue::UploadQueue()
+    : mounted(false), headSegment(0), headIndex(0), headRecords(0),
+      tailSegment(0), tailRecords(0), pending(0), uncommittedPops(0), removed(0) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool UploadQueue::begin() {
+    mounted = LittleFS.begin(true);
+    if (!mounted) {
+        Serial.println("✗ LittleFS mount failed - offline queue disabled");
+        return false;
+    }
+    LittleFS.mkdir(QUEUE_DIR);
+    recover();
+    
+    if (pending > 0) {
+        Serial.print("✓ Offline queue: ");
+        Serial.print(pending);
+        Serial.println(" records waiting for upload");
+    }
+    return true;
+}
+
+void UploadQueue::recover() {
+    bool found = false;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    size_t lastBytes = 0;
+    uint32_t total = 0;
+    
+    File dir = LittleFS.open(QUEUE_DIR);
+    File entry = dir ? dir.openNextFile() : File();
+    while (entry) {
+        const char* name = entry.name();
+        if (!entry.isDirectory() && strlen(name) == SEGMENT_NAME_LENGTH &&
+            strcmp(name + SEGMENT_NAME_LENGTH - strlen(SEGMENT_SUFFIX), SEGMENT_SUFFIX) == 0) {
+            uint32_t segment = (uint32_t)strtoul(name, nullptr, 16);
+            size_t bytes = entry.size();
+            total += bytes / RECORD_BYTES;
+            if (!found || segment < first) first = segment;
+            if (!found || segment > last) {
+                last = segment;
+                lastBytes = bytes;
+            }
+            found = true;
+        }
+        entry.close();
+        entry = dir.openNextFile();
+    }
+    dir.close();
+    
+    if (!found) {
+        // Nothing queued; a cursor left over from a crash mid-cleanup is stale
+        LittleFS.remove(CURSOR_PATH);
+        return;
+    }
+    
+    headSegment = first;
+    tailSegment = last;
+    tailRecords = lastBytes / RECORD_BYTES;
+    if (lastBytes % RECORD_BYTES != 0) {
+        // Torn append: keep the complete records, continue in a fresh segment
+        tailSegment = last + 1;
+        tailRecords = 0;
+    }
+    headRecords = headSegment == tailSegment ? tailRecords : readableRecords(headSegment);
+    
+    File cursorFile = LittleFS.open(CURSOR_PATH, FILE_READ);
+    if (cursorFile) {
+        Cursor cursor;
+        if (cursorFile.read((uint8_t*)&cursor, sizeof(cursor)) == sizeof(cursor) &&
+            cursor.crc == cursorCrc(cursor) && cursor.segment == headSegment &&
+            cursor.index <= headRecords) {
+            headIndex = cursor.index;
+        }
+        cursorFile.close();
+    }
+    pending = total - headIndex;
+    
+    // Drop head segments with nothing left to upload (fully sent, or torn
+    // before their first complete record)
+    while (headIndex >= headRecords && headSegment != tailSegment) {
+        removeHeadSegment();
+    }
+}
+
+void UploadQueue::segmentPath(uint32_t segment, char* path, size_t length) const {
+    snprintf(path, length, "%s/%08lx%s", QUEUE_DIR, (unsigned long)segment, SEGMENT_SUFFIX);
+}
+
+uint32_t UploadQueue::readableRecords(uint32_t segment) const {
+    char path[32];
+    segmentPath(segment, path, sizeof(path));
+    File file = LittleFS.open(path, FILE_READ);
+    if (!file) return 0;
+    uint32_t records = file.size() / RECORD_BYTES;
+    file.close();
+    return records;
+}
+
+bool UploadQueue::push(const QueuedRecord& record) {
+    if (!mounted) return false;
+    
+    if (tailRecords == (uint32_t)RECORDS_PER_SEGMENT) {
+        tailSegment++;
+        tailRecords = 0;
+        // Bound flash use: make room by discarding the oldest segment
+        if (tailSegment - headSegment >= (uint32_t)MAX_SEGMENTS) {
+            skipHeadSegment(stats.dropped);
+        }
+    }
+    
+    uint8_t bytes[RECORD_BYTES];
+    memcpy(bytes, &record.timestamp, sizeof(record.timestamp));
+    memcpy(bytes + sizeof(record.timestamp), &record.data, sizeof(record.data));
+    uint32_t crc = crc32(bytes, RECORD_BYTES - sizeof(crc));
+    memcpy(bytes + RECORD_BYTES - sizeof(crc), &crc, sizeof(crc));
+    
+    char path[32];
+    segmentPath(tailSegment, path, sizeof(path));
+    File file = LittleFS.open(path, FILE_APPEND);
+    if (!file) return false;
+    size_t written = file.write(bytes, RECORD_BYTES);
+    file.close();
+    if (written != RECORD_BYTES) {
+        // Never append after a partial record; the next push starts a new segment
+        tailRecords = RECORDS_PER_SEGMENT;
+        return false;
+    }
+    
+    tailRecords++;
+    if (headSegment == tailSegment) headRecords = tailRecords;
+    pending++;
+    stats.appended++;
+    return true;
+}
+
+bool UploadQueue::readRecord(File& file, uint32_t index, QueuedRecord& record) const {
+    uint8_t bytes[RECORD_BYTES];
+    if (!file.seek(index * RECORD_BYTES) || file.read(bytes, RECORD_BYTES) != RECORD_BYTES) {
+        return false;
+    }
+    uint32_t crc;
+    memcpy(&crc, bytes + RECORD_BYTES - sizeof(crc), sizeof(crc));
+    if (crc != crc32(bytes, RECORD_BYTES - sizeof(crc))) {
+        return false;
+    }
+    memcpy(&record.timestamp, bytes, sizeof(record.timestamp));
+    memcpy(&record.data, bytes + sizeof(record.timestamp), sizeof(record.data));
+    return true;
+}
+
+bool UploadQueue::peek(QueuedRecord& record) {
+    while (pending > 0) {
+        char path[32];
+        segmentPath(headSegment, path, sizeof(path));
+        File file = LittleFS.open(path, FILE_READ);
+        if (!file) {
+            // Segment vanished: nothing left in it can be uploaded
+            skipHeadSegment(stats.corrupt);
+            continue;
+        }
+        
+        bool valid = readRecord(file, headIndex, record);
+        file.close();
+        if (valid) {
+            return true;
+        }
+        
+        stats.corrupt++;
+        consumeHead();
+    }
+    return false;
+}
+
+int UploadQueue::peek(QueuedRecord* records, int maxRecords) {
+    return peekFrom(removed, records, maxRecords);
+}
+
+int UploadQueue::peekFrom(uint32_t position, QueuedRecord* records, int maxRecords) {
+    if (maxRecords <= 0 || !peek(records[0])) {
+        return 0;
+    }
+    uint32_t skip = position > removed ? position - removed : 0;
+    if (skip >= pending) {
+        return 0;
+    }
+    
+    // Continue from the record after the head, across segment boundaries
+    int count = skip == 0 ? 1 : 0;
+    uint32_t offset = 1;
+    uint32_t segment = headSegment;
+    uint32_t index = headIndex + 1;
+    uint32_t segmentRecords = headRecords;
+    File file;
+    while (count < maxRecords && offset < pending) {
+        if (index >= segmentRecords) {
+            if (segment == tailSegment) break;
+            file.close();
+            segment++;
+            index = 0;
+            segmentRecords = segment == tailSegment ? tailRecords : readableRecords(segment);
+            continue;
+        }
+        if (offset >= skip) {
+            if (!file) {
+                char path[32];
+                segmentPath(segment, path, sizeof(path));
+                file = LittleFS.open(path, FILE_READ);
+                if (!file) break;
+            }
+            if (!readRecord(file, index, records[count])) {
+                break; // Upload what we have; the bad record becomes the head next time
+            }
+            count++;
+        }
+        index++;
+        offset++;
+    }
+    file.close();
+    return count;
+}
+
+void UploadQueue::pop(int count) {
+    for (int i = 0; i < count && pending > 0; i++) {
+        stats.drained++;
+        consumeHead();
+    }
+    if (uncommittedPops >= CURSOR_COMMIT_INTERVAL) {
+        commitCursor();
+    }
+}
+
+void UploadQueue::consumeHead() {
+    headIndex++;
+    pending--;
+    removed++;
+    if (headIndex >= headRecords) {
+        removeHeadSegment();
+    } else {
+        uncommittedPops++;
+    }
+}
+
+void UploadQueue::skipHeadSegment(uint32_t& counter) {
+    uint32_t remaining = headRecords - headIndex;
+    counter += remaining;
+    pending -= remaining;
+    removed += remaining;
+    headIndex = headRecords;
+    removeHeadSegment();
+}
+
+void UploadQueue::removeHeadSegment() {
+    // Removing the file first means a crash in between leaves a cursor that
+    // points at a segment that no longer exists, which recover() ignores
+    char path[32];
+    segmentPath(headSegment, path, sizeof(path));
+    LittleFS.remove(path);
+    uncommittedPops = 0;
+    
+    if (headSegment == tailSegment) {
+        LittleFS.remove(CURSOR_PATH);
+        tailSegment++;
+        headSegment = tailSegment;
+        headIndex = 0;
+        headRecords = 0;
+        tailRecords = 0;
+        pending = 0;
+        return;
+    }
+    
+    headSegment++;
+    headIndex = 0;
+    headRecords = headSegment == tailSegment ? tailRecords : readableRecords(headSegment);
+    if (headRecords == 0 && headSegment != tailSegment) {
+        removeHeadSegment(); // Missing or empty segment in the middle
+    }
+}
+
+void UploadQueue::commitCursor() {
+    Cursor cursor;
+    cursor.segment = headSegment;
+    cursor.index = headIndex;
+    cursor.crc = cursorCrc(cursor);
+    
+    File file = LittleFS.open(CURSOR_PATH, FILE_WRITE);
+    if (file) {
+        file.write((const uint8_t*)&cursor, sizeof(cursor));
+        file.close();
+    }
+    uncommittedPops = 0;
+}
+
+uint32_t UploadQueue::size() const {
+    return pending;
+}
+
+bool UploadQueue::isEmpty() const {
+    return pending == 0;
+}
+
+uint32_t UploadQueue::headPosition() const {
+    return removed;
+}
+
+bool UploadQueue::isMounted() const {
+    return mounted;
+}
+
+const UploadQueueStats& UploadQueue::getStats() const {
+    return stats;
+}
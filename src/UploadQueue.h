@@ -0,0 +1,145 @@
+/**
+ * @file UploadQueue.h
+ * @brief Persistent store-and-forward queue of averaged readings on LittleFS
+ * 
+ * Records that could not be uploaded are appended to fixed-size segment
+ * files under /queue and drained oldest-first once the network is back.
+ * The queue survives reboots and power loss:
+ *   - every record carries a CRC32, so a corrupted record is skipped
+ *     instead of being uploaded as garbage;
+ *   - a torn append at the end of a segment is detected from the file size
+ *     and sealed off, appends continue in a fresh segment;
+ *   - the read position is saved to a small cursor file every
+ *     CURSOR_COMMIT_INTERVAL uploads, so after a crash at most that many
+ *     records are sent twice and none are lost.
+ * 
+ * Flash wear is bounded: nothing is written while uploads succeed, the
+ * queue never holds more than MAX_SEGMENTS segment files (the oldest
+ * segment is dropped when it is full), and fully drained segments are
+ * deleted whole. RAM use is a handful of counters; records are read from
+ * flash one at a time.
+ */
+
+#ifndef UPLOAD_QUEUE_H
+#define UPLOAD_QUEUE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "SensorData.h"
+
+/**
+ * @brief One averaged reading waiting for upload
+ */
+struct QueuedRecord {
+    uint32_t timestamp;  // Unix time of the averaging window, 0 if the clock was not synced
+    SensorData data;
+};
+
+struct UploadQueueStats {
+    uint32_t appended;   // Records written to flash
+    uint32_t drained;    // Records removed after a successful upload
+    uint32_t dropped;    // Records discarded because the queue was full
+    uint32_t corrupt;    // Records skipped because their CRC did not match
+};
+
+class UploadQueue {
+public:
+    static const int RECORDS_PER_SEGMENT = 128;    // 5 KB per segment file
+    static const int MAX_SEGMENTS = 32;            // 4096 records, ~17 h at one per 15 s
+    static const int CURSOR_COMMIT_INTERVAL = 8;   // Uploads between cursor writes
+    static const size_t RECORD_BYTES = sizeof(uint32_t) + sizeof(SensorData) + sizeof(uint32_t);
+    
+    UploadQueue();
+    
+    /**
+     * @brief Mount LittleFS and recover the queue left by the previous boot
+     * 
+     * @return true if the filesystem is usable
+     * @return false if mounting (and formatting) failed; push() then fails too
+     */
+    bool begin();
+    
+    /**
+     * @brief Append a record at the tail, dropping the oldest segment when full
+     * 
+     * @return true if the record reached flash
+     */
+    bool push(const QueuedRecord& record);
+    
+    /**
+     * @brief Read the oldest record without removing it
+     * 
+     * Corrupt records are skipped (and counted) on the way.
+     * 
+     * @return true if a record was read
+     * @return false if the queue is empty or flash could not be read
+     */
+    bool peek(QueuedRecord& record);
+    
+    /**
+     * @brief Read up to maxRecords of the oldest records without removing them
+     * 
+     * Leading corrupt records are skipped as in peek(); a corrupt record
+     * further in ends the batch early and is skipped on the next call.
+     * 
+     * @return Number of records written to records (0 if empty)
+     */
+    int peek(QueuedRecord* records, int maxRecords);
+    
+    /**
+     * @brief Like peek(), starting at a position instead of at the head
+     * 
+     * For records handed to an uploader that confirms them later: they
+     * stay queued, and the next batch starts after them.
+     * 
+     * @param position Position of the first record wanted (see
+     *        headPosition()); one already removed means the head
+     */
+    int peekFrom(uint32_t position, QueuedRecord* records, int maxRecords);
+    
+    /**
+     * @brief Remove the oldest count records (after they were uploaded)
+     */
+    void pop(int count = 1);
+    
+    /**
+     * @brief Number of records waiting
+     */
+    uint32_t size() const;
+    
+    bool isEmpty() const;
+    
+    /**
+     * @brief Position of the head record: records removed from the head
+     *        (uploaded, dropped or corrupt) since boot
+     */
+    uint32_t headPosition() const;
+    
+    /** Whether push() can reach flash (LittleFS mounted) */
+    bool isMounted() const;
+    
+    const UploadQueueStats& getStats() const;
+    
+private:
+    bool mounted;
+    uint32_t headSegment;    // Oldest segment still holding records
+    uint32_t headIndex;      // Next record to read in headSegment
+    uint32_t headRecords;    // Readable records in headSegment
+    uint32_t tailSegment;    // Segment receiving appends
+    uint32_t tailRecords;    // Records in tailSegment
+    uint32_t pending;        // Records waiting across all segments
+    int uncommittedPops;     // Pops since the cursor file was last written
+    uint32_t removed;        // Records removed from the head since boot
+    UploadQueueStats stats;
+    
+    void segmentPath(uint32_t segment, char* path, size_t length) const;
+    bool readRecord(File& file, uint32_t index, QueuedRecord& record) const;
+    uint32_t readableRecords(uint32_t segment) const;
+    void consumeHead();
+    void skipHeadSegment(uint32_t& counter);
+    void removeHeadSegment();
+    void commitCursor();
+    void recover();
+};
+
+#endif // UPLOAD_QUEUE_H
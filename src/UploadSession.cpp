@@ -0,0 +1,273 @@
+/**
+ * @file UploadSession.cpp
+ * @brief Implementation of the keep-alive upload connection
+ */
+
+#include "UploadSession.h"
+
+#include <strings.h>
+
+UploadSession::UploadSession(const char* host, uint16_t port)
+    : host(host), port(port), lastUsed(0), connectTime(0), transferTime(0), reusedLast(false) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool UploadSession::ensureConnected(bool& reused) {
+    // A socket the server already closed reports !connected() here
+    if (client.connected() && millis() - lastUsed <= MAX_IDLE_MS) {
+        reused = true;
+        return true;
+    }
+
+    client.stop();
+    reused = false;
+    unsigned long start = micros();
+    bool connected = client.connect(host, port, TIMEOUT_MS);
+    connectTime = micros() - start;
+    stats.connectMicros += connectTime;
+    if (connected) {
+        stats.connects++;
+        client.setNoDelay(true);
+    }
+    return connected;
+}
+
+bool UploadSession::waitForData() {
+    unsigned long start = millis();
+    while (!client.available()) {
+        if (!client.connected() || millis() - start >= TIMEOUT_MS) {
+            return false;
+        }
+        delay(1);
+    }
+    return true;
+}
+
+int UploadSession::readByte() {
+    return waitForData() ? client.read() : -1;
+}
+
+int UploadSession::readLine(char* line, size_t size) {
+    size_t count = 0;
+    for (;;) {
+        int c = readByte();
+        if (c < 0) {
+            return -1;
+        }
+        if (c == '\n') {
+            break;
+        }
+        if (c != '\r' && count + 1 < size) {
+            line[count++] = (char)c;
+        }
+    }
+    line[count] = '\0';
+    return (int)count;
+}
+
+bool UploadSession::readBody(size_t count, char* response, size_t responseSize, size_t& stored) {
+    for (size_t i = 0; i < count; i++) {
+        int c = readByte();
+        if (c < 0) {
+            return false;
+        }
+        if (stored + 1 < responseSize) {
+            response[stored++] = (char)c;
+        }
+    }
+    return true;
+}
+
+int UploadSession::readResponse(char* response, size_t responseSize, bool& keepOpen, bool& unanswered) {
+    char line[MAX_LINE_BYTES];
+    size_t stored = 0;
+    response[0] = '\0';
+    keepOpen = false;
+    unanswered = false;
+
+    if (!waitForData()) {
+        // Closed before the status line: the server dropped the request without acting on it
+        unanswered = !client.connected();
+        return unanswered ? HTTPC_ERROR_CONNECTION_LOST : HTTPC_ERROR_READ_TIMEOUT;
+    }
+    int length = readLine(line, sizeof(line));
+    if (length < 0) {
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    if (strncmp(line, "HTTP/1.", 7) != 0 || length < 12) {
+        return HTTPC_ERROR_NO_HTTP_SERVER;
+    }
+    int code = atoi(line + 9);
+    keepOpen = line[7] == '1'; // HTTP/1.1 defaults to keep-alive, 1.0 to close
+
+    long contentLength = -1;
+    bool chunked = false;
+    for (;;) {
+        length = readLine(line, sizeof(line));
+        if (length < 0) {
+            return HTTPC_ERROR_CONNECTION_LOST;
+        }
+        if (length == 0) {
+            break;
+        }
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            contentLength = atol(line + 15);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            chunked = strstr(line + 18, "chunked") != nullptr;
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            const char* value = line + 11;
+            while (*value == ' ') value++;
+            keepOpen = strncasecmp(value, "close", 5) != 0;
+        }
+    }
+
+    bool complete = true;
+    if (chunked) {
+        for (;;) {
+            if (readLine(line, sizeof(line)) < 0) {
+                complete = false;
+                break;
+            }
+            size_t chunk = (size_t)strtoul(line, nullptr, 16);
+            if (chunk == 0) {
+                // Skip trailers up to the blank line
+                while ((length = readLine(line, sizeof(line))) > 0) {}
+                complete = length == 0;
+                break;
+            }
+            if (!readBody(chunk, response, responseSize, stored) || readLine(line, sizeof(line)) < 0) {
+                complete = false;
+                break;
+            }
+        }
+    } else if (contentLength >= 0) {
+        complete = readBody((size_t)contentLength, response, responseSize, stored);
+    } else {
+        // No framing: the body ends when the server closes the connection
+        int c;
+        while ((c = readByte()) >= 0) {
+            if (stored + 1 < responseSize) {
+                response[stored++] = (char)c;
+            }
+        }
+        keepOpen = false;
+    }
+
+    response[stored] = '\0';
+    if (!complete) {
+        keepOpen = false;
+        return HTTPC_ERROR_CONNECTION_LOST;
+    }
+    return code;
+}
+
+int UploadSession::send(const char* path, const char* contentType, const uint8_t* body, size_t length,
+                        char* response, size_t responseSize, bool& unsent) {
+    unsent = false;
+    char head[MAX_HEAD_BYTES];
+    int headLength = snprintf(head, sizeof(head),
+                              "POST %s HTTP/1.1\r\n"
+                              "Host: %s\r\n"
+                              "User-Agent: ESP32\r\n"
+                              "Connection: keep-alive\r\n"
+                              "Content-Type: %s\r\n"
+                              "Content-Length: %u\r\n"
+                              "\r\n",
+                              path, host, contentType, (unsigned)length);
+    if (headLength < 0 || (size_t)headLength >= sizeof(head)) {
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+
+    unsigned long start = micros();
+    int code;
+    bool keepOpen = false;
+    if (client.write((const uint8_t*)head, (size_t)headLength) != (size_t)headLength) {
+        code = HTTPC_ERROR_SEND_HEADER_FAILED;
+        unsent = true;
+    } else if (length && client.write(body, length) != length) {
+        code = HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+        unsent = true; // Short of Content-Length, the server cannot act on it
+    } else {
+        code = readResponse(response, responseSize, keepOpen, unsent);
+    }
+    transferTime = micros() - start;
+    stats.transferMicros += transferTime;
+    lastUsed = millis();
+
+    if (!keepOpen) {
+        client.stop();
+    }
+    return code;
+}
+
+int UploadSession::post(const char* path, const char* contentType, const uint8_t* body, size_t length,
+                        char* response, size_t responseSize) {
+    stats.requests++;
+    response[0] = '\0';
+    connectTime = 0;
+    transferTime = 0;
+
+    bool reused = false;
+    if (!ensureConnected(reused)) {
+        reusedLast = false;
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    bool unsent = false;
+    int code = send(path, contentType, body, length, response, responseSize, unsent);
+    reusedLast = reused;
+    if (reused) {
+        stats.reused++;
+    }
+
+    // A reused socket the server closed before taking the request: retry once fresh.
+    // Timeouts and responses cut short are not retried, the request may have been acted on
+    if (code < 0 && reused && unsent) {
+        stats.staleRetries++;
+        uint32_t staleTransfer = transferTime;
+        client.stop();
+        if (!ensureConnected(reused)) {
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        code = send(path, contentType, body, length, response, responseSize, unsent);
+        transferTime += staleTransfer;
+        reusedLast = false;
+    }
+    return code;
+}
+
+void UploadSession::close() {
+    client.stop();
+}
+
+bool UploadSession::isOpen() {
+    return client.connected();
+}
+
+uint32_t UploadSession::lastConnectMicros() const {
+    return connectTime;
+}
+
+uint32_t UploadSession::lastTransferMicros() const {
+    return transferTime;
+}
+
+bool UploadSession::lastReused() const {
+    return reusedLast;
+}
+
+const UploadSessionStats& UploadSession::getStats() const {
+    return stats;
+}
+
+const char* UploadSession::errorToString(int error) {
+    switch (error) {
+        case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+        case HTTPC_ERROR_SEND_HEADER_FAILED: return "send header failed";
+        case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+        case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+        case HTTPC_ERROR_NO_HTTP_SERVER: return "no HTTP server";
+        case HTTPC_ERROR_READ_TIMEOUT: return "read timeout";
+        default: return "unknown error";
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * @file UploadSession.h
+ * @brief Long-lived HTTP/1.1 keep-alive connection to the upload server
+ *
+ * Creating a WiFiClient per upload pays DNS lookup and the TCP handshake
+ * on every request. UploadSession keeps one socket open between requests
+ * and reuses it while the server allows, reconnecting transparently when
+ * it does not:
+ *   - a socket the server closed (FIN seen) reports !connected() and is
+ *     replaced before the request is sent;
+ *   - a socket idle for longer than MAX_IDLE_MS is closed proactively,
+ *     since APs and NATs drop idle flows silently;
+ *   - a request on a reused socket that the server closed under it, before
+ *     the request was written or before any byte of a response came back,
+ *     is retried once on a fresh connection. Once the request is out, a
+ *     timeout or a connection lost mid-response is returned as is: the
+ *     server may have acted on the request, and sending it again could
+ *     store it twice (a half-open socket after a link drop ends here, and
+ *     is replaced by the next request).
+ *
+ * HTTP is spoken directly on the WiFiClient instead of through HTTPClient,
+ * which keeps URL parts, headers and the response body in heap Strings.
+ * The request head is formatted into a MAX_HEAD_BYTES stack buffer and the
+ * response is parsed byte by byte (Content-Length, chunked or
+ * read-until-close) into a caller-supplied buffer, so a request performs
+ * no heap allocation.
+ *
+ * Each request records how long connecting (DNS + handshake, 0 when the
+ * socket was reused) and the transfer itself took.
+ */
+
+#ifndef UPLOAD_SESSION_H
+#define UPLOAD_SESSION_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h> // HTTPC_ERROR_* codes
+
+struct UploadSessionStats {
+    uint32_t requests;        // Requests attempted (a retry counts once)
+    uint32_t connects;        // TCP connections opened
+    uint32_t reused;          // Requests sent on an already open connection
+    uint32_t staleRetries;    // Reused connections closed before the request got through, retried
+    uint64_t connectMicros;   // Total time spent connecting
+    uint64_t transferMicros;  // Total time from sending the request to reading the response
+};
+
+class UploadSession {
+public:
+    static const unsigned long MAX_IDLE_MS = 60000;  // Close idle sockets older than this
+    static const uint16_t TIMEOUT_MS = 10000;        // Connect and response timeout
+    static const size_t MAX_HEAD_BYTES = 256;        // Request line and headers
+    static const size_t MAX_LINE_BYTES = 128;        // Longer response header lines are truncated
+
+    /**
+     * @param host Server host name (the string must outlive the session)
+     * @param port Server TCP port
+     */
+    UploadSession(const char* host, uint16_t port = 80);
+
+    /**
+     * @brief POST a body to path, reusing the open connection if possible
+     *
+     * @param path Request path including query string
+     * @param contentType Value of the Content-Type header
+     * @param body Request body
+     * @param length Body length in bytes
+     * @param response Receives the NUL-terminated response body, truncated
+     *        to responseSize - 1 bytes (the rest is read and discarded)
+     * @param responseSize Size of the response buffer
+     * @return HTTP status code, or a negative HTTPC_ERROR_* code
+     */
+    int post(const char* path, const char* contentType, const uint8_t* body, size_t length,
+             char* response, size_t responseSize);
+
+    /**
+     * @brief Close the connection, e.g. after the WiFi link was lost
+     */
+    void close();
+
+    bool isOpen();
+
+    /** Connect time of the last request in microseconds (0 if reused). */
+    uint32_t lastConnectMicros() const;
+    /** Transfer time of the last request in microseconds. */
+    uint32_t lastTransferMicros() const;
+    /** Whether the last request went out on a reused connection. */
+    bool lastReused() const;
+
+    const UploadSessionStats& getStats() const;
+
+    /** Static description of a negative post() result. */
+    static const char* errorToString(int error);
+
+private:
+    const char* host;
+    uint16_t port;
+    WiFiClient client;
+    unsigned long lastUsed;
+    uint32_t connectTime;
+    uint32_t transferTime;
+    bool reusedLast;
+    UploadSessionStats stats;
+
+    bool ensureConnected(bool& reused);
+    int send(const char* path, const char* contentType, const uint8_t* body, size_t length,
+             char* response, size_t responseSize, bool& unsent);
+    int readResponse(char* response, size_t responseSize, bool& keepOpen, bool& unanswered);
+    bool waitForData();
+    int readByte();
+    int readLine(char* line, size_t size);
+    bool readBody(size_t count, char* response, size_t responseSize, size_t& stored);
+};
+
+#endif // UPLOAD_SESSION_H
@@ -0,0 +1,90 @@
+/**
+ * @file WebSocketBroadcaster.cpp
+ * @brief Implementation of the shared WebSocket frames
+ */
+
+#include "WebSocketBroadcaster.h"
+
+WebSocketBroadcaster::WebSocketBroadcaster() : current(NONE), editing(NONE), nextSequence(1) {
+    memset(frames, 0, sizeof(frames));
+    memset(&stats, 0, sizeof(stats));
+}
+
+char* WebSocketBroadcaster::edit() {
+    editing = NONE;
+    for (int i = 0; i < MAX_FRAMES; i++) {
+        if (i != current && frames[i].holders == 0) {
+            editing = i;
+            return (char*)frames[i].data + HEADER_ROOM;
+        }
+    }
+    stats.skipped++;
+    return nullptr;
+}
+
+bool WebSocketBroadcaster::publish(size_t length) {
+    if (editing == NONE) {
+        return false;
+    }
+    Frame& frame = frames[editing];
+    editing = NONE;
+    if (length >= MAX_PAYLOAD) {
+        stats.overflows++; // snprintf() truncated it: not valid JSON
+        return false;
+    }
+
+    // FIN + text opcode; server frames are not masked
+    if (length < 126) {
+        frame.start = HEADER_ROOM - 2;
+        frame.data[frame.start + 1] = (uint8_t)length;
+    } else {
+        frame.start = 0;
+        frame.data[1] = 126;
+        frame.data[2] = (uint8_t)(length >> 8);
+        frame.data[3] = (uint8_t)length;
+    }
+    frame.data[frame.start] = 0x81;
+    frame.length = (uint16_t)(HEADER_ROOM - frame.start + length);
+    frame.sequence = nextSequence++;
+    current = (int)(&frame - frames);
+    stats.published++;
+    return true;
+}
+
+uint32_t WebSocketBroadcaster::sequence() const {
+    return current == NONE ? 0 : frames[current].sequence;
+}
+
+int WebSocketBroadcaster::acquire(uint32_t& last, const uint8_t*& data, size_t& length) {
+    if (current == NONE || frames[current].sequence == last) {
+        return NONE;
+    }
+    Frame& frame = frames[current];
+    if (last != 0) {
+        stats.superseded += frame.sequence - last - 1;
+    }
+    last = frame.sequence;
+    frame.holders++;
+    data = frame.data + frame.start;
+    length = frame.length;
+    stats.sent++;
+    return current;
+}
+
+void WebSocketBroadcaster::release(int frame) {
+    if (frame != NONE && frames[frame].holders > 0) {
+        frames[frame].holders--;
+    }
+}
+
+int WebSocketBroadcaster::heldFrames() const {
+    int held = 0;
+    for (const Frame& frame : frames) {
+        held += frame.holders > 0;
+    }
+    return held;
+}
+
+const WebSocketBroadcasterStats& WebSocketBroadcaster::getStats() const {
+    return stats;
+}
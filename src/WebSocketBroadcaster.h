@@ -0,0 +1,92 @@
+/**
+ * @file WebSocketBroadcaster.h
+ * @brief Latest-value-wins WebSocket frames shared by every subscriber
+ *
+ * The producer serializes each message once, with edit() and publish(),
+ * into a pooled buffer that already carries the WebSocket frame header, so
+ * every subscriber sends the same bytes and nothing is copied or queued per
+ * client. A subscriber that is idle takes the newest frame with acquire()
+ * and holds it until release(); frames published while it was still
+ * sending are never queued for it: it moves straight to the newest one when
+ * it is done (latest value wins), and the skipped sequence numbers are
+ * counted as superseded. A frame is reused once no subscriber holds it.
+ *
+ * Each subscriber holds at most one frame, so a slow client costs one
+ * buffer however far behind it falls. With MAX_FRAMES frames, up to
+ * MAX_FRAMES - 2 subscribers (the current frame and one to write into
+ * stay available) never make the producer skip a message. Producer and
+ * subscribers run in the same task.
+ */
+
+#ifndef WEB_SOCKET_BROADCASTER_H
+#define WEB_SOCKET_BROADCASTER_H
+
+#include <Arduino.h>
+
+struct WebSocketBroadcasterStats {
+    uint32_t published;   // Frames made current
+    uint32_t skipped;     // Messages dropped because every frame was held
+    uint32_t overflows;   // Messages that did not fit MAX_PAYLOAD (not published)
+    uint32_t sent;        // Frames handed to subscribers
+    uint32_t superseded;  // Frames subscribers never got because a newer one replaced them
+};
+
+class WebSocketBroadcaster {
+public:
+    static const int MAX_FRAMES = 6;          // DashboardServer::MAX_CLIENTS + 2
+    static const size_t HEADER_ROOM = 4;      // Text frame header for payloads up to 65535 bytes
+    static const size_t MAX_PAYLOAD = 636;
+    static const int NONE = -1;
+
+    WebSocketBroadcaster();
+
+    /**
+     * @brief Buffer for the next message payload (MAX_PAYLOAD bytes)
+     *
+     * @return nullptr if every frame is held by a subscriber; skip this message
+     */
+    char* edit();
+
+    /**
+     * @brief Frame the payload written into edit()'s buffer and make it current
+     *
+     * @return false if nothing was being edited or length does not fit MAX_PAYLOAD
+     */
+    bool publish(size_t length);
+
+    /** Sequence number of the current frame; 0 before the first publish() */
+    uint32_t sequence() const;
+
+    /**
+     * @brief Hold the current frame for sending if it is newer than the subscriber's last
+     *
+     * @param last Sequence number of the subscriber's last frame (0 for none); updated
+     * @param data Receives the complete frame (header and payload)
+     * @param length Receives its length
+     * @return Frame to pass to release(), or NONE if there is nothing newer
+     */
+    int acquire(uint32_t& last, const uint8_t*& data, size_t& length);
+    void release(int frame);
+
+    /** Frames currently held by subscribers (at most one each) */
+    int heldFrames() const;
+
+    const WebSocketBroadcasterStats& getStats() const;
+
+private:
+    struct Frame {
+        uint8_t data[HEADER_ROOM + MAX_PAYLOAD];
+        uint16_t start;    // Offset of the frame header in data
+        uint16_t length;   // Header and payload
+        uint16_t holders;  // Subscribers still writing this frame
+        uint32_t sequence;
+    };
+
+    Frame frames[MAX_FRAMES];
+    int current;  // Newest frame; NONE before the first publish()
+    int editing;  // Handed out by edit(); NONE otherwise
+    uint32_t nextSequence;
+    WebSocketBroadcasterStats stats;
+};
+
+#endif // WEB_SOCKET_BROADCASTER_H
@@ -1,6 +1,6 @@
 /*
  * SEN55 with ThingSpeak Data Logging + OTA Updates
- * Sends sensor data to ThingSpeak cloud
+ * Sends sensor data to ThingSpeak cloud or an MQTT broker
  * Supports Over-The-Air firmware updates
  */
 
@@ -8,14 +8,31 @@
 #include <SensirionI2CSen5x.h>
 #include <Wire.h>
 #include <WiFi.h>
-#include <HTTPClient.h>
 #include <ArduinoOTA.h>
+#include <ESPmDNS.h>
+#include <time.h>
 #include "StatusLed.h"
 #include "config.h"  // Local configuration file (not in Git)
 #include "DataAveraging.h"
+#include "SampleFilter.h"
+#include "UploadQueue.h"
+#include "BulkUploader.h"
+#include "UploadSession.h"
+#include "MqttPublisher.h"
+#include "RecordUploader.h"
 #include "SensorUtils.h"
 #include "NetworkManager.h"
 #include "SensorManager.h"
+#include "SensorTask.h"
+#include "Logger.h"
+#include "Scheduler.h"
+#include "PowerManager.h"
+#include "DashboardServer.h"
+#include "DashboardJson.h"
+#include "DashboardAssets.h"
+#include "HistoryStore.h"
+#include "Metrics.h"
+#include "TraceRecorder.h"
 
 // Network Manager
 NetworkManager networkManager(WIFI_SSID, WIFI_PASSWORD);
@@ -24,6 +41,21 @@ NetworkManager networkManager(WIFI_SSID, WIFI_PASSWORD);
 const char* writeAPIKey = THINGSPEAK_API_KEY;
 unsigned long channelID = THINGSPEAK_CHANNEL_ID;
 
+// MQTT broker (optional, from config.h): when set, records are published
+// there over one persistent session instead of posted to ThingSpeak
+#ifndef MQTT_BROKER
+#define MQTT_BROKER ""
+#endif
+#ifndef MQTT_PORT
+#define MQTT_PORT 1883
+#endif
+
+// Field trace (optional, from config.h): TRACE_FLASH or TRACE_SERIAL record
+// readings, network outcomes and timing for the native replay
+#ifndef TRACE_SINK
+#define TRACE_SINK TRACE_OFF
+#endif
+
 // OTA settings (from config.h)
 const char* otaHostname = OTA_HOSTNAME;
 const char* otaPassword = OTA_PASSWORD;
@@ -36,46 +68,169 @@ StatusLed statusLed(RGB_BUILTIN_PIN);
 #define I2C_SDA 1
 #define I2C_SCL 2
 
-// Send interval (ThingSpeak free tier: minimum 15 seconds between updates)
-const unsigned long SEND_INTERVAL = 20000; // 20 seconds to be safe
-const unsigned long SENSOR_READ_INTERVAL = 1000; // Read sensor every second
+// One averaged record per window. Records are uploaded in bulk, so the
+// 15-second request limit no longer applies per point; 15 s keeps the
+// channel at 5760 messages/day, inside the free tier's 3M messages/year.
+const unsigned long RECORD_INTERVAL = 15000;
+const unsigned long SENSOR_READ_INTERVAL = 1000; // SEN55 measurement period; reads follow its data-ready flag
+const unsigned RECORD_SAMPLES = RECORD_INTERVAL / SENSOR_READ_INTERVAL; // Readings in a complete record
+const unsigned long THINGSPEAK_MIN_INTERVAL = 16000; // Rate limit (15 s) plus margin between requests
+const unsigned long MQTT_MIN_INTERVAL = 1000; // No rate limit; the in-flight window holds publishes back
+
+// Unix times before this mean the clock has not been set by SNTP yet
+const time_t MIN_VALID_EPOCH = 1609459200; // 2021-01-01
+
+// Acquisition runs on core 0 (PRO_CPU), beside the WiFi driver's short
+// bursts; loop() does records, uploads and OTA on core 1 (APP_CPU), so a
+// slow request never delays a read
+const BaseType_t SENSOR_TASK_CORE = 0;
+const UBaseType_t SENSOR_TASK_PRIORITY = 5; // Above loopTask (1), below WiFi/lwIP (18+)
+
+// Log text is formatted and written to the UART by a task that only runs
+// when core 0 has nothing better to do; callers just queue a record
+const BaseType_t LOG_TASK_CORE = 0;
+const UBaseType_t LOG_TASK_PRIORITY = 1;
+const LogLevel LOG_LEVEL = LOG_LEVEL_DEBUG; // LOG_LEVEL_INFO drops the per-sample lines
+
+// POWER_LOW: automatic light sleep between deadlines and WiFi modem sleep;
+// POWER_PERFORMANCE keeps the CPU and radio at full power (e.g. to debug
+// over USB, which light sleep interrupts)
+const PowerMode POWER_MODE = POWER_LOW;
 
-unsigned long lastSendTime = 0;
-unsigned long lastSensorReadTime = 0;
+// Outlier filter between a valid reading and the averaging window: values
+// far from the running median (a dust grain or insect at the fan inlet)
+// are replaced by it, and humidity and temperature may not jump faster
+// than air does. A window of 1 turns the median off, rates of 0 the limits
+const SampleFilterConfig FILTER_CONFIG = {
+    7,    // Running median of 7 readings: excursions up to 3 s are removed
+    3.5f, // Threshold, in robust standard deviations (1.4826 x MAD)
+    // pm1  pm2.5   pm4   pm10   RH     temp   VOC   NOx
+    {1.0f, 1.0f, 1.0f, 1.0f, 0.5f, 0.2f, 2.0f, 1.0f},  // Scale floor: the sensor's own noise
+    {0.0f, 0.0f, 0.0f, 0.0f, 5.0f, 1.0f, 0.0f, 0.0f}   // Largest change per second
+};
+
+// Polling jobs run from loop() in deadline order; in between, loop() sleeps
+// until the next one is due or the sensor task posts a sample. In POWER_LOW
+// they run once a second, so the chip is not woken ten times as often as
+// the sensor needs.
+const unsigned long OTA_POLL_INTERVAL = 100;       // ArduinoOTA.handle(); an upload starts within 0.1 s
+const unsigned long NETWORK_POLL_INTERVAL = 100;   // WiFi state machine (driver events are latched until then)
+const unsigned long LOW_POWER_POLL_INTERVAL = 1000; // Both, in POWER_LOW (espota waits 10 s for an answer)
+const unsigned long POWER_REPORT_INTERVAL = 600000; // loop() idle share and wakeups, every 10 minutes
+const unsigned long METRICS_REPORT_INTERVAL = 300000; // Latency quantiles and heap, every 5 minutes
+// The dashboard server is polled with OTA while nobody is connected, and
+// every WEB_ACTIVE_POLL_INTERVAL while a browser holds an HTTP connection
+// open or a WebSocket frame is part-way out (idle WebSockets are pushed to
+// as each sample is published)
+const unsigned long WEB_ACTIVE_POLL_INTERVAL = 50;
+const uint16_t DASHBOARD_PORT = 80;
+
+unsigned long lastRecordTime = 0;
+unsigned long lastUploadTime = 0;
+
+// Flash queue positions (UploadQueue::headPosition()) of records handed to a
+// backend that confirms them later; they leave the queue once confirmed
+uint32_t queueSentEnd = 0;       // One past the last record handed over
+uint32_t queueDeliveredEnd = 0;  // One past the last record confirmed
 
 // OTA update flag
 bool otaInProgress = false;
+bool otaStarted = false;     // OTA starts once the first WiFi connection is up
+uint32_t seenDisconnects = 0; // NetworkManager link drops already handled
+bool sensorReady = false;    // A valid reading has arrived (time-to-first-valid-sample logged)
+bool traceLinkUp = false;    // WiFi state last written to the trace
+bool traceClockSet = false;  // The first valid wall-clock time is in the trace
 
 SensirionI2CSen5x sen5x;
 SensorManager sensorManager(&sen5x);
+SampleQueue sampleQueue;    // Sensor task -> loop(), lock-free single producer / single consumer
+SensorTask sensorTask(sensorManager, sampleQueue, SENSOR_READ_INTERVAL);
 DataAveraging dataAveraging;
+SampleFilter sampleFilter(FILTER_CONFIG);
+HistoryStore history;       // Every reading of the last days (PSRAM), for /api/history
+UploadQueue uploadQueue;    // Averaged records waiting for connectivity (LittleFS)
+BulkUploader bulkUploader(writeAPIKey, RECORD_INTERVAL / 1000);
+UploadSession thingSpeakSession("api.thingspeak.com"); // Keep-alive connection reused across uploads
+MqttPublisher mqttPublisher(MQTT_BROKER, MQTT_PORT, OTA_HOSTNAME); // Session kept open while WiFi is up
+Scheduler scheduler;        // Periodic jobs of loop()
+DashboardServer dashboard(DASHBOARD_PORT);
+JsonSnapshot currentJson;   // /api/current, /api/average and /api/status: serialized once per
+JsonSnapshot averageJson;   // reading, sent to every request as they are
+JsonSnapshot statusJson;
+WebSocketBroadcaster liveFeed; // /ws: status and reading pushed to open dashboards once per sample
+bool webActivePolling = false; // The fast "web-active" job is scheduled
+PowerManager power(POWER_MODE);
+PowerStats lastPowerStats;  // Snapshot at the previous power report
+TraceSink traceSink = TRACE_SINK;
+TraceRecorder trace;        // Inputs and outcomes for the native replay
+
+// Run-time metrics: /metrics (Prometheus text) and a serial summary every
+// METRICS_REPORT_INTERVAL. Timings are recorded where they happen; the
+// gauges and the counters mirrored from subsystem stats are refreshed
+// just before each export.
+MetricsRegistry metrics;
+MetricHistogram loopLatency;     // loop() passes that did work (sleep excluded)
+MetricHistogram uploadLatency;   // Bulk upload requests, connect included
+MetricHistogram webPollLatency;  // DashboardServer::poll()
+MetricCounter uploadCount;
+MetricCounter uploadFailures;
+MetricCounter sensorReads;
+MetricCounter sensorReadErrors;
+MetricCounter samplesDropped;
+MetricCounter recordsDropped;
+MetricCounter wifiDisconnects;
+MetricCounter dashboardRequests;
+MetricCounter logDropped;
+MetricCounter schedulerOverruns;
+MetricCounter filterOutliers;
+MetricCounter filterRateLimited;
+MetricGauge uptimeGauge;
+MetricGauge heapFree;
+MetricGauge heapMinFree;
+MetricGauge heapLargestBlock;
+MetricGauge heapFragmentation;
+MetricGauge psramFree;
+MetricGauge wifiRssi;
+MetricGauge queuedRecordsGauge;
+MetricGauge historyReadings;
+MetricGauge dashboardClients;
+MetricCounter mqttRetransmits;
+MetricGauge mqttInFlight;
+
+int sendBulkToThingSpeak(const QueuedRecord* records, int count, void* context);
+void closeThingSpeak(void* context);
+int publishMqtt(const QueuedRecord* records, int count, void* context);
+void pollMqtt(void* context);
+void closeMqtt(void* context);
+int mqttDelivered(void* context);
+void collectDelivered();
+
+// Where records go: ThingSpeak's bulk-update API, or the MQTT broker if one is configured
+RecordUploader thingSpeakUploader = {"ThingSpeak", sendBulkToThingSpeak, nullptr, closeThingSpeak, nullptr,
+                                     &thingSpeakSession, THINGSPEAK_MIN_INTERVAL, BulkUploader::MAX_RECORDS};
+RecordUploader mqttUploader = {"MQTT", publishMqtt, pollMqtt, closeMqtt, mqttDelivered, &mqttPublisher,
+                               MQTT_MIN_INTERVAL, MqttPublisher::MAX_RECORDS};
+RecordUploader* uploader = MQTT_BROKER[0] != '\0' ? &mqttUploader : &thingSpeakUploader;
 
 void setupOTA() {
-    Serial.println("Configuring OTA updates...");
+    Log.info(LOG_OTA_CONFIGURING);
     
     ArduinoOTA.setHostname(otaHostname);
     ArduinoOTA.setPassword(otaPassword);
     
     ArduinoOTA.onStart([]() {
-        String type;
-        if (ArduinoOTA.getCommand() == U_FLASH) {
-            type = "sketch";
-        } else { // U_SPIFFS
-            type = "filesystem";
-        }
-        Serial.println("\n🔄 OTA: Starting update (" + type + ")");
-        Serial.println("⚠️  Do not power off!");
+        // U_FLASH or U_SPIFFS
+        Log.warn(LOG_OTA_START, ArduinoOTA.getCommand() == U_FLASH ? "sketch" : "filesystem");
         
-        // Stop sensor measurements during OTA
+        // Stop sensor measurements during OTA (the sensor task owns the bus)
         otaInProgress = true;
-        if (!sensorManager.stopMeasurement()) {
-            Serial.println("⚠️  Could not stop sensor measurements");
-        }
+        sensorTask.pause();
+        power.holdAwake(); // Full CPU speed and radio for the transfer
     });
     
     ArduinoOTA.onEnd([]() {
-        Serial.println("\n✓ OTA: Update complete!");
-        Serial.println("Rebooting...");
+        Log.info(LOG_OTA_END);
+        Log.flush(500); // Queued messages would be lost in the reboot
         // No need to restart measurements - device will reboot
     });
     
@@ -86,40 +241,223 @@ void setupOTA() {
             percent = (progress * 100) / total;
         }
         if (percent != lastPercent && percent % 10 == 0) {
-            Serial.printf("OTA Progress: %u%%\n", percent);
+            Log.info(LOG_OTA_PROGRESS, percent);
             lastPercent = percent;
         }
     });
     
     ArduinoOTA.onError([](ota_error_t error) {
-        Serial.printf("\n✗ OTA Error[%u]: ", error);
-        if (error == OTA_AUTH_ERROR) Serial.println("Auth Failed");
-        else if (error == OTA_BEGIN_ERROR) Serial.println("Begin Failed");
-        else if (error == OTA_CONNECT_ERROR) Serial.println("Connect Failed");
-        else if (error == OTA_RECEIVE_ERROR) Serial.println("Receive Failed");
-        else if (error == OTA_END_ERROR) Serial.println("End Failed");
+        const char* reason = "";
+        if (error == OTA_AUTH_ERROR) reason = "Auth Failed";
+        else if (error == OTA_BEGIN_ERROR) reason = "Begin Failed";
+        else if (error == OTA_CONNECT_ERROR) reason = "Connect Failed";
+        else if (error == OTA_RECEIVE_ERROR) reason = "Receive Failed";
+        else if (error == OTA_END_ERROR) reason = "End Failed";
+        Log.error(LOG_OTA_ERROR, (unsigned)error, reason);
         
         // Restart measurements on OTA error
         otaInProgress = false;
-        if (!sensorManager.startMeasurement()) {
-            Serial.println("⚠️  Could not restart sensor measurements");
-        }
+        sensorTask.resume();
+        power.release();
     });
     
     ArduinoOTA.begin();
     
-    Serial.println("✓ OTA Ready!");
-    Serial.print("  Hostname: ");
-    Serial.println(otaHostname);
-    Serial.print("  IP: ");
-    Serial.println(networkManager.getIP());
-    Serial.println("  Upload via: Tools → Port → Network ports");
-    Serial.println();
+    IPAddress ip = WiFi.localIP();
+    Log.info(LOG_OTA_READY, otaHostname, ip[0], ip[1], ip[2], ip[3]);
+}
+
+// /api/history, downsampled from the PSRAM history while the request is served
+size_t serveHistory(const char* query, char* body, size_t capacity, void* context) {
+    return formatHistoryJson(body, capacity, *(HistoryStore*)context, query);
+}
+
+// Export every metric; names follow Prometheus conventions (base units, _total counters)
+void setupMetrics() {
+    metrics.addHistogram("aqm_loop_seconds", "Time loop() spends per pass, sleep excluded", loopLatency);
+    metrics.addHistogram("aqm_sensor_read_seconds", "SEN55 readData() I2C transfer", sensorTask.getReadLatency());
+    metrics.addHistogram("aqm_upload_seconds", "Bulk-update request or MQTT publish, connect included",
+                         uploadLatency);
+    metrics.addHistogram("aqm_dashboard_poll_seconds", "Dashboard server poll()", webPollLatency);
+    metrics.addHistogram("aqm_wifi_reconnect_seconds", "Time from boot or a lost link to the next connection",
+                         networkManager.getReconnectLatency());
+    metrics.addCounter("aqm_sensor_reads_total", "Sensor reads attempted", sensorReads);
+    metrics.addCounter("aqm_sensor_read_errors_total", "Sensor reads and data-ready polls that failed",
+                       sensorReadErrors);
+    metrics.addCounter("aqm_samples_dropped_total", "Samples lost because loop() fell behind", samplesDropped);
+    metrics.addCounter("aqm_uploads_total", "Bulk-update requests or MQTT publishes attempted", uploadCount);
+    metrics.addCounter("aqm_upload_failures_total", "Uploads not accepted (MQTT: window full or no session)",
+                       uploadFailures);
+    metrics.addCounter("aqm_records_dropped_total", "Records discarded from the full offline queue",
+                       recordsDropped);
+    metrics.addCounter("aqm_wifi_disconnects_total", "Established WiFi links that dropped", wifiDisconnects);
+    metrics.addCounter("aqm_dashboard_requests_total", "Dashboard HTTP requests answered", dashboardRequests);
+    metrics.addCounter("aqm_log_dropped_total", "Log messages lost to a full ring", logDropped);
+    metrics.addCounter("aqm_scheduler_overruns_total", "Job periods skipped because loop() was held",
+                       schedulerOverruns);
+    metrics.addCounter("aqm_filter_outliers_total", "Sensor values replaced by the running median",
+                       filterOutliers);
+    metrics.addCounter("aqm_filter_rate_limited_total", "Sensor values replaced for changing too fast",
+                       filterRateLimited);
+    metrics.addGauge("aqm_uptime_seconds", "Time since boot", uptimeGauge);
+    metrics.addGauge("aqm_heap_free_bytes", "Free internal heap", heapFree);
+    metrics.addGauge("aqm_heap_min_free_bytes", "Lowest free internal heap since boot", heapMinFree);
+    metrics.addGauge("aqm_heap_largest_free_block_bytes", "Largest allocation that would succeed",
+                     heapLargestBlock);
+    metrics.addGauge("aqm_heap_fragmentation_ratio", "1 - largest free block / free heap", heapFragmentation);
+    metrics.addGauge("aqm_psram_free_bytes", "Free PSRAM", psramFree);
+    metrics.addGauge("aqm_wifi_rssi_dbm", "Signal strength, 0 while disconnected", wifiRssi);
+    metrics.addGauge("aqm_upload_queue_records", "Records on flash waiting for upload", queuedRecordsGauge);
+    metrics.addGauge("aqm_history_readings", "Readings held for /api/history", historyReadings);
+    metrics.addGauge("aqm_dashboard_clients", "Open dashboard connections", dashboardClients);
+    if (uploader == &mqttUploader) {
+        metrics.addHistogram("aqm_mqtt_ack_seconds", "MQTT publish to PUBACK", mqttPublisher.getAckLatency());
+        metrics.addCounter("aqm_mqtt_retransmits_total", "MQTT messages sent again after a reconnect",
+                           mqttRetransmits);
+        metrics.addGauge("aqm_mqtt_inflight_messages", "MQTT messages not acknowledged yet", mqttInFlight);
+    }
 }
 
+// Copy what subsystems count in their own stats into the exported metrics
+void refreshMetrics() {
+    const SensorTaskStats& acquisition = sensorTask.getStats();
+    sensorReads.set(acquisition.reads);
+    sensorReadErrors.set(acquisition.readErrors);
+    samplesDropped.set(sampleQueue.getDropped());
+    recordsDropped.set(uploadQueue.getStats().dropped);
+    wifiDisconnects.set(networkManager.getDisconnectCount());
+    dashboardRequests.set(dashboard.getStats().requests);
+    logDropped.set(Log.getStats().dropped);
+    uint32_t overruns = 0;
+    for (int id = 0; id < Scheduler::MAX_JOBS; id++) {
+        overruns += scheduler.jobName(id) ? scheduler.jobStats(id).overruns : 0;
+    }
+    schedulerOverruns.set(overruns);
+    filterOutliers.set(sampleFilter.totalOutliers());
+    filterRateLimited.set(sampleFilter.totalRateLimited());
+
+    uint32_t free = ESP.getFreeHeap();
+    uint32_t largest = ESP.getMaxAllocHeap();
+    uptimeGauge.set(millis() / 1000.0f);
+    heapFree.set(free);
+    heapMinFree.set(ESP.getMinFreeHeap());
+    heapLargestBlock.set(largest);
+    heapFragmentation.set(free > 0 && largest <= free ? 1.0f - (float)largest / free : 0.0f);
+    psramFree.set(ESP.getFreePsram());
+    wifiRssi.set(networkManager.isConnected() ? WiFi.RSSI() : 0);
+    queuedRecordsGauge.set(uploadQueue.size());
+    historyReadings.set(history.size());
+    dashboardClients.set(dashboard.clientCount());
+    mqttRetransmits.set(mqttPublisher.getStats().retransmits);
+    mqttInFlight.set(mqttPublisher.inFlight());
+}
+
+// /metrics, rendered from the live metrics while the request is served
+size_t serveMetrics(const char* query, char* body, size_t capacity, void*) {
+    (void)query;
+    refreshMetrics();
+    return metrics.formatPrometheus(body, capacity);
+}
+
+// Compact serial summary of the same numbers
+void reportMetrics(void*) {
+    refreshMetrics();
+    const MetricHistogram& read = sensorTask.getReadLatency();
+    Log.info(LOG_METRICS_TIMING, loopLatency.percentile(0.5f), loopLatency.percentile(0.99f), loopLatency.max(),
+             read.percentile(0.99f), read.max(), uploadLatency.percentile(0.99f) / 1000, uploadLatency.max() / 1000,
+             webPollLatency.percentile(0.99f));
+    Log.info(LOG_METRICS_HEAP, (uint32_t)heapFree.get(), (uint32_t)heapMinFree.get(),
+             (uint32_t)heapLargestBlock.get(), heapFragmentation.get() * 100.0f, (uint32_t)psramFree.get(),
+             history.size());
+    const SampleFilterStats& filter = sampleFilter.getStats();
+    Log.info(LOG_METRICS_FILTER, filter.readings, filter.outliers[FIELD_PM1], filter.outliers[FIELD_PM25],
+             filter.outliers[FIELD_PM4], filter.outliers[FIELD_PM10], filter.outliers[FIELD_HUMIDITY],
+             filter.outliers[FIELD_TEMPERATURE], filter.outliers[FIELD_VOC], filter.outliers[FIELD_NOX],
+             sampleFilter.totalRateLimited());
+}
+
+// Start the dashboard once the network is up (ArduinoOTA already started mDNS)
+void startDashboard() {
+    dashboard.begin();
+    MDNS.addService("http", "tcp", DASHBOARD_PORT);
+    IPAddress ip = WiFi.localIP();
+    Log.info(LOG_WEB_READY, ip[0], ip[1], ip[2], ip[3], otaHostname);
+}
+
+// Handle OTA updates (during an update, handle() runs the whole transfer)
+void pollOTA(void*) {
+    if (otaStarted) {
+        ArduinoOTA.handle();
+    }
+}
+
+// Advance the WiFi state machine (never blocks)
+void pollNetwork(void*) {
+    if (networkManager.update() && !otaStarted) {
+        setupOTA();
+        startDashboard();
+        otaStarted = true;
+    }
+    if (networkManager.isConnected() != traceLinkUp) {
+        traceLinkUp = networkManager.isConnected();
+        trace.wifi(traceLinkUp);
+    }
+    if (networkManager.getDisconnectCount() != seenDisconnects) {
+        seenDisconnects = networkManager.getDisconnectCount();
+        if (uploader->linkLost) {
+            uploader->linkLost(uploader->context); // The socket did not survive the link loss
+        }
+    }
+}
+
+// Session upkeep of the upload backend (MQTT acknowledgements and keepalive)
+void pollUploader(void*) {
+    if (networkManager.isConnected()) {
+        uploader->poll(uploader->context);
+        if (uploader->delivered) {
+            collectDelivered();
+        }
+    }
+}
+
+// Serve dashboard requests; while poll() has work in progress, keep
+// polling every WEB_ACTIVE_POLL_INTERVAL instead of waiting for the slow job
+bool pollDashboard() {
+    uint32_t started = micros();
+    bool active = dashboard.poll();
+    webPollLatency.record(micros() - started);
+    return active;
+}
+
+void pollWebActive(void*) {
+    webActivePolling = pollDashboard();
+    if (webActivePolling) {
+        scheduler.after("web-active", WEB_ACTIVE_POLL_INTERVAL, pollWebActive, nullptr, millis());
+    }
+}
+
+void pollWeb(void*) {
+    if (pollDashboard() && !webActivePolling) {
+        webActivePolling = true;
+        scheduler.after("web-active", WEB_ACTIVE_POLL_INTERVAL, pollWebActive, nullptr, millis());
+    }
+}
+
+// Report how much of the time loop() slept and how often it woke
+void reportPower(void*) {
+    PowerStats now = power.getStats();
+    Log.info(LOG_POWER_STATS, PowerManager::idlePercent(lastPowerStats, now), now.wakeups - lastPowerStats.wakeups,
+             now.notified - lastPowerStats.notified, (unsigned)(POWER_REPORT_INTERVAL / 1000));
+    lastPowerStats = now;
+}
+
+// Startup is staged so nothing waits on anything else: the sensor starts
+// measuring first (its warm-up is the longest), WiFi associates in the
+// background meanwhile, and the sensor task starts straight away. The first
+// valid reading marks the sensor ready; records are averaged and queued
+// locally whether or not the network is up yet.
 void setup() {
-    Serial.begin(115200);
-    delay(1000); // Give serial time to initialize
+    Serial.begin(115200); // No settle delay: output before a host attaches is lost either way
     
     Serial.println();
     Serial.println("================================");
@@ -130,233 +468,463 @@ void setup() {
     // Initialize LED
     statusLed.begin();
 
-    // Connect to WiFi using NetworkManager
-    if (!networkManager.connect()) {
-        Serial.println("Failed to connect to WiFi. Restarting in 5 seconds...");
+    // Start measuring first so the warm-up overlaps the rest of setup()
+    if (!sensorManager.begin(I2C_SDA, I2C_SCL, 0.0)) {
+        Serial.println("Failed to initialize sensor. Restarting in 5 seconds...");
         delay(5000);
         ESP.restart();
     }
+
+    // Start connecting to WiFi; the link comes up in the background and
+    // records are queued until it does
+    networkManager.begin();
+    
+    // Needs the station started (modem sleep is a station setting)
+    power.begin();
     
-    Serial.print("ThingSpeak Channel: ");
-    Serial.println(channelID);
+    if (uploader == &mqttUploader) {
+        Serial.printf("MQTT broker: %s:%u, topic %s\n", MQTT_BROKER, (unsigned)MQTT_PORT, mqttPublisher.getTopic());
+    } else {
+        Serial.print("ThingSpeak Channel: ");
+        Serial.println(channelID);
+    }
+    Serial.printf("Sample filter: median of %d, threshold %.1f\n", FILTER_CONFIG.window,
+                  FILTER_CONFIG.threshold);
     Serial.println();
+    
+    // Wall clock for record timestamps (UTC; ThingSpeak converts for display)
+    configTime(0, 0, "pool.ntp.org", "time.nist.gov");
+    
+    // Records that were still waiting when the device last went down
+    uploadQueue.begin();
 
-     // Setup OTA
-    setupOTA();
+    // Field trace (flash needs LittleFS, mounted by the queue)
+    trace.begin(traceSink);
 
-    // Initialize sensor using SensorManager
-    if (!sensorManager.begin(I2C_SDA, I2C_SCL, 0.0)) {
-        Serial.println("Failed to initialize sensor. Restarting in 5 seconds...");
-        delay(5000);
-        ESP.restart();
+    // Three days of per-second readings in PSRAM
+    if (!history.begin()) {
+        Serial.println("⚠️  No PSRAM for the reading history - /api/history stays empty");
     }
-    
+
+    // Dashboard routes; the server starts listening once WiFi is up
+    for (size_t i = 0; i < DASHBOARD_ASSET_COUNT; i++) {
+        const DashboardAsset& asset = DASHBOARD_ASSETS[i];
+        dashboard.addAsset(asset.path, asset.contentType, asset.body, asset.length, asset.etag, asset.immutable);
+    }
+    dashboard.addSnapshot("/api/current", currentJson);
+    dashboard.addSnapshot("/api/average", averageJson);
+    dashboard.addSnapshot("/api/status", statusJson);
+    dashboard.addWebSocket("/ws", liveFeed);
+    dashboard.addQuery("/api/history", serveHistory, &history);
+    setupMetrics();
+    dashboard.addQuery("/metrics", serveMetrics, nullptr, "text/plain; version=0.0.4");
+
     // Print sensor info
     sensorManager.printInfo();
     
-    // Wait for sensor to stabilize and provide valid readings
-    waitForSensorStabilization();
+    // From here on messages are queued and printed by the log task
+    Log.setLevel(LOG_LEVEL);
+    if (!Log.start(LOG_TASK_CORE, LOG_TASK_PRIORITY)) {
+        Serial.println("⚠️  Log task not started - logging synchronously");
+    }
+    
+    // Periodic work; samples wake loop() as they arrive
+    bool lowPower = power.getMode() == POWER_LOW;
+    scheduler.every("ota", lowPower ? LOW_POWER_POLL_INTERVAL : OTA_POLL_INTERVAL, pollOTA, nullptr, millis());
+    scheduler.every("network", lowPower ? LOW_POWER_POLL_INTERVAL : NETWORK_POLL_INTERVAL, pollNetwork, nullptr,
+                    millis());
+    scheduler.every("web", lowPower ? LOW_POWER_POLL_INTERVAL : OTA_POLL_INTERVAL, pollWeb, nullptr, millis());
+    scheduler.every("power", POWER_REPORT_INTERVAL, reportPower, nullptr, millis(), POWER_REPORT_INTERVAL);
+    scheduler.every("metrics", METRICS_REPORT_INTERVAL, reportMetrics, nullptr, millis(), METRICS_REPORT_INTERVAL);
+    if (uploader->poll) {
+        scheduler.every("upload", lowPower ? LOW_POWER_POLL_INTERVAL : NETWORK_POLL_INTERVAL, pollUploader, nullptr,
+                        millis());
+    }
+    sensorTask.setConsumer(xTaskGetCurrentTaskHandle()); // setup() and loop() share loopTask
+    
+    // From here on only the sensor task touches the I2C bus; readings are
+    // flagged as warming up until the first valid one
+    if (!sensorTask.start(SENSOR_TASK_CORE, SENSOR_TASK_PRIORITY)) {
+        Serial.println("Failed to start sensor task. Restarting in 5 seconds...");
+        delay(5000);
+        ESP.restart();
+    }
     
-    Serial.println("Waiting 20 seconds before first upload...");
+    Serial.println("Sensor warming up; records start once readings are valid, uploaded in batches of 8...");
     Serial.println("================================");
     Serial.println();
 }
 
-bool sendToThingSpeak(float pm1, float pm25, float pm4, float pm10, 
-                      float humidity, float temperature, float voc, float nox) {
-    // Validate data before uploading
-    if (!isValidReading(pm1, pm25, pm4, pm10, humidity, temperature, voc, nox)) {
-        Serial.println("✗ Skipping upload - invalid data detected");
-        return false;
+// Unix time at which a sample taken at sampleMillis was read (samples can
+// wait in the queue while an upload runs), 0 if the clock is not set yet
+uint32_t epochAt(unsigned long sampleMillis) {
+    time_t now = time(nullptr);
+    if (now < MIN_VALID_EPOCH) {
+        return 0;
     }
-    
-    if (!networkManager.isConnected()) {
-        Serial.println("✗ WiFi Disconnected! Reconnecting...");
-        if (!networkManager.reconnect()) {
-            Serial.println("✗ Failed to reconnect. Skipping upload.");
-            return false;
+    return (uint32_t)(now - (time_t)((millis() - sampleMillis) / 1000));
+}
+
+// Serialize the dashboard's data once per sample: the API bodies every
+// request is answered from until the next sample, and the frame pushed to
+// every open WebSocket. Skipped while slow clients still hold the buffers.
+void publishDashboard(const SensorSample& sample) {
+    if (!sample.ok) {
+        return;
+    }
+    DashboardStatus status;
+    IPAddress ip = WiFi.localIP();
+    status.uptimeSeconds = millis() / 1000;
+    status.wifiConnected = networkManager.isConnected();
+    status.rssi = status.wifiConnected ? WiFi.RSSI() : 0;
+    for (int i = 0; i < 4; i++) {
+        status.ip[i] = ip[i];
+    }
+    status.sensorReady = sensorReady;
+    status.firstValidMs = sensorTask.getStats().firstValidMs;
+    status.queuedRecords = uploadQueue.size();
+    status.batchRecords = bulkUploader.size();
+    status.freeHeap = ESP.getFreeHeap();
+    status.largestFreeBlock = ESP.getMaxAllocHeap();
+    status.dashboardClients = dashboard.clientCount();
+    char* body = statusJson.edit();
+    if (body) {
+        statusJson.publish(formatStatusJson(body, JsonSnapshot::MAX_BODY, status));
+    }
+
+    bool valid = isValidReading(sample.data);
+    uint32_t timestamp = epochAt(sample.timestamp);
+    if (valid) {
+        body = currentJson.edit();
+        if (body) {
+            currentJson.publish(formatCurrentJson(body, JsonSnapshot::MAX_BODY, sample.data, timestamp));
+        }
+        body = averageJson.edit();
+        if (body) {
+            averageJson.publish(formatAverageJson(body, JsonSnapshot::MAX_BODY, dataAveraging.getStats()));
         }
-        // Wait briefly for connection to stabilize
-        delay(1000);
+    }
+
+    body = liveFeed.edit();
+    if (body) {
+        liveFeed.publish(formatUpdateJson(body, WebSocketBroadcaster::MAX_PAYLOAD, status,
+                                          valid ? &sample.data : nullptr, timestamp));
+        pollWeb(nullptr); // Push it now rather than at the next poll
+    }
+}
+
+// Upload records with one bulk-update request; returns how many were accepted
+int sendBulkToThingSpeak(const QueuedRecord* records, int count, void* context) {
+    UploadSession& session = *(UploadSession*)context;
+    int encoded = 0;
+    const char* body = bulkUploader.encode(records, count, encoded);
+    if (!body) {
+        Log.error(LOG_UPLOAD_ENCODE_FAILED);
+        return 0;
     }
     
-    // Use WiFiClient explicitly to manage TCP connection lifecycle and prevent leaks
-    WiFiClient client;
-    client.setTimeout(10000); // 10 second TCP connection timeout (milliseconds)
-    
-    HTTPClient http;
-    
-    // Build URL with all 8 fields
-    String url = "http://api.thingspeak.com/update?api_key=";
-    url += writeAPIKey;
-    url += "&field1=" + String(pm1, 2);
-    url += "&field2=" + String(pm25, 2);
-    url += "&field3=" + String(pm4, 2);
-    url += "&field4=" + String(pm10, 2);
-    url += "&field5=" + String(temperature, 2);
-    url += "&field6=" + String((int)voc);
-    url += "&field7=" + String((int)nox);
-    url += "&field8=" + String(humidity, 2);
+    if (!networkManager.isConnected()) {
+        Log.warn(LOG_UPLOAD_WIFI_DOWN);
+        return 0;
+    }
     
-    Serial.println();
-    Serial.println("--- Uploading to ThingSpeak ---");
+    char path[64];
+    snprintf(path, sizeof(path), "/channels/%lu/bulk_update.json", channelID);
     
-    // Pass client to begin() to avoid deprecated method and internal allocation
-    http.begin(client, url);
-    http.setTimeout(10000); // 10 second HTTP request timeout
+    Log.info(LOG_UPLOAD_START, encoded);
     
-    int httpResponseCode = http.GET();
+    static char response[128];
+    unsigned long startedMs = millis();
+    uint32_t started = micros();
+    int httpResponseCode = session.post(path, "application/json", (const uint8_t*)body, bulkUploader.payloadLength(),
+                                        response, sizeof(response));
+    uploadLatency.record(micros() - started);
+    uploadCount.add();
     bool success = false;
     
     if (httpResponseCode > 0) {
-        String response = http.getString();
-        response.trim();
-        
-        Serial.print("HTTP Response Code: ");
-        Serial.println(httpResponseCode);
-        Serial.print("Server Response: ");
-        Serial.println(response);
-        
-        if (httpResponseCode == 200 && response.toInt() > 0) {
-            Serial.println("✓ SUCCESS! Entry #" + response);
+        // ThingSpeak answers 202 Accepted with {"success":true}
+        if ((httpResponseCode == 200 || httpResponseCode == 202) && strstr(response, "\"success\":true") != nullptr) {
+            Log.info(LOG_UPLOAD_ACCEPTED, httpResponseCode);
             success = true;
         } else {
-            Serial.println("✗ Upload failed - check API key or rate limit");
+            Log.warn(LOG_UPLOAD_REJECTED, httpResponseCode);
         }
     } else {
-        Serial.print("✗ HTTP Error Code: ");
-        Serial.println(httpResponseCode);
-        Serial.print("Error: ");
-        Serial.println(http.errorToString(httpResponseCode));
+        Log.warn(LOG_UPLOAD_HTTP_ERROR, httpResponseCode, UploadSession::errorToString(httpResponseCode));
     }
     
-    Serial.println("-------------------------------");
-    Serial.println();
+    uint32_t transferMs = session.lastTransferMicros() / 1000;
+    trace.upload(startedMs, false, httpResponseCode, encoded, transferMs);
+    if (session.lastReused()) {
+        Log.debug(LOG_UPLOAD_TIMING_REUSED, transferMs);
+    } else {
+        Log.debug(LOG_UPLOAD_TIMING, (uint32_t)(session.lastConnectMicros() / 1000), transferMs);
+    }
+    Log.info(LOG_UPLOAD_END);
     
-    http.end();
-    client.stop(); // Explicitly close TCP connection
-    return success;
+    if (!success) {
+        uploadFailures.add();
+    }
+    return success ? encoded : 0;
 }
 
-void loop() {
-     // Handle OTA updates (must be called frequently)
-    ArduinoOTA.handle();
-    
-    // Skip sensor operations during OTA update
-    if (otaInProgress) {
-        delay(10); // Very short delay, allows OTA.handle() to be called ~100x per second
+void closeThingSpeak(void* context) {
+    ((UploadSession*)context)->close();
+}
+
+// Publish records as one QoS 1 message; records taken stay in the
+// publisher's in-flight window until the broker acknowledges them
+int publishMqtt(const QueuedRecord* records, int count, void* context) {
+    MqttPublisher& publisher = *(MqttPublisher*)context;
+    if (!networkManager.isConnected()) {
+        Log.warn(LOG_UPLOAD_WIFI_DOWN);
+        return 0;
+    }
+
+    unsigned long startedMs = millis();
+    uint32_t started = micros();
+    int taken = publisher.publish(records, count);
+    uploadLatency.record(micros() - started);
+    trace.upload(startedMs, true, taken, count, (micros() - started) / 1000);
+    uploadCount.add();
+    if (taken > 0) {
+        Log.info(LOG_MQTT_PUBLISHED, taken, publisher.inFlight());
+    } else {
+        uploadFailures.add();
+        if (publisher.inFlight() >= publisher.getWindow()) {
+            Log.warn(LOG_MQTT_WINDOW_FULL, publisher.inFlight());
+        }
+    }
+    return taken;
+}
+
+void pollMqtt(void* context) {
+    ((MqttPublisher*)context)->poll();
+}
+
+void closeMqtt(void* context) {
+    ((MqttPublisher*)context)->linkLost();
+}
+
+int mqttDelivered(void* context) {
+    return ((MqttPublisher*)context)->takeDelivered();
+}
+
+void persistRecords(const QueuedRecord* records, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!uploadQueue.push(records[i])) {
+            Log.warn(LOG_RECORD_LOST);
+        }
+    }
+}
+
+// Persist records that could not be uploaded; they are retried in order from flash
+void queueRecords(const QueuedRecord* records, int count) {
+    persistRecords(records, count);
+    Log.info(LOG_RECORDS_QUEUED, uploadQueue.size());
+}
+
+// Records that left the head past those handed over (dropped from a full
+// queue, or corrupt) restart the positions, once everything handed over is
+// confirmed; false while that is still outstanding
+bool syncQueuePositions() {
+    uint32_t head = uploadQueue.headPosition();
+    if (head <= queueSentEnd) {
+        return true;
+    }
+    if (queueDeliveredEnd != queueSentEnd) {
+        return false;
+    }
+    queueSentEnd = head;
+    queueDeliveredEnd = head;
+    return true;
+}
+
+// Remove the records the backend confirmed from the flash queue
+void collectDelivered() {
+    int count = uploader->delivered(uploader->context);
+    if (count == 0) {
         return;
     }
-    
-    unsigned long currentTime = millis();
-    
-    // Non-blocking sensor reading - only read every SENSOR_READ_INTERVAL
-    if (currentTime - lastSensorReadTime < SENSOR_READ_INTERVAL) {
-        delay(10); // Short delay to prevent tight loop, but still responsive to OTA
+    queueDeliveredEnd += count;
+    uint32_t head = uploadQueue.headPosition();
+    if (queueDeliveredEnd > head) {
+        uploadQueue.pop(queueDeliveredEnd - head);
+    }
+}
+
+// Upload the oldest queued records not yet handed over in one request;
+// called between windows
+void drainUploadQueue(unsigned long currentTime) {
+    static QueuedRecord backlog[RecordUploader::MAX_BATCH];
+    if (!syncQueuePositions() || queueSentEnd - uploadQueue.headPosition() >= uploadQueue.size()) {
+        return; // Everything queued is waiting to be confirmed
+    }
+    int count = uploadQueue.peekFrom(queueSentEnd, backlog, uploader->maxRecords);
+    if (count == 0 || !syncQueuePositions()) {
         return;
     }
     
-    lastSensorReadTime = currentTime;
+    lastUploadTime = currentTime;
+    Log.info(LOG_UPLOAD_BACKLOG, uploadQueue.size());
+    int taken = uploader->send(backlog, count, uploader->context);
+    if (uploader->delivered) {
+        queueSentEnd += taken;
+        collectDelivered();
+    } else {
+        uploadQueue.pop(taken);
+    }
+}
+
+// Validate, display, average, record and upload one sample
+void handleSample(const SensorSample& sample) {
+    unsigned long currentTime = sample.timestamp;
+    const SensorData& raw = sample.data;
 
-    // Read sensor values
-    float pm1, pm25, pm4, pm10;
-    float humidity, temperature, voc, nox;
+    trace.sample(sample);
+    if (!traceClockSet && trace.isActive() && time(nullptr) >= MIN_VALID_EPOCH) {
+        traceClockSet = true; // Record timestamps depend on it
+        trace.clock((uint32_t)time(nullptr));
+    }
 
-    if (!sensorManager.readData(pm1, pm25, pm4, pm10, humidity, temperature, voc, nox)) {
-        Serial.println("⚠️  Check wiring! Skipping this reading...");
+    if (!sample.ok) {
+        Log.warn(LOG_SAMPLE_READ_FAILED);
         return;
     }
 
-    // Validate sensor data
-    if (!isValidReading(pm1, pm25, pm4, pm10, humidity, temperature, voc, nox)) {
-        Serial.println("⚠️  WARNING: Invalid sensor data detected");
-        Serial.println("   Check I2C connections and power supply!");
-        delay(1000); // Brief delay before retrying
+    // Validate sensor data; NaN fields are expected while the sensor warms up
+    if (!isValidReading(raw)) {
+        if (!sample.warmingUp) {
+            Log.warn(LOG_SAMPLE_INVALID);
+        } else if (!isnan(raw.pm25)) {
+            // Particle readings settle first: show them before the rest is ready
+            statusLed.update(raw.pm25);
+            Log.debug(LOG_SENSOR_WARMING_UP, raw.pm25, isnan(raw.temperature) ? "pending" : "ready",
+                      isnan(raw.voc) ? "pending" : "ready");
+        }
         return;
     }
+    if (!sensorReady) {
+        sensorReady = true;
+        const SensorTaskStats& acquisition = sensorTask.getStats();
+        Log.info(LOG_SENSOR_READY, (unsigned long)acquisition.firstValidMs, (unsigned)acquisition.warmupReads);
+        lastRecordTime = currentTime; // The first averaging window starts with the first valid sample
+    }
+
+    // Outliers are replaced before the LED, the averaging window and the
+    // history see the reading (the dashboard's live values stay the sensor's own)
+    SensorData reading = sampleFilter.apply(raw, currentTime);
 
     // Update LED status
-    statusLed.update(pm25);
-
-    // Get PM2.5 air quality status
-    String pm25Quality, pm25Color;
-    getPM25Quality(pm25, pm25Quality, pm25Color);
-
-    // Print to serial (formatted nicely with all PM values)
-    Serial.print("PM1.0:");
-    Serial.print(pm1, 1);
-    Serial.print(" | PM2.5:");
-    Serial.print(pm25, 1);
-    Serial.print(" µg/m³ ");
-    Serial.print(pm25Color);
-    Serial.print(" [");
-    Serial.print(pm25Quality);
-    Serial.print("] | PM4:");
-    Serial.print(pm4, 1);
-    Serial.print(" | PM10:");
-    Serial.print(pm10, 1);
-    Serial.print(" | Temp:");
-    Serial.print(temperature, 1);
-    Serial.print("°C | Hum:");
-    Serial.print(humidity, 1);
-    Serial.print("% | VOC:");
-    Serial.print((int)voc);
-    Serial.print(" | NOx:");
-    Serial.print((int)nox);
-    
-    // Show averaging progress
-    Serial.print(" | Avg:");
-    Serial.print(dataAveraging.getCount());
-    Serial.print("/");
-    Serial.print(AVERAGING_SAMPLES);
-    
-    // Show countdown to next upload
-    if (currentTime >= lastSendTime) {
-        unsigned long timeSinceLast = currentTime - lastSendTime;
-        if (timeSinceLast < SEND_INTERVAL) {
-            unsigned long timeUntilSend = (SEND_INTERVAL - timeSinceLast) / 1000;
-            Serial.print(" | Upload in ");
-            Serial.print(timeUntilSend);
-            Serial.print("s");
-        }
+    statusLed.update(reading.pm25);
+
+    // Get PM2.5 air quality status (static strings, no allocation)
+    const char* pm25Quality;
+    const char* pm25Color;
+    getPM25Quality(reading.pm25, pm25Quality, pm25Color);
+
+    // One status line with all PM values, averaging progress, the countdown
+    // to the next record and how full the batch is (queued, printed later)
+    unsigned long timeSinceLast = currentTime - lastRecordTime;
+    if (currentTime >= lastRecordTime && timeSinceLast < RECORD_INTERVAL) {
+        Log.debug(LOG_SAMPLE, reading.pm1, reading.pm25, pm25Color, pm25Quality, reading.pm4, reading.pm10,
+                  reading.temperature, reading.humidity, (int)reading.voc, (int)reading.nox,
+                  dataAveraging.getCount(), RECORD_SAMPLES, (RECORD_INTERVAL - timeSinceLast) / 1000,
+                  bulkUploader.size(), BulkUploader::BATCH_SIZE);
+    } else {
+        Log.debug(LOG_SAMPLE_RECORD_DUE, reading.pm1, reading.pm25, pm25Color, pm25Quality, reading.pm4,
+                  reading.pm10, reading.temperature, reading.humidity, (int)reading.voc, (int)reading.nox,
+                  dataAveraging.getCount(), RECORD_SAMPLES, bulkUploader.size(), BulkUploader::BATCH_SIZE);
     }
-    Serial.println();
 
-    // Send to ThingSpeak periodically with averaged data
-    if (currentTime - lastSendTime >= SEND_INTERVAL) {
+    // Close an averaging window into a timestamped record periodically
+    if (currentTime - lastRecordTime >= RECORD_INTERVAL) {
         if (dataAveraging.hasEnoughSamples()) {
-            float avgPm1, avgPm25, avgPm4, avgPm10;
-            float avgHumidity, avgTemperature, avgVoc, avgNox;
+            SensorStats stats = dataAveraging.getStats();
             
-            dataAveraging.getAveraged(avgPm1, avgPm25, avgPm4, avgPm10,
-                                     avgHumidity, avgTemperature, avgVoc, avgNox);
+            Log.info(LOG_RECORD_AVERAGED, stats.count, stats.min.pm25, stats.max.pm25, sqrtf(stats.variance.pm25));
             
-            Serial.println();
-            Serial.print("📊 Uploading averaged data (");
-            Serial.print(AVERAGING_SAMPLES);
-            Serial.println(" samples)");
+            QueuedRecord record;
+            record.timestamp = epochAt(currentTime);
+            record.data = stats.mean;
+            dataAveraging.reset();
+            trace.record(record);
             
-            bool uploadSuccess = sendToThingSpeak(avgPm1, avgPm25, avgPm4, avgPm10,
-                                                  avgHumidity, avgTemperature, avgVoc, avgNox);
-            
-            if (uploadSuccess) {
-                dataAveraging.reset(); // Only reset on successful upload
+            if (!isValidReading(record.data)) {
+                Log.warn(LOG_RECORD_INVALID);
+            } else if (!uploadQueue.isEmpty()) {
+                // Older records are waiting on flash; stay behind them
+                queueRecords(&record, 1);
             } else {
-                Serial.println("⚠️  Data preserved for retry on next interval");
+                bulkUploader.add(record);
+                if (bulkUploader.isFull()) {
+                    bool uploadNow = networkManager.isConnected()
+                                     && currentTime - lastUploadTime >= uploader->minIntervalMs;
+                    if (uploader->delivered && uploadQueue.isMounted()) {
+                        // Confirmed after send() returns: the batch waits on flash until then
+                        persistRecords(bulkUploader.records(), bulkUploader.size());
+                        if (uploadNow) {
+                            drainUploadQueue(currentTime);
+                        }
+                    } else {
+                        int sent = 0;
+                        if (uploadNow) {
+                            lastUploadTime = currentTime;
+                            sent = uploader->send(bulkUploader.records(), bulkUploader.size(), uploader->context);
+                        }
+                        if (sent < bulkUploader.size()) {
+                            queueRecords(bulkUploader.records() + sent, bulkUploader.size() - sent);
+                        }
+                    }
+                    bulkUploader.clear();
+                }
             }
             
-            lastSendTime = currentTime;
+            lastRecordTime = currentTime;
         } else {
-            Serial.println();
-            Serial.print("⏳ Collecting more samples (");
-            Serial.print(dataAveraging.getCount());
-            Serial.print("/");
-            Serial.print(AVERAGING_SAMPLES);
-            Serial.println(") before upload...");
-            lastSendTime = currentTime; // Update to prevent spam on next iteration
+            Log.info(LOG_RECORD_COLLECTING, dataAveraging.getCount(), MIN_RECORD_SAMPLES);
+            lastRecordTime = currentTime; // Update to prevent spam on next iteration
+        }
+    } else if (!uploadQueue.isEmpty() && networkManager.isConnected()
+               && currentTime - lastUploadTime >= uploader->minIntervalMs) {
+        // Spend rate-limit slots between windows on the backlog
+        drainUploadQueue(currentTime);
+    }
+    
+    // Add reading to the sliding window after upload check
+    dataAveraging.addReading(reading);
+    
+    // Keep it at full resolution once the clock is set (queries are by Unix time)
+    uint32_t epoch = epochAt(currentTime);
+    if (epoch != 0) {
+        history.add(epoch, reading);
+    }
+}
+
+void loop() {
+    uint32_t started = micros();
+    scheduler.runDue(millis());
+    
+    // Samples come from the sensor task on the other core. After a slow
+    // upload several are waiting; they are handled one per pass, each with
+    // the time it was read, so jobs that fell due meanwhile run in between.
+    // Sensor operations are skipped during an OTA update. Notifications
+    // for samples about to be popped are cleared first, so they do not wake
+    // the sleep below for nothing.
+    ulTaskNotifyTake(pdTRUE, 0);
+    SensorSample sample;
+    if (!otaInProgress && sampleQueue.pop(sample)) {
+        handleSample(sample);
+        if (dashboard.isRunning()) {
+            publishDashboard(sample);
         }
+        loopLatency.record(micros() - started);
+        return;
     }
     
-    // Add reading to running average after upload check
-    dataAveraging.addReading(pm1, pm25, pm4, pm10, humidity, temperature, voc, nox);
+    loopLatency.record(micros() - started);
+
+    // Sleep until the next job is due or the sensor task posts a sample
+    power.sleep(scheduler.msUntilNext(millis()));
 }
\ No newline at end of file
@@ -0,0 +1,139 @@
+"""Bundle the dashboard's web assets (web/) into src/DashboardAssets.h.
+
+Each asset is minified and gzipped; the firmware serves the gzip bytes
+straight from flash with Content-Encoding: gzip and a strong ETag (a hash of
+those bytes). The stylesheet and script get their content hash in the file
+name and are cached by the browser for good; index.html links the hashed
+names and is revalidated on every load (304 Not Modified while unchanged).
+
+Runs before every PlatformIO build (extra_scripts) and rewrites the header
+only when web/ changed, so the build does not need Python for anything
+else and unchanged sources do not trigger a recompile. Also runs on its
+own: python tools/build_web.py
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WEB_DIR = os.path.join(ROOT, "web")
+OUTPUT = os.path.join(ROOT, "src", "DashboardAssets.h")
+
+# Source, content type, whether the name carries the content hash
+ASSETS = [
+    ("style.css", "text/css", True),
+    ("app.js", "application/javascript", True),
+    ("index.html", "text/html; charset=utf-8", False),
+]
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};:,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    # Conservative: indentation, blank lines and whole-line comments only;
+    # line breaks stay, so automatic semicolon insertion is unaffected
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line and not line.startswith("//"))
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line)
+
+
+MINIFIERS = {".css": minify_css, ".js": minify_js, ".html": minify_html}
+
+
+def content_hash(data, length):
+    return hashlib.sha256(data).hexdigest()[:length]
+
+
+def c_array(name, data):
+    rows = []
+    for i in range(0, len(data), 16):
+        rows.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "const uint8_t %s[] PROGMEM = {\n%s\n};\n" % (name, "\n".join(rows))
+
+
+def build():
+    sources = {}
+    for name, _, _ in ASSETS:
+        with open(os.path.join(WEB_DIR, name), "rb") as f:
+            sources[name] = f.read()
+    source_hash = content_hash(b"".join(sources[name] for name, _, _ in ASSETS) + open(__file__, "rb").read(), 16)
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT, encoding="utf-8") as f:
+            if "Sources: %s" % source_hash in f.read():
+                return False
+
+    paths = {}
+    built = []
+    for name, content_type, hashed in ASSETS:
+        stem, extension = os.path.splitext(name)
+        text = MINIFIERS[extension](sources[name].decode("utf-8"))
+        for original, path in paths.items():
+            text = text.replace('"%s"' % original, '"%s"' % path)
+        minified = text.encode("utf-8")
+        body = gzip.compress(minified, compresslevel=9, mtime=0)
+        path = "/%s.%s%s" % (stem, content_hash(minified, 8), extension) if hashed else "/"
+        paths[name] = path
+        symbol = "DASHBOARD_" + re.sub(r"\W", "_", name).upper() + "_GZ"
+        etag = '\\"%s\\"' % content_hash(body, 16)
+        built.append((name, path, content_type, hashed, len(sources[name]), len(minified), body, symbol, etag))
+
+    out = ["/**",
+           " * @file DashboardAssets.h",
+           " * @brief Dashboard page, stylesheet and script, minified and gzipped",
+           " *",
+           " * Generated by tools/build_web.py from web/ before each build; do not edit.",
+           " * Sources: %s" % source_hash,
+           " */",
+           "",
+           "#ifndef DASHBOARD_ASSETS_H",
+           "#define DASHBOARD_ASSETS_H",
+           "",
+           "#include <Arduino.h>",
+           "",
+           "struct DashboardAsset {",
+           "    const char* path;",
+           "    const char* contentType;",
+           "    const uint8_t* body;       // gzip",
+           "    size_t length;",
+           "    const char* etag;          // Strong: hash of the gzip bytes",
+           "    bool immutable;            // Content hash in the path: cache for good",
+           "    size_t sourceLength;       // web/ file",
+           "    size_t minifiedLength;     // Before gzip",
+           "};",
+           ""]
+    for name, path, content_type, hashed, source_length, minified_length, body, symbol, etag in built:
+        out.append("// %s: %d bytes, %d minified, %d gzipped" % (name, source_length, minified_length, len(body)))
+        out.append(c_array(symbol, body))
+    out.append("const DashboardAsset DASHBOARD_ASSETS[] = {")
+    for name, path, content_type, hashed, source_length, minified_length, body, symbol, etag in built:
+        out.append('    {"%s", "%s", %s, sizeof(%s), "%s", %s, %d, %d},'
+                   % (path, content_type, symbol, symbol, etag, "true" if hashed else "false",
+                      source_length, minified_length))
+    out.append("};")
+    out.append("const size_t DASHBOARD_ASSET_COUNT = sizeof(DASHBOARD_ASSETS) / sizeof(DASHBOARD_ASSETS[0]);")
+    out.append("")
+    out.append("#endif // DASHBOARD_ASSETS_H")
+    out.append("")
+    with open(OUTPUT, "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(out))
+    return True
+
+
+if __name__ == "__main__":
+    print("Updated src/DashboardAssets.h" if build() else "src/DashboardAssets.h is up to date")
+else:
+    Import("env")  # noqa: F821 (PlatformIO extra script)
+    if build():
+        print("build_web: updated src/DashboardAssets.h")
@@ -0,0 +1,62 @@
+// Dashboard client: readings arrive on the /ws WebSocket once per sample;
+// while it is down the page polls the JSON API and keeps reconnecting.
+const $ = id => document.getElementById(id);
+const fields = ['pm1', 'pm25', 'pm4', 'pm10', 'temperature', 'humidity', 'voc', 'nox'];
+
+function uptime(s) {
+  const d = Math.floor(s / 86400), h = Math.floor(s / 3600) % 24, m = Math.floor(s / 60) % 60;
+  return (d ? d + 'd ' : '') + h + 'h ' + m + 'm';
+}
+
+function show(d) {
+  fields.forEach(f => $(f).textContent = d[f]);
+  $('quality').textContent = d.quality;
+  $('quality').className = d.quality.split(' ')[0];
+}
+
+function status(s) {
+  $('state').textContent = (s.wifi ? 'WiFi ' + s.rssi + ' dBm' : 'WiFi down') + ' · up ' + uptime(s.uptime)
+    + ' · ' + s.queued + ' queued';
+}
+
+async function refresh() {
+  try {
+    const r = await fetch('/api/current', {cache: 'no-store'});
+    if (r.status == 503) {
+      $('state').textContent = 'sensor warming up';
+    } else {
+      show(await r.json());
+    }
+    status(await (await fetch('/api/status', {cache: 'no-store'})).json());
+  } catch (e) {
+    $('state').textContent = 'offline';
+  }
+}
+
+let timer = null;
+
+function connect() {
+  const ws = new WebSocket('ws://' + location.host + '/ws');
+  ws.onopen = () => {
+    clearInterval(timer);
+    timer = null;
+  };
+  ws.onmessage = e => {
+    const m = JSON.parse(e.data);
+    status(m.status);
+    if (m.current) {
+      show(m.current);
+    } else if (!m.status.sensorReady) {
+      $('state').textContent = 'sensor warming up';
+    }
+  };
+  ws.onclose = () => {
+    if (!timer) {
+      refresh();
+      timer = setInterval(refresh, 2000);
+    }
+    setTimeout(connect, 5000);
+  };
+}
+
+connect();